@@ -0,0 +1,475 @@
+/*! \file parallel_range_image.h
+*  RangeImage::createFromPointCloud in parallel: per-thread z-buffer tiles merged into the cropped image, fast trigonometry with a bounded error.
+*/
+#ifndef PARALLEL_RANGE_IMAGE_H_
+#define PARALLEL_RANGE_IMAGE_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/range_image/range_image.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief A RangeImage that is created from a point cloud in parallel.
+    *
+    * RangeImage::createFromPointCloud runs the z-buffer over the points
+    * serially on a full-size image, copies the image again in cropImage and
+    * computes the 3D point of every pixel with sinf / cosf in
+    * recalculate3DPointPositions. Here:
+    *  - the points are split into one chunk per thread; each thread projects
+    *    its chunk and runs the same z-buffer (nearest point wins, points
+    *    within noise_level are averaged, the up to three free pixels around
+    *    the projection get the interpolated range) on a private tile that
+    *    only covers the pixels it writes to. For the points of a spinning
+    *    lidar, which arrive column after column, the tiles are narrow
+    *    vertical bands and all of them together have about the size of the
+    *    image;
+    *  - the tiles are merged directly into the cropped image, row by row in
+    *    parallel, and the 3D points are computed in the same pass;
+    *  - the angles come from atan2Fast (error below 1.2e-5 rad) and sinCosFast
+    *    (error below 1e-6) instead of the lookup tables and sinf / cosf. Both
+    *    are branch free, so the projection and the 3D points are computed on
+    *    kBlockSize values at a time in loops the compiler vectorizes.
+    * With noise_level 0 the ranges are the ones the serial z-buffer yields,
+    * except for points that the approximate angles move across a pixel
+    * border. With noise_level > 0 the serial result depends on the order of
+    * the points; the tiles are merged with the same rules, which gives the
+    * result of an order in which each thread's points are consecutive.
+    *
+    * The buffers are kept between calls, so creating an image per frame
+    * allocates nothing once the frame size is stable.
+    */
+  class ParallelRangeImage : public RangeImage
+  {
+    public:
+      typedef boost::shared_ptr<ParallelRangeImage> Ptr;
+      typedef boost::shared_ptr<const ParallelRangeImage> ConstPtr;
+
+      /** \brief Number of points (or pixels) computed together. */
+      static const int kBlockSize = 256;
+      /** \brief Chunks with fewer points are not worth a thread of their own. */
+      static const int kMinPointsPerThread = 4096;
+
+      ParallelRangeImage () : threads_ (0) {}
+
+      virtual RangeImage*
+      getNew () const { return (new ParallelRangeImage); }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Same as RangeImage::createFromPointCloud, in parallel. */
+      template <typename PointCloudType> void
+      createFromPointCloudParallel (const PointCloudType &point_cloud, float angular_resolution = pcl::deg2rad (0.5f),
+                                    float max_angle_width = pcl::deg2rad (360.0f), float max_angle_height = pcl::deg2rad (180.0f),
+                                    const Eigen::Affine3f &sensor_pose = Eigen::Affine3f::Identity (),
+                                    CoordinateFrame coordinate_frame = CAMERA_FRAME, float noise_level = 0.0f,
+                                    float min_range = 0.0f, int border_size = 0)
+      {
+        createFromPointCloudParallel (point_cloud, angular_resolution, angular_resolution, max_angle_width, max_angle_height,
+                                      sensor_pose, coordinate_frame, noise_level, min_range, border_size);
+      }
+
+      /** \brief Same as RangeImage::createFromPointCloud with different horizontal and vertical resolutions, in parallel. */
+      template <typename PointCloudType> void
+      createFromPointCloudParallel (const PointCloudType &point_cloud, float angular_resolution_x, float angular_resolution_y,
+                                    float max_angle_width, float max_angle_height, const Eigen::Affine3f &sensor_pose,
+                                    CoordinateFrame coordinate_frame, float noise_level, float min_range, int border_size);
+
+      /** \brief atan (t) for |t| <= 1, Abramowitz & Stegun 4.4.49; |error| < 1e-5 rad. */
+      static inline float
+      atanFast (float t)
+      {
+        const float t2 = t * t;
+        return (t * (0.9998660f + t2 * (-0.3302995f + t2 * (0.1801410f + t2 * (-0.0851330f + t2 * 0.0208351f)))));
+      }
+
+      /** \brief atan2 (y, x) through atanFast on the octant, without branches; |error| < 1.2e-5 rad, atan2Fast (0, 0) = 0. */
+      static inline float
+      atan2Fast (float y, float x)
+      {
+        // 比较的结果作为 0 / 1 参与运算，不用 ?: 和 min / max，循环里调用时编译器才会向量化
+        const float ax = std::fabs (x), ay = std::fabs (y);
+        const float swap = static_cast<float> (ay > ax);
+        const float a = atanFast ((ay + swap * (ax - ay)) / (ax + swap * (ay - ax) + std::numeric_limits<float>::min ()));
+        const float octant = a + swap * (static_cast<float> (0.5 * M_PI) - 2.0f * a);
+        const float half = octant + static_cast<float> (x < 0.0f) * (static_cast<float> (M_PI) - 2.0f * octant);
+        return (half - static_cast<float> (y < 0.0f) * 2.0f * half);
+      }
+
+      /** \brief sin and cos of an angle, without branches: reduction to [-pi/4, pi/4] in three steps, then the
+        * Cephes polynomials; |error| < 1e-6 for |angle| < 1e4.
+        */
+      static inline void
+      sinCosFast (float angle, float &s, float &c)
+      {
+        const int quadrant = floorInt (angle * static_cast<float> (2.0 / M_PI) + 0.5f);
+        const float k = static_cast<float> (quadrant);
+        // pi/2 = 1.5703125 + 4.837512969970703125e-4 + 7.549789948768648e-8，前两项尾数很短，k 倍时没有舍入
+        const float r = ((angle - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.549789948768648e-8f;
+        const float r2 = r * r;
+        const float sin_r = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+        const float cos_r = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+        // 象限 q：奇数时 sin、cos 互换，q & 2 时 sin 变号，(q + 1) & 2 时 cos 变号
+        const float odd = static_cast<float> (quadrant & 1);
+        s = (sin_r + odd * (cos_r - sin_r)) * static_cast<float> (1 - (quadrant & 2));
+        c = (cos_r + odd * (sin_r - cos_r)) * static_cast<float> (1 - ((quadrant + 1) & 2));
+      }
+
+      /** \brief floor (v) as an int, without the libm call of floor / lrint; |v| < 2^31. */
+      static inline int
+      floorInt (float v)
+      {
+        const int i = static_cast<int> (v);
+        return (i - static_cast<int> (v < static_cast<float> (i)));
+      }
+
+    protected:
+      /** \brief One z-buffer pixel. */
+      struct Cell
+      {
+        float range;   // 无穷大 = 没有写过
+        int counter;   // 0 = 只有插值得到的距离
+      };
+
+      /** \brief Private z-buffer of one thread, covering the pixels [left, right] x [top, bottom] of the full image.
+        *
+        * The rows are stride cells apart, an odd number of cache lines: with a power of two the pixels of one
+        * image column, which a lidar frame writes one after the other, would all fall into the same cache set.
+        */
+      struct Tile
+      {
+        int top, right, bottom, left;
+        int stride;
+        std::vector<Cell> cells;
+
+        inline bool
+        empty () const { return (right < left); }
+      };
+
+      /** \brief Fold the state (range, counter) of a tile pixel into a pixel, with the rules of RangeImage::doZBuffer. */
+      static inline void
+      mergePixel (float range, int counter, float noise_level, float &merged_range, int &merged_counter)
+      {
+        if (counter == 0)
+        {
+          // 插值得到的距离只在没有点直接落入时有效
+          if (merged_counter == 0)
+            merged_range = (std::min) (merged_range, range);
+          return;
+        }
+        if (merged_counter == 0 || range < merged_range - noise_level)
+        {
+          merged_range = range;
+          merged_counter = counter;
+        }
+        else if (std::fabs (range - merged_range) <= noise_level)
+        {
+          merged_range = (merged_range * static_cast<float> (merged_counter) + range * static_cast<float> (counter)) /
+                         static_cast<float> (merged_counter + counter);
+          merged_counter += counter;
+        }
+      }
+
+      static inline int
+      chunkBegin (int n, int chunks, int c)
+      {
+        return (static_cast<int> (static_cast<long long> (n) * c / chunks));
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      unsigned int threads_;
+      std::vector<Tile> tiles_;
+      std::vector<float> image_x_, image_y_, point_ranges_;   // 每个点的投影结果，距离为负表示跳过
+      std::vector<float> row_ranges_;                         // 合并时每个线程一行
+      std::vector<int> row_counters_;
+  };
+}
+
+template <typename PointCloudType> void
+pcl::ParallelRangeImage::createFromPointCloudParallel (const PointCloudType &point_cloud,
+                                                       float angular_resolution_x, float angular_resolution_y,
+                                                       float max_angle_width, float max_angle_height,
+                                                       const Eigen::Affine3f &sensor_pose, CoordinateFrame coordinate_frame,
+                                                       float noise_level, float min_range, int border_size)
+{
+  // 图像大小、偏移和坐标变换与 RangeImage::createFromPointCloud 相同
+  setAngularResolution (angular_resolution_x, angular_resolution_y);
+  const int full_width = static_cast<int> (pcl_lrint (std::floor (max_angle_width * angular_resolution_x_reciprocal_)));
+  const int full_height = static_cast<int> (pcl_lrint (std::floor (max_angle_height * angular_resolution_y_reciprocal_)));
+  const int sphere_width = static_cast<int> (pcl_lrint (std::floor (pcl::deg2rad (360.0f) * angular_resolution_x_reciprocal_)));
+  const int sphere_height = static_cast<int> (pcl_lrint (std::floor (pcl::deg2rad (180.0f) * angular_resolution_y_reciprocal_)));
+  const int offset_x = (sphere_width - full_width) / 2;
+  const int offset_y = (sphere_height - full_height) / 2;
+  is_dense = false;
+
+  getCoordinateFrameTransformation (coordinate_frame, to_world_system_);
+  to_world_system_ = sensor_pose * to_world_system_;
+  to_range_image_system_ = to_world_system_.inverse (Eigen::Isometry);
+
+  const int n = static_cast<int> (point_cloud.points.size ());
+  const int threads = (std::max) (1, (std::min) (getThreads (), n / kMinPointsPerThread));
+  image_x_.resize (n);
+  image_y_.resize (n);
+  point_ranges_.resize (n);
+  tiles_.resize (threads);
+
+  // 1. 投影：每个线程一段点，按块计算，同时求出它要写的像素范围（落点及其插值邻点）
+  const Eigen::Matrix4f &to_image = to_range_image_system_.matrix ();
+  const float m00 = to_image (0, 0), m01 = to_image (0, 1), m02 = to_image (0, 2), m03 = to_image (0, 3);
+  const float m10 = to_image (1, 0), m11 = to_image (1, 1), m12 = to_image (1, 2), m13 = to_image (1, 3);
+  const float m20 = to_image (2, 0), m21 = to_image (2, 1), m22 = to_image (2, 2), m23 = to_image (2, 3);
+  const float pi = static_cast<float> (M_PI);
+  const float scale_x = angular_resolution_x_reciprocal_, scale_y = angular_resolution_y_reciprocal_;
+  const float shift_x = pi * scale_x - static_cast<float> (offset_x);
+  const float shift_y = 0.5f * pi * scale_y - static_cast<float> (offset_y);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+  for (int t = 0; t < threads; ++t)
+  {
+    Tile &tile = tiles_[t];
+    tile.top = full_height; tile.right = -1; tile.bottom = -1; tile.left = full_width;
+    const int last = chunkBegin (n, threads, t + 1);
+    for (int first = chunkBegin (n, threads, t); first < last; first += kBlockSize)
+    {
+      const int count = (std::min) (kBlockSize, last - first);
+      float x[kBlockSize], y[kBlockSize], z[kBlockSize], horizontal[kBlockSize], ranges[kBlockSize];
+      for (int i = 0; i < count; ++i)
+      {
+        const typename PointCloudType::PointType &p = point_cloud.points[first + i];
+        x[i] = p.x;
+        y[i] = p.y;
+        z[i] = p.z;
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        const float qx = m00 * x[i] + m01 * y[i] + m02 * z[i] + m03;
+        const float qy = m10 * x[i] + m11 * y[i] + m12 * z[i] + m13;
+        const float qz = m20 * x[i] + m21 * y[i] + m22 * z[i] + m23;
+        x[i] = qx;
+        y[i] = qy;
+        z[i] = qz;
+        horizontal[i] = qx * qx + qz * qz;
+        ranges[i] = horizontal[i] + qy * qy;
+      }
+      // 开方单独成一个循环：std::sqrt 要设置 errno，其中的分支会让整个循环无法向量化
+      for (int i = 0; i < count; ++i)
+      {
+        horizontal[i] = std::sqrt (horizontal[i]);
+        ranges[i] = std::sqrt (ranges[i]);
+      }
+      // asin (y / range) = atan2 (y, horizontal)，cos (angle_y) = horizontal / range，省去 asin 和 cos
+      for (int i = 0; i < count; ++i)
+      {
+        const float cos_y = horizontal[i] / (ranges[i] + std::numeric_limits<float>::min ());
+        x[i] = atan2Fast (x[i], z[i]) * cos_y * scale_x + shift_x;
+        y[i] = atan2Fast (y[i], horizontal[i]) * scale_y + shift_y;
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        const float range = ranges[i];
+        point_ranges_[first + i] = -1.0f;
+        // NaN 的点距离也是 NaN，在这里跳过
+        if (!(range >= min_range) || range == 0.0f || !pcl_isfinite (range))
+          continue;
+        const int pixel_x = floorInt (x[i] + 0.5f), pixel_y = floorInt (y[i] + 0.5f);
+        if (pixel_x < 0 || pixel_x >= full_width || pixel_y < 0 || pixel_y >= full_height)
+          continue;
+        image_x_[first + i] = x[i];
+        image_y_[first + i] = y[i];
+        point_ranges_[first + i] = range;
+        // 插值的邻点在 floor 和 ceil 之间
+        const int floor_x = floorInt (x[i]), floor_y = floorInt (y[i]);
+        tile.top = (std::min) (tile.top, (std::max) (0, floor_y));
+        tile.bottom = (std::max) (tile.bottom, (std::min) (full_height - 1, floor_y + (y[i] > static_cast<float> (floor_y) ? 1 : 0)));
+        tile.left = (std::min) (tile.left, (std::max) (0, floor_x));
+        tile.right = (std::max) (tile.right, (std::min) (full_width - 1, floor_x + (x[i] > static_cast<float> (floor_x) ? 1 : 0)));
+      }
+    }
+  }
+
+  int top = full_height, right = -1, bottom = -1, left = full_width;
+  for (int t = 0; t < threads; ++t)
+  {
+    const Tile &tile = tiles_[t];
+    if (tile.empty ())
+      continue;
+    top = (std::min) (top, tile.top); bottom = (std::max) (bottom, tile.bottom);
+    left = (std::min) (left, tile.left); right = (std::max) (right, tile.right);
+  }
+  if (right < left)
+  {
+    // 没有点落入图像
+    width = height = 0;
+    points.clear ();
+    image_offset_x_ = offset_x;
+    image_offset_y_ = offset_y;
+    return;
+  }
+
+  // 2. 每个线程在自己的 tile 上做 z-buffer，规则与 RangeImage::doZBuffer 相同
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+  for (int t = 0; t < threads; ++t)
+  {
+    Tile &tile = tiles_[t];
+    if (tile.empty ())
+      continue;
+    const int line = 64 / static_cast<int> (sizeof (Cell));
+    tile.stride = (((tile.right - tile.left + line) / line) | 1) * line;
+    Cell empty;
+    empty.range = std::numeric_limits<float>::infinity ();
+    empty.counter = 0;
+    tile.cells.assign (tile.stride * (tile.bottom - tile.top + 1), empty);
+    Cell *cells = &tile.cells[0] - tile.top * tile.stride - tile.left;   // cells[y * stride + x]，x、y 为整幅图像的坐标
+
+    const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+    for (int i = first; i < last; ++i)
+    {
+      const float range = point_ranges_[i];
+      if (range < 0.0f)
+        continue;
+      const float x_real = image_x_[i], y_real = image_y_[i];
+      const int floor_x = floorInt (x_real), floor_y = floorInt (y_real);
+      const int ceil_x = floor_x + (x_real > static_cast<float> (floor_x) ? 1 : 0);
+      const int ceil_y = floor_y + (y_real > static_cast<float> (floor_y) ? 1 : 0);
+      // 插值：落点本身也一起处理，它随后会被直接覆盖，结果与跳过它相同
+      if (floor_x >= 0 && ceil_x < full_width && floor_y >= 0 && ceil_y < full_height)
+      {
+        Cell *neighbors[4] = { &cells[floor_y * tile.stride + floor_x], &cells[ceil_y * tile.stride + floor_x],
+                               &cells[floor_y * tile.stride + ceil_x], &cells[ceil_y * tile.stride + ceil_x] };
+        for (int k = 0; k < 4; ++k)
+        {
+          const float nearer = (std::min) (neighbors[k]->range, range);
+          neighbors[k]->range = neighbors[k]->counter == 0 ? nearer : neighbors[k]->range;
+        }
+      }
+      else
+      {
+        const int neighbor_x[4] = { floor_x, floor_x, ceil_x, ceil_x };
+        const int neighbor_y[4] = { floor_y, ceil_y, floor_y, ceil_y };
+        for (int k = 0; k < 4; ++k)
+        {
+          if (neighbor_x[k] < 0 || neighbor_x[k] >= full_width || neighbor_y[k] < 0 || neighbor_y[k] >= full_height)
+            continue;
+          Cell &neighbor = cells[neighbor_y[k] * tile.stride + neighbor_x[k]];
+          if (neighbor.counter == 0)
+            neighbor.range = (std::min) (neighbor.range, range);
+        }
+      }
+
+      Cell &cell = cells[floorInt (y_real + 0.5f) * tile.stride + floorInt (x_real + 0.5f)];
+      if (cell.counter == 0 || range < cell.range - noise_level)
+      {
+        cell.counter = 1;
+        cell.range = range;
+      }
+      else if (std::fabs (range - cell.range) <= noise_level)
+      {
+        ++cell.counter;
+        cell.range += (range - cell.range) / static_cast<float> (cell.counter);
+      }
+    }
+  }
+
+  // 3. 裁剪后的图像：逐行合并各 tile，再按块计算三维点（与 calculate3DPoint 相同的公式）
+  width = static_cast<uint32_t> (right - left + 1 + 2 * border_size);
+  height = static_cast<uint32_t> (bottom - top + 1 + 2 * border_size);
+  image_offset_x_ = offset_x + left - border_size;
+  image_offset_y_ = offset_y + top - border_size;
+  points.resize (width * height);
+  const int rows = static_cast<int> (height), cols = static_cast<int> (width);
+  row_ranges_.resize (threads * cols);
+  row_counters_.resize (threads * cols);
+
+  PointWithRange unobserved;
+  unobserved.x = unobserved.y = unobserved.z = std::numeric_limits<float>::quiet_NaN ();
+  unobserved.range = -std::numeric_limits<float>::infinity ();
+  const Eigen::Matrix4f &to_world = to_world_system_.matrix ();
+  const float w00 = to_world (0, 0), w01 = to_world (0, 1), w02 = to_world (0, 2), w03 = to_world (0, 3);
+  const float w10 = to_world (1, 0), w11 = to_world (1, 1), w12 = to_world (1, 2), w13 = to_world (1, 3);
+  const float w20 = to_world (2, 0), w21 = to_world (2, 1), w22 = to_world (2, 2), w23 = to_world (2, 3);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+  for (int t = 0; t < threads; ++t)
+  {
+    float *ranges = &row_ranges_[t * cols];
+    int *counters = &row_counters_[t * cols];
+    const int last_row = chunkBegin (rows, threads, t + 1);
+    for (int y = chunkBegin (rows, threads, t); y < last_row; ++y)
+    {
+      PointWithRange *row = &points[y * cols];
+      const int full_y = y + top - border_size;
+      if (full_y < top || full_y > bottom)
+      {
+        std::fill (row, row + cols, unobserved);
+        continue;
+      }
+      std::fill (ranges, ranges + cols, std::numeric_limits<float>::infinity ());
+      std::fill (counters, counters + cols, 0);
+      for (int k = 0; k < threads; ++k)
+      {
+        const Tile &tile = tiles_[k];
+        if (tile.empty () || full_y < tile.top || full_y > tile.bottom)
+          continue;
+        const Cell *cells = &tile.cells[(full_y - tile.top) * tile.stride];
+        const int x_begin = tile.left - left + border_size;
+        for (int x = 0; x <= tile.right - tile.left; ++x)
+          if (cells[x].range != std::numeric_limits<float>::infinity ())
+            mergePixel (cells[x].range, cells[x].counter, noise_level, ranges[x_begin + x], counters[x_begin + x]);
+      }
+
+      float sin_y, cos_y;
+      sinCosFast ((static_cast<float> (y) + static_cast<float> (image_offset_y_)) * angular_resolution_y_ - 0.5f * pi, sin_y, cos_y);
+      const float inverse_cos_y = cos_y == 0.0f ? 0.0f : 1.0f / cos_y;
+      for (int first = 0; first < cols; first += kBlockSize)
+      {
+        const int count = (std::min) (kBlockSize, cols - first);
+        float wx[kBlockSize], wy[kBlockSize], wz[kBlockSize];
+        for (int i = 0; i < count; ++i)
+        {
+          const float angle_x = ((static_cast<float> (first + i) + static_cast<float> (image_offset_x_)) * angular_resolution_x_ - pi) * inverse_cos_y;
+          float sin_x, cos_x;
+          sinCosFast (angle_x, sin_x, cos_x);
+          const float range = ranges[first + i];
+          const float lx = range * sin_x * cos_y, ly = range * sin_y, lz = range * cos_x * cos_y;
+          wx[i] = w00 * lx + w01 * ly + w02 * lz + w03;
+          wy[i] = w10 * lx + w11 * ly + w12 * lz + w13;
+          wz[i] = w20 * lx + w21 * ly + w22 * lz + w23;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+          PointWithRange &p = row[first + i];
+          const float range = ranges[first + i];
+          if (range == std::numeric_limits<float>::infinity ())
+          {
+            p = unobserved;
+            continue;
+          }
+          p.x = wx[i];
+          p.y = wy[i];
+          p.z = wz[i];
+          p.range = range;
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include <pcl/point_types.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "parallel_range_image.h"
+#include "streaming_range_image.h"
+
+typedef pcl::PointXYZ PointT;
+using namespace pcl::console;
+
+static float
+random01 ()
+{
+  return (rand () / (RAND_MAX + 1.0f));
+}
+
+/** \brief One frame of a spinning lidar, column after column: the ground 1.8 m below the sensor and the
+  * walls of a 60 m x 40 m hall, 1% of the returns missing (NaN).
+  */
+static void
+makeLidarFrame (int columns, int rings, float lowest, float highest, pcl::PointCloud<PointT> &frame)
+{
+  frame.width = columns;
+  frame.height = rings;
+  frame.is_dense = false;
+  frame.points.resize (columns * rings);
+  for (int c = 0; c < columns; ++c)
+  {
+    const float azimuth = static_cast<float> (2.0 * M_PI) * (c + 0.1f * random01 ()) / columns;
+    const float dx = std::cos (azimuth), dy = std::sin (azimuth);
+    const float wall = std::min (30.0f / std::max (std::fabs (dx), 1e-6f), 20.0f / std::max (std::fabs (dy), 1e-6f));
+    for (int r = 0; r < rings; ++r)
+    {
+      const float elevation = pcl::deg2rad (lowest + (highest - lowest) * r / (rings - 1));
+      float range = wall / std::cos (elevation);
+      if (elevation < 0.0f)
+        range = std::min (range, 1.8f / std::sin (-elevation));
+      range += 0.02f * random01 ();
+      PointT &p = frame.points[c * rings + r];
+      if (random01 () < 0.01f)
+      {
+        p.x = p.y = p.z = std::numeric_limits<float>::quiet_NaN ();
+        continue;
+      }
+      p.x = range * std::cos (elevation) * dx;
+      p.y = range * std::cos (elevation) * dy;
+      p.z = range * std::sin (elevation);
+    }
+  }
+}
+
+static void
+countFrame (const pcl::StreamingRangeImage &, int *frames)
+{
+  ++*frames;
+}
+
+int
+main (int argc, char** argv)
+{
+  int columns = 2048, rings = 64, frames = 100, threads = 0, packet = 16;
+  float lowest = -25.0f, highest = 3.0f;
+  parse_argument (argc, argv, "-cols", columns);
+  parse_argument (argc, argv, "-rings", rings);
+  parse_argument (argc, argv, "-frames", frames);
+  parse_argument (argc, argv, "-t", threads);
+  parse_argument (argc, argv, "-packet", packet);
+  bool skip_pcl = find_switch (argc, argv, "-skip");
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [-cols columns (default 2048)] [-rings rings (default 64)] [-frames frames (default 100)]"
+              << " [-t threads] [-packet columns per packet (default 16)] [-skip (no RangeImage::createFromPointCloud)]\n";
+    return (0);
+  }
+  if (columns < 1 || rings < 2 || frames < 1 || packet < 1)
+  {
+    std::cerr << "Need at least one column, two rings, one frame and one column per packet." << std::endl;
+    return (-1);
+  }
+
+  // 一个像素对应一个激光束和一个方位角
+  pcl::PointCloud<PointT> frame;
+  makeLidarFrame (columns, rings, lowest, highest, frame);
+  const float resolution_x = pcl::deg2rad (360.0f / columns);
+  const float resolution_y = pcl::deg2rad ((highest - lowest) / (rings - 1));
+  const float max_angle_height = pcl::deg2rad (2.0f * std::max (-lowest, highest) + 2.0f);
+  const Eigen::Affine3f sensor_pose = Eigen::Affine3f::Identity ();
+  std::cerr << columns << "x" << rings << " frame, " << frame.points.size () << " points, " << frames << " frames" << std::endl;
+
+  TicToc tt;
+  pcl::RangeImage reference;
+  if (!skip_pcl)
+  {
+    tt.tic ();
+    for (int f = 0; f < frames; ++f)
+      reference.createFromPointCloud (frame, resolution_x, resolution_y, pcl::deg2rad (360.0f), max_angle_height,
+                                      sensor_pose, pcl::RangeImage::LASER_FRAME, 0.0f, 0.0f, 0);
+    std::cerr << "RangeImage::createFromPointCloud:          " << tt.toc () / frames << " ms per frame, "
+              << reference.width << "x" << reference.height << std::endl;
+  }
+
+  pcl::ParallelRangeImage range_image;
+  range_image.setNumberOfThreads (threads);
+  tt.tic ();
+  for (int f = 0; f < frames; ++f)
+    range_image.createFromPointCloudParallel (frame, resolution_x, resolution_y, pcl::deg2rad (360.0f), max_angle_height,
+                                              sensor_pose, pcl::RangeImage::LASER_FRAME, 0.0f, 0.0f, 0);
+  std::cerr << "ParallelRangeImage::createFromPointCloudParallel: " << tt.toc () / frames << " ms per frame, "
+            << range_image.width << "x" << range_image.height << std::endl;
+
+  // 按数据包逐列写入：每转一圈应当正好触发一次回调，每个有效的点都在图像中
+  std::vector<pcl::PointCloud<PointT>, Eigen::aligned_allocator<pcl::PointCloud<PointT> > > packets ((columns + packet - 1) / packet);
+  for (int p = 0; p < static_cast<int> (packets.size ()); ++p)
+    packets[p].points.assign (frame.points.begin () + p * packet * rings,
+                              frame.points.begin () + std::min (columns, (p + 1) * packet) * rings);
+  pcl::StreamingRangeImage streaming;
+  streaming.setupLidar (columns, rings, pcl::deg2rad (lowest), pcl::deg2rad (highest), sensor_pose);
+  int complete_frames = 0;
+  streaming.registerCallback (boost::bind (&countFrame, _1, &complete_frames));
+  tt.tic ();
+  for (int f = 0; f < frames; ++f)
+    for (size_t p = 0; p < packets.size (); ++p)
+      streaming.addColumns (packets[p]);
+  const double streaming_ms = tt.toc ();
+  std::cerr << "StreamingRangeImage::addColumns:           " << 1000.0 * streaming_ms / (frames * packets.size ())
+            << " us per packet of " << packet << " columns, " << streaming_ms / frames << " ms per frame, "
+            << complete_frames << " frames complete" << std::endl;
+  size_t returns = 0, written = 0;
+  for (size_t i = 0; i < frame.points.size (); ++i)
+    returns += pcl::isFinite (frame.points[i]) ? 1 : 0;
+  for (size_t i = 0; i < streaming.points.size (); ++i)
+    written += pcl_isfinite (streaming.points[i].range) ? 1 : 0;
+  if (complete_frames != frames || written != returns)
+  {
+    std::cerr << "Streaming image incomplete: " << written << " of " << returns << " returns!" << std::endl;
+    return (-1);
+  }
+  if (skip_pcl)
+    return (0);
+
+  // 近似的角度会把正好落在像素边界上的点移到相邻像素，只统计距离相同的像素所占的比例
+  if (range_image.width != reference.width || range_image.height != reference.height)
+  {
+    std::cerr << "Results differ!" << std::endl;
+    return (-1);
+  }
+  size_t valid = 0, same = 0;
+  for (size_t i = 0; i < reference.points.size (); ++i)
+  {
+    const float a = reference.points[i].range, b = range_image.points[i].range;
+    const bool valid_a = pcl_isfinite (a), valid_b = pcl_isfinite (b);
+    valid += valid_a ? 1 : 0;
+    if (valid_a == valid_b && (!valid_a || std::fabs (a - b) <= 1e-5f * a))
+      same += valid_a ? 1 : 0;
+  }
+  std::cerr << same << " of " << valid << " pixels have the same range ("
+            << 100.0 * static_cast<double> (same) / static_cast<double> (std::max<size_t> (valid, 1)) << "%)." << std::endl;
+  return (0);
+}
@@ -1,4 +1,6 @@
 ﻿#include <pcl/range_image/range_image.h>
+#include <string>
+#include "parallel_range_image.h"
 int main(int argc, char** argv) {
   pcl::PointCloud<pcl::PointXYZ> pointCloud;
   //生成数据
@@ -27,9 +29,16 @@ int main(int argc, char** argv) {
   float noiseLevel = 0.00;
   float minRange = 0.0f;
   int borderSize = 1;
-  pcl::RangeImage rangeImage;
-  rangeImage.createFromPointCloud(pointCloud, angularResolution, maxAngleWidth,
-                                  maxAngleHeight, sensorPose, coordinate_frame,
-                                  noiseLevel, minRange, borderSize);
+  //加 -p 参数时多线程创建，除了正好落在像素边界上的点，结果与 createFromPointCloud 相同
+  pcl::ParallelRangeImage rangeImage;
+  if (argc > 1 && std::string(argv[1]) == "-p")
+    rangeImage.createFromPointCloudParallel(
+        pointCloud, angularResolution, maxAngleWidth, maxAngleHeight,
+        sensorPose, coordinate_frame, noiseLevel, minRange, borderSize);
+  else
+    rangeImage.createFromPointCloud(pointCloud, angularResolution,
+                                    maxAngleWidth, maxAngleHeight, sensorPose,
+                                    coordinate_frame, noiseLevel, minRange,
+                                    borderSize);
   std::cout << rangeImage << "\n";
 }
@@ -0,0 +1,326 @@
+/*! \file streaming_range_image.h
+*  Ring-organized range image of a spinning lidar, written column packet by column packet, with a callback for every complete revolution.
+*/
+#ifndef STREAMING_RANGE_IMAGE_H_
+#define STREAMING_RANGE_IMAGE_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/console/print.h>
+#include <pcl/range_image/range_image.h>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief A RangeImage with one column per azimuth step and one row per ring of a spinning lidar,
+    * updated in place while the lidar turns.
+    *
+    * RangeImage::createFromPointCloud needs the whole cloud, so border extraction
+    * or NARF can only start a full revolution after the first column was measured.
+    * Here setupLidar fixes the geometry once (rows ordered from the highest to the
+    * lowest ring) and addColumns writes packets of columns straight into their
+    * pixels:
+    *  - a column goes to the azimuth of its points; the points keep their measured
+    *    position, there is no z-buffer and no recalculation of 3D points;
+    *  - a column is overwritten as a whole, so the image always holds the latest
+    *    revolution, and columns skipped by lost packets are cleared;
+    *  - the FrameCallback is called each time the columns written since the last
+    *    call cover a full revolution, wherever the sweep started and in whichever
+    *    direction the lidar turns.
+    * Between two callbacks the image is a valid RangeImage too, the newest columns
+    * ending at getLastColumn, so consumers can already work on a partial sweep.
+    *
+    * getImagePoint and calculate3DPoint are overridden with the lidar geometry
+    * (equal azimuth steps, ring elevations from the table); the angle helpers that
+    * are not virtual in RangeImage (getAnglesFromImagePoint, ...) see evenly spaced
+    * rows with the mean ring spacing. addColumns and the callback run in the
+    * caller's thread, e.g. the one of the grabber.
+    */
+  class StreamingRangeImage : public RangeImage
+  {
+    public:
+      typedef boost::shared_ptr<StreamingRangeImage> Ptr;
+      typedef boost::shared_ptr<const StreamingRangeImage> ConstPtr;
+      /** \brief Called from addColumns after every full revolution. */
+      typedef boost::function<void (const StreamingRangeImage&)> FrameCallback;
+
+      using RangeImage::getImagePoint;
+      using RangeImage::calculate3DPoint;
+
+      StreamingRangeImage ()
+        : min_range_ (0.0f)
+        , last_column_ (-1)
+        , direction_ (0)
+        , columns_since_frame_ (0)
+        , frames_ (0)
+      {}
+
+      virtual RangeImage*
+      getNew () const { return (new StreamingRangeImage); }
+
+      /** \brief Set the geometry of the lidar and clear the image.
+        * \param[in] columns azimuth steps per revolution, the width of the image
+        * \param[in] ring_elevations elevation of each ring in radians, in the order of the points of a column
+        * \param[in] sensor_pose pose of the lidar in the world
+        * \param[in] coordinate_frame LASER_FRAME for x forward and z up
+        * \param[in] min_range closer returns are ignored
+        */
+      bool
+      setupLidar (int columns, const std::vector<float> &ring_elevations,
+                  const Eigen::Affine3f &sensor_pose = Eigen::Affine3f::Identity (),
+                  CoordinateFrame coordinate_frame = LASER_FRAME, float min_range = 0.0f)
+      {
+        const int rings = static_cast<int> (ring_elevations.size ());
+        if (columns < 1 || rings < 1)
+        {
+          PCL_ERROR ("[pcl::StreamingRangeImage::setupLidar] Need at least one column and one ring!\n");
+          return (false);
+        }
+        // 行按仰角从高到低排列，ring_rows_ 记录每个 ring 所在的行
+        std::vector<std::pair<float, int> > order (rings);
+        for (int r = 0; r < rings; ++r)
+          order[r] = std::make_pair (-ring_elevations[r], r);
+        std::sort (order.begin (), order.end ());
+        ring_rows_.resize (rings);
+        row_elevations_.resize (rings);
+        for (int row = 0; row < rings; ++row)
+        {
+          if (row > 0 && order[row].first == order[row - 1].first)
+          {
+            PCL_ERROR ("[pcl::StreamingRangeImage::setupLidar] Rings %d and %d have the same elevation!\n",
+                       order[row - 1].second, order[row].second);
+            ring_rows_.clear ();
+            return (false);
+          }
+          row_elevations_[row] = -order[row].first;
+          ring_rows_[order[row].second] = row;
+        }
+
+        // 列 x 的方位角为 x * 分辨率 - pi；纵向分辨率取平均线间距，偏移使第 0 行大致对应最高的 ring
+        const float spacing = rings > 1 ? (row_elevations_.front () - row_elevations_.back ()) / static_cast<float> (rings - 1)
+                                        : pcl::deg2rad (1.0f);
+        setAngularResolution (static_cast<float> (2.0 * M_PI) / static_cast<float> (columns), spacing);
+        image_offset_x_ = 0;
+        image_offset_y_ = static_cast<int> (pcl_lrint ((static_cast<float> (0.5 * M_PI) - row_elevations_.front ()) / spacing));
+        getCoordinateFrameTransformation (coordinate_frame, to_world_system_);
+        to_world_system_ = sensor_pose * to_world_system_;
+        to_range_image_system_ = to_world_system_.inverse (Eigen::Isometry);
+        min_range_ = min_range;
+
+        width = columns;
+        height = rings;
+        is_dense = false;
+        clear ();
+        return (true);
+      }
+
+      /** \brief setupLidar with rings evenly spaced from the lowest to the highest elevation, lowest first. */
+      bool
+      setupLidar (int columns, int rings, float lowest_elevation, float highest_elevation,
+                  const Eigen::Affine3f &sensor_pose = Eigen::Affine3f::Identity (),
+                  CoordinateFrame coordinate_frame = LASER_FRAME, float min_range = 0.0f)
+      {
+        std::vector<float> ring_elevations (std::max (rings, 0));
+        for (int r = 0; r < rings; ++r)
+          ring_elevations[r] = rings > 1 ? lowest_elevation + (highest_elevation - lowest_elevation) * r / (rings - 1)
+                                         : lowest_elevation;
+        return (setupLidar (columns, ring_elevations, sensor_pose, coordinate_frame, min_range));
+      }
+
+      /** \brief Set the function called after every full revolution. */
+      inline void
+      registerCallback (const FrameCallback &callback) { callback_ = callback; }
+
+      /** \brief Write a packet of columns into the image.
+        * \param[in] packet getRings () points per column in the order of the ring elevations, column after
+        * column; missing returns are NaN
+        */
+      template <typename PointCloudType> void
+      addColumns (const PointCloudType &packet);
+
+      /** \brief Mark all pixels unobserved and start counting the revolution anew, e.g. after a long gap in the data. */
+      void
+      clear ()
+      {
+        points.assign (static_cast<size_t> (width) * height, unobserved_point);
+        last_column_ = -1;
+        direction_ = 0;
+        columns_since_frame_ = 0;
+      }
+
+      inline int
+      getRings () const { return (static_cast<int> (ring_rows_.size ())); }
+
+      /** \brief Image row of a ring, in the order given to setupLidar. */
+      inline int
+      getRowOfRing (int ring) const { return (ring_rows_[ring]); }
+
+      /** \brief Column written last, -1 before the first column. */
+      inline int
+      getLastColumn () const { return (last_column_); }
+
+      /** \brief Columns written since the last complete revolution. */
+      inline int
+      getColumnsSinceFrame () const { return (columns_since_frame_); }
+
+      /** \brief Number of complete revolutions so far. */
+      inline unsigned int
+      getFrameCount () const { return (frames_); }
+
+      virtual void
+      getImagePoint (const Eigen::Vector3f &point, float &image_x, float &image_y, float &range) const
+      {
+        const Eigen::Vector3f local = to_range_image_system_ * point;
+        range = local.norm ();
+        image_x = (std::atan2 (local[0], local[2]) + static_cast<float> (M_PI)) * angular_resolution_x_reciprocal_;
+        image_y = getImageYFromElevation (range > 0.0f ? -std::asin (local[1] / range) : 0.0f);
+      }
+
+      virtual void
+      calculate3DPoint (float image_x, float image_y, float range, Eigen::Vector3f &point) const
+      {
+        const float angle_x = image_x * angular_resolution_x_ - static_cast<float> (M_PI);
+        const float angle_y = -getElevationFromImageY (image_y);
+        const float cos_y = std::cos (angle_y);
+        point = to_world_system_ * Eigen::Vector3f (range * std::sin (angle_x) * cos_y, range * std::sin (angle_y),
+                                                    range * std::cos (angle_x) * cos_y);
+      }
+
+    protected:
+      /** \brief Row (with fraction) of an elevation, linear between the rings and beyond the outer ones. */
+      float
+      getImageYFromElevation (float elevation) const
+      {
+        const int rings = getRings ();
+        if (rings < 2)
+          return ((row_elevations_.front () - elevation) * angular_resolution_y_reciprocal_);
+        // 行的仰角递减：找到仰角下方的第一行
+        int row = static_cast<int> (std::upper_bound (row_elevations_.begin (), row_elevations_.end (), elevation,
+                                                      std::greater<float> ()) - row_elevations_.begin ());
+        row = (std::min) ((std::max) (row, 1), rings - 1);
+        return (static_cast<float> (row - 1) + (row_elevations_[row - 1] - elevation) / (row_elevations_[row - 1] - row_elevations_[row]));
+      }
+
+      float
+      getElevationFromImageY (float image_y) const
+      {
+        const int rings = getRings ();
+        if (rings < 2)
+          return (row_elevations_.front () - image_y * angular_resolution_y_);
+        const int row = (std::min) ((std::max) (static_cast<int> (std::floor (image_y)), 0), rings - 2);
+        return (row_elevations_[row] + (image_y - static_cast<float> (row)) * (row_elevations_[row + 1] - row_elevations_[row]));
+      }
+
+      inline void
+      clearColumn (int x)
+      {
+        for (unsigned int y = 0; y < height; ++y)
+          points[y * width + x] = unobserved_point;
+      }
+
+      /** \brief Move on to column x: clear it and the columns skipped on the way, count the columns passed.
+        * A column behind the last one (the same azimuth step again, or out of order) is written over without
+        * clearing. Gaps of more than half a revolution look like going backwards; call clear () after them.
+        */
+      void
+      advanceTo (int x)
+      {
+        const int w = static_cast<int> (width);
+        if (last_column_ < 0)
+        {
+          clearColumn (x);
+          last_column_ = x;
+          columns_since_frame_ = 1;
+          return;
+        }
+        // 最短方向上的列差，-w/2 < step <= w/2
+        int step = (x - last_column_ + w) % w;
+        if (step > w / 2)
+          step -= w;
+        if (step == 0)
+          return;
+        if (direction_ == 0)
+          direction_ = step > 0 ? 1 : -1;
+        const int forward = step * direction_;
+        if (forward < 0)
+          return;
+        for (int k = 1; k <= forward; ++k)
+          clearColumn ((last_column_ + k * direction_ + w) % w);
+        last_column_ = x;
+        columns_since_frame_ += forward;
+      }
+
+      float min_range_;
+      std::vector<int> ring_rows_;          // 每个 ring 所在的行
+      std::vector<float> row_elevations_;   // 每行的仰角，从高到低
+      int last_column_;
+      int direction_;                       // 列号递增为 1，递减为 -1，还不知道为 0
+      int columns_since_frame_;
+      unsigned int frames_;
+      FrameCallback callback_;
+  };
+}
+
+template <typename PointCloudType> void
+pcl::StreamingRangeImage::addColumns (const PointCloudType &packet)
+{
+  const int rings = getRings ();
+  if (rings == 0)
+  {
+    PCL_ERROR ("[pcl::StreamingRangeImage::addColumns] Call setupLidar first!\n");
+    return;
+  }
+  const int columns = static_cast<int> (packet.points.size ()) / rings;
+  if (static_cast<int> (packet.points.size ()) != columns * rings)
+    PCL_WARN ("[pcl::StreamingRangeImage::addColumns] %d points are no whole number of columns of %d rings, the rest is ignored!\n",
+              static_cast<int> (packet.points.size ()), rings);
+
+  const Eigen::Vector3f origin = to_world_system_.translation ();
+  const int w = static_cast<int> (width);
+  for (int c = 0; c < columns; ++c)
+  {
+    const typename PointCloudType::PointType *column = &packet.points[c * rings];
+    // 一列的方位角取第一个有效点的；整列缺失时放不进任何一列，下一列到来时它作为空缺被清除
+    int r = 0;
+    while (r < rings && !isFinite (column[r]))
+      ++r;
+    if (r == rings)
+      continue;
+    const Eigen::Vector3f local = to_range_image_system_ * column[r].getVector3fMap ();
+    int x = static_cast<int> (pcl_lrint ((std::atan2 (local[0], local[2]) + static_cast<float> (M_PI)) * angular_resolution_x_reciprocal_));
+    x = (x % w + w) % w;
+    advanceTo (x);
+
+    for (; r < rings; ++r)
+    {
+      const typename PointCloudType::PointType &p = column[r];
+      if (!isFinite (p))
+        continue;
+      const float range = (p.getVector3fMap () - origin).norm ();
+      if (range < min_range_)
+        continue;
+      PointWithRange &pixel = points[ring_rows_[r] * width + x];
+      pixel.x = p.x;
+      pixel.y = p.y;
+      pixel.z = p.z;
+      pixel.range = range;
+    }
+
+    if (columns_since_frame_ >= w)
+    {
+      columns_since_frame_ -= w;
+      ++frames_;
+      if (callback_)
+        callback_ (*this);
+    }
+  }
+}
+
+#endif
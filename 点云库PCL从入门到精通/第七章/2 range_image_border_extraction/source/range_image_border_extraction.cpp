@@ -7,6 +7,7 @@
 #include <pcl/visualization/range_image_visualizer.h>
 #include <boost/thread/thread.hpp>
 #include <iostream>
+#include "parallel_range_image_border_extractor.h"
 typedef pcl::PointXYZ PointType;
 // --------------------
 // -----参数-----
@@ -126,7 +127,7 @@ int main(int argc, char** argv) {
   // -------------------------
   // -----提取边界-----
   // -------------------------
-  pcl::RangeImageBorderExtractor border_extractor(&range_image);
+  pcl::ParallelRangeImageBorderExtractor border_extractor(&range_image);
   pcl::PointCloud<pcl::BorderDescription> border_descriptions;
   border_extractor.compute(border_descriptions);
   // ----------------------------------
@@ -20,16 +20,18 @@
 #include <pcl/console/parse.h>
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/visualization/range_image_visualizer.h>
+#include "streaming_organized_mesh.h"
 using namespace pcl::console;
 int main(int argc, char** argv) {
   // Generate the data
   if (argc < 2) {
     print_error(
         "Syntax is: %s input.pcd -w 640 -h 480 -cx 320 -cy 240 -fx 525 -fy 525 "
-        "-type 0 -size 2\n",
+        "-type 0 -size 2 [-stream]\n",
         argv[0]);
     print_info("  where options are:\n");
     print_info("                     -w X = width of detph iamge ");
+    print_info("                     -stream = mesh depth frames in place\n");
 
     return -1;
   }
@@ -46,6 +48,7 @@ int main(int argc, char** argv) {
   parse_argument(argc, argv, "-fy", fy);
   parse_argument(argc, argv, "-type", type);
   parse_argument(argc, argv, "-size", size);
+  bool stream = find_switch(argc, argv, "-stream");
   // convert unorignized point cloud to orginized point cloud begin
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(
       new pcl::PointCloud<pcl::PointXYZRGB>);
@@ -69,6 +72,38 @@ int main(int argc, char** argv) {
       "点云库PCL从入门到精通");
   range_image_widget.showRangeImage(*rangeImage);
   range_image_widget.setWindowTitle("点云库PCL从入门到精通");
+  if (stream) {
+    // 流式网格：索引缓冲区只建一次，每帧只更新顶点位置和三角形的有效标记
+    typedef pcl::StreamingOrganizedMesh<pcl::PointWithRange> StreamingMesh;
+    if (type > StreamingMesh::TRIANGLE_ADAPTIVE_CUT) {
+      print_warn("-type %d is not supported with -stream, using %d\n", type,
+                 (int)StreamingMesh::TRIANGLE_ADAPTIVE_CUT);
+      type = StreamingMesh::TRIANGLE_ADAPTIVE_CUT;
+    }
+    StreamingMesh mesh;
+    mesh.setup(width, height, size, (StreamingMesh::TriangulationType)type);
+    mesh.update(*rangeImage);
+    pcl::visualization::PCLVisualizer viewer("点云库PCL从入门到精通");
+    viewer.setBackgroundColor(0.5, 0.5, 0.5);
+    mesh.addToViewer(viewer, "tin");
+    viewer.addCoordinateSystem();
+    // 传感器绕自身左右摆动，模拟连续的深度帧；网格原地更新，不再 addPolygonMesh
+    for (int frame = 1;
+         !range_image_widget.wasStopped() && !viewer.wasStopped(); ++frame) {
+      Eigen::Affine3f pose(Eigen::AngleAxisf(0.1f * std::sin(0.05f * frame),
+                                             Eigen::Vector3f::UnitY()));
+      rangeImage->createFromPointCloudWithFixedSize(
+          *cloud, width, height, cx, cy, fx, fy, pose, coordinate_frame);
+      mesh.update(*rangeImage);
+      if (frame % 30 == 0)
+        print_info("mesh update %g ms (average %g ms), %d triangles\n",
+                   mesh.getLastUpdateTime(), mesh.getAverageUpdateTime(),
+                   mesh.getNumberOfValidTriangles());
+      range_image_widget.spinOnce();
+      viewer.spinOnce();
+    }
+    return 0;
+  }
   // triangulation based on range image
   pcl::OrganizedFastMesh<pcl::PointWithRange>::Ptr tri(
       new pcl::OrganizedFastMesh<pcl::PointWithRange>);
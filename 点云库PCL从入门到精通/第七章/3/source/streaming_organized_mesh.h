@@ -0,0 +1,333 @@
+/*! \file streaming_organized_mesh.h
+*  Mesh of an organized cloud (e.g. a RangeImagePlanar) with a fixed index buffer, updated in place for every frame.
+*/
+#ifndef STREAMING_ORGANIZED_MESH_H_
+#define STREAMING_ORGANIZED_MESH_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/common/angles.h>
+#include <pcl/common/time.h>
+#include <pcl/console/print.h>
+#include <pcl/visualization/pcl_visualizer.h>
+#include <vtkVersion.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkProp.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// VTK 9 keeps the cells in offset and connectivity arrays, GetData () no longer writes through to them
+#if VTK_MAJOR_VERSION >= 9
+#error "StreamingOrganizedMesh writes the legacy vtkCellArray layout, which needs VTK 8 or older"
+#endif
+
+namespace pcl
+{
+  /** \brief Triangle mesh of an organized cloud whose topology is fixed by the sensor resolution.
+    *
+    * OrganizedFastMesh builds a new PolygonMesh with a new vector of polygons
+    * for every cloud, and addPolygonMesh a new vtkPolyData from it. For a
+    * stream of frames with the same resolution the possible triangles never
+    * change, only which of them are valid. setup () therefore builds the index
+    * buffer of all candidate triangles once (two per cell of
+    * triangle_pixel_size x triangle_pixel_size pixels, four with the adaptive
+    * cut: both diagonals), together with one vtkPolyData holding a cell for each
+    * candidate. update () only
+    *  - writes the vertex positions into the existing point array (invalid
+    *    pixels go to the origin, which no valid triangle uses),
+    *  - computes the validity mask of the triangles, with the tests of
+    *    OrganizedFastMesh: all three points finite and, unless shadowed faces are
+    *    kept, no edge seen at a grazing angle from the viewpoint (the origin),
+    *  - and collapses the cells of masked triangles onto one vertex, so they
+    *    draw nothing while the number of cells stays the same.
+    * Nothing is allocated per frame, only when the resolution changes.
+    *
+    * The cells are written in the legacy layout of vtkCellArray (count, ids...)
+    * that VTK up to version 8 keeps in GetData (); with VTK 9 the header does
+    * not compile. All calls must be made from the thread that renders the viewer.
+    */
+  template <typename PointT>
+  class StreamingOrganizedMesh
+  {
+    public:
+      typedef boost::shared_ptr<StreamingOrganizedMesh<PointT> > Ptr;
+      typedef boost::shared_ptr<const StreamingOrganizedMesh<PointT> > ConstPtr;
+      typedef pcl::PointCloud<PointT> Cloud;
+
+      /** \brief Same values as OrganizedFastMesh::TriangulationType (without QUAD_MESH). */
+      enum TriangulationType
+      {
+        TRIANGLE_RIGHT_CUT,     // _always_ "cuts" a quad from top left to bottom right
+        TRIANGLE_LEFT_CUT,      // _always_ "cuts" a quad from top right to bottom left
+        TRIANGLE_ADAPTIVE_CUT   // "cuts" where possible and prefers larger differences in 'z' direction
+      };
+
+      StreamingOrganizedMesh ()
+        : width_ (0)
+        , height_ (0)
+        , triangle_pixel_size_ (1)
+        , triangulation_type_ (TRIANGLE_RIGHT_CUT)
+        , cos_angle_tolerance_ (std::fabs (std::cos (pcl::deg2rad (12.5f))))
+        , store_shadowed_faces_ (false)
+        , valid_triangles_ (0)
+        , last_update_ms_ (0.0)
+        , total_update_ms_ (0.0)
+        , updates_ (0)
+      {
+        polydata_ = vtkSmartPointer<vtkPolyData>::New ();
+      }
+
+      /** \brief Build the index buffer and the VTK arrays for the given resolution.
+        * \param[in] width columns of the organized clouds
+        * \param[in] height rows of the organized clouds
+        * \param[in] triangle_pixel_size edge length of the triangles in pixels
+        * \param[in] triangulation_type how each cell is cut into two triangles
+        */
+      void
+      setup (int width, int height, int triangle_pixel_size = 1, TriangulationType triangulation_type = TRIANGLE_RIGHT_CUT)
+      {
+        width_ = (std::max) (width, 0);
+        height_ = (std::max) (height, 0);
+        triangle_pixel_size_ = (std::max) (triangle_pixel_size, 1);
+        triangulation_type_ = triangulation_type;
+
+        // 每个格子的候选三角形，与 OrganizedFastMesh 中的顶点顺序相同
+        index_buffer_.clear ();
+        const int last_column = width_ - triangle_pixel_size_, last_row = height_ - triangle_pixel_size_;
+        for (int y = 0; y < last_row; y += triangle_pixel_size_)
+          for (int x = 0; x < last_column; x += triangle_pixel_size_)
+          {
+            const int i = y * width_ + x;
+            const int index_right = i + triangle_pixel_size_;
+            const int index_down = i + triangle_pixel_size_ * width_;
+            const int index_down_right = index_down + triangle_pixel_size_;
+            if (triangulation_type_ != TRIANGLE_LEFT_CUT)
+            {
+              addTriangle (i, index_down, index_right);
+              addTriangle (index_right, index_down, index_down_right);
+            }
+            if (triangulation_type_ != TRIANGLE_RIGHT_CUT)
+            {
+              addTriangle (i, index_down, index_down_right);
+              addTriangle (i, index_down_right, index_right);
+            }
+          }
+        const int triangles = static_cast<int> (index_buffer_.size () / 3);
+        vertex_valid_.assign (width_ * height_, 0);
+        mask_.assign (triangles, 0);
+        valid_triangles_ = 0;
+
+        points_ = vtkSmartPointer<vtkPoints>::New ();
+        points_->SetDataTypeToFloat ();
+        points_->SetNumberOfPoints (width_ * height_);
+        float *xyz = static_cast<float*> (points_->GetData ()->GetVoidPointer (0));
+        for (int i = 0; i < 3 * width_ * height_; ++i)
+          xyz[i] = 0.0f;
+        polys_ = vtkSmartPointer<vtkCellArray>::New ();
+        for (int t = 0; t < triangles; ++t)
+        {
+          polys_->InsertNextCell (3);
+          for (int k = 0; k < 3; ++k)
+            polys_->InsertCellPoint (index_buffer_[3 * t]);
+        }
+        polydata_->SetPoints (points_);
+        polydata_->SetPolys (polys_);
+        if (prop_)
+          prop_->SetVisibility (0);
+      }
+
+      /** \brief Edges closer than this angle (in rad) to the viewing ray are shadows, default 12.5 deg. */
+      inline void
+      setAngleTolerance (float angle_tolerance) { cos_angle_tolerance_ = std::fabs (std::cos (angle_tolerance)); }
+
+      /** \brief Keep triangles with edges along the viewing rays (default false). */
+      inline void
+      storeShadowedFaces (bool enable) { store_shadowed_faces_ = enable; }
+
+      /** \brief Add the mesh to the viewer as a shape with the given id (use setShapeRenderingProperties for its look). */
+      bool
+      addToViewer (pcl::visualization::PCLVisualizer &viewer, const std::string &id, int viewport = 0)
+      {
+        if (!viewer.addModelFromPolyData (polydata_, id, viewport))
+          return (false);
+        pcl::visualization::ShapeActorMap::iterator it = viewer.getShapeActorMap ()->find (id);
+        if (it != viewer.getShapeActorMap ()->end ())
+          prop_ = it->second;
+        if (prop_)
+          prop_->SetVisibility (valid_triangles_ > 0 ? 1 : 0);
+        return (true);
+      }
+
+      /** \brief Write the points of cloud into the mesh and recompute which triangles are valid.
+        * A cloud with another resolution than the last one calls setup () first.
+        * \return number of valid triangles
+        */
+      int
+      update (const Cloud &cloud)
+      {
+        const double start = pcl::getTime ();
+        if (static_cast<int> (cloud.width) != width_ || static_cast<int> (cloud.height) != height_ || !points_)
+          setup (cloud.width, cloud.height, triangle_pixel_size_, triangulation_type_);
+        if (cloud.points.size () != vertex_valid_.size ())
+        {
+          PCL_ERROR ("[pcl::StreamingOrganizedMesh::update] Cloud is not organized (%d points for %dx%d)!\n",
+                     static_cast<int> (cloud.points.size ()), width_, height_);
+          return (0);
+        }
+
+        // 1. 顶点：无效的像素放到原点
+        float *xyz = static_cast<float*> (points_->GetData ()->GetVoidPointer (0));
+        const int vertices = width_ * height_;
+        for (int i = 0; i < vertices; ++i)
+        {
+          const PointT &p = cloud.points[i];
+          const bool valid = pcl_isfinite (p.x) && pcl_isfinite (p.y) && pcl_isfinite (p.z);
+          vertex_valid_[i] = valid;
+          xyz[3 * i + 0] = valid ? p.x : 0.0f;
+          xyz[3 * i + 1] = valid ? p.y : 0.0f;
+          xyz[3 * i + 2] = valid ? p.z : 0.0f;
+        }
+
+        // 2. 三角形的有效标记
+        const int triangles = static_cast<int> (mask_.size ());
+        if (triangulation_type_ == TRIANGLE_ADAPTIVE_CUT)
+          for (int t = 0; t < triangles; t += 4)
+          {
+            const int *cell = &index_buffer_[3 * t];
+            const int i = cell[0], index_down = cell[1], index_right = cell[2], index_down_right = cell[5];
+            if (vertex_valid_[i] && vertex_valid_[index_down] && vertex_valid_[index_right] && vertex_valid_[index_down_right])
+            {
+              // 四个点都有效时沿 z 差较小的对角线切开
+              const float dist_right_cut = std::fabs (cloud.points[index_down].z - cloud.points[index_right].z);
+              const float dist_left_cut = std::fabs (cloud.points[i].z - cloud.points[index_down_right].z);
+              const int cut = (dist_right_cut >= dist_left_cut ? 2 : 0);
+              for (int k = 0; k < 4; ++k)
+                mask_[t + k] = k >= cut && k < cut + 2 && isVisibleTriangle (cloud, t + k);
+            }
+            else
+              for (int k = 0; k < 4; ++k)
+                mask_[t + k] = isValidTriangle (t + k) && isVisibleTriangle (cloud, t + k);
+          }
+        else
+          for (int t = 0; t < triangles; ++t)
+            mask_[t] = isValidTriangle (t) && isVisibleTriangle (cloud, t);
+
+        // 3. 单元：无效的三角形退化到第一个顶点
+        vtkIdType *cells = polys_->GetData ()->GetPointer (0);
+        int valid_triangles = 0;
+        for (int t = 0; t < triangles; ++t)
+        {
+          const int *triangle = &index_buffer_[3 * t];
+          const bool valid = (mask_[t] != 0);
+          valid_triangles += valid;
+          cells[4 * t + 1] = triangle[0];
+          cells[4 * t + 2] = valid ? triangle[1] : triangle[0];
+          cells[4 * t + 3] = valid ? triangle[2] : triangle[0];
+        }
+        valid_triangles_ = valid_triangles;
+        points_->Modified ();
+        polys_->Modified ();
+        polydata_->Modified ();
+        if (prop_)
+          prop_->SetVisibility (valid_triangles_ > 0 ? 1 : 0);
+
+        last_update_ms_ = (pcl::getTime () - start) * 1000.0;
+        total_update_ms_ += last_update_ms_;
+        ++updates_;
+        return (valid_triangles_);
+      }
+
+      /** \brief All candidate triangles, three point indices each. */
+      inline const std::vector<int>&
+      getIndexBuffer () const { return (index_buffer_); }
+
+      /** \brief One entry per candidate triangle, non-zero if it is part of the mesh after the last update (). */
+      inline const std::vector<unsigned char>&
+      getValidityMask () const { return (mask_); }
+
+      inline int
+      getNumberOfValidTriangles () const { return (valid_triangles_); }
+
+      inline vtkSmartPointer<vtkPolyData>
+      getPolyData () const { return (polydata_); }
+
+      /** \brief Time spent in the last update () in milliseconds. */
+      inline double
+      getLastUpdateTime () const { return (last_update_ms_); }
+
+      /** \brief Mean update () time in milliseconds since the last resetStats (). */
+      inline double
+      getAverageUpdateTime () const { return (updates_ > 0 ? total_update_ms_ / updates_ : 0.0); }
+
+      inline void
+      resetStats () { total_update_ms_ = 0.0; updates_ = 0; }
+
+    private:
+      inline void
+      addTriangle (int a, int b, int c)
+      {
+        index_buffer_.push_back (a);
+        index_buffer_.push_back (b);
+        index_buffer_.push_back (c);
+      }
+
+      inline bool
+      isValidTriangle (int t) const
+      {
+        const int *triangle = &index_buffer_[3 * t];
+        return (vertex_valid_[triangle[0]] && vertex_valid_[triangle[1]] && vertex_valid_[triangle[2]]);
+      }
+
+      /** \brief OrganizedFastMesh::isShadowed without the square roots: |cos| >= tolerance. */
+      inline bool
+      isShadowed (const PointT &point_a, const PointT &point_b) const
+      {
+        const float ax = point_a.x, ay = point_a.y, az = point_a.z;
+        const float bx = point_b.x - ax, by = point_b.y - ay, bz = point_b.z - az;
+        const float dot = -(ax * bx + ay * by + az * bz);
+        const float norms = (ax * ax + ay * ay + az * az) * (bx * bx + by * by + bz * bz);
+        return (dot * dot >= cos_angle_tolerance_ * cos_angle_tolerance_ * norms);
+      }
+
+      inline bool
+      isVisibleTriangle (const Cloud &cloud, int t) const
+      {
+        if (store_shadowed_faces_)
+          return (true);
+        const int *triangle = &index_buffer_[3 * t];
+        const PointT &a = cloud.points[triangle[0]], &b = cloud.points[triangle[1]], &c = cloud.points[triangle[2]];
+        return (!isShadowed (a, b) && !isShadowed (b, c) && !isShadowed (c, a));
+      }
+
+      int width_;
+      int height_;
+      int triangle_pixel_size_;
+      TriangulationType triangulation_type_;
+      float cos_angle_tolerance_;
+      bool store_shadowed_faces_;
+
+      std::vector<int> index_buffer_;
+      std::vector<unsigned char> vertex_valid_;
+      std::vector<unsigned char> mask_;
+      int valid_triangles_;
+
+      vtkSmartPointer<vtkPolyData> polydata_;
+      vtkSmartPointer<vtkPoints> points_;
+      vtkSmartPointer<vtkCellArray> polys_;
+      vtkSmartPointer<vtkProp> prop_;
+
+      double last_update_ms_;
+      double total_update_ms_;
+      size_t updates_;
+  };
+}
+
+#endif
@@ -52,6 +52,7 @@
 #include <vtkImageImport.h>
 #include <vector>
 #include <string>
+#include "updateable_cloud.h"
 
 using namespace std;
 
@@ -89,6 +90,9 @@ class SimpleOpenNIViewer
     SimpleOpenNIViewer (pcl::OpenNIGrabber& grabber)
       : cloud_viewer_ ("PCL OpenNI Viewer")
       , grabber_ (grabber)
+      , cloud_display_ (640 * 480)
+      , cloud_display_added_ (false)
+      , camera_reset_ (false)
 #if !((VTK_MAJOR_VERSION == 5)&&(VTK_MINOR_VERSION <= 4))
       , image_viewer_ ("PCL image viewer")
 #endif
@@ -161,6 +165,37 @@ class SimpleOpenNIViewer
       return (temp_cloud);
     }
 
+    /**
+     * @brief runs in the visualization thread: writes the latest cloud into the VTK arrays in place
+     */
+    void
+    viz_callback (pcl::visualization::PCLVisualizer& viz)
+    {
+      if (!cloud_display_added_)
+        cloud_display_added_ = cloud_display_.addToViewer (viz, "OpenNICloud");
+
+      CloudConstPtr cloud = getLatestCloud ();
+      if (!cloud)
+        return;
+      FPS_CALC ("drawing cloud");
+      cloud_display_.update (*cloud);
+      if (!camera_reset_ && cloud_display_.getSize () > 0)
+      {
+        viz.resetCamera ();
+        camera_reset_ = true;
+      }
+
+      static double last = pcl::getTime ();
+      double now = pcl::getTime ();
+      if (now - last >= 1.0)
+      {
+        std::cout << "Average upload time: " << cloud_display_.getAverageUploadTime () << " ms ("
+                  << cloud_display_.getSize () << " points)" << std::endl;
+        cloud_display_.resetStats ();
+        last = now;
+      }
+    }
+
     /**
      * @brief starts the main loop
      */
@@ -175,6 +210,7 @@ class SimpleOpenNIViewer
       cloud_viewer_.registerKeyboardCallback(&SimpleOpenNIViewer::keyboard_callback, *this, (void*)(&keyMsg3D));
       boost::function<void (const CloudConstPtr&) > cloud_cb = boost::bind (&SimpleOpenNIViewer::cloud_callback, this, _1);
       boost::signals2::connection cloud_connection = grabber_.registerCallback (cloud_cb);
+      cloud_viewer_.runOnVisualizationThread (boost::bind (&SimpleOpenNIViewer::viz_callback, this, _1), "viz_callback");
       
 #if !((VTK_MAJOR_VERSION == 5)&&(VTK_MINOR_VERSION <= 4))
       boost::signals2::connection image_connection;
@@ -195,12 +231,7 @@ class SimpleOpenNIViewer
       
       while (!cloud_viewer_.wasStopped(1))
       {
-        if (cloud_)
-        {
-          FPS_CALC ("drawing cloud");
-          //the call to get() sets the cloud_ to null;
-          cloud_viewer_.showCloud (getLatestCloud ());
-        }
+        // 点云由 viz_callback 在可视化线程中原地更新，不再每帧调用 showCloud
 #if !((VTK_MAJOR_VERSION == 5)&&(VTK_MINOR_VERSION <= 4))        
         if (image_)
         {
@@ -226,6 +257,7 @@ class SimpleOpenNIViewer
       }
 
       grabber_.stop();
+      cloud_viewer_.removeVisualizationCallable ("viz_callback");
       
       cloud_connection.disconnect();
 #if !((VTK_MAJOR_VERSION == 5)&&(VTK_MINOR_VERSION <= 4))      
@@ -239,6 +271,9 @@ class SimpleOpenNIViewer
     pcl::OpenNIGrabber& grabber_;
     boost::mutex cloud_mutex_;
     CloudConstPtr cloud_;
+    pcl::visualization::UpdateableCloud<PointType> cloud_display_;
+    bool cloud_display_added_;
+    bool camera_reset_;
     
 #if !((VTK_MAJOR_VERSION == 5)&&(VTK_MINOR_VERSION <= 4))    
     boost::mutex image_mutex_;
@@ -0,0 +1,217 @@
+/*! \file updateable_cloud.h
+*  Point cloud display for PCLVisualizer whose VTK arrays are allocated once and overwritten in place every frame.
+*/
+#ifndef UPDATEABLE_CLOUD_H_
+#define UPDATEABLE_CLOUD_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/common/time.h>
+#include <pcl/visualization/pcl_visualizer.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkFloatArray.h>
+#include <vtkCellArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkPointData.h>
+#include <vtkProp.h>
+#include <string>
+
+namespace pcl
+{
+  namespace visualization
+  {
+    /** \brief Per-point color of the cloud, false for point types without color. */
+    template <typename PointT> inline bool
+    getUpdateableCloudColor (const PointT &, unsigned char *)
+    {
+      return (false);
+    }
+
+    inline bool
+    getUpdateableCloudColor (const pcl::PointXYZRGB &p, unsigned char *rgb)
+    {
+      rgb[0] = p.r; rgb[1] = p.g; rgb[2] = p.b;
+      return (true);
+    }
+
+    inline bool
+    getUpdateableCloudColor (const pcl::PointXYZRGBA &p, unsigned char *rgb)
+    {
+      rgb[0] = p.r; rgb[1] = p.g; rgb[2] = p.b;
+      return (true);
+    }
+
+    /** \brief A cloud shown in a PCLVisualizer that is updated in place.
+      *
+      * addPointCloud/updatePointCloud (and CloudViewer::showCloud) build a new
+      * vtkPolyData with new point, color and cell arrays for every frame. This
+      * class creates one polydata with fixed-capacity arrays and a single
+      * poly-vertex cell over all slots, once. update() only writes the finite
+      * points into the existing arrays; unused slots repeat the last point, so
+      * the cell never changes. The arrays only grow when a cloud larger than
+      * the capacity arrives.
+      *
+      * All calls must be made from the thread that renders the viewer.
+      */
+    template <typename PointT>
+    class UpdateableCloud
+    {
+      public:
+        typedef pcl::PointCloud<PointT> Cloud;
+
+        /** \brief Constructor.
+          * \param[in] capacity number of points to allocate for, e.g. 640 * 480 for a Kinect
+          */
+        UpdateableCloud (size_t capacity = 0)
+          : capacity_ (0)
+          , size_ (0)
+          , has_color_ (getUpdateableCloudColor (PointT (), color_probe_))
+          , last_upload_ms_ (0.0)
+          , total_upload_ms_ (0.0)
+          , uploads_ (0)
+        {
+          polydata_ = vtkSmartPointer<vtkPolyData>::New ();
+          allocate (capacity);
+        }
+
+        /** \brief Add the cloud to the viewer as a shape with the given id (use the
+          * setShapeRenderingProperties family to change point size or color).
+          */
+        bool
+        addToViewer (PCLVisualizer &viewer, const std::string &id, int viewport = 0)
+        {
+          if (!viewer.addModelFromPolyData (polydata_, id, viewport))
+            return (false);
+          ShapeActorMap::iterator it = viewer.getShapeActorMap ()->find (id);
+          if (it != viewer.getShapeActorMap ()->end ())
+            prop_ = it->second;
+          if (prop_)
+            prop_->SetVisibility (size_ > 0 ? 1 : 0);
+          return (true);
+        }
+
+        /** \brief Copy the finite points of cloud into the VTK arrays.
+          * \return number of points now displayed
+          */
+        size_t
+        update (const Cloud &cloud)
+        {
+          double start = pcl::getTime ();
+          if (cloud.points.size () > capacity_)
+            allocate (cloud.points.size ());
+          if (capacity_ == 0)
+            return (0);
+
+          float *xyz = static_cast<float*> (points_->GetData ()->GetVoidPointer (0));
+          unsigned char *rgb = colors_->GetPointer (0);
+          size_t n = 0;
+          for (size_t i = 0; i < cloud.points.size (); ++i)
+          {
+            const PointT &p = cloud.points[i];
+            if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+              continue;
+            xyz[3 * n + 0] = p.x;
+            xyz[3 * n + 1] = p.y;
+            xyz[3 * n + 2] = p.z;
+            getUpdateableCloudColor (p, rgb + 3 * n);
+            ++n;
+          }
+          // 未用的槽位重复最后一个点，单元数组保持不变
+          for (size_t i = n; n > 0 && i < capacity_; ++i)
+          {
+            xyz[3 * i + 0] = xyz[3 * (n - 1) + 0];
+            xyz[3 * i + 1] = xyz[3 * (n - 1) + 1];
+            xyz[3 * i + 2] = xyz[3 * (n - 1) + 2];
+            rgb[3 * i + 0] = rgb[3 * (n - 1) + 0];
+            rgb[3 * i + 1] = rgb[3 * (n - 1) + 1];
+            rgb[3 * i + 2] = rgb[3 * (n - 1) + 2];
+          }
+          size_ = n;
+          points_->Modified ();
+          if (has_color_)
+            colors_->Modified ();
+          polydata_->Modified ();
+          if (prop_)
+            prop_->SetVisibility (n > 0 ? 1 : 0);
+
+          last_upload_ms_ = (pcl::getTime () - start) * 1000.0;
+          total_upload_ms_ += last_upload_ms_;
+          ++uploads_;
+          return (n);
+        }
+
+        inline size_t
+        getCapacity () const { return (capacity_); }
+
+        /** \brief Number of points shown after the last update. */
+        inline size_t
+        getSize () const { return (size_); }
+
+        /** \brief Time spent in the last update() in milliseconds. */
+        inline double
+        getLastUploadTime () const { return (last_upload_ms_); }
+
+        /** \brief Mean update() time in milliseconds since the last resetStats(). */
+        inline double
+        getAverageUploadTime () const { return (uploads_ > 0 ? total_upload_ms_ / uploads_ : 0.0); }
+
+        inline void
+        resetStats () { total_upload_ms_ = 0.0; uploads_ = 0; }
+
+      private:
+        /** \brief (Re)allocate the arrays in the existing polydata, so the actor keeps working. */
+        void
+        allocate (size_t capacity)
+        {
+          if (capacity == 0)
+            return;
+          capacity_ = capacity;
+          points_ = vtkSmartPointer<vtkPoints>::New ();
+          points_->SetDataTypeToFloat ();
+          points_->SetNumberOfPoints (static_cast<vtkIdType> (capacity));
+          colors_ = vtkSmartPointer<vtkUnsignedCharArray>::New ();
+          colors_->SetNumberOfComponents (3);
+          colors_->SetName ("Colors");
+          colors_->SetNumberOfTuples (static_cast<vtkIdType> (capacity));
+
+          float *xyz = static_cast<float*> (points_->GetData ()->GetVoidPointer (0));
+          unsigned char *rgb = colors_->GetPointer (0);
+          for (size_t i = 0; i < 3 * capacity; ++i)
+          {
+            xyz[i] = 0.0f;
+            rgb[i] = 255;
+          }
+
+          vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New ();
+          verts->InsertNextCell (static_cast<vtkIdType> (capacity));
+          for (vtkIdType i = 0; i < static_cast<vtkIdType> (capacity); ++i)
+            verts->InsertCellPoint (i);
+
+          polydata_->SetPoints (points_);
+          polydata_->SetVerts (verts);
+          if (has_color_)
+            polydata_->GetPointData ()->SetScalars (colors_);
+          size_ = 0;
+        }
+
+        vtkSmartPointer<vtkPolyData> polydata_;
+        vtkSmartPointer<vtkPoints> points_;
+        vtkSmartPointer<vtkUnsignedCharArray> colors_;
+        vtkSmartPointer<vtkProp> prop_;
+
+        size_t capacity_;
+        size_t size_;
+        unsigned char color_probe_[3];
+        bool has_color_;
+
+        double last_upload_ms_;
+        double total_upload_ms_;
+        size_t uploads_;
+    };
+  }
+}
+
+#endif
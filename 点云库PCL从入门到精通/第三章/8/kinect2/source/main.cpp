@@ -5,6 +5,8 @@
 
 #include "kinect2_grabber.h"
 #include <pcl/visualization/pcl_visualizer.h>
+#include <pcl/common/time.h>
+#include "updateable_cloud.h"
 
 typedef pcl::PointXYZRGBA PointType;
 
@@ -18,6 +20,13 @@ int main( int argc, char* argv[] )
     // Point Cloud
     pcl::PointCloud<PointType>::ConstPtr cloud;
 
+    // Display buffer for one Kinect v2 frame (512 x 424), updated in place every frame
+    pcl::visualization::UpdateableCloud<PointType> display( 512 * 424 );
+    display.addToViewer( *viewer, "cloud" );
+    double render_ms = 0.0;
+    size_t frames = 0, spins = 0;
+    double last = pcl::getTime();
+
     // Retrieved Point Cloud Callback Function
     boost::mutex mutex;
     boost::function<void( const pcl::PointCloud<PointType>::ConstPtr& )> function =
@@ -39,14 +48,29 @@ int main( int argc, char* argv[] )
 
     while( !viewer->wasStopped() ){
         // Update Viewer
+        double start = pcl::getTime();
         viewer->spinOnce();
+        render_ms += ( pcl::getTime() - start ) * 1000.0;
+        spins++;
 
         boost::mutex::scoped_try_lock lock( mutex );
         if( lock.owns_lock() && cloud ){
             // Update Point Cloud
-            if( !viewer->updatePointCloud( cloud, "cloud" ) ){
-                viewer->addPointCloud( cloud, "cloud" );
-            }
+            display.update( *cloud );
+            cloud.reset();
+            frames++;
+        }
+
+        // Report per-frame upload (copy into VTK arrays) and render time once per second
+        double now = pcl::getTime();
+        if( now - last >= 1.0 && frames > 0 ){
+            std::cout << frames / ( now - last ) << " Hz, upload " << display.getAverageUploadTime() << " ms, render "
+                      << render_ms / spins << " ms (" << display.getSize() << " points)" << std::endl;
+            display.resetStats();
+            render_ms = 0.0;
+            frames = 0;
+            spins = 0;
+            last = now;
         }
     }
     // Stop Grabber
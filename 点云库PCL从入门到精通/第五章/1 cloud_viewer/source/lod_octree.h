@@ -0,0 +1,573 @@
+/*! \file lod_octree.h
+*  Multi-resolution octree stored on disk and streamed in by camera for out-of-core viewing.
+*/
+#ifndef LOD_OCTREE_H_
+#define LOD_OCTREE_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace pcl
+{
+  namespace lod
+  {
+    /** \brief One node of the level-of-detail octree.
+      * Nodes are named like the path from the root ("r", "r0", "r07", ...) and
+      * hold a grid-subsampled share of the points of their cell; the points of a
+      * node and of all its ancestors together form the cloud at that resolution.
+      */
+    struct LodNodeInfo
+    {
+      LodNodeInfo () : point_count (0), spacing (0), parent (-1), level (0)
+      {
+        std::fill (children, children + 8, -1);
+      }
+
+      std::string name;
+      uint32_t point_count;
+      float spacing;                // 该节点的采样间距（栅格边长）
+      Eigen::Vector3f min_pt;
+      Eigen::Vector3f max_pt;
+      int children[8];
+      int parent;
+      int level;
+    };
+
+    /** \brief Node hierarchy of a LOD octree directory ("index.lod" + one ".bin" file per node). */
+    class LodOctreeIndex
+    {
+      public:
+        /** \brief Write the node table as text, one node per line. */
+        bool
+        save (const std::string &dir) const
+        {
+          std::ofstream out ((dir + "/index.lod").c_str ());
+          if (!out)
+            return (false);
+          out << "LOD_OCTREE 1 " << nodes.size () << "\n";
+          for (size_t i = 0; i < nodes.size (); ++i)
+          {
+            const LodNodeInfo &n = nodes[i];
+            out << n.name << " " << n.point_count << " " << n.spacing << " "
+                << n.min_pt[0] << " " << n.min_pt[1] << " " << n.min_pt[2] << " "
+                << n.max_pt[0] << " " << n.max_pt[1] << " " << n.max_pt[2] << "\n";
+          }
+          return (out.good ());
+        }
+
+        /** \brief Read the node table and rebuild parent/child links from the node names. */
+        bool
+        load (const std::string &dir)
+        {
+          directory = dir;
+          nodes.clear ();
+          std::ifstream in ((dir + "/index.lod").c_str ());
+          std::string magic;
+          int version = 0;
+          size_t count = 0;
+          in >> magic >> version >> count;
+          if (!in || magic != "LOD_OCTREE" || version != 1)
+            return (false);
+          std::map<std::string, int> by_name;
+          nodes.resize (count);
+          for (size_t i = 0; i < count; ++i)
+          {
+            LodNodeInfo &n = nodes[i];
+            in >> n.name >> n.point_count >> n.spacing
+               >> n.min_pt[0] >> n.min_pt[1] >> n.min_pt[2]
+               >> n.max_pt[0] >> n.max_pt[1] >> n.max_pt[2];
+            n.level = static_cast<int> (n.name.size ()) - 1;
+            by_name[n.name] = static_cast<int> (i);
+          }
+          if (!in)
+            return (false);
+          for (size_t i = 0; i < count; ++i)
+          {
+            LodNodeInfo &n = nodes[i];
+            if (n.level == 0)
+              continue;
+            std::map<std::string, int>::const_iterator parent = by_name.find (n.name.substr (0, n.name.size () - 1));
+            if (parent == by_name.end ())
+              return (false);
+            n.parent = parent->second;
+            nodes[n.parent].children[n.name[n.name.size () - 1] - '0'] = static_cast<int> (i);
+          }
+          return (!nodes.empty () && nodes[0].level == 0);
+        }
+
+        inline std::string
+        nodeFile (int node) const { return (directory + "/" + nodes[node].name + ".bin"); }
+
+        uint64_t
+        totalPoints () const
+        {
+          uint64_t total = 0;
+          for (size_t i = 0; i < nodes.size (); ++i)
+            total += nodes[i].point_count;
+          return (total);
+        }
+
+        std::string directory;
+        std::vector<LodNodeInfo> nodes;   // nodes[0] 为根节点
+    };
+
+    /** \brief Read the points of one node file. */
+    template <typename PointT> bool
+    loadLodNode (const std::string &file, pcl::PointCloud<PointT> &cloud)
+    {
+      std::ifstream in (file.c_str (), std::ios::binary);
+      uint32_t count = 0;
+      in.read (reinterpret_cast<char*> (&count), sizeof (count));
+      if (!in)
+        return (false);
+      cloud.points.resize (count);
+      if (count > 0)
+        in.read (reinterpret_cast<char*> (&cloud.points[0]), count * sizeof (PointT));
+      cloud.width = count;
+      cloud.height = 1;
+      cloud.is_dense = true;
+      return (in.good ());
+    }
+
+    /** \brief Builds a LOD octree from a cloud and writes it to a directory.
+      *
+      * Every node keeps at most one point per cell of a grid_size^3 grid laid over
+      * its bounding cube; the remaining points are pushed down to the eight
+      * children. A node with fewer than max_points_per_node points (or at
+      * max_depth) keeps all of them and becomes a leaf.
+      */
+    template <typename PointT>
+    class LodOctreeBuilder
+    {
+      public:
+        typedef pcl::PointCloud<PointT> PointCloud;
+
+        LodOctreeBuilder ()
+          : grid_size_ (128)
+          , max_points_per_node_ (20000)
+          , max_depth_ (20)
+        {
+        }
+
+        /** \brief Cells per axis of the subsampling grid of a node. */
+        inline void
+        setGridSize (int grid_size) { grid_size_ = std::max (grid_size, 2); }
+
+        inline void
+        setMaxPointsPerNode (unsigned int max_points) { max_points_per_node_ = std::max (max_points, 1u); }
+
+        inline void
+        setMaxDepth (int max_depth) { max_depth_ = std::max (max_depth, 0); }
+
+        /** \brief Build the hierarchy and write index.lod plus the node files to dir. */
+        bool
+        build (const PointCloud &cloud, const std::string &dir)
+        {
+          boost::filesystem::create_directories (dir);
+          cloud_ = &cloud;
+          dir_ = dir;
+          index_ = LodOctreeIndex ();
+          index_.directory = dir;
+
+          std::vector<int> indices;
+          indices.reserve (cloud.points.size ());
+          Eigen::Vector3f min_pt = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+          Eigen::Vector3f max_pt = -min_pt;
+          for (size_t i = 0; i < cloud.points.size (); ++i)
+          {
+            const PointT &p = cloud.points[i];
+            if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+              continue;
+            indices.push_back (static_cast<int> (i));
+            min_pt = min_pt.cwiseMin (Eigen::Vector3f (p.x, p.y, p.z));
+            max_pt = max_pt.cwiseMax (Eigen::Vector3f (p.x, p.y, p.z));
+          }
+          if (indices.empty ())
+            return (false);
+          // 八叉树使用立方体包围盒
+          float size = (max_pt - min_pt).maxCoeff () * 1.0001f + 1e-6f;
+          max_pt = min_pt + Eigen::Vector3f::Constant (size);
+
+          cell_stamp_.assign (static_cast<size_t> (grid_size_) * grid_size_ * grid_size_, 0);
+          stamp_ = 0;
+          buildNode ("r", indices, min_pt, max_pt, -1);
+          cell_stamp_.clear ();
+          return (index_.save (dir));
+        }
+
+        inline const LodOctreeIndex&
+        getIndex () const { return (index_); }
+
+      private:
+        int
+        buildNode (const std::string &name, std::vector<int> &indices,
+                   const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt, int parent)
+        {
+          const int node = static_cast<int> (index_.nodes.size ());
+          index_.nodes.push_back (LodNodeInfo ());
+          {
+            LodNodeInfo &info = index_.nodes.back ();
+            info.name = name;
+            info.min_pt = min_pt;
+            info.max_pt = max_pt;
+            info.parent = parent;
+            info.level = static_cast<int> (name.size ()) - 1;
+            info.spacing = (max_pt[0] - min_pt[0]) / grid_size_;
+          }
+          const int level = index_.nodes[node].level;
+
+          std::vector<int> kept;
+          std::vector<int> pushed[8];
+          if (indices.size () <= max_points_per_node_ || level >= max_depth_)
+            kept.swap (indices);
+          else
+          {
+            // 每个栅格只保留第一个点，其余点下放到子节点
+            ++stamp_;
+            const Eigen::Vector3f center = 0.5f * (min_pt + max_pt);
+            const float inv_cell = grid_size_ / (max_pt[0] - min_pt[0]);
+            for (size_t i = 0; i < indices.size (); ++i)
+            {
+              const PointT &p = cloud_->points[indices[i]];
+              int c[3];
+              const float xyz[3] = { p.x, p.y, p.z };
+              for (int d = 0; d < 3; ++d)
+                c[d] = std::min (grid_size_ - 1, std::max (0, static_cast<int> ((xyz[d] - min_pt[d]) * inv_cell)));
+              size_t cell = (static_cast<size_t> (c[2]) * grid_size_ + c[1]) * grid_size_ + c[0];
+              if (cell_stamp_[cell] != stamp_)
+              {
+                cell_stamp_[cell] = stamp_;
+                kept.push_back (indices[i]);
+              }
+              else
+              {
+                int child = (p.x >= center[0] ? 1 : 0) | (p.y >= center[1] ? 2 : 0) | (p.z >= center[2] ? 4 : 0);
+                pushed[child].push_back (indices[i]);
+              }
+            }
+            std::vector<int> ().swap (indices);
+          }
+
+          writeNode (name, kept);
+          index_.nodes[node].point_count = static_cast<uint32_t> (kept.size ());
+          std::vector<int> ().swap (kept);
+
+          const Eigen::Vector3f half = 0.5f * (max_pt - min_pt);
+          for (int child = 0; child < 8; ++child)
+          {
+            if (pushed[child].empty ())
+              continue;
+            Eigen::Vector3f child_min = min_pt;
+            if (child & 1) child_min[0] += half[0];
+            if (child & 2) child_min[1] += half[1];
+            if (child & 4) child_min[2] += half[2];
+            std::ostringstream child_name;
+            child_name << name << child;
+            int c = buildNode (child_name.str (), pushed[child], child_min, child_min + half, node);
+            index_.nodes[node].children[child] = c;
+          }
+          return (node);
+        }
+
+        void
+        writeNode (const std::string &name, const std::vector<int> &indices)
+        {
+          std::ofstream out ((dir_ + "/" + name + ".bin").c_str (), std::ios::binary);
+          uint32_t count = static_cast<uint32_t> (indices.size ());
+          out.write (reinterpret_cast<const char*> (&count), sizeof (count));
+          for (size_t i = 0; i < indices.size (); ++i)
+            out.write (reinterpret_cast<const char*> (&cloud_->points[indices[i]]), sizeof (PointT));
+        }
+
+        int grid_size_;
+        unsigned int max_points_per_node_;
+        int max_depth_;
+
+        const PointCloud *cloud_;
+        std::string dir_;
+        LodOctreeIndex index_;
+        std::vector<uint32_t> cell_stamp_;
+        uint32_t stamp_;
+    };
+
+    /** \brief View parameters used to pick the nodes to draw. */
+    struct LodView
+    {
+      /** \brief Set up from a camera description as used by pcl::visualization::Camera.
+        * \param[in] pos camera position
+        * \param[in] focal focal point
+        * \param[in] view_up up vector
+        * \param[in] fovy vertical field of view in radians
+        * \param[in] width, height window size in pixels
+        */
+      void
+      set (const Eigen::Vector3d &pos, const Eigen::Vector3d &focal, const Eigen::Vector3d &view_up,
+           double fovy, int width, int height)
+      {
+        eye = pos;
+        Eigen::Vector3d forward = (focal - pos).normalized ();
+        Eigen::Vector3d up = (view_up - view_up.dot (forward) * forward).normalized ();
+        Eigen::Vector3d right = forward.cross (up);
+        double tan_y = std::tan (0.5 * fovy);
+        double tan_x = tan_y * width / std::max (height, 1);
+        // 侧面与近平面，法向指向视锥内部；远平面由 VTK 自动调整，不参与裁剪
+        Eigen::Vector3d normals[5] = { forward * tan_x + right, forward * tan_x - right,
+                                       forward * tan_y + up, forward * tan_y - up, forward };
+        for (int i = 0; i < 5; ++i)
+        {
+          planes[i].head<3> () = normals[i];
+          planes[i][3] = -normals[i].dot (pos);
+        }
+        pixels_per_radian = 0.5 * height / tan_y;
+      }
+
+      /** \brief false if the box lies completely outside one of the frustum planes. */
+      bool
+      intersects (const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt) const
+      {
+        for (int i = 0; i < 5; ++i)
+        {
+          Eigen::Vector3d p;
+          for (int d = 0; d < 3; ++d)
+            p[d] = planes[i][d] >= 0 ? max_pt[d] : min_pt[d];
+          if (planes[i].head<3> ().dot (p) + planes[i][3] < 0)
+            return (false);
+        }
+        return (true);
+      }
+
+      /** \brief Projected size of the node spacing in pixels. */
+      double
+      screenSpaceError (const LodNodeInfo &node) const
+      {
+        Eigen::Vector3d center = (0.5f * (node.min_pt + node.max_pt)).cast<double> ();
+        double radius = 0.5 * (node.max_pt - node.min_pt).cast<double> ().norm ();
+        double distance = std::max ((center - eye).norm () - radius, 1e-3);
+        return (node.spacing * pixels_per_radian / distance);
+      }
+
+      Eigen::Vector3d eye;
+      Eigen::Vector4d planes[5];
+      double pixels_per_radian;
+    };
+
+    /** \brief Pick the nodes to draw, most important first.
+      * A node is refined into its children while it is in the frustum and its
+      * projected spacing is larger than max_sse pixels; selection stops at the
+      * point budget. Since the LOD is additive, every selected node's ancestors are selected too.
+      */
+    inline void
+    selectLodNodes (const LodOctreeIndex &index, const LodView &view, double max_sse,
+                    uint64_t point_budget, std::vector<int> &selected)
+    {
+      selected.clear ();
+      if (index.nodes.empty ())
+        return;
+      std::priority_queue<std::pair<double, int> > queue;
+      queue.push (std::make_pair (std::numeric_limits<double>::max (), 0));
+      uint64_t points = 0;
+      while (!queue.empty ())
+      {
+        int node = queue.top ().second;
+        queue.pop ();
+        const LodNodeInfo &info = index.nodes[node];
+        if (points + info.point_count > point_budget && !selected.empty ())
+          break;
+        selected.push_back (node);
+        points += info.point_count;
+        if (view.screenSpaceError (info) <= max_sse)
+          continue;
+        for (int c = 0; c < 8; ++c)
+        {
+          int child = info.children[c];
+          if (child < 0)
+            continue;
+          const LodNodeInfo &child_info = index.nodes[child];
+          if (view.intersects (child_info.min_pt, child_info.max_pt))
+            queue.push (std::make_pair (view.screenSpaceError (child_info), child));
+        }
+      }
+    }
+
+    /** \brief Keeps node point clouds in memory under a point budget and loads
+      * requested nodes on background threads. Nodes that have not been requested
+      * for the longest time are evicted first.
+      */
+    template <typename PointT>
+    class LodNodeCache
+    {
+      public:
+        typedef pcl::PointCloud<PointT> PointCloud;
+        typedef typename PointCloud::Ptr PointCloudPtr;
+        typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+        LodNodeCache (const LodOctreeIndex &index, uint64_t memory_budget_points, unsigned int threads = 2)
+          : index_ (index)
+          , budget_ (memory_budget_points)
+          , loaded_points_ (0)
+          , reserved_points_ (0)
+          , frame_ (0)
+          , running_ (true)
+        {
+          for (unsigned int t = 0; t < std::max (threads, 1u); ++t)
+            workers_.push_back (boost::shared_ptr<boost::thread> (
+              new boost::thread (boost::bind (&LodNodeCache::loadLoop, this))));
+        }
+
+        ~LodNodeCache ()
+        {
+          {
+            boost::mutex::scoped_lock lock (mutex_);
+            running_ = false;
+          }
+          condition_.notify_all ();
+          for (size_t t = 0; t < workers_.size (); ++t)
+            workers_[t]->join ();
+        }
+
+        /** \brief Replace the load queue with the nodes of this frame (highest priority
+          * first) and evict unused nodes if the cache is over budget.
+          */
+        void
+        request (const std::vector<int> &nodes)
+        {
+          {
+            boost::mutex::scoped_lock lock (mutex_);
+            ++frame_;
+            queue_.clear ();
+            for (size_t i = 0; i < nodes.size (); ++i)
+            {
+              last_used_[nodes[i]] = frame_;
+              if (loaded_.find (nodes[i]) == loaded_.end () && loading_.find (nodes[i]) == loading_.end ())
+                queue_.push_back (nodes[i]);
+            }
+            evict (budget_ - std::min (budget_, reserved_points_));
+          }
+          condition_.notify_all ();
+        }
+
+        /** \brief Points of a node, or an empty pointer while it is not loaded yet. */
+        PointCloudConstPtr
+        get (int node)
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          typename std::map<int, PointCloudPtr>::const_iterator it = loaded_.find (node);
+          return (it == loaded_.end () ? PointCloudConstPtr () : PointCloudConstPtr (it->second));
+        }
+
+        uint64_t
+        getLoadedPoints ()
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          return (loaded_points_);
+        }
+
+        size_t
+        getPendingCount ()
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          return (queue_.size () + loading_.size ());
+        }
+
+      private:
+        /** \brief Drop least recently requested nodes of earlier frames until at most
+          * target points are loaded (mutex held).
+          */
+        void
+        evict (uint64_t target)
+        {
+          if (loaded_points_ <= target)
+            return;
+          std::vector<std::pair<uint64_t, int> > candidates;
+          for (typename std::map<int, PointCloudPtr>::const_iterator it = loaded_.begin (); it != loaded_.end (); ++it)
+            if (last_used_[it->first] != frame_)
+              candidates.push_back (std::make_pair (last_used_[it->first], it->first));
+          std::sort (candidates.begin (), candidates.end ());
+          for (size_t i = 0; i < candidates.size () && loaded_points_ > target; ++i)
+          {
+            typename std::map<int, PointCloudPtr>::iterator it = loaded_.find (candidates[i].second);
+            loaded_points_ -= it->second->points.size ();
+            loaded_.erase (it);
+          }
+        }
+
+        void
+        loadLoop ()
+        {
+          for (;;)
+          {
+            int node;
+            {
+              boost::mutex::scoped_lock lock (mutex_);
+              while (running_ && queue_.empty ())
+                condition_.wait (lock);
+              if (!running_)
+                return;
+              node = queue_.front ();
+              queue_.pop_front ();
+              // 正在加载的节点已按点数预留了预算；缓存已满且无法再淘汰时，不再加载本帧优先级更低的节点
+              const uint64_t needed = reserved_points_ + index_.nodes[node].point_count;
+              if (loaded_points_ + needed > budget_)
+                evict (budget_ - std::min (budget_, needed));
+              if (loaded_points_ + needed > budget_)
+              {
+                queue_.clear ();
+                continue;
+              }
+              loading_.insert (node);
+              reserved_points_ = needed;
+            }
+            PointCloudPtr cloud (new PointCloud);
+            bool ok = loadLodNode (index_.nodeFile (node), *cloud);
+            {
+              boost::mutex::scoped_lock lock (mutex_);
+              loading_.erase (node);
+              reserved_points_ -= index_.nodes[node].point_count;
+              if (ok)
+              {
+                loaded_[node] = cloud;
+                loaded_points_ += cloud->points.size ();
+              }
+            }
+          }
+        }
+
+        const LodOctreeIndex &index_;
+        uint64_t budget_;
+        uint64_t loaded_points_;
+        uint64_t reserved_points_;   // 正在加载的节点的点数
+        uint64_t frame_;
+        bool running_;
+
+        std::map<int, PointCloudPtr> loaded_;
+        std::map<int, uint64_t> last_used_;
+        std::set<int> loading_;
+        std::deque<int> queue_;
+
+        boost::mutex mutex_;
+        boost::condition_variable condition_;
+        std::vector<boost::shared_ptr<boost::thread> > workers_;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,49 @@
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <iostream>
+#include "lod_octree.h"
+
+typedef pcl::PointXYZRGB PointT;
+using namespace pcl::console;
+
+int
+main (int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::cout << argv[0] << " input.pcd output_dir -g grid_size -m max_points_per_node -d max_depth" << std::endl;
+    return (0);
+  }
+  int grid_size = 128, max_points = 20000, max_depth = 20;
+  parse_argument (argc, argv, "-g", grid_size);
+  parse_argument (argc, argv, "-m", max_points);
+  parse_argument (argc, argv, "-d", max_depth);
+
+  TicToc tt;
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  std::cerr << "Loading...\n", tt.tic ();
+  if (pcl::io::loadPCDFile (argv[1], *cloud) < 0)
+    return (-1);
+  std::cerr << ">> Done: " << tt.toc () << " ms, " << cloud->points.size () << " points\n";
+
+  // 构建多分辨率八叉树，每个节点的点写入单独的文件
+  std::cerr << "Building LOD octree...\n", tt.tic ();
+  pcl::lod::LodOctreeBuilder<PointT> builder;
+  builder.setGridSize (grid_size);
+  builder.setMaxPointsPerNode (max_points);
+  builder.setMaxDepth (max_depth);
+  if (!builder.build (*cloud, argv[2]))
+  {
+    std::cerr << "Could not write " << argv[2] << std::endl;
+    return (-1);
+  }
+  const pcl::lod::LodOctreeIndex &index = builder.getIndex ();
+  int depth = 0;
+  for (size_t i = 0; i < index.nodes.size (); ++i)
+    depth = std::max (depth, index.nodes[i].level);
+  std::cerr << ">> Done: " << tt.toc () << " ms, " << index.nodes.size () << " nodes, depth "
+            << depth << ", " << index.totalPoints () << " points written to " << argv[2] << "\n";
+  return (0);
+}
@@ -0,0 +1,118 @@
+#include <pcl/point_types.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <pcl/visualization/pcl_visualizer.h>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include "lod_octree.h"
+
+typedef pcl::PointXYZRGB PointT;
+using namespace pcl::console;
+
+int
+main (int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cout << argv[0] << " lod_dir -sse max_pixel_error -budget points_drawn -memory points_cached"
+              << " -threads loader_threads -uploads nodes_per_frame" << std::endl;
+    return (0);
+  }
+  double max_sse = 2.0;
+  int point_budget = 3000000, memory_budget = 10000000, threads = 2, max_uploads = 16;
+  parse_argument (argc, argv, "-sse", max_sse);
+  parse_argument (argc, argv, "-budget", point_budget);
+  parse_argument (argc, argv, "-memory", memory_budget);
+  parse_argument (argc, argv, "-threads", threads);
+  parse_argument (argc, argv, "-uploads", max_uploads);
+
+  pcl::lod::LodOctreeIndex index;
+  if (!index.load (argv[1]))
+  {
+    std::cerr << "Could not read " << argv[1] << "/index.lod" << std::endl;
+    return (-1);
+  }
+  std::cout << index.nodes.size () << " nodes, " << index.totalPoints () << " points" << std::endl;
+  // 后台线程按优先级加载节点，内存中最多保留 memory_budget 个点
+  pcl::lod::LodNodeCache<PointT> cache (index, memory_budget, threads);
+
+  pcl::visualization::PCLVisualizer viewer ("LOD Viewer");
+  viewer.setBackgroundColor (0, 0, 0);
+  const pcl::lod::LodNodeInfo &root = index.nodes[0];
+  Eigen::Vector3f center = 0.5f * (root.min_pt + root.max_pt);
+  float size = root.max_pt[0] - root.min_pt[0];
+  viewer.setCameraPosition (center[0], center[1], center[2] - 1.5 * size, center[0], center[1], center[2], 0, -1, 0);
+  viewer.addText ("", 10, 10, "lod_stats");
+
+  std::set<int> displayed;
+  std::vector<int> selected;
+  std::vector<pcl::visualization::Camera> cameras;
+  pcl::lod::LodView view;
+  TicToc tt;
+  double frame_ms = 0;
+  int frame = 0;
+  while (!viewer.wasStopped ())
+  {
+    tt.tic ();
+    viewer.getCameras (cameras);
+    const pcl::visualization::Camera &cam = cameras[0];
+    view.set (Eigen::Vector3d (cam.pos[0], cam.pos[1], cam.pos[2]),
+              Eigen::Vector3d (cam.focal[0], cam.focal[1], cam.focal[2]),
+              Eigen::Vector3d (cam.view[0], cam.view[1], cam.view[2]),
+              cam.fovy, static_cast<int> (cam.window_size[0]), static_cast<int> (cam.window_size[1]));
+
+    // 按视锥和屏幕空间误差选择节点，并交给加载线程
+    pcl::lod::selectLodNodes (index, view, max_sse, point_budget, selected);
+    cache.request (selected);
+
+    // 移除不再需要的节点，按优先级上传已加载的新节点（每帧限量，保证交互帧率）
+    std::set<int> wanted (selected.begin (), selected.end ());
+    for (std::set<int>::iterator it = displayed.begin (); it != displayed.end (); )
+    {
+      if (wanted.count (*it) == 0)
+      {
+        std::ostringstream id;
+        id << "lod_" << *it;
+        viewer.removePointCloud (id.str ());
+        displayed.erase (it++);
+      }
+      else
+        ++it;
+    }
+    int uploads = 0;
+    uint64_t drawn = 0;
+    for (size_t i = 0; i < selected.size (); ++i)
+    {
+      int node = selected[i];
+      if (displayed.count (node))
+      {
+        drawn += index.nodes[node].point_count;
+        continue;
+      }
+      if (uploads >= max_uploads)
+        continue;
+      pcl::PointCloud<PointT>::ConstPtr cloud = cache.get (node);
+      if (!cloud)
+        continue;
+      std::ostringstream id;
+      id << "lod_" << node;
+      pcl::visualization::PointCloudColorHandlerRGBField<PointT> rgb (cloud);
+      viewer.addPointCloud<PointT> (cloud, rgb, id.str ());
+      displayed.insert (node);
+      drawn += cloud->points.size ();
+      ++uploads;
+    }
+
+    viewer.spinOnce (1);
+    frame_ms = 0.9 * frame_ms + 0.1 * tt.toc ();
+    if (++frame % 10 == 0)
+    {
+      std::ostringstream stats;
+      stats << "frame " << static_cast<int> (frame_ms) << " ms | nodes " << displayed.size () << "/" << selected.size ()
+            << " | drawn " << drawn << " | cached " << cache.getLoadedPoints () << " | pending " << cache.getPendingCount ();
+      viewer.updateText (stats.str (), 10, 10, "lod_stats");
+    }
+  }
+  return (0);
+}
@@ -0,0 +1,248 @@
+/*! \file offscreen_render.h
+*  Offscreen rendering, scripted camera paths and frame/memory statistics for benchmarking the visualizers without a window.
+*/
+#ifndef OFFSCREEN_RENDER_H_
+#define OFFSCREEN_RENDER_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/common/time.h>
+#include <pcl/visualization/pcl_visualizer.h>
+#include <vtkRenderWindow.h>
+#include <vtkWindowToImageFilter.h>
+#include <vtkPNGWriter.h>
+#include <vtkSmartPointer.h>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+  namespace visualization
+  {
+    /** \brief Switch a render window to offscreen rendering with a fixed size.
+      *
+      * Without a GPU or X server VTK has to be built with OSMesa (VTK_OPENGL_HAS_OSMESA)
+      * or EGL; alternatively run the program under xvfb-run with Mesa's software renderer.
+      */
+    inline void
+    setupOffscreen (vtkRenderWindow *window, int width, int height)
+    {
+      window->SetOffScreenRendering (1);
+      window->SetSize (width, height);
+    }
+
+    /** \brief Render one frame and wait until it is finished.
+      * Reading back one depth value forces the driver to complete the frame, so the
+      * time includes buffer uploads and drawing, not only queueing the commands.
+      * \return frame time in milliseconds
+      */
+    inline double
+    renderSynchronous (vtkRenderWindow *window)
+    {
+      double start = pcl::getTime ();
+      window->Render ();
+      window->GetZbufferDataAtPoint (0, 0);
+      return ((pcl::getTime () - start) * 1000.0);
+    }
+
+    /** \brief Save the current content of the render window as PNG. */
+    inline void
+    saveWindowImage (vtkRenderWindow *window, const std::string &file)
+    {
+      vtkSmartPointer<vtkWindowToImageFilter> filter = vtkSmartPointer<vtkWindowToImageFilter>::New ();
+      filter->SetInput (window);
+      filter->Update ();
+      vtkSmartPointer<vtkPNGWriter> writer = vtkSmartPointer<vtkPNGWriter>::New ();
+      writer->SetFileName (file.c_str ());
+      writer->SetInputConnection (filter->GetOutputPort ());
+      writer->Write ();
+    }
+
+    /** \brief Resident and peak resident memory of this process in bytes (Linux, /proc/self/status).
+      * \return false if the values are not available
+      */
+    inline bool
+    getMemoryUsage (size_t &rss, size_t &peak_rss)
+    {
+      rss = peak_rss = 0;
+      std::ifstream status ("/proc/self/status");
+      std::string line;
+      while (std::getline (status, line))
+      {
+        std::istringstream ss (line);
+        std::string key;
+        size_t kb = 0;
+        ss >> key >> kb;
+        if (key == "VmRSS:")
+          rss = kb * 1024;
+        else if (key == "VmHWM:")
+          peak_rss = kb * 1024;
+      }
+      return (rss > 0);
+    }
+
+    /** \brief One camera pose: position, focal point and view up vector. */
+    struct CameraPose
+    {
+      Eigen::Vector3f pos;
+      Eigen::Vector3f focal;
+      Eigen::Vector3f up;
+    };
+
+    /** \brief A scripted camera path made of key poses, sampled at a fixed number of frames.
+      *
+      * Paths are either generated (orbit, fly-through) or read from a text file with one
+      * key pose per line: "px py pz fx fy fz ux uy uz"; empty lines and lines starting
+      * with '#' are ignored.
+      */
+    class CameraPath
+    {
+      public:
+        /** \brief Circle around center at the given radius and height above it. */
+        static CameraPath
+        orbit (const Eigen::Vector3f &center, float radius, float height, int keys = 36)
+        {
+          CameraPath path;
+          for (int i = 0; i <= keys; ++i)
+          {
+            float a = 2.0f * static_cast<float> (M_PI) * i / keys;
+            CameraPose p;
+            p.pos = center + Eigen::Vector3f (radius * std::cos (a), radius * std::sin (a), height);
+            p.focal = center;
+            p.up = Eigen::Vector3f::UnitZ ();
+            path.keys_.push_back (p);
+          }
+          return (path);
+        }
+
+        /** \brief Fly low along the diagonal of a bounding box, looking ahead. */
+        static CameraPath
+        flyThrough (const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt)
+        {
+          CameraPath path;
+          Eigen::Vector3f diag = max_pt - min_pt;
+          float height = max_pt.z () + 0.05f * diag.head<2> ().norm ();
+          for (int i = 0; i <= 10; ++i)
+          {
+            float t = 0.1f * i;
+            CameraPose p;
+            p.pos = min_pt + t * diag;
+            p.pos.z () = height;
+            p.focal = p.pos + 0.1f * diag;
+            p.focal.z () = min_pt.z () + 0.5f * diag.z ();
+            p.up = Eigen::Vector3f::UnitZ ();
+            path.keys_.push_back (p);
+          }
+          return (path);
+        }
+
+        /** \brief Read key poses from a text file. */
+        bool
+        load (const std::string &file)
+        {
+          std::ifstream in (file.c_str ());
+          if (!in)
+            return (false);
+          keys_.clear ();
+          std::string line;
+          while (std::getline (in, line))
+          {
+            if (line.empty () || line[0] == '#')
+              continue;
+            std::istringstream ss (line);
+            CameraPose p;
+            if (ss >> p.pos[0] >> p.pos[1] >> p.pos[2] >> p.focal[0] >> p.focal[1] >> p.focal[2] >> p.up[0] >> p.up[1] >> p.up[2])
+              keys_.push_back (p);
+          }
+          return (!keys_.empty ());
+        }
+
+        inline bool
+        empty () const { return (keys_.empty ()); }
+
+        /** \brief Pose of frame i out of frames, linearly interpolated between the key poses. */
+        CameraPose
+        sample (int i, int frames) const
+        {
+          if (keys_.size () == 1 || frames <= 1)
+            return (keys_.front ());
+          float t = static_cast<float> (i) / (frames - 1) * (keys_.size () - 1);
+          size_t k = std::min (static_cast<size_t> (t), keys_.size () - 2);
+          float f = t - k;
+          CameraPose p;
+          p.pos = (1.0f - f) * keys_[k].pos + f * keys_[k + 1].pos;
+          p.focal = (1.0f - f) * keys_[k].focal + f * keys_[k + 1].focal;
+          p.up = ((1.0f - f) * keys_[k].up + f * keys_[k + 1].up).normalized ();
+          return (p);
+        }
+
+        /** \brief Move the viewer camera to frame i out of frames. */
+        void
+        apply (PCLVisualizer &viewer, int i, int frames) const
+        {
+          CameraPose p = sample (i, frames);
+          viewer.setCameraPosition (p.pos[0], p.pos[1], p.pos[2], p.focal[0], p.focal[1], p.focal[2],
+                                    p.up[0], p.up[1], p.up[2]);
+        }
+
+      private:
+        std::vector<CameraPose> keys_;
+    };
+
+    /** \brief Frame time statistics in milliseconds. */
+    class FrameTimes
+    {
+      public:
+        inline void
+        add (double ms) { times_.push_back (ms); }
+
+        inline void
+        clear () { times_.clear (); }
+
+        inline size_t
+        size () const { return (times_.size ()); }
+
+        double
+        mean () const
+        {
+          double sum = 0.0;
+          for (size_t i = 0; i < times_.size (); ++i)
+            sum += times_[i];
+          return (times_.empty () ? 0.0 : sum / times_.size ());
+        }
+
+        /** \brief Percentile p in [0, 100] (nearest rank). */
+        double
+        percentile (double p) const
+        {
+          if (times_.empty ())
+            return (0.0);
+          std::vector<double> sorted (times_);
+          std::sort (sorted.begin (), sorted.end ());
+          size_t rank = static_cast<size_t> (std::ceil (p / 100.0 * sorted.size ()));
+          return (sorted[std::min (std::max<size_t> (rank, 1), sorted.size ()) - 1]);
+        }
+
+        /** \brief "mean 12.3 ms, p50 ..., p95 ..., max ..., 81.3 fps" */
+        std::string
+        summary () const
+        {
+          char buf[256];
+          double m = mean ();
+          sprintf (buf, "mean %.2f ms, p50 %.2f ms, p95 %.2f ms, max %.2f ms, %.1f fps",
+                   m, percentile (50), percentile (95), percentile (100), m > 0.0 ? 1000.0 / m : 0.0);
+          return (std::string (buf));
+        }
+
+      private:
+        std::vector<double> times_;
+    };
+  }
+}
+
+#endif
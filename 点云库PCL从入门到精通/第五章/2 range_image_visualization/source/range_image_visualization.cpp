@@ -4,8 +4,12 @@
 #include <pcl/range_image/range_image.h>
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/visualization/range_image_visualizer.h>
+#include <boost/bind.hpp>
 #include <boost/thread/thread.hpp>
 #include <iostream>
+#include <limits>
+#include "offscreen_render.h"
+#include "streaming_range_image.h"
 
 typedef pcl::PointXYZ PointType;
 // 全局参数
@@ -13,6 +17,12 @@ float angular_resolution = 0.5f;
 pcl::RangeImage::CoordinateFrame coordinate_frame =
     pcl::RangeImage::CAMERA_FRAME;
 bool live_update = false;
+bool offscreen = false;
+int offscreen_frames = 120;
+std::string png_file;
+bool stream = false;
+int stream_packet = 32;
+bool frame_complete = false;
 // -----打印帮助-----
 void printUsage(const char* progName) {
   std::cout << "\n\nUsage: " << progName << " [options] <scene.pcd>\n\n"
@@ -24,6 +34,11 @@ void printUsage(const char* progName) {
             << (int)coordinate_frame << ")\n"
             << "-l           live update - update the range image according to "
                "the selected view in the 3D viewer.\n"
+            << "-offscreen <frames>  render <frames> frames of an orbit around the scene\n"
+            << "             without a window and print frame times (default 120)\n"
+            << "-png <file>  with -offscreen: save the last frame\n"
+            << "-stream <columns>  replay the scene as a spinning lidar, <columns>\n"
+            << "             columns per packet (default " << stream_packet << ")\n"
             << "-h           this help\n"
             << "\n\n";
 }
@@ -53,6 +68,49 @@ void setViewerPose(pcl::visualization::PCLVisualizer& viewer,
   viewer.updateCamera();
 }
 
+// 把场景按虚拟激光雷达重新采样：每个像素取最近的点，一列接一列存放，
+// 每列 getRings() 个点（按 ring 的顺序），缺失的点为 NaN
+void resampleAsLidar(const pcl::PointCloud<PointType>& point_cloud,
+                     const pcl::StreamingRangeImage& lidar,
+                     pcl::PointCloud<PointType>& columns) {
+  const int rings = lidar.getRings();
+  std::vector<int> ring_of_row(rings);
+  for (int r = 0; r < rings; ++r) ring_of_row[lidar.getRowOfRing(r)] = r;
+  PointType missing;
+  missing.x = missing.y = missing.z = std::numeric_limits<float>::quiet_NaN();
+  columns.points.assign(lidar.width * rings, missing);
+  std::vector<float> nearest(columns.points.size(),
+                             std::numeric_limits<float>::infinity());
+  for (size_t i = 0; i < point_cloud.points.size(); ++i) {
+    const PointType& point = point_cloud.points[i];
+    if (!pcl::isFinite(point)) continue;
+    int x, y;
+    float range;
+    lidar.getImagePoint(point.getVector3fMap(), x, y, range);
+    if (x == (int)lidar.width) x = 0;
+    if (!lidar.isInImage(x, y)) continue;
+    const int index = x * rings + ring_of_row[y];
+    if (range < nearest[index]) {
+      nearest[index] = range;
+      columns.points[index] = point;
+    }
+  }
+}
+
+void frameComplete(const pcl::StreamingRangeImage&) { frame_complete = true; }
+
+// 送入从 next_column 开始的 stream_packet 列，到最后一列后从头重放
+void feedPacket(const pcl::PointCloud<PointType>& columns,
+                pcl::StreamingRangeImage& lidar, int& next_column) {
+  const int rings = lidar.getRings();
+  const int count = std::min(stream_packet, (int)lidar.width - next_column);
+  pcl::PointCloud<PointType> packet;
+  packet.points.assign(columns.points.begin() + next_column * rings,
+                       columns.points.begin() + (next_column + count) * rings);
+  lidar.addColumns(packet);
+  next_column = (next_column + count) % lidar.width;
+}
+
 // -----Main-----
 int main(int argc, char** argv) {
   //解析命令行参数
@@ -72,6 +130,20 @@ int main(int argc, char** argv) {
     coordinate_frame = pcl::RangeImage::CoordinateFrame(tmp_coordinate_frame);
     std::cout << "Using coordinate frame " << (int)coordinate_frame << ".\n";
   }
+  if (pcl::console::find_argument(argc, argv, "-offscreen") >= 0) {
+    offscreen = true;
+    pcl::console::parse_argument(argc, argv, "-offscreen", offscreen_frames);
+    pcl::console::parse_argument(argc, argv, "-png", png_file);
+  }
+  if (pcl::console::find_argument(argc, argv, "-stream") >= 0) {
+    stream = true;
+    pcl::console::parse_argument(argc, argv, "-stream", stream_packet);
+    stream_packet = std::max(stream_packet, 1);
+    if (live_update) {
+      std::cout << "Live update is off while streaming.\n";
+      live_update = false;
+    }
+  }
   angular_resolution = pcl::deg2rad(angular_resolution);
 
   // 读取给定的pcd点云文件或者自行创建随机点云
@@ -111,14 +183,37 @@ int main(int argc, char** argv) {
   float noise_level = 0.0;
   float min_range = 0.0f;
   int border_size = 1;
+  // -stream：场景被一个分辨率为 angular_resolution、覆盖整个球面的激光雷达
+  // 扫描，数据包逐个写入 StreamingRangeImage，每转完一圈刷新一次显示
+  pcl::StreamingRangeImage::Ptr streaming_ptr(new pcl::StreamingRangeImage);
+  pcl::PointCloud<PointType> lidar_columns;
+  int next_column = 0;
   boost::shared_ptr<pcl::RangeImage> range_image_ptr(new pcl::RangeImage);
+  if (!stream) {
+    range_image_ptr->createFromPointCloud(
+        point_cloud, angular_resolution, pcl::deg2rad(360.0f),
+        pcl::deg2rad(180.0f), scene_sensor_pose, coordinate_frame,
+        noise_level, min_range, border_size);
+  } else {
+    const int columns = (int)pcl_lrint(2.0 * M_PI / angular_resolution);
+    const int rings = (int)pcl_lrint(M_PI / angular_resolution) - 1;
+    const float pole = 0.5f * (float)M_PI - 0.5f * angular_resolution;
+    streaming_ptr->setupLidar(columns, rings, -pole, pole, scene_sensor_pose,
+                              coordinate_frame, min_range);
+    streaming_ptr->registerCallback(boost::bind(&frameComplete, _1));
+    resampleAsLidar(point_cloud, *streaming_ptr, lidar_columns);
+    // 先转完一圈，显示的是完整的图像
+    do {
+      feedPacket(lidar_columns, *streaming_ptr, next_column);
+    } while (next_column != 0);
+    frame_complete = false;
+    range_image_ptr = streaming_ptr;
+  }
   pcl::RangeImage& range_image = *range_image_ptr;
-  range_image.createFromPointCloud(point_cloud, angular_resolution,
-                                   pcl::deg2rad(360.0f), pcl::deg2rad(180.0f),
-                                   scene_sensor_pose, coordinate_frame,
-                                   noise_level, min_range, border_size);
   //创建3D视图并且添加点云进行显示
-  pcl::visualization::PCLVisualizer viewer("3D Viewer");
+  pcl::visualization::PCLVisualizer viewer("3D Viewer", !offscreen);
+  if (offscreen)
+    pcl::visualization::setupOffscreen(viewer.getRenderWindow(), 800, 600);
   viewer.setBackgroundColor(1, 1, 1);
   pcl::visualization::PointCloudColorHandlerCustom<pcl::PointWithRange>
       range_image_color_handler(range_image_ptr, 0, 0, 0);
@@ -132,6 +227,51 @@ int main(int argc, char** argv) {
   // point_cloud_color_handler, "original point cloud");
   viewer.initCameraParameters();
   setViewerPose(viewer, range_image.getTransformationToWorldSystem());
+  // 离屏渲染：绕场景旋转，统计帧时间；-l 时同时统计每帧重建深度图像的时间，
+  // -stream 时统计每帧写入一个数据包的时间
+  if (offscreen) {
+    PointType min_pt, max_pt;
+    pcl::getMinMax3D(point_cloud, min_pt, max_pt);
+    Eigen::Vector3f center =
+        0.5f * (min_pt.getVector3fMap() + max_pt.getVector3fMap());
+    float radius = (max_pt.getVector3fMap() - min_pt.getVector3fMap()).norm();
+    pcl::visualization::CameraPath path =
+        pcl::visualization::CameraPath::orbit(center, radius, 0.5f * radius);
+    pcl::visualization::FrameTimes render_times, update_times;
+    for (int f = 0; f < offscreen_frames; ++f) {
+      path.apply(viewer, f, offscreen_frames);
+      if (live_update) {
+        double start = pcl::getTime();
+        range_image.createFromPointCloud(
+            point_cloud, angular_resolution, pcl::deg2rad(360.0f),
+            pcl::deg2rad(180.0f), viewer.getViewerPose(),
+            pcl::RangeImage::LASER_FRAME, noise_level, min_range, border_size);
+        update_times.add((pcl::getTime() - start) * 1000.0);
+      }
+      if (stream) {
+        double start = pcl::getTime();
+        feedPacket(lidar_columns, *streaming_ptr, next_column);
+        update_times.add((pcl::getTime() - start) * 1000.0);
+        if (frame_complete) {
+          viewer.updatePointCloud(range_image_ptr, range_image_color_handler,
+                                  "range image");
+          frame_complete = false;
+        }
+      }
+      render_times.add(
+          pcl::visualization::renderSynchronous(viewer.getRenderWindow()));
+    }
+    std::cout << "Offscreen, " << offscreen_frames
+              << " frames: " << render_times.summary() << "\n";
+    if (live_update)
+      std::cout << "Range image update: " << update_times.summary() << "\n";
+    if (stream)
+      std::cout << "Packet of " << stream_packet
+                << " columns: " << update_times.summary() << "\n";
+    if (!png_file.empty())
+      pcl::visualization::saveWindowImage(viewer.getRenderWindow(), png_file);
+    return 0;
+  }
   //显示深度图像
   pcl::visualization::RangeImageVisualizer range_image_widget("Range image");
   range_image_widget.showRangeImage(range_image);
@@ -148,5 +288,14 @@ int main(int argc, char** argv) {
           noise_level, min_range, border_size);
       range_image_widget.showRangeImage(range_image);
     }
+    if (stream) {
+      feedPacket(lidar_columns, *streaming_ptr, next_column);
+      if (frame_complete) {
+        range_image_widget.showRangeImage(range_image);
+        viewer.updatePointCloud(range_image_ptr, range_image_color_handler,
+                                "range image");
+        frame_complete = false;
+      }
+    }
   }
 }
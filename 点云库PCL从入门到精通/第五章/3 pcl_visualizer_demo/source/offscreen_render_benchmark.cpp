@@ -0,0 +1,188 @@
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/time.h>
+#include <pcl/console/parse.h>
+#include <pcl/visualization/pcl_visualizer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "offscreen_render.h"
+
+using namespace pcl::console;
+typedef pcl::PointXYZRGB PointT;
+
+// 合成地形点云的一块：[first, first + count) 号点，点号决定位置，结果与分块方式无关
+void
+generateTerrainBlock (size_t first, size_t count, float extent, pcl::PointCloud<PointT> &block)
+{
+  block.points.resize (count);
+  block.width = static_cast<uint32_t> (count);
+  block.height = 1;
+  block.is_dense = true;
+#pragma omp parallel for
+  for (int i = 0; i < static_cast<int> (count); ++i)
+  {
+    // 整数哈希得到 [0,1) 的伪随机坐标
+    unsigned long long h = (first + i) * 6364136223846793005ULL + 1442695040888963407ULL;
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdULL; h ^= h >> 33;
+    float u = static_cast<float> (h & 0xffffff) / 16777216.0f;
+    float v = static_cast<float> ((h >> 24) & 0xffffff) / 16777216.0f;
+    PointT &p = block.points[i];
+    p.x = (u - 0.5f) * extent;
+    p.y = (v - 0.5f) * extent;
+    p.z = 0.05f * extent * std::sin (6.0f * static_cast<float> (M_PI) * u) * std::cos (4.0f * static_cast<float> (M_PI) * v);
+    float t = 0.5f + p.z / (0.1f * extent);
+    p.r = static_cast<uint8_t> (255 * t);
+    p.g = static_cast<uint8_t> (255 * (1.0f - std::fabs (2.0f * t - 1.0f)));
+    p.b = static_cast<uint8_t> (255 * (1.0f - t));
+  }
+}
+
+struct BenchmarkResult
+{
+  size_t points;
+  double upload_ms;        // addPointCloud：转换成 VTK 数组
+  double first_frame_ms;   // 第一帧：显存上传 + 绘制
+  std::vector<pcl::visualization::FrameTimes> paths;
+  size_t rss, peak_rss;
+};
+
+int
+main (int argc, char** argv)
+{
+  if (find_switch (argc, argv, "-help"))
+  {
+    std::cout << argv[0] << " [options]\n"
+              << "  -sizes 1,10,100     cloud sizes in millions of points (default 1,10)\n"
+              << "  -block n            points per added cloud block (default 1000000)\n"
+              << "  -frames n           frames per camera path (default 120)\n"
+              << "  -path file          extra camera path, one key pose per line: px py pz fx fy fz ux uy uz\n"
+              << "  -width w -height h  window size (default 1280 x 720)\n"
+              << "  -point_size n       rendered point size (default 1)\n"
+              << "  -csv file           append results as CSV, for regression tracking\n"
+              << "  -png prefix         save the last frame of every path as PNG\n"
+              << "Without a GPU run with VTK built against OSMesa/EGL, or under xvfb-run (Mesa llvmpipe).\n";
+    return (0);
+  }
+  std::vector<double> sizes;
+  parse_x_arguments (argc, argv, "-sizes", sizes);
+  if (sizes.empty ())
+  {
+    sizes.push_back (1);
+    sizes.push_back (10);
+  }
+  int block_size = 1000000, frames = 120, width = 1280, height = 720, point_size = 1;
+  std::string path_file, csv_file, png_prefix;
+  parse_argument (argc, argv, "-block", block_size);
+  parse_argument (argc, argv, "-frames", frames);
+  parse_argument (argc, argv, "-width", width);
+  parse_argument (argc, argv, "-height", height);
+  parse_argument (argc, argv, "-point_size", point_size);
+  parse_argument (argc, argv, "-path", path_file);
+  parse_argument (argc, argv, "-csv", csv_file);
+  parse_argument (argc, argv, "-png", png_prefix);
+
+  // 相机路径：环绕、低空穿越，以及可选的脚本文件
+  const float extent = 100.0f;
+  std::vector<std::string> path_names;
+  std::vector<pcl::visualization::CameraPath> paths;
+  path_names.push_back ("orbit");
+  paths.push_back (pcl::visualization::CameraPath::orbit (Eigen::Vector3f::Zero (), 0.9f * extent, 0.5f * extent));
+  path_names.push_back ("flythrough");
+  paths.push_back (pcl::visualization::CameraPath::flyThrough (Eigen::Vector3f (-0.5f * extent, -0.5f * extent, -0.05f * extent),
+                                                               Eigen::Vector3f (0.5f * extent, 0.5f * extent, 0.05f * extent)));
+  if (!path_file.empty ())
+  {
+    pcl::visualization::CameraPath scripted;
+    if (!scripted.load (path_file))
+    {
+      std::cerr << "Could not read camera path " << path_file << std::endl;
+      return (-1);
+    }
+    path_names.push_back (path_file);
+    paths.push_back (scripted);
+  }
+
+  std::vector<BenchmarkResult> results;
+  for (size_t s = 0; s < sizes.size (); ++s)
+  {
+    BenchmarkResult result;
+    result.points = static_cast<size_t> (sizes[s] * 1e6);
+    result.upload_ms = 0.0;
+    std::cout << "== " << result.points << " points" << std::endl;
+
+    // 不创建交互器，窗口不映射到屏幕
+    pcl::visualization::PCLVisualizer viewer ("offscreen benchmark", false);
+    pcl::visualization::setupOffscreen (viewer.getRenderWindow (), width, height);
+    viewer.setBackgroundColor (0, 0, 0);
+
+    // 分块生成并添加，PCL 一侧同时只保留一块点云
+    pcl::PointCloud<PointT>::Ptr block (new pcl::PointCloud<PointT>);
+    for (size_t first = 0, b = 0; first < result.points; first += block_size, ++b)
+    {
+      size_t count = std::min (static_cast<size_t> (block_size), result.points - first);
+      generateTerrainBlock (first, count, extent, *block);
+      std::stringstream id;
+      id << "block" << b;
+      double start = pcl::getTime ();
+      pcl::visualization::PointCloudColorHandlerRGBField<PointT> rgb (block);
+      viewer.addPointCloud<PointT> (block, rgb, id.str ());
+      viewer.setPointCloudRenderingProperties (pcl::visualization::PCL_VISUALIZER_POINT_SIZE, point_size, id.str ());
+      result.upload_ms += (pcl::getTime () - start) * 1000.0;
+    }
+    block.reset ();
+
+    paths[0].apply (viewer, 0, frames);
+    result.first_frame_ms = pcl::visualization::renderSynchronous (viewer.getRenderWindow ());
+    std::cout << "  upload (addPointCloud): " << result.upload_ms << " ms, first frame: "
+              << result.first_frame_ms << " ms" << std::endl;
+
+    for (size_t p = 0; p < paths.size (); ++p)
+    {
+      pcl::visualization::FrameTimes times;
+      for (int f = 0; f < frames; ++f)
+      {
+        paths[p].apply (viewer, f, frames);
+        times.add (pcl::visualization::renderSynchronous (viewer.getRenderWindow ()));
+      }
+      std::cout << "  " << path_names[p] << ": " << times.summary () << std::endl;
+      result.paths.push_back (times);
+      if (!png_prefix.empty ())
+      {
+        std::stringstream file;
+        file << png_prefix << "_" << result.points << "_" << p << ".png";
+        pcl::visualization::saveWindowImage (viewer.getRenderWindow (), file.str ());
+      }
+    }
+
+    pcl::visualization::getMemoryUsage (result.rss, result.peak_rss);
+    std::cout << "  memory: rss " << result.rss / (1024 * 1024) << " MB, peak "
+              << result.peak_rss / (1024 * 1024) << " MB" << std::endl;
+    results.push_back (result);
+  }
+
+  if (!csv_file.empty ())
+  {
+    std::ifstream exists (csv_file.c_str ());
+    bool header = !exists.good ();
+    exists.close ();
+    std::ofstream csv (csv_file.c_str (), std::ios::app);
+    if (header)
+      csv << "points,path,frames,upload_ms,first_frame_ms,mean_ms,p50_ms,p95_ms,max_ms,rss_mb,peak_rss_mb\n";
+    for (size_t r = 0; r < results.size (); ++r)
+      for (size_t p = 0; p < results[r].paths.size (); ++p)
+      {
+        const pcl::visualization::FrameTimes &t = results[r].paths[p];
+        csv << results[r].points << "," << path_names[p] << "," << t.size () << "," << results[r].upload_ms << ","
+            << results[r].first_frame_ms << "," << t.mean () << "," << t.percentile (50) << ","
+            << t.percentile (95) << "," << t.percentile (100) << "," << results[r].rss / (1024 * 1024) << ","
+            << results[r].peak_rss / (1024 * 1024) << "\n";
+      }
+  }
+  return (0);
+}
@@ -7,6 +7,11 @@
 #include <pcl/visualization/pcl_visualizer.h>
 #include <boost/thread/thread.hpp>
 #include <iostream>
+#include "offscreen_render.h"
+// 离屏渲染参数
+bool offscreen(false);
+int offscreen_frames(120);
+std::string png_file;
 // 帮助
 void printUsage(const char* progName) {
   std::cout << "\n\nUsage: " << progName << " [options]\n\n"
@@ -20,14 +25,26 @@ void printUsage(const char* progName) {
             << "-a           Shapes visualisation example\n"
             << "-v           Viewports example\n"
             << "-i           Interaction Customization example\n"
+            << "-offscreen <frames>  render <frames> frames of an orbit without a\n"
+            << "                     window and print frame times (default 120)\n"
+            << "-png <file>  with -offscreen: save the last frame\n"
             << "\n\n";
 }
 
+// 离屏模式下不创建交互器，也不打开屏幕窗口
+boost::shared_ptr<pcl::visualization::PCLVisualizer> createViewer() {
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
+      new pcl::visualization::PCLVisualizer("3D Viewer", !offscreen));
+  if (offscreen)
+    pcl::visualization::setupOffscreen(viewer->getRenderWindow(), 800, 600);
+  return (viewer);
+}
+
 boost::shared_ptr<pcl::visualization::PCLVisualizer> simpleVis(
     pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloud) {
   //创建3D窗口并添加点云
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->setBackgroundColor(0, 0, 0);
   viewer->addPointCloud<pcl::PointXYZ>(cloud, "sample cloud");
   viewer->setPointCloudRenderingProperties(
@@ -40,8 +57,8 @@ boost::shared_ptr<pcl::visualization::PCLVisualizer> simpleVis(
 boost::shared_ptr<pcl::visualization::PCLVisualizer> rgbVis(
     pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud) {
   //创建3D窗口并添加点云
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->setBackgroundColor(0, 0, 0);
   pcl::visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGB> rgb(
       cloud);
@@ -56,8 +73,8 @@ boost::shared_ptr<pcl::visualization::PCLVisualizer> rgbVis(
 boost::shared_ptr<pcl::visualization::PCLVisualizer> customColourVis(
     pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloud) {
   //创建3D窗口并添加点云
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->setBackgroundColor(0, 0, 0);
   pcl::visualization::PointCloudColorHandlerCustom<pcl::PointXYZ> single_color(
       cloud, 0, 255, 0);
@@ -73,8 +90,8 @@ boost::shared_ptr<pcl::visualization::PCLVisualizer> normalsVis(
     pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud,
     pcl::PointCloud<pcl::Normal>::ConstPtr normals) {
   //创建3D窗口并添加点云其包括法线
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->setBackgroundColor(0, 0, 0);
   pcl::visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGB> rgb(
       cloud);
@@ -91,8 +108,8 @@ boost::shared_ptr<pcl::visualization::PCLVisualizer> normalsVis(
 boost::shared_ptr<pcl::visualization::PCLVisualizer> shapesVis(
     pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud) {
   //创建3D窗口并添加点云
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->setBackgroundColor(0, 0, 0);
   pcl::visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGB> rgb(
       cloud);
@@ -130,8 +147,8 @@ boost::shared_ptr<pcl::visualization::PCLVisualizer> viewportsVis(
     pcl::PointCloud<pcl::Normal>::ConstPtr normals1,
     pcl::PointCloud<pcl::Normal>::ConstPtr normals2) {
   // 创建3D窗口并添加显示点云其包括法线
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->initCameraParameters();
   int v1(0);
   viewer->createViewPort(0.0, 0.0, 0.5, 1.0, v1);
@@ -198,8 +215,8 @@ void mouseEventOccurred(const pcl::visualization::MouseEvent& event,
 
 boost::shared_ptr<pcl::visualization::PCLVisualizer>
 interactionCustomizationVis() {
-  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer(
-      new pcl::visualization::PCLVisualizer("3D Viewer"));
+  boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer =
+      createViewer();
   viewer->setBackgroundColor(0, 0, 0);
   viewer->addCoordinateSystem(1.0);
 
@@ -215,6 +232,11 @@ int main(int argc, char** argv) {
     printUsage(argv[0]);
     return 0;
   }
+  if (pcl::console::find_argument(argc, argv, "-offscreen") >= 0) {
+    offscreen = true;
+    pcl::console::parse_argument(argc, argv, "-offscreen", offscreen_frames);
+    pcl::console::parse_argument(argc, argv, "-png", png_file);
+  }
   bool simple(false), rgb(false), custom_c(false), normals(false),
       shapes(false), viewports(false), interaction_customization(false);
   if (pcl::console::find_argument(argc, argv, "-s") >= 0) {
@@ -311,6 +333,21 @@ int main(int argc, char** argv) {
   } else if (interaction_customization) {
     viewer = interactionCustomizationVis();
   }
+  // 离屏渲染：沿环绕路径渲染固定帧数并统计帧时间
+  if (offscreen) {
+    pcl::visualization::CameraPath path =
+        pcl::visualization::CameraPath::orbit(Eigen::Vector3f::Zero(), 4.0f, 2.0f);
+    pcl::visualization::FrameTimes times;
+    for (int f = 0; f < offscreen_frames; ++f) {
+      path.apply(*viewer, f, offscreen_frames);
+      times.add(pcl::visualization::renderSynchronous(viewer->getRenderWindow()));
+    }
+    std::cout << "Offscreen, " << offscreen_frames << " frames: " << times.summary()
+              << "\n";
+    if (!png_file.empty())
+      pcl::visualization::saveWindowImage(viewer->getRenderWindow(), png_file);
+    return 0;
+  }
   // 主循环
   while (!viewer->wasStopped()) {
     viewer->spinOnce(100);
@@ -9,7 +9,7 @@
 #include <pcl/filters/normal_space.h>
 #include <pcl/common/eigen.h>
 #include <pcl/features/normal_3d.h>
-#include <pcl/features/fpfh.h>
+#include <pcl/features/fpfh_omp.h>
 #include <pcl/visualization/histogram_visualizer.h>
 
 
@@ -17,6 +17,8 @@
 #include<vector>
 #include<utility>
 #include<math.h>  //for abs()
+#include "offscreen_render.h"
+#include "histogram_statistics.h"
 
 using namespace std;
 using namespace pcl::visualization;
@@ -49,18 +51,33 @@ identity_i (double val)
   return val;
 }
 
+//.....................ģʽÿʾֻȾһ֡ʱ....................
+bool offscreen = false;
+FrameTimes frame_times;
+
+void
+showPlot (PCLPlotter *plotter, int time)
+{
+  if (offscreen)
+    frame_times.add (renderSynchronous (plotter->getRenderWindow ()));
+  else
+    plotter->spinOnce (time);
+}
+
 
 int
 main (int argc, char * argv [])
 {
 		if(argc<2)
 	{
-		std::cout<<".exe source.pcd -r 0.005 -ds 5"<<endl;
+		std::cout<<".exe source.pcd -r 0.005 -ds 5 [-offscreen] [-stats]"<<endl;
 		return 0;
 	}
 	float voxel_re=0.005,ds_N=5;
 	parse_argument (argc, argv, "-r", voxel_re);// õƷֱ
 	parse_argument (argc, argv, "-ds", ds_N);// ð뾶
+	offscreen = find_switch (argc, argv, "-offscreen");// 򿪴ڣͳȾʱ
+	bool stats = find_switch (argc, argv, "-stats");// еFPFHʾͳͼǵֱͼ
   
 
 	//²ķֱԱݴٶȡ
@@ -99,11 +116,11 @@ main (int argc, char * argv [])
 	PCL_INFO ("FPFH - Feature Descriptor\n"); 
 	//FPFH	
 	//FPFH Source 
-	pcl::FPFHEstimation<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> fpfh_est_src; 
+	pcl::FPFHEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> fpfh_est_src; 
 	pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_fpfh_src (new pcl::search::KdTree<pcl::PointXYZ>); 
 
 	fpfh_est_src.setSearchSurface (ds_src);//
-	fpfh_est_src.setInputCloud (keypoints_src); // ؼ
+	fpfh_est_src.setInputCloud (stats ? ds_src : keypoints_src); // ؼ㣬ͳģʽе
 	fpfh_est_src.setInputNormals (norm_src); 
 	fpfh_est_src.setRadiusSearch (2*ds_N*voxel_re);
 	fpfh_est_src.setSearchMethod(tree_fpfh_src);
@@ -114,13 +131,25 @@ main (int argc, char * argv [])
 
   //ͼ
   PCLPlotter *plotter = new PCLPlotter ("My Plotter"); 
+  if (offscreen)
+    setupOffscreen (plotter->getRenderWindow (), 800, 600);
   //
   plotter->setShowLegend (true);
   std::cout<<pcl::getFieldsList<pcl::FPFHSignature33>(*fpfh_src);
-  plotter->addFeatureHistogram<pcl::FPFHSignature33>(*fpfh_src,"fpfh",5,"one_fpfh");
+  if (stats)
+  {
+    //еFPFHÿbinľֵλܶȻͬһͼ
+    double start = pcl::getTime ();
+    HistogramStatistics fpfh_stats;
+    fpfh_stats.compute (*fpfh_src);
+    std::cout<<"statistics of "<<fpfh_stats.getCount ()<<" FPFH: "<<(pcl::getTime () - start) * 1000.0<<" ms"<<endl;
+    fpfh_stats.addToPlotter (*plotter, "fpfh");
+  }
+  else
+    plotter->addFeatureHistogram<pcl::FPFHSignature33>(*fpfh_src,"fpfh",5,"one_fpfh");
   //ʾ
   plotter->setWindowSize (800, 600);
-  plotter->spinOnce (30000000);
+  showPlot (plotter, 30000000);
   plotter->clearPlots ();
 
   // Ӧ
@@ -133,7 +162,7 @@ main (int argc, char * argv [])
   plotter->addPlotData (ax, asin, numPoints, "sin");
 
   //ʾ2s
-  plotter->spinOnce (30000);
+  showPlot (plotter, 30000);
   plotter->clearPlots ();
   
   
@@ -149,20 +178,20 @@ main (int argc, char * argv [])
   func2[2] = 1; //y = x^2
 
   plotter->addPlotData (std::make_pair (func1, func2), -10, 10, "y = 1/x^2", 100, vtkChart::POINTS);
-  plotter->spinOnce (2000);
+  showPlot (plotter, 2000);
 
   plotter->addPlotData (func2, -10, 10, "y = x^2");
-  plotter->spinOnce (2000);
+  showPlot (plotter, 2000);
 
   //ص
   plotter->addPlotData ( identity_i, -10, 10, "identity");
-  plotter->spinOnce (2000);
+  showPlot (plotter, 2000);
 
   plotter->addPlotData (abs, -10, 10, "abs");
-  plotter->spinOnce (2000);
+  showPlot (plotter, 2000);
 
   plotter->addPlotData (step, -10, 10, "step", 100, vtkChart::POINTS);
-  plotter->spinOnce (2000);
+  showPlot (plotter, 2000);
 
   plotter->clearPlots ();
 
@@ -171,7 +200,8 @@ main (int argc, char * argv [])
  
   vector<double> fsq (3, 0);
   fsq[2] = -100; //y = x^2
-  while (plotter->wasStopped ())
+  int frame = 0;
+  while (offscreen ? frame++ < 200 : plotter->wasStopped ())
   {
     if (fsq[2] == 100) fsq[2] = -100;
     fsq[2]++;
@@ -179,9 +209,11 @@ main (int argc, char * argv [])
     sprintf (str, "y = %dx^2", (int) fsq[2]);
     plotter->addPlotData (fsq, -10, 10, str);
 	 plotter->setYRange (-1, 1);
-    plotter->spinOnce (100);
+    showPlot (plotter, 100);
     plotter->clearPlots ();
   }
+  if (offscreen)
+    std::cout << frame_times.size () << " frames offscreen: " << frame_times.summary () << std::endl;
   
   return 1;
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ TEMPLATE = app
 SOURCES += main.cpp\
         pclviewer.cpp
 
-HEADERS  += pclviewer.h
+HEADERS  += pclviewer.h\
+        updateable_cloud.h
 
 FORMS    += pclviewer.ui
@@ -52,7 +52,8 @@ PCLViewer::PCLViewer (QWidget *parent) :
   // Connect point size slider
   connect (ui->horizontalSlider_p, SIGNAL (valueChanged (int)), this, SLOT (pSliderValueChanged (int)));
 
-  viewer->addPointCloud (cloud, "cloud");
+  cloud_display.update (*cloud);
+  cloud_display.addToViewer (*viewer, "cloud");
   pSliderValueChanged (2);
   viewer->resetCamera ();
   ui->qvtkWidget->update ();
@@ -71,7 +72,8 @@ PCLViewer::randomButtonPressed ()
     cloud->points[i].b = 255 *(1024 * rand () / (RAND_MAX + 1.0f));
   }
 
-  viewer->updatePointCloud (cloud, "cloud");
+  cloud_display.update (*cloud);
+  printf ("Upload time: %.3f ms\n", cloud_display.getLastUploadTime ());
   ui->qvtkWidget->update ();
 }
 
@@ -85,14 +87,15 @@ PCLViewer::RGBsliderReleased ()
     cloud->points[i].g = green;
     cloud->points[i].b = blue;
   }
-  viewer->updatePointCloud (cloud, "cloud");
+  cloud_display.update (*cloud);
+  printf ("Upload time: %.3f ms\n", cloud_display.getLastUploadTime ());
   ui->qvtkWidget->update ();
 }
 
 void
 PCLViewer::pSliderValueChanged (int value)
 {
-  viewer->setPointCloudRenderingProperties (pcl::visualization::PCL_VISUALIZER_POINT_SIZE, value, "cloud");
+  viewer->setShapeRenderingProperties (pcl::visualization::PCL_VISUALIZER_POINT_SIZE, value, "cloud");
   ui->qvtkWidget->update ();
 }
 
@@ -10,6 +10,7 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <pcl/visualization/pcl_visualizer.h>
+#include "updateable_cloud.h"
 
 // Visualization Toolkit (VTK)
 #include <vtkRenderWindow.h>
@@ -52,6 +53,8 @@ public slots:
 protected:
   boost::shared_ptr<pcl::visualization::PCLVisualizer> viewer;
   PointCloudT::Ptr cloud;
+  // VTK arrays of the displayed cloud, overwritten in place instead of re-adding the cloud
+  pcl::visualization::UpdateableCloud<PointT> cloud_display;
 
   unsigned int red;
   unsigned int green;
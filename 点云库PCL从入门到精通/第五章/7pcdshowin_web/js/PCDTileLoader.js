@@ -0,0 +1,195 @@
+/**
+ * Description: A THREE loader for the chunked, level-of-detail ordered tile sets
+ * written by source/pcd2tiles.
+ *
+ * tiles.json lists the chunks from coarse to fine. Chunks are downloaded and decoded
+ * by a pool of web workers (js/PCDTileWorker.js); the next chunk to fetch is always
+ * the coarsest one left, chunks in the view frustum and close to the camera first.
+ * Every chunk becomes a THREE.Points in the returned group as soon as it arrives,
+ * so the whole scene is visible after the first few chunks and then refines.
+ *
+ * Usage:
+ *   var loader = new THREE.PCDTileLoader();
+ *   var group = loader.load( 'tiles/tiles.json', camera, onLoad, onProgress, onError );
+ *   scene.add( group );
+ *
+ */
+
+THREE.PCDTileLoader = function ( manager ) {
+
+	this.manager = ( manager !== undefined ) ? manager : THREE.DefaultLoadingManager;
+	this.workerUrl = 'js/PCDTileWorker.js';
+	this.workerCount = Math.max( 1, Math.min( navigator.hardwareConcurrency || 4, 4 ) );
+	this.maxRequests = 6;
+	this.pointBudget = Infinity;
+	this.material = new THREE.PointsMaterial( { size: 0.005, vertexColors: THREE.VertexColors } );
+
+	this.info = null;
+	this.loadedPoints = 0;
+	this.loadedChunks = 0;
+	this.firstChunkTime = - 1;
+
+	this.workers = [];
+	this.pending = [];
+	this.requests = {};
+	this.activeRequests = 0;
+
+};
+
+
+THREE.PCDTileLoader.prototype = {
+
+	constructor: THREE.PCDTileLoader,
+
+	// onLoad( group, info ) is called when tiles.json has been read, before any chunk;
+	// onProgress( points, chunk, loader ) for every chunk added to the group.
+	load: function ( url, camera, onLoad, onProgress, onError ) {
+
+		var scope = this;
+		var group = new THREE.Group();
+		group.name = url.split( '/' ).slice( - 2 ).join( '/' );
+		var base = url.substring( 0, url.lastIndexOf( '/' ) + 1 );
+		var start = performance.now();
+
+		var loader = new THREE.FileLoader( scope.manager );
+		loader.load( url, function ( text ) {
+
+			var info = JSON.parse( text );
+			if ( info.format !== 'PCT1' ) {
+
+				if ( onError ) onError( new Error( url + ': unsupported tile format ' + info.format ) );
+				return;
+
+			}
+			scope.info = info;
+			if ( ! info.hasColor ) {
+
+				scope.material.vertexColors = THREE.NoColors;
+				scope.material.color.setHex( Math.random() * 0xffffff );
+
+			}
+
+			for ( var i = 0; i < info.chunks.length; i ++ ) {
+
+				var chunk = info.chunks[ i ];
+				chunk.id = i;
+				chunk.url = base + chunk.file;
+				chunk.box = new THREE.Box3( new THREE.Vector3().fromArray( chunk.min ), new THREE.Vector3().fromArray( chunk.max ) );
+				scope.pending.push( chunk );
+
+			}
+
+			if ( onLoad ) onLoad( group, info );
+
+			for ( var w = 0; w < scope.workerCount; w ++ ) {
+
+				var worker = new Worker( scope.workerUrl );
+				worker.onmessage = function ( event ) {
+
+					scope.onChunkDecoded( event.data, group, camera, start, onProgress, onError );
+
+				};
+				scope.workers.push( worker );
+
+			}
+			scope.schedule( camera );
+
+		}, undefined, onError );
+
+		return group;
+
+	},
+
+	// 按需选取下一个块：先粗后细，同一层中先取视锥内、离相机近的块
+	nextChunk: function ( camera ) {
+
+		var frustum = new THREE.Frustum();
+		camera.updateMatrixWorld();
+		camera.matrixWorldInverse.getInverse( camera.matrixWorld );
+		frustum.setFromMatrix( new THREE.Matrix4().multiplyMatrices( camera.projectionMatrix, camera.matrixWorldInverse ) );
+		var eye = camera.getWorldPosition();
+
+		var best = - 1, bestScore = Infinity;
+		for ( var i = 0; i < this.pending.length; i ++ ) {
+
+			var chunk = this.pending[ i ];
+			var score = chunk.level * 2;
+			if ( chunk.level > 0 && ! frustum.intersectsBox( chunk.box ) )
+				score += 1;
+			score += 1 - 1 / ( 1 + chunk.box.distanceToPoint( eye ) );
+			if ( score < bestScore ) {
+
+				bestScore = score;
+				best = i;
+
+			}
+
+		}
+		return best < 0 ? null : this.pending.splice( best, 1 )[ 0 ];
+
+	},
+
+	schedule: function ( camera ) {
+
+		while ( this.activeRequests < this.maxRequests && this.pending.length > 0 &&
+			this.loadedPoints < this.pointBudget ) {
+
+			var chunk = this.nextChunk( camera );
+			this.requests[ chunk.id ] = chunk;
+			this.activeRequests ++;
+			this.workers[ chunk.id % this.workers.length ].postMessage( { id: chunk.id, url: chunk.url } );
+
+		}
+
+	},
+
+	onChunkDecoded: function ( data, group, camera, start, onProgress, onError ) {
+
+		var chunk = this.requests[ data.id ];
+		delete this.requests[ data.id ];
+		this.activeRequests --;
+
+		if ( data.error !== undefined ) {
+
+			if ( onError ) onError( new Error( data.error ) );
+
+		} else {
+
+			var geometry = new THREE.BufferGeometry();
+			geometry.addAttribute( 'position', new THREE.BufferAttribute( data.position, 3 ) );
+			if ( data.color !== null )
+				geometry.addAttribute( 'color', new THREE.BufferAttribute( data.color, 3, true ) );
+			// 包围盒来自 tiles.json，不必遍历所有点
+			geometry.boundingBox = chunk.box.clone();
+			geometry.boundingSphere = chunk.box.getBoundingSphere();
+
+			var points = new THREE.Points( geometry, this.material );
+			points.name = chunk.file;
+			points.userData.level = chunk.level;
+			group.add( points );
+
+			this.loadedPoints += data.count;
+			this.loadedChunks ++;
+			if ( this.firstChunkTime < 0 )
+				this.firstChunkTime = performance.now() - start;
+			if ( onProgress ) onProgress( points, chunk, this );
+
+		}
+
+		if ( this.activeRequests === 0 && ( this.pending.length === 0 || this.loadedPoints >= this.pointBudget ) )
+			this.dispose();
+		else
+			this.schedule( camera );
+
+	},
+
+	dispose: function () {
+
+		for ( var i = 0; i < this.workers.length; i ++ )
+			this.workers[ i ].terminate();
+		this.workers = [];
+		this.pending = [];
+
+	}
+
+};
@@ -0,0 +1,106 @@
+/**
+ * Web worker of THREE.PCDTileLoader.
+ *
+ * Description: Downloads one chunk written by pcd2tiles and decodes it into typed
+ * arrays off the main thread. The arrays are transferred back, not copied.
+ *
+ * Chunk layout (little endian):
+ *   char[4] "PCT1", uint32 count, uint32 flags (1 = color),
+ *   float32[3] min, float32[3] step, uint16[3 * count] quantized xyz,
+ *   padding to 4 bytes, uint8[3 * count] rgb
+ *
+ */
+
+var HEADER_SIZE = 36;
+var littleEndianHost = new Uint8Array( new Uint16Array( [ 1 ] ).buffer )[ 0 ] === 1;
+
+self.onmessage = function ( event ) {
+
+	var job = event.data;
+	var request = new XMLHttpRequest();
+	request.open( 'GET', job.url, true );
+	request.responseType = 'arraybuffer';
+
+	request.onload = function () {
+
+		if ( request.status !== 200 && request.status !== 0 ) {
+
+			self.postMessage( { id: job.id, error: job.url + ': HTTP ' + request.status } );
+			return;
+
+		}
+
+		try {
+
+			var result = decode( request.response );
+			result.id = job.id;
+			var transfer = [ result.position.buffer ];
+			if ( result.color !== null )
+				transfer.push( result.color.buffer );
+			self.postMessage( result, transfer );
+
+		} catch ( e ) {
+
+			self.postMessage( { id: job.id, error: job.url + ': ' + e.message } );
+
+		}
+
+	};
+
+	request.onerror = function () {
+
+		self.postMessage( { id: job.id, error: job.url + ': network error' } );
+
+	};
+
+	request.send();
+
+};
+
+function decode( buffer ) {
+
+	var view = new DataView( buffer );
+	if ( buffer.byteLength < HEADER_SIZE || view.getUint32( 0, true ) !== 0x31544350 )
+		throw new Error( 'not a PCT1 chunk' );
+
+	var count = view.getUint32( 4, true );
+	var hasColor = ( view.getUint32( 8, true ) & 1 ) !== 0;
+	var colorOffset = ( HEADER_SIZE + count * 6 + 3 ) & ~ 3;
+	if ( buffer.byteLength < ( hasColor ? colorOffset + count * 3 : HEADER_SIZE + count * 6 ) )
+		throw new Error( 'truncated chunk' );
+
+	var minX = view.getFloat32( 12, true ), minY = view.getFloat32( 16, true ), minZ = view.getFloat32( 20, true );
+	var stepX = view.getFloat32( 24, true ), stepY = view.getFloat32( 28, true ), stepZ = view.getFloat32( 32, true );
+
+	var position = new Float32Array( count * 3 );
+	var i, i3;
+	if ( littleEndianHost ) {
+
+		var q = new Uint16Array( buffer, HEADER_SIZE, count * 3 );
+		for ( i3 = 0; i3 < count * 3; i3 += 3 ) {
+
+			position[ i3 + 0 ] = minX + q[ i3 + 0 ] * stepX;
+			position[ i3 + 1 ] = minY + q[ i3 + 1 ] * stepY;
+			position[ i3 + 2 ] = minZ + q[ i3 + 2 ] * stepZ;
+
+		}
+
+	} else {
+
+		for ( i = 0, i3 = 0; i < count; i ++, i3 += 3 ) {
+
+			var row = HEADER_SIZE + i * 6;
+			position[ i3 + 0 ] = minX + view.getUint16( row + 0, true ) * stepX;
+			position[ i3 + 1 ] = minY + view.getUint16( row + 2, true ) * stepY;
+			position[ i3 + 2 ] = minZ + view.getUint16( row + 4, true ) * stepZ;
+
+		}
+
+	}
+
+	// 颜色保持 uint8，在显卡上归一化，比 float 省 3/4 的内存
+	var color = hasColor ? new Uint8Array( buffer.slice( colorOffset, colorOffset + count * 3 ) ) : null;
+
+	return { count: count, position: position, color: color };
+
+}
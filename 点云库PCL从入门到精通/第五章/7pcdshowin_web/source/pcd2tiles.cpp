@@ -0,0 +1,348 @@
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/common/io.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef pcl::PointXYZRGB PointT;
+using namespace pcl::console;
+
+// 把点云转换成浏览器端逐级加载的瓦片集：
+//   tiles.json      元数据：包围盒、每层点数、按由粗到细排好序的块列表
+//   cNNNNNN.bin     每块一个文件，格式（小端）：
+//     char[4]   "PCT1"
+//     uint32    点数 n
+//     uint32    标志，1 = 带颜色
+//     float[3]  块包围盒最小点
+//     float[3]  量化步长，坐标 = min + q * step
+//     uint16[3n] 量化坐标
+//     补齐到 4 字节后 uint8[3n] RGB
+// 第 0 层在 2^start_level 的网格里每格取一个点，之后每层网格加密一倍，取剩下的点，
+// 最后一层包含所有剩余点。所以前几个块就覆盖整个场景，后面的块只是加密。
+
+static const int kMortonBits = 21;
+static const size_t kHeaderSize = 36;
+
+struct MortonEntry
+{
+  unsigned long long code;
+  unsigned int index;
+  bool operator< (const MortonEntry &other) const { return (code < other.code); }
+};
+
+struct Chunk
+{
+  int level;
+  size_t first, count;     // 在 lod_order 中的范围
+  float min[3], max[3];
+  size_t bytes;
+};
+
+// 把 21 位整数的每一位隔两位展开
+inline unsigned long long
+spreadBits (unsigned long long v)
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return (v);
+}
+
+// 同一网格内随机选代表点，避免总是取到格子角上的点
+inline unsigned int
+pointRank (unsigned int i)
+{
+  unsigned int h = i * 2654435761u;
+  h ^= h >> 16; h *= 0x85ebca6bu; h ^= h >> 13;
+  return (h);
+}
+
+std::string
+chunkFileName (size_t c)
+{
+  char name[32];
+  sprintf (name, "c%06d.bin", static_cast<int> (c));
+  return (std::string (name));
+}
+
+bool
+writeChunk (const pcl::PointCloud<PointT> &cloud, const std::vector<unsigned int> &lod_order,
+            bool has_color, const std::string &file, Chunk &chunk)
+{
+  for (int k = 0; k < 3; ++k)
+  {
+    chunk.min[k] = std::numeric_limits<float>::max ();
+    chunk.max[k] = -std::numeric_limits<float>::max ();
+  }
+  for (size_t i = chunk.first; i < chunk.first + chunk.count; ++i)
+  {
+    const PointT &p = cloud.points[lod_order[i]];
+    const float xyz[3] = { p.x, p.y, p.z };
+    for (int k = 0; k < 3; ++k)
+    {
+      chunk.min[k] = std::min (chunk.min[k], xyz[k]);
+      chunk.max[k] = std::max (chunk.max[k], xyz[k]);
+    }
+  }
+  float step[3];
+  for (int k = 0; k < 3; ++k)
+    step[k] = chunk.max[k] > chunk.min[k] ? (chunk.max[k] - chunk.min[k]) / 65535.0f : 1.0f;
+
+  const size_t color_offset = (kHeaderSize + 6 * chunk.count + 3) & ~static_cast<size_t> (3);
+  chunk.bytes = has_color ? color_offset + 3 * chunk.count : kHeaderSize + 6 * chunk.count;
+  std::vector<unsigned char> buffer (chunk.bytes, 0);
+  unsigned char *out = &buffer[0];
+  // 目标平台（x86/ARM）都是小端，直接按内存布局写出
+  const unsigned int header[3] = { 0x31544350u, static_cast<unsigned int> (chunk.count), has_color ? 1u : 0u };
+  memcpy (out, header, 12);
+  memcpy (out + 12, chunk.min, 12);
+  memcpy (out + 24, step, 12);
+  unsigned short *q = reinterpret_cast<unsigned short*> (out + kHeaderSize);
+  unsigned char *rgb = out + color_offset;
+  for (size_t i = 0; i < chunk.count; ++i)
+  {
+    const PointT &p = cloud.points[lod_order[chunk.first + i]];
+    const float xyz[3] = { p.x, p.y, p.z };
+    for (int k = 0; k < 3; ++k)
+    {
+      float v = (xyz[k] - chunk.min[k]) / step[k] + 0.5f;
+      q[3 * i + k] = static_cast<unsigned short> (std::min (v, 65535.0f));
+    }
+    if (has_color)
+    {
+      rgb[3 * i + 0] = p.r;
+      rgb[3 * i + 1] = p.g;
+      rgb[3 * i + 2] = p.b;
+    }
+  }
+
+  std::ofstream f (file.c_str (), std::ios::binary);
+  f.write (reinterpret_cast<const char*> (out), chunk.bytes);
+  return (f.good ());
+}
+
+void
+writeVector (std::ostream &out, const float *v)
+{
+  out << "[" << v[0] << ", " << v[1] << ", " << v[2] << "]";
+}
+
+int
+main (int argc, char** argv)
+{
+  std::vector<int> files = parse_file_extension_argument (argc, argv, ".pcd");
+  std::string out_dir;
+  parse_argument (argc, argv, "-o", out_dir);
+  if (files.empty () || out_dir.empty ())
+  {
+    std::cout << argv[0] << " input1.pcd [input2.pcd ...] -o output_dir [options]\n"
+              << "  -start_level n   level 0 grid is 2^n cells along the longest side (default 6)\n"
+              << "  -levels n        maximum number of levels, the last one takes all remaining points (default 12)\n"
+              << "  -chunk n         maximum points per chunk file (default 65536)\n"
+              << "Serve the directory containing index.html with any static file server, e.g.\n"
+              << "  python -m http.server 8000   and open  http://localhost:8000/index.html?tiles=tiles/tiles.json\n";
+    return (0);
+  }
+  int start_level = 6, max_levels = 12, chunk_points = 65536;
+  parse_argument (argc, argv, "-start_level", start_level);
+  parse_argument (argc, argv, "-levels", max_levels);
+  parse_argument (argc, argv, "-chunk", chunk_points);
+  start_level = std::max (0, std::min (start_level, kMortonBits));
+  max_levels = std::max (1, max_levels);
+  chunk_points = std::max (1, chunk_points);
+
+  // 读入并合并所有点云，只保留有限点；没有 rgb 字段的文件用白色
+  TicToc tt;
+  tt.tic ();
+  pcl::PointCloud<PointT> cloud;
+  bool has_color = false;
+  for (size_t f = 0; f < files.size (); ++f)
+  {
+    pcl::PCLPointCloud2 header;
+    pcl::PCDReader reader;
+    if (reader.readHeader (argv[files[f]], header) < 0)
+      return (-1);
+    bool file_color = pcl::getFieldIndex (header, "rgb") >= 0 || pcl::getFieldIndex (header, "rgba") >= 0;
+    has_color = has_color || file_color;
+
+    pcl::PointCloud<PointT> part;
+    if (pcl::io::loadPCDFile (argv[files[f]], part) < 0)
+      return (-1);
+    size_t first = cloud.points.size ();
+    cloud.points.reserve (first + part.points.size ());
+    for (size_t i = 0; i < part.points.size (); ++i)
+    {
+      PointT p = part.points[i];
+      if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+        continue;
+      if (!file_color)
+        p.r = p.g = p.b = 255;
+      cloud.points.push_back (p);
+    }
+    std::cerr << argv[files[f]] << ": " << cloud.points.size () - first << " points\n";
+  }
+  const size_t n = cloud.points.size ();
+  cloud.width = static_cast<uint32_t> (n);
+  cloud.height = 1;
+  if (n == 0)
+  {
+    std::cerr << "No finite points" << std::endl;
+    return (-1);
+  }
+  std::cerr << ">> Loaded " << n << " points in " << tt.toc () << " ms\n";
+
+  // 整个场景的立方体包围盒
+  tt.tic ();
+  float bb_min[3], bb_max[3];
+  for (int k = 0; k < 3; ++k)
+  {
+    bb_min[k] = std::numeric_limits<float>::max ();
+    bb_max[k] = -std::numeric_limits<float>::max ();
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    const float xyz[3] = { cloud.points[i].x, cloud.points[i].y, cloud.points[i].z };
+    for (int k = 0; k < 3; ++k)
+    {
+      bb_min[k] = std::min (bb_min[k], xyz[k]);
+      bb_max[k] = std::max (bb_max[k], xyz[k]);
+    }
+  }
+  float size = std::max (bb_max[0] - bb_min[0], std::max (bb_max[1] - bb_min[1], bb_max[2] - bb_min[2]));
+  const double scale = size > 0.0f ? static_cast<double> (1 << kMortonBits) / size : 0.0;
+
+  // Morton 码排序后，任意一层网格的同一格子都是连续的一段
+  std::vector<MortonEntry> entries (n);
+#pragma omp parallel for
+  for (int i = 0; i < static_cast<int> (n); ++i)
+  {
+    const PointT &p = cloud.points[i];
+    const float xyz[3] = { p.x, p.y, p.z };
+    unsigned long long code = 0;
+    for (int k = 0; k < 3; ++k)
+    {
+      long long c = static_cast<long long> ((xyz[k] - bb_min[k]) * scale);
+      c = std::max (0LL, std::min (c, (1LL << kMortonBits) - 1));
+      code |= spreadBits (static_cast<unsigned long long> (c)) << k;
+    }
+    entries[i].code = code;
+    entries[i].index = static_cast<unsigned int> (i);
+  }
+  std::sort (entries.begin (), entries.end ());
+
+  // 逐层在每个被占据的格子里取一个点，层内保持 Morton 顺序
+  std::vector<unsigned int> remaining (n), lod_order;
+  for (size_t i = 0; i < n; ++i)
+    remaining[i] = static_cast<unsigned int> (i);
+  lod_order.reserve (n);
+  std::vector<size_t> level_first;
+  for (int level = 0; !remaining.empty (); ++level)
+  {
+    level_first.push_back (lod_order.size ());
+    const int bits = start_level + level;
+    if (level == max_levels - 1 || bits >= kMortonBits)
+    {
+      for (size_t i = 0; i < remaining.size (); ++i)
+        lod_order.push_back (entries[remaining[i]].index);
+      remaining.clear ();
+      break;
+    }
+    const int shift = 3 * (kMortonBits - bits);
+    size_t kept = 0;
+    for (size_t a = 0; a < remaining.size (); )
+    {
+      const unsigned long long cell = entries[remaining[a]].code >> shift;
+      size_t b = a + 1;
+      while (b < remaining.size () && (entries[remaining[b]].code >> shift) == cell)
+        ++b;
+      size_t best = a;
+      for (size_t i = a + 1; i < b; ++i)
+        if (pointRank (entries[remaining[i]].index) < pointRank (entries[remaining[best]].index))
+          best = i;
+      lod_order.push_back (entries[remaining[best]].index);
+      for (size_t i = a; i < b; ++i)
+        if (i != best)
+          remaining[kept++] = remaining[i];
+      a = b;
+    }
+    remaining.resize (kept);
+  }
+  std::vector<MortonEntry> ().swap (entries);
+  level_first.push_back (n);
+  std::cerr << ">> " << level_first.size () - 1 << " levels in " << tt.toc () << " ms\n";
+
+  // 每层按 Morton 顺序切块，空间上相邻的点落在同一块里
+  std::vector<Chunk> chunks;
+  for (size_t l = 0; l + 1 < level_first.size (); ++l)
+    for (size_t first = level_first[l]; first < level_first[l + 1]; first += chunk_points)
+    {
+      Chunk c;
+      c.level = static_cast<int> (l);
+      c.first = first;
+      c.count = std::min (static_cast<size_t> (chunk_points), level_first[l + 1] - first);
+      c.bytes = 0;
+      chunks.push_back (c);
+    }
+
+  tt.tic ();
+  boost::filesystem::create_directories (out_dir);
+  int failed = 0;
+#pragma omp parallel for schedule(dynamic,1) reduction(+:failed)
+  for (int c = 0; c < static_cast<int> (chunks.size ()); ++c)
+    if (!writeChunk (cloud, lod_order, has_color, out_dir + "/" + chunkFileName (c), chunks[c]))
+      ++failed;
+  if (failed > 0)
+  {
+    std::cerr << "Could not write " << failed << " chunks to " << out_dir << std::endl;
+    return (-1);
+  }
+
+  std::ofstream json ((out_dir + "/tiles.json").c_str ());
+  json << std::setprecision (9);
+  json << "{\n  \"format\": \"PCT1\",\n  \"points\": " << n << ",\n  \"hasColor\": " << (has_color ? "true" : "false")
+       << ",\n  \"min\": ";
+  writeVector (json, bb_min);
+  json << ",\n  \"max\": ";
+  writeVector (json, bb_max);
+  json << ",\n  \"levels\": [";
+  for (size_t l = 0; l + 1 < level_first.size (); ++l)
+    json << (l > 0 ? ", " : "") << level_first[l + 1] - level_first[l];
+  json << "],\n  \"chunks\": [\n";
+  size_t total_bytes = 0;
+  for (size_t c = 0; c < chunks.size (); ++c)
+  {
+    json << "    {\"file\": \"" << chunkFileName (c) << "\", \"level\": " << chunks[c].level << ", \"points\": "
+         << chunks[c].count << ", \"bytes\": " << chunks[c].bytes << ", \"min\": ";
+    writeVector (json, chunks[c].min);
+    json << ", \"max\": ";
+    writeVector (json, chunks[c].max);
+    json << "}" << (c + 1 < chunks.size () ? "," : "") << "\n";
+    total_bytes += chunks[c].bytes;
+  }
+  json << "  ]\n}\n";
+  if (!json.good ())
+  {
+    std::cerr << "Could not write " << out_dir << "/tiles.json" << std::endl;
+    return (-1);
+  }
+  std::cerr << ">> " << chunks.size () << " chunks, " << total_bytes / (1024 * 1024) << " MB written in "
+            << tt.toc () << " ms\n";
+  for (size_t l = 0; l + 1 < level_first.size (); ++l)
+    std::cerr << "   level " << l << ": " << level_first[l + 1] - level_first[l] << " points\n";
+  return (0);
+}
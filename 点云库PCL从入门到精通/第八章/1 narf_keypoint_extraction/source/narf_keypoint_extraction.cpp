@@ -9,6 +9,7 @@
 #include <pcl/visualization/range_image_visualizer.h>
 #include <boost/thread/thread.hpp>
 #include <iostream>
+#include "parallel_narf.h"
 
 typedef pcl::PointXYZ PointType;
 //参数
@@ -154,8 +155,9 @@ int main(int argc, char** argv) {
   range_image_widget.showRangeImage(range_image);
 
   //提取NARF关键点
-  pcl::RangeImageBorderExtractor range_image_border_extractor;
-  pcl::NarfKeypoint narf_keypoint_detector(&range_image_border_extractor);
+  pcl::ParallelRangeImageBorderExtractor range_image_border_extractor;
+  pcl::ParallelNarfKeypoint narf_keypoint_detector(
+      &range_image_border_extractor);
   narf_keypoint_detector.setRangeImage(&range_image);
   narf_keypoint_detector.getParameters().support_size = support_size;
   // narf_keypoint_detector.getParameters ().add_points_on_straight_edges =
@@ -12,6 +12,7 @@
 #include <pcl/kdtree/impl/kdtree_flann.hpp>
 #include <pcl/common/transforms.h>
 #include <pcl/console/parse.h>
+#include "descriptor_matcher.h"
 
 typedef pcl::PointXYZRGBA PointType;
 typedef pcl::Normal NormalType;
@@ -32,6 +33,7 @@ float rf_rad_ (0.015f);
 float descr_rad_ (0.02f);
 float cg_size_ (0.01f);
 float cg_thresh_ (5.0f);
+float match_recall_ (0.0f);
 
 void
 showHelp (char *filename)
@@ -55,7 +57,9 @@ showHelp (char *filename)
   std::cout << "     --rf_rad val:           Reference frame radius (default 0.015)" << std::endl;
   std::cout << "     --descr_rad val:        Descriptor radius (default 0.02)" << std::endl;
   std::cout << "     --cg_size val:          Cluster size (default 0.01)" << std::endl;
-  std::cout << "     --cg_thresh val:        Clustering threshold (default 5)" << std::endl << std::endl;
+  std::cout << "     --cg_thresh val:        Clustering threshold (default 5)" << std::endl;
+  std::cout << "     --match_recall val:     Use approximate descriptor matching tuned to this" << std::endl;
+  std::cout << "                             recall, e.g. 0.95 (default exact matching)" << std::endl << std::endl;
 }
 
 void
@@ -118,6 +122,7 @@ parseCommandLine (int argc, char *argv[])
   pcl::console::parse_argument (argc, argv, "--scene_ss", scene_ss_);
   pcl::console::parse_argument (argc, argv, "--rf_rad", rf_rad_);
   pcl::console::parse_argument (argc, argv, "--descr_rad", descr_rad_);
+  pcl::console::parse_argument (argc, argv, "--match_recall", match_recall_);
   pcl::console::parse_argument (argc, argv, "--cg_size", cg_size_);
   pcl::console::parse_argument (argc, argv, "--cg_thresh", cg_thresh_);
 }
@@ -254,29 +259,25 @@ main (int argc, char *argv[])
   descr_est.compute (*scene_descriptors);
 
   //
-  //  Find Model-Scene Correspondences with KdTree
+  //  Find Model-Scene Correspondences
   //
   pcl::CorrespondencesPtr model_scene_corrs (new pcl::Correspondences ());
 
-  pcl::KdTreeFLANN<DescriptorType> match_search;
-  match_search.setInputCloud (model_descriptors);
-
-  //  For each scene keypoint descriptor, find nearest neighbor into the model keypoints descriptor cloud and add it to the correspondences vector.
-  for (size_t i = 0; i < scene_descriptors->size (); ++i)
+  //  All scene descriptors are matched in one batched, multi-threaded call. Only matches with a
+  //  squared descriptor distance below 0.25 are kept (SHOT descriptor distances are between 0 and 1 by design).
+  pcl::DescriptorMatcher<DescriptorType> match_search;
+  match_search.setMaxSquaredDistance (0.25f);
+  if (match_recall_ > 0.0f)
   {
-    std::vector<int> neigh_indices (1);
-    std::vector<float> neigh_sqr_dists (1);
-    if (!pcl_isfinite (scene_descriptors->at (i).descriptor[0])) //skipping NaNs
-    {
-      continue;
-    }
-    int found_neighs = match_search.nearestKSearch (scene_descriptors->at (i), 1, neigh_indices, neigh_sqr_dists);
-    if(found_neighs == 1 && neigh_sqr_dists[0] < 0.25f) //  add match only if the squared descriptor distance is less than 0.25 (SHOT descriptor distances are between 0 and 1 by design)
-    {
-      pcl::Correspondence corr (neigh_indices[0], static_cast<int> (i), neigh_sqr_dists[0]);
-      model_scene_corrs->push_back (corr);
-    }
+    match_search.setMethod (pcl::DescriptorMatcher<DescriptorType>::FLANN_KDTREES);
+    match_search.setTargetRecall (match_recall_);
+  }
+  else
+  {
+    match_search.setMethod (pcl::DescriptorMatcher<DescriptorType>::EXACT);
   }
+  match_search.setInputModel (model_descriptors);
+  match_search.match (*scene_descriptors, *model_scene_corrs);
   std::cout << "Correspondences found: " << model_scene_corrs->size () << std::endl;
 
   //
@@ -0,0 +1,215 @@
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_cloud.h>
+#include <pcl/correspondence.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/keypoints/uniform_sampling.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/kdtree/impl/kdtree_flann.hpp>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "descriptor_matcher.h"
+
+typedef pcl::PointXYZRGBA PointType;
+typedef pcl::Normal NormalType;
+typedef pcl::SHOT352 DescriptorType;
+typedef pcl::DescriptorMatcher<DescriptorType> Matcher;
+
+using namespace pcl::console;
+
+// 与 correspondence_grouping 相同的流程：法线 -> 均匀采样关键点 -> SHOT 描述子
+bool
+computeDescriptors (const std::string &file, float ss, float descr_rad, pcl::PointCloud<DescriptorType> &descriptors)
+{
+  pcl::PointCloud<PointType>::Ptr cloud (new pcl::PointCloud<PointType> ());
+  pcl::PointCloud<PointType>::Ptr keypoints (new pcl::PointCloud<PointType> ());
+  pcl::PointCloud<NormalType>::Ptr normals (new pcl::PointCloud<NormalType> ());
+  if (pcl::io::loadPCDFile (file, *cloud) < 0)
+  {
+    std::cout << "Error loading " << file << std::endl;
+    return (false);
+  }
+
+  pcl::NormalEstimationOMP<PointType, NormalType> norm_est;
+  norm_est.setKSearch (10);
+  norm_est.setInputCloud (cloud);
+  norm_est.compute (*normals);
+
+  pcl::PointCloud<int> sampled_indices;
+  pcl::UniformSampling<PointType> uniform_sampling;
+  uniform_sampling.setInputCloud (cloud);
+  uniform_sampling.setRadiusSearch (ss);
+  uniform_sampling.compute (sampled_indices);
+  pcl::copyPointCloud (*cloud, sampled_indices.points, *keypoints);
+
+  pcl::SHOTEstimationOMP<PointType, NormalType, DescriptorType> descr_est;
+  descr_est.setRadiusSearch (descr_rad);
+  descr_est.setInputCloud (keypoints);
+  descr_est.setInputNormals (normals);
+  descr_est.setSearchSurface (cloud);
+  descr_est.compute (descriptors);
+  return (true);
+}
+
+// 随机的单位长度描述子，用于测试大模型（数万个描述子）
+void
+randomDescriptors (size_t n, pcl::PointCloud<DescriptorType> &descriptors)
+{
+  descriptors.points.resize (n);
+  descriptors.width = static_cast<uint32_t> (n);
+  descriptors.height = 1;
+  for (size_t i = 0; i < n; ++i)
+  {
+    float norm = 0.0f;
+    for (int d = 0; d < 352; ++d)
+    {
+      // 稀疏、非负的直方图，和真实 SHOT 类似
+      float v = (std::rand () % 4 == 0) ? static_cast<float> (std::rand ()) / RAND_MAX : 0.0f;
+      descriptors.points[i].descriptor[d] = v;
+      norm += v * v;
+    }
+    norm = std::sqrt (norm);
+    for (int d = 0; d < 352 && norm > 0.0f; ++d)
+      descriptors.points[i].descriptor[d] /= norm;
+  }
+}
+
+// 原 correspondence_grouping 中的逐点 KdTreeFLANN 查询
+void
+serialMatch (const pcl::PointCloud<DescriptorType>::Ptr &model, const pcl::PointCloud<DescriptorType> &scene, std::vector<int> &indices)
+{
+  pcl::KdTreeFLANN<DescriptorType> match_search;
+  match_search.setInputCloud (model);
+  indices.assign (scene.size (), -1);
+  std::vector<int> neigh_indices (1);
+  std::vector<float> neigh_sqr_dists (1);
+  for (size_t i = 0; i < scene.size (); ++i)
+  {
+    if (!pcl_isfinite (scene.at (i).descriptor[0]))
+      continue;
+    if (match_search.nearestKSearch (scene.at (i), 1, neigh_indices, neigh_sqr_dists) == 1)
+      indices[i] = neigh_indices[0];
+  }
+}
+
+// 召回率：近似最近邻与精确最近邻相同的比例
+double
+recall (const std::vector<int> &reference, const std::vector<int> &indices)
+{
+  size_t valid = 0, hits = 0;
+  for (size_t i = 0; i < reference.size (); ++i)
+  {
+    if (reference[i] < 0)
+      continue;
+    ++valid;
+    if (indices[i] == reference[i])
+      ++hits;
+  }
+  return (valid > 0 ? static_cast<double> (hits) / valid : 1.0);
+}
+
+void
+printRow (const std::string &name, double ms, size_t queries, double r)
+{
+  std::cout << "  " << std::setw (28) << std::left << name << std::right << std::fixed
+            << std::setprecision (2) << std::setw (10) << ms << " ms  " << std::setw (10)
+            << std::setprecision (0) << queries / (ms * 1e-3) << " queries/s  recall "
+            << std::setprecision (4) << r << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  float model_ss = 0.01f, scene_ss = 0.03f, descr_rad = 0.02f;
+  int synthetic = 0, threads = 0, trees = 4;
+  parse_argument (argc, argv, "--model_ss", model_ss);
+  parse_argument (argc, argv, "--scene_ss", scene_ss);
+  parse_argument (argc, argv, "--descr_rad", descr_rad);
+  parse_argument (argc, argv, "--synthetic", synthetic);
+  parse_argument (argc, argv, "-t", threads);
+  parse_argument (argc, argv, "--trees", trees);
+
+  pcl::PointCloud<DescriptorType>::Ptr model_descriptors (new pcl::PointCloud<DescriptorType> ());
+  pcl::PointCloud<DescriptorType>::Ptr scene_descriptors (new pcl::PointCloud<DescriptorType> ());
+  std::vector<int> filenames = parse_file_extension_argument (argc, argv, ".pcd");
+  TicToc tt;
+  if (synthetic > 0)
+  {
+    randomDescriptors (static_cast<size_t> (synthetic), *model_descriptors);
+    randomDescriptors (static_cast<size_t> (synthetic) / 4, *scene_descriptors);
+  }
+  else if (filenames.size () == 2)
+  {
+    std::cerr << "Computing SHOT descriptors...\n", tt.tic ();
+    if (!computeDescriptors (argv[filenames[0]], model_ss, descr_rad, *model_descriptors) ||
+        !computeDescriptors (argv[filenames[1]], scene_ss, descr_rad, *scene_descriptors))
+      return (-1);
+    std::cerr << ">> Done: " << tt.toc () << " ms\n";
+  }
+  else
+  {
+    std::cout << argv[0] << " model.pcd scene.pcd [--model_ss val --scene_ss val --descr_rad val]" << std::endl;
+    std::cout << argv[0] << " --synthetic model_size" << std::endl;
+    std::cout << "     -t threads, --trees randomized kd-trees (default 4)" << std::endl;
+    return (0);
+  }
+  const size_t queries = scene_descriptors->size ();
+  std::cout << "model descriptors: " << model_descriptors->size () << ", scene descriptors: " << queries << std::endl;
+
+  std::vector<int> reference, indices;
+  std::vector<float> sqr_distances;
+  tt.tic ();
+  serialMatch (model_descriptors, *scene_descriptors, reference);
+  printRow ("KdTreeFLANN, one by one", tt.toc (), queries, 1.0);
+
+  Matcher matcher;
+  matcher.setMethod (Matcher::EXACT);
+  matcher.setInputModel (model_descriptors);
+  matcher.setNumberOfThreads (1);
+  tt.tic ();
+  matcher.findNearest (*scene_descriptors, indices, sqr_distances);
+  printRow ("exact, 1 thread", tt.toc (), queries, recall (reference, indices));
+  // 以批量精确搜索的结果为基准（KdTreeFLANN 本身也是精确的）
+  reference = indices;
+  matcher.setNumberOfThreads (threads);
+  tt.tic ();
+  matcher.findNearest (*scene_descriptors, indices, sqr_distances);
+  printRow ("exact, all threads", tt.toc (), queries, recall (reference, indices));
+
+  // 近似搜索：叶节点检查次数与召回率、速度的关系
+  matcher.setMethod (Matcher::FLANN_KDTREES);
+  matcher.setNumberOfTrees (trees);
+  tt.tic ();
+  matcher.setInputModel (model_descriptors);
+  matcher.setChecks (16);
+  matcher.findNearest (*scene_descriptors, indices, sqr_distances);
+  std::cout << "  kd-tree build + first search: " << tt.toc () << " ms" << std::endl;
+  for (int checks = 16; checks <= 1024; checks *= 2)
+  {
+    std::stringstream name;
+    name << "flann, checks " << checks;
+    matcher.setChecks (checks);
+    tt.tic ();
+    matcher.findNearest (*scene_descriptors, indices, sqr_distances);
+    printRow (name.str (), tt.toc (), queries, recall (reference, indices));
+  }
+
+  // 自动标定：达到目标召回率所需的最少检查次数
+  const double targets[] = { 0.8, 0.9, 0.95, 0.99 };
+  for (int i = 0; i < 4; ++i)
+  {
+    matcher.setTargetRecall (targets[i]);
+    matcher.findNearest (*scene_descriptors, indices, sqr_distances);
+    std::stringstream name;
+    name << "target " << targets[i] << " -> checks " << matcher.getChecks ();
+    tt.tic ();
+    matcher.findNearest (*scene_descriptors, indices, sqr_distances);
+    printRow (name.str (), tt.toc (), queries, recall (reference, indices));
+  }
+  return (0);
+}
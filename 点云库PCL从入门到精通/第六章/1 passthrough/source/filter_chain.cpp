@@ -0,0 +1,110 @@
+#include <pcl/point_types.h>
+#include <pcl/filters/filter.h>
+#include <pcl/filters/passthrough.h>
+#include <pcl/filters/conditional_removal.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "filter_chain.h"
+
+typedef pcl::PointXYZ PointT;
+using namespace pcl::console;
+
+// 融合后的谓词：去 NaN、z 直通、x 条件、裁剪盒，对应下面逐级滤波的四步
+typedef pcl::chain::And<pcl::chain::Greater<pcl::fields::x>, pcl::chain::Less<pcl::fields::x> > XCondition;
+typedef pcl::chain::And<pcl::chain::FiniteXYZ,
+        pcl::chain::And<pcl::chain::PassThrough<pcl::fields::z>,
+        pcl::chain::And<XCondition, pcl::chain::CropBox> > > Predicate;
+
+int
+main (int argc, char** argv)
+{
+  float millions = 5.0f, nan_ratio = 0.05f;
+  int threads = 0;
+  parse_argument (argc, argv, "-n", millions);
+  parse_argument (argc, argv, "-nan", nan_ratio);
+  parse_argument (argc, argv, "-t", threads);
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [-n millions (default 5)] [-nan ratio (default 0.05)] [-t threads]\n";
+    return (0);
+  }
+
+  // 填入点云数据：[-1, 1]^3 内的随机点，部分为 NaN
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  cloud->width = static_cast<uint32_t> (millions * 1e6);
+  cloud->height = 1;
+  cloud->is_dense = false;
+  cloud->points.resize (cloud->width);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    cloud->points[i].x = 2.0f * rand () / (RAND_MAX + 1.0f) - 1.0f;
+    cloud->points[i].y = 2.0f * rand () / (RAND_MAX + 1.0f) - 1.0f;
+    cloud->points[i].z = 2.0f * rand () / (RAND_MAX + 1.0f) - 1.0f;
+    if (rand () / (RAND_MAX + 1.0f) < nan_ratio)
+      cloud->points[i].x = cloud->points[i].y = cloud->points[i].z = std::numeric_limits<float>::quiet_NaN ();
+  }
+  std::cerr << cloud->points.size () << " points" << std::endl;
+
+  // 逐级滤波：每一级扫描一遍点云并生成一个中间点云
+  TicToc tt;
+  tt.tic ();
+  pcl::PointCloud<PointT>::Ptr finite (new pcl::PointCloud<PointT>);
+  std::vector<int> nan_indices;
+  pcl::removeNaNFromPointCloud (*cloud, *finite, nan_indices);
+
+  pcl::PointCloud<PointT>::Ptr passed (new pcl::PointCloud<PointT>);
+  pcl::PassThrough<PointT> pass;
+  pass.setInputCloud (finite);
+  pass.setFilterFieldName ("z");
+  pass.setFilterLimits (-0.5f, 0.8f);
+  pass.filter (*passed);
+
+  pcl::PointCloud<PointT>::Ptr conditioned (new pcl::PointCloud<PointT>);
+  pcl::ConditionAnd<PointT>::Ptr range_cond (new pcl::ConditionAnd<PointT> ());
+  range_cond->addComparison (pcl::FieldComparison<PointT>::ConstPtr (new
+    pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::GT, -0.7)));
+  range_cond->addComparison (pcl::FieldComparison<PointT>::ConstPtr (new
+    pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::LT, 0.7)));
+  pcl::ConditionalRemoval<PointT> condrem (range_cond);
+  condrem.setInputCloud (passed);
+  condrem.filter (*conditioned);
+
+  pcl::PointCloud<PointT> staged;
+  pcl::CropBox<PointT> crop;
+  crop.setInputCloud (conditioned);
+  crop.setMin (Eigen::Vector4f (-0.9f, -0.6f, -1.0f, 1.0f));
+  crop.setMax (Eigen::Vector4f (0.9f, 0.6f, 1.0f, 1.0f));
+  crop.filter (staged);
+  std::cerr << "4 chained filters: " << tt.toc () << " ms, " << staged.points.size () << " points" << std::endl;
+
+  // 融合：同样四个条件组成一个谓词，一次并行扫描
+  pcl::FilterChain<PointT, Predicate> chain (pcl::chain::allOf (
+    pcl::chain::FiniteXYZ (),
+    pcl::chain::PassThrough<pcl::fields::z> (-0.5f, 0.8f),
+    pcl::chain::allOf (pcl::chain::Greater<pcl::fields::x> (-0.7f), pcl::chain::Less<pcl::fields::x> (0.7f)),
+    pcl::chain::CropBox (Eigen::Vector3f (-0.9f, -0.6f, -1.0f), Eigen::Vector3f (0.9f, 0.6f, 1.0f))));
+  chain.setInputCloud (cloud);
+  chain.setNumberOfThreads (threads);
+  pcl::PointCloud<PointT> fused;
+  tt.tic ();
+  chain.filter (fused);
+  std::cerr << "FilterChain (cloud):   " << tt.toc () << " ms, " << fused.points.size () << " points" << std::endl;
+
+  std::vector<int> indices;
+  tt.tic ();
+  chain.filter (indices);
+  std::cerr << "FilterChain (indices): " << tt.toc () << " ms, " << indices.size () << " indices" << std::endl;
+
+  // 两种方式保留的点应当完全相同，且顺序一致
+  bool same = staged.points.size () == fused.points.size ();
+  for (size_t i = 0; same && i < fused.points.size (); ++i)
+    same = staged.points[i].x == fused.points[i].x && staged.points[i].y == fused.points[i].y &&
+           staged.points[i].z == fused.points[i].z;
+  std::cerr << (same ? "Results are identical." : "Results differ!") << std::endl;
+  return (same ? 0 : -1);
+}
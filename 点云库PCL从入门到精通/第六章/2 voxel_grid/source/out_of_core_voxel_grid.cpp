@@ -0,0 +1,78 @@
+#include <pcl/console/parse.h>
+#include <pcl/console/print.h>
+#include <pcl/console/time.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "out_of_core_voxel_grid.h"
+
+using namespace pcl::console;
+
+int
+main (int argc, char** argv)
+{
+  std::vector<int> files = parse_file_extension_argument (argc, argv, ".pcd");
+  std::string output;
+  parse_argument (argc, argv, "-o", output);
+  const int output_index = find_argument (argc, argv, "-o") + 1;
+  files.erase (std::remove (files.begin (), files.end (), output_index), files.end ());
+  if (files.empty () || output.empty ())
+  {
+    std::cout << argv[0] << " input.pcd [input2.pcd ...] -o output.pcd [options]\n"
+              << "  -leaf size        leaf size in metres (default 0.01)\n"
+              << "  -tile size        tile size in metres, the output is ordered by tile (default 10)\n"
+              << "  -mem MB           memory for the voxel sums before they go to disk (default 1024)\n"
+              << "  -chunk n          points read at a time (default 1048576)\n"
+              << "  -partitions n     number of temporary partitions (default 64)\n"
+              << "  -tmp dir          directory for temporary files (default output.pcd.tmp)\n"
+              << "  -min_points n     drop voxels with fewer points (default 0)\n"
+              << "  -t n              number of threads (default: all cores)\n"
+              << "Input files must be ascii or binary PCDs with the same fields.\n";
+    return (0);
+  }
+
+  float leaf = 0.01f, tile = 10.0f;
+  int memory = 1024, chunk = 1 << 20, partitions = 64, min_points = 0, threads = 0;
+  std::string temporary;
+  parse_argument (argc, argv, "-leaf", leaf);
+  parse_argument (argc, argv, "-tile", tile);
+  parse_argument (argc, argv, "-mem", memory);
+  parse_argument (argc, argv, "-chunk", chunk);
+  parse_argument (argc, argv, "-partitions", partitions);
+  parse_argument (argc, argv, "-tmp", temporary);
+  parse_argument (argc, argv, "-min_points", min_points);
+  parse_argument (argc, argv, "-t", threads);
+
+  std::vector<std::string> inputs;
+  for (size_t i = 0; i < files.size (); ++i)
+  {
+    inputs.push_back (argv[files[i]]);
+    if (inputs.back () == output)
+    {
+      print_error ("The output %s is also an input.\n", output.c_str ());
+      return (-1);
+    }
+  }
+
+  pcl::OutOfCoreVoxelGrid grid;
+  grid.setLeafSize (leaf);
+  grid.setTileSize (tile);
+  grid.setMemoryLimit (static_cast<size_t> (memory) << 20);
+  grid.setChunkSize (chunk);
+  grid.setNumberOfPartitions (partitions);
+  grid.setTemporaryDirectory (temporary);
+  grid.setMinimumPointsNumberPerVoxel (min_points);
+  grid.setNumberOfThreads (threads);
+
+  TicToc tt;
+  tt.tic ();
+  if (!grid.filter (inputs, output))
+    return (-1);
+  double ms = tt.toc ();
+  std::cout << "Read " << grid.getPointsRead () << " points (" << grid.getValidPoints () << " finite) from "
+            << inputs.size () << " file(s), wrote " << grid.getNumberOfVoxels () << " voxels to " << output << "\n"
+            << "  " << grid.getNumberOfSpills () << " spills, " << grid.getTemporaryBytes () / (1 << 20)
+            << " MB of temporary files, " << ms / 1000.0 << " s" << std::endl;
+  return (0);
+}
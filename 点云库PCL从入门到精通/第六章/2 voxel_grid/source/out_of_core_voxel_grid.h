@@ -0,0 +1,997 @@
+/*! \file out_of_core_voxel_grid.h
+*  Voxel grid downsampling of PCD files larger than memory: chunked reading, voxel sums partitioned by tile and spilled to disk, output in tile order.
+*/
+#ifndef OUT_OF_CORE_VOXEL_GRID_H_
+#define OUT_OF_CORE_VOXEL_GRID_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/console/print.h>
+#include <boost/unordered_map.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief Voxel grid downsampling of PCD files that do not fit into memory.
+    *
+    * VoxelGrid<PCLPointCloud2> needs the whole blob and its sorted index in
+    * memory. This filter streams one or more PCD files (ascii or binary, all
+    * with the same fields) in chunks of setChunkSize points and only keeps the
+    * per-voxel sums:
+    *  - every voxel belongs to a tile of setTileSize; a hash of the tile picks one
+    *    of setNumberOfPartitions partitions, each with its own voxel hash map, so
+    *    a chunk is accumulated by all threads at once, one partition per thread;
+    *  - when the maps grow beyond setMemoryLimit they are appended to one
+    *    temporary file per partition and cleared;
+    *  - at the end every partition file is reduced on its own (split again by
+    *    voxel hash while it is still too large), its voxels are averaged, sorted
+    *    by tile and written as a run, and the runs are merged into the output,
+    *    which therefore lists the voxels tile after tile.
+    * Memory use is the limit plus one chunk, whatever the size of the input.
+    * All fields are averaged (packed rgb/rgba per channel) and written with
+    * their input types to a binary PCD.
+    */
+  class OutOfCoreVoxelGrid
+  {
+    public:
+      struct VoxelKey
+      {
+        int x, y, z;
+        inline bool operator== (const VoxelKey &other) const { return (x == other.x && y == other.y && z == other.z); }
+      };
+
+      OutOfCoreVoxelGrid ()
+        : leaf_size_ (0.01f)
+        , tile_size_ (10.0f)
+        , memory_limit_ (static_cast<size_t> (1) << 30)
+        , chunk_size_ (1 << 20)
+        , partitions_ (64)
+        , min_points_per_voxel_ (0)
+        , threads_ (0)
+        , point_step_ (0)
+        , tile_voxels_ (1)
+        , points_read_ (0)
+        , points_valid_ (0)
+        , voxels_ (0)
+        , spills_ (0)
+        , temporary_bytes_ (0)
+      {
+      }
+
+      inline void
+      setLeafSize (float leaf_size) { leaf_size_ = leaf_size; }
+
+      inline float
+      getLeafSize () const { return (leaf_size_); }
+
+      /** \brief Edge length of the tiles (in metres, rounded to whole voxels) the output is ordered by. */
+      inline void
+      setTileSize (float tile_size) { tile_size_ = tile_size; }
+
+      inline float
+      getTileSize () const { return (tile_size_); }
+
+      /** \brief Bytes the voxel sums may use before they are spilled to disk. */
+      inline void
+      setMemoryLimit (size_t bytes) { memory_limit_ = bytes; }
+
+      inline size_t
+      getMemoryLimit () const { return (memory_limit_); }
+
+      /** \brief Number of points read and accumulated at a time. */
+      inline void
+      setChunkSize (int points) { chunk_size_ = std::max (points, 1); }
+
+      inline int
+      getChunkSize () const { return (chunk_size_); }
+
+      /** \brief Number of partitions (and temporary files) the voxels are hashed into. */
+      inline void
+      setNumberOfPartitions (int partitions) { partitions_ = std::max (partitions, 1); }
+
+      /** \brief Directory for the temporary files, by default "<output>.tmp". Every run works in
+        * a new subdirectory of it with a unique name, removed with all its files at the end.
+        */
+      inline void
+      setTemporaryDirectory (const std::string &directory) { temporary_directory_ = directory; }
+
+      /** \brief Voxels with fewer points are dropped. */
+      inline void
+      setMinimumPointsNumberPerVoxel (unsigned int min_points) { min_points_per_voxel_ = min_points; }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Downsample the input files into one binary PCD.
+        * \param[in] inputs PCD files (ascii or binary) with identical fields
+        * \param[in] output the downsampled cloud
+        * \return false on errors (unreadable or compressed input, fields differ, no x/y/z)
+        */
+      bool
+      filter (const std::vector<std::string> &inputs, const std::string &output)
+      {
+        points_read_ = points_valid_ = voxels_ = spills_ = temporary_bytes_ = 0;
+        if (inputs.empty () || leaf_size_ <= 0.0f)
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::filter] No input files or invalid leaf size.\n");
+          return (false);
+        }
+        tile_voxels_ = std::max (1, static_cast<int> (tile_size_ / leaf_size_ + 0.5f));
+
+        PCDHeader header;
+        if (!readHeader (inputs[0], header) || !setLayout (header))
+          return (false);
+
+        std::string directory = temporary_directory_.empty () ? output + ".tmp" : temporary_directory_;
+        bool created_directory = false;
+        if (!boost::filesystem::exists (directory))
+        {
+          boost::system::error_code ec;
+          boost::filesystem::create_directories (directory, ec);
+          if (ec)
+          {
+            PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::filter] Can not create %s.\n", directory.c_str ());
+            return (false);
+          }
+          created_directory = true;
+        }
+        // 每次运行用一个新建的子目录：中断或并行运行留下的分区文件不会被续写进来
+        boost::filesystem::path run_directory;
+        bool created_run_directory = false;
+        for (int attempt = 0; attempt < 16 && !created_run_directory; ++attempt)
+        {
+          boost::system::error_code ec;
+          run_directory = boost::filesystem::path (directory) / boost::filesystem::unique_path ("voxel_grid_%%%%-%%%%-%%%%-%%%%");
+          created_run_directory = boost::filesystem::create_directory (run_directory, ec) && !ec;
+        }
+        if (!created_run_directory)
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::filter] Can not create a temporary directory in %s.\n", directory.c_str ());
+          if (created_directory)
+          {
+            boost::system::error_code ec;
+            boost::filesystem::remove (directory, ec);
+          }
+          return (false);
+        }
+        directory_ = run_directory.string ();
+        partition_maps_.assign (partitions_, Partition ());
+        runs_.clear ();
+
+        // 第一遍：分块读入，按分区累加体素和，超出内存上限就写到分区文件
+        bool ok = true;
+        for (size_t f = 0; f < inputs.size () && ok; ++f)
+        {
+          if (f > 0 && !(readHeader (inputs[f], header) && sameLayout (header, inputs[f])))
+            ok = false;
+          else
+            ok = readFile (inputs[f], header);
+        }
+
+        // 第二遍：每个分区单独归约、求平均，按瓦片排序写成一段
+        if (ok && spills_ == 0)
+        {
+          for (int p = 0; p < partitions_ && ok; ++p)
+          {
+            ok = writeRun (partition_maps_[p]);
+            Partition ().swap (partition_maps_[p]);
+          }
+        }
+        else if (ok)
+        {
+          ok = spill ();
+          for (int p = 0; p < partitions_ && ok; ++p)
+            if (boost::filesystem::exists (partitionFile (p)))
+              ok = reduceFile (partitionFile (p), 0);
+        }
+        std::vector<Partition> ().swap (partition_maps_);
+
+        // 各段已经按瓦片排好序，多路归并得到输出
+        if (ok)
+          ok = mergeRuns (output);
+
+        boost::system::error_code ec;
+        boost::filesystem::remove_all (run_directory, ec);
+        if (created_directory)
+          boost::filesystem::remove (directory, ec);
+        return (ok);
+      }
+
+      /** \brief Points read by the last filter call. */
+      inline size_t
+      getPointsRead () const { return (points_read_); }
+
+      /** \brief Points with finite x, y, z read by the last filter call. */
+      inline size_t
+      getValidPoints () const { return (points_valid_); }
+
+      /** \brief Points written by the last filter call. */
+      inline size_t
+      getNumberOfVoxels () const { return (voxels_); }
+
+      /** \brief How often the voxel sums were spilled to disk. */
+      inline size_t
+      getNumberOfSpills () const { return (spills_); }
+
+      /** \brief Bytes written to temporary files. */
+      inline size_t
+      getTemporaryBytes () const { return (temporary_bytes_); }
+
+    private:
+      struct PCDField
+      {
+        std::string name;
+        int size;
+        char type;
+        int count;
+        int offset;
+      };
+
+      struct PCDHeader
+      {
+        std::vector<PCDField> fields;
+        int point_step;
+        size_t points;
+        int data_type;                // 0 ascii, 1 binary, 2 binary_compressed
+        std::streamoff data_offset;
+      };
+
+      /** \brief One averaged value: a field element, or one byte of a packed rgb/rgba field (shift >= 0). */
+      struct Channel
+      {
+        int offset;
+        int size;
+        char type;
+        int shift;
+      };
+
+      struct VoxelKeyHash
+      {
+        inline size_t operator() (const VoxelKey &k) const { return (static_cast<size_t> (hashKey (k, 0))); }
+      };
+
+      /** \brief Voxel sums of one partition: the map gives the row in sums, a row is
+        * the point count followed by the sum of every channel.
+        */
+      struct Partition
+      {
+        boost::unordered_map<VoxelKey, size_t, VoxelKeyHash> index;
+        std::vector<double> sums;
+
+        void swap (Partition &other) { index.swap (other.index); sums.swap (other.sums); }
+      };
+
+      bool
+      readHeader (const std::string &file_name, PCDHeader &header) const
+      {
+        // 自己解析文件头：PCDReader::readHeader 会按点数分配整个数据块
+        std::ifstream fs (file_name.c_str (), std::ios::in | std::ios::binary);
+        if (!fs.is_open ())
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::readHeader] Could not open %s.\n", file_name.c_str ());
+          return (false);
+        }
+        header.fields.clear ();
+        header.points = 0;
+        header.data_type = -1;
+        size_t width = 0, height = 1;
+        bool has_points = false;
+        std::string line;
+        while (std::getline (fs, line))
+        {
+          boost::trim (line);
+          if (line.empty () || line[0] == '#')
+            continue;
+          std::vector<std::string> st;
+          boost::split (st, line, boost::is_any_of ("\t\r "), boost::token_compress_on);
+          const std::string &tag = st[0];
+          const size_t values = st.size () - 1;
+          if (tag == "FIELDS" || tag == "COLUMNS")
+          {
+            header.fields.resize (values);
+            for (size_t i = 0; i < values; ++i)
+            {
+              header.fields[i].name = st[i + 1];
+              header.fields[i].size = 4;
+              header.fields[i].type = 'F';
+              header.fields[i].count = 1;
+            }
+          }
+          else if ((tag == "SIZE" || tag == "TYPE" || tag == "COUNT") && values != header.fields.size ())
+          {
+            PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::readHeader] %s of %s does not match FIELDS.\n", tag.c_str (), file_name.c_str ());
+            return (false);
+          }
+          else if (tag == "SIZE")
+            for (size_t i = 0; i < values; ++i)
+              header.fields[i].size = atoi (st[i + 1].c_str ());
+          else if (tag == "TYPE")
+            for (size_t i = 0; i < values; ++i)
+              header.fields[i].type = st[i + 1][0];
+          else if (tag == "COUNT")
+            for (size_t i = 0; i < values; ++i)
+              header.fields[i].count = atoi (st[i + 1].c_str ());
+          else if (tag == "WIDTH" && values > 0)
+            width = strtoul (st[1].c_str (), NULL, 10);
+          else if (tag == "HEIGHT" && values > 0)
+            height = strtoul (st[1].c_str (), NULL, 10);
+          else if (tag == "POINTS" && values > 0)
+          {
+            header.points = strtoul (st[1].c_str (), NULL, 10);
+            has_points = true;
+          }
+          else if (tag == "DATA" && values > 0)
+          {
+            header.data_type = st[1] == "ascii" ? 0 : (st[1] == "binary" ? 1 : 2);
+            header.data_offset = fs.tellg ();
+            break;
+          }
+        }
+        if (header.data_type < 0 || header.fields.empty ())
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::readHeader] %s is not a PCD file.\n", file_name.c_str ());
+          return (false);
+        }
+        if (header.data_type == 2)
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::readHeader] %s is binary_compressed and can not be read in chunks, "
+                     "convert it to binary first.\n", file_name.c_str ());
+          return (false);
+        }
+        if (!has_points)
+          header.points = width * height;
+        header.point_step = 0;
+        for (size_t i = 0; i < header.fields.size (); ++i)
+        {
+          header.fields[i].offset = header.point_step;
+          header.point_step += header.fields[i].size * header.fields[i].count;
+        }
+        return (true);
+      }
+
+      bool
+      setLayout (const PCDHeader &header)
+      {
+        fields_ = header.fields;
+        point_step_ = header.point_step;
+        channels_.clear ();
+        int xyz[3] = { -1, -1, -1 };
+        for (size_t i = 0; i < fields_.size (); ++i)
+        {
+          const PCDField &field = fields_[i];
+          if ((field.name == "rgb" || field.name == "rgba") && field.size == 4 && field.count == 1)
+          {
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+              Channel c = { field.offset, 4, 'U', shift };
+              channels_.push_back (c);
+            }
+            continue;
+          }
+          for (int k = 0; k < 3; ++k)
+            if (field.name == std::string (1, static_cast<char> ('x' + k)) && field.type == 'F' && field.count == 1)
+              xyz[k] = static_cast<int> (channels_.size ());
+          for (int e = 0; e < field.count; ++e)
+          {
+            Channel c = { field.offset + e * field.size, field.size, field.type, -1 };
+            channels_.push_back (c);
+          }
+        }
+        if (xyz[0] < 0 || xyz[1] < 0 || xyz[2] < 0)
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::setLayout] The input has no float x, y, z fields.\n");
+          return (false);
+        }
+        std::copy (xyz, xyz + 3, xyz_);
+        return (true);
+      }
+
+      bool
+      sameLayout (const PCDHeader &header, const std::string &file_name) const
+      {
+        bool same = header.fields.size () == fields_.size ();
+        for (size_t i = 0; same && i < fields_.size (); ++i)
+          same = header.fields[i].name == fields_[i].name && header.fields[i].size == fields_[i].size &&
+                 header.fields[i].type == fields_[i].type && header.fields[i].count == fields_[i].count;
+        if (!same)
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::filter] The fields of %s differ from the first input.\n", file_name.c_str ());
+        return (same);
+      }
+
+      /** \brief Read one file chunk by chunk and accumulate every chunk. */
+      bool
+      readFile (const std::string &file_name, const PCDHeader &header)
+      {
+        std::ifstream fs (file_name.c_str (), std::ios::in | std::ios::binary);
+        fs.seekg (header.data_offset);
+        std::vector<unsigned char> chunk (static_cast<size_t> (chunk_size_) * point_step_);
+        size_t remaining = header.points;
+        std::string line;
+        while (remaining > 0 && fs.good ())
+        {
+          size_t n = std::min (remaining, static_cast<size_t> (chunk_size_));
+          if (header.data_type == 1)
+          {
+            fs.read (reinterpret_cast<char*> (&chunk[0]), static_cast<std::streamsize> (n * point_step_));
+            n = static_cast<size_t> (fs.gcount ()) / point_step_;
+          }
+          else
+          {
+            size_t read = 0;
+            while (read < n && std::getline (fs, line))
+              if (parseLine (line, &chunk[read * point_step_]))
+                ++read;
+            n = read;
+          }
+          if (n == 0)
+            break;
+          remaining -= n;
+          points_read_ += n;
+          accumulate (chunk, static_cast<int> (n));
+          if (memoryUsage () > memory_limit_ && !spill ())
+            return (false);
+        }
+        if (remaining > 0)
+          PCL_WARN ("[pcl::OutOfCoreVoxelGrid::readFile] %s ends %lu points early.\n", file_name.c_str (), static_cast<unsigned long> (remaining));
+        return (true);
+      }
+
+      /** \brief Parse one ascii line into the binary layout of a point. */
+      bool
+      parseLine (const std::string &line, unsigned char *point) const
+      {
+        std::vector<std::string> st;
+        std::string trimmed = boost::trim_copy (line);
+        if (trimmed.empty ())
+          return (false);
+        boost::split (st, trimmed, boost::is_any_of ("\t\r "), boost::token_compress_on);
+        size_t t = 0;
+        for (size_t i = 0; i < fields_.size (); ++i)
+        {
+          const PCDField &field = fields_[i];
+          for (int e = 0; e < field.count; ++e, ++t)
+          {
+            if (t >= st.size ())
+              return (false);
+            unsigned char *value = point + field.offset + e * field.size;
+            // PCDWriter 把 float 类型的 rgb 按 uint32 整数写出
+            if ((field.name == "rgb" || field.name == "rgba") && field.size == 4 &&
+                st[t].find_first_of (".eEnN") == std::string::npos)
+            {
+              unsigned int rgb = static_cast<unsigned int> (strtoul (st[t].c_str (), NULL, 10));
+              memcpy (value, &rgb, 4);
+            }
+            else
+              writeValue (value, field.size, field.type, strtod (st[t].c_str (), NULL));
+          }
+        }
+        return (true);
+      }
+
+      /** \brief Add the points of a chunk to the partition maps. */
+      void
+      accumulate (const std::vector<unsigned char> &chunk, int n)
+      {
+        const int channels = static_cast<int> (channels_.size ());
+        const int stride = channels + 1;
+        const double inverse_leaf = 1.0 / leaf_size_;
+        values_.resize (static_cast<size_t> (n) * channels);
+        keys_.resize (n);
+        std::vector<int> partition (n);
+
+        // 解码、求体素键和分区，各点独立
+        int valid = 0;
+#pragma omp parallel for reduction(+:valid) num_threads(getThreads ())
+        for (int i = 0; i < n; ++i)
+        {
+          const unsigned char *point = &chunk[static_cast<size_t> (i) * point_step_];
+          double *v = &values_[static_cast<size_t> (i) * channels];
+          for (int c = 0; c < channels; ++c)
+            v[c] = readChannel (point, channels_[c]);
+          partition[i] = -1;
+          double b[3];
+          bool ok = true;
+          for (int k = 0; k < 3; ++k)
+          {
+            b[k] = std::floor (v[xyz_[k]] * inverse_leaf);
+            ok = ok && pcl_isfinite (b[k]) && std::abs (b[k]) < 1e9;
+          }
+          if (!ok)
+            continue;
+          VoxelKey key = { static_cast<int> (b[0]), static_cast<int> (b[1]), static_cast<int> (b[2]) };
+          keys_[i] = key;
+          partition[i] = static_cast<int> (hashKey (tileOf (key), 1) % partitions_);
+          ++valid;
+        }
+        points_valid_ += valid;
+
+        // 按分区分桶，之后每个线程独占一个分区的哈希表
+        std::vector<int> offsets (partitions_ + 1, 0), order (valid);
+        for (int i = 0; i < n; ++i)
+          if (partition[i] >= 0)
+            ++offsets[partition[i] + 1];
+        for (int p = 0; p < partitions_; ++p)
+          offsets[p + 1] += offsets[p];
+        std::vector<int> fill (offsets.begin (), offsets.end () - 1);
+        for (int i = 0; i < n; ++i)
+          if (partition[i] >= 0)
+            order[fill[partition[i]]++] = i;
+
+#pragma omp parallel for schedule(dynamic,1) num_threads(getThreads ())
+        for (int p = 0; p < partitions_; ++p)
+        {
+          Partition &part = partition_maps_[p];
+          for (int j = offsets[p]; j < offsets[p + 1]; ++j)
+          {
+            const int i = order[j];
+            double *sum = addVoxel (part, keys_[i], stride);
+            sum[0] += 1.0;
+            const double *v = &values_[static_cast<size_t> (i) * channels];
+            for (int c = 0; c < channels; ++c)
+              sum[c + 1] += v[c];
+          }
+        }
+      }
+
+      static inline double*
+      addVoxel (Partition &part, const VoxelKey &key, int stride)
+      {
+        std::pair<boost::unordered_map<VoxelKey, size_t, VoxelKeyHash>::iterator, bool> r =
+          part.index.insert (std::make_pair (key, part.sums.size () / stride));
+        if (r.second)
+          part.sums.resize (part.sums.size () + stride, 0.0);
+        return (&part.sums[r.first->second * stride]);
+      }
+
+      /** \brief Estimated bytes of the partition maps: map nodes and buckets plus the sums. */
+      size_t
+      memoryUsage () const
+      {
+        size_t bytes = 0;
+        for (int p = 0; p < partitions_; ++p)
+          bytes += partition_maps_[p].index.size () * (sizeof (VoxelKey) + 3 * sizeof (size_t) + sizeof (void*)) +
+                   partition_maps_[p].index.bucket_count () * sizeof (void*) +
+                   partition_maps_[p].sums.capacity () * sizeof (double);
+        return (bytes);
+      }
+
+      inline size_t
+      recordBytes () const { return (sizeof (VoxelKey) + (channels_.size () + 1) * sizeof (double)); }
+
+      inline std::string
+      partitionFile (int p) const
+      {
+        std::stringstream ss;
+        ss << directory_ << "/partition_" << p << ".bin";
+        return (ss.str ());
+      }
+
+      /** \brief Append every partition map to its file and clear it. */
+      bool
+      spill ()
+      {
+        const int stride = static_cast<int> (channels_.size ()) + 1;
+        size_t written = 0;
+        int failed = 0;
+#pragma omp parallel for schedule(dynamic,1) reduction(+:written,failed) num_threads(getThreads ())
+        for (int p = 0; p < partitions_; ++p)
+        {
+          Partition &part = partition_maps_[p];
+          if (part.index.empty ())
+            continue;
+          if (!appendRecords (partitionFile (p), part, stride))
+            ++failed;
+          written += part.index.size () * recordBytes ();
+          Partition ().swap (part);
+        }
+        temporary_bytes_ += written;
+        ++spills_;
+        if (failed > 0)
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::spill] Could not write to %s.\n", directory_.c_str ());
+        return (failed == 0);
+      }
+
+      bool
+      appendRecords (const std::string &file_name, const Partition &part, int stride) const
+      {
+        FILE *file = fopen (file_name.c_str (), "ab");
+        if (!file)
+          return (false);
+        std::vector<unsigned char> buffer;
+        buffer.reserve (1 << 20);
+        boost::unordered_map<VoxelKey, size_t, VoxelKeyHash>::const_iterator it = part.index.begin ();
+        bool ok = true;
+        for ( ; it != part.index.end (); ++it)
+        {
+          const unsigned char *key = reinterpret_cast<const unsigned char*> (&it->first);
+          const unsigned char *sum = reinterpret_cast<const unsigned char*> (&part.sums[it->second * stride]);
+          buffer.insert (buffer.end (), key, key + sizeof (VoxelKey));
+          buffer.insert (buffer.end (), sum, sum + stride * sizeof (double));
+          if (buffer.size () >= (1 << 20))
+          {
+            ok = ok && fwrite (&buffer[0], 1, buffer.size (), file) == buffer.size ();
+            buffer.clear ();
+          }
+        }
+        if (!buffer.empty ())
+          ok = ok && fwrite (&buffer[0], 1, buffer.size (), file) == buffer.size ();
+        return (fclose (file) == 0 && ok);
+      }
+
+      /** \brief Reduce one partition file to a run; files whose voxels would not fit
+        * into the memory limit are first split by voxel hash (up to four times).
+        */
+      bool
+      reduceFile (const std::string &file_name, int depth)
+      {
+        const int stride = static_cast<int> (channels_.size ()) + 1;
+        const size_t record_bytes = recordBytes ();
+        const size_t records = static_cast<size_t> (boost::filesystem::file_size (file_name)) / record_bytes;
+        const size_t entry_bytes = record_bytes + 3 * sizeof (size_t) + 2 * sizeof (void*);
+        FILE *file = fopen (file_name.c_str (), "rb");
+        if (!file)
+          return (false);
+        std::vector<unsigned char> record (record_bytes);
+
+        if (records * entry_bytes > memory_limit_ && depth < 4)
+        {
+          const int fanout = static_cast<int> (std::min<size_t> (16, 2 * records * entry_bytes / std::max<size_t> (memory_limit_, 1) + 1));
+          std::vector<std::string> names (fanout);
+          std::vector<FILE*> parts (fanout);
+          bool ok = true;
+          for (int s = 0; s < fanout; ++s)
+          {
+            std::stringstream ss;
+            ss << file_name << "." << s;
+            names[s] = ss.str ();
+            parts[s] = fopen (names[s].c_str (), "wb");
+            ok = ok && parts[s] != NULL;
+          }
+          while (ok && fread (&record[0], 1, record_bytes, file) == record_bytes)
+          {
+            VoxelKey key;
+            memcpy (&key, &record[0], sizeof (VoxelKey));
+            ok = fwrite (&record[0], 1, record_bytes, parts[hashKey (key, depth + 2) % fanout]) == record_bytes;
+          }
+          fclose (file);
+          std::remove (file_name.c_str ());
+          for (int s = 0; s < fanout; ++s)
+            if (parts[s])
+              ok = fclose (parts[s]) == 0 && ok;
+          temporary_bytes_ += records * record_bytes;
+          for (int s = 0; s < fanout && ok; ++s)
+            ok = reduceFile (names[s], depth + 1);
+          for (int s = 0; s < fanout; ++s)
+            std::remove (names[s].c_str ());
+          return (ok);
+        }
+
+        // 同一体素可能在多次溢出中各有一份部分和，在这里合并
+        Partition part;
+        while (fread (&record[0], 1, record_bytes, file) == record_bytes)
+        {
+          VoxelKey key;
+          memcpy (&key, &record[0], sizeof (VoxelKey));
+          double *sum = addVoxel (part, key, stride);
+          const double *add = reinterpret_cast<const double*> (&record[sizeof (VoxelKey)]);
+          for (int c = 0; c < stride; ++c)
+            sum[c] += add[c];
+        }
+        fclose (file);
+        std::remove (file_name.c_str ());
+        return (writeRun (part));
+      }
+
+      struct TileOrder
+      {
+        TileOrder (const OutOfCoreVoxelGrid &grid) : grid_ (grid) {}
+
+        inline bool
+        operator() (const VoxelKey &a, const VoxelKey &b) const
+        {
+          const VoxelKey ta = grid_.tileOf (a), tb = grid_.tileOf (b);
+          if (ta.z != tb.z) return (ta.z < tb.z);
+          if (ta.y != tb.y) return (ta.y < tb.y);
+          if (ta.x != tb.x) return (ta.x < tb.x);
+          if (a.z != b.z) return (a.z < b.z);
+          if (a.y != b.y) return (a.y < b.y);
+          return (a.x < b.x);
+        }
+
+        inline bool
+        operator() (const std::pair<VoxelKey, size_t> &a, const std::pair<VoxelKey, size_t> &b) const
+        {
+          return ((*this) (a.first, b.first));
+        }
+
+        const OutOfCoreVoxelGrid &grid_;
+      };
+
+      /** \brief Average the voxels of a partition and write them sorted by tile: key, then the point. */
+      bool
+      writeRun (const Partition &part)
+      {
+        if (part.index.empty ())
+          return (true);
+        const int channels = static_cast<int> (channels_.size ());
+        const int stride = channels + 1;
+        std::vector<std::pair<VoxelKey, size_t> > voxels;
+        voxels.reserve (part.index.size ());
+        boost::unordered_map<VoxelKey, size_t, VoxelKeyHash>::const_iterator it = part.index.begin ();
+        for ( ; it != part.index.end (); ++it)
+          if (part.sums[it->second * stride] >= min_points_per_voxel_)
+            voxels.push_back (*it);
+        std::sort (voxels.begin (), voxels.end (), TileOrder (*this));
+
+        std::stringstream ss;
+        ss << directory_ << "/run_" << runs_.size () << ".bin";
+        FILE *file = fopen (ss.str ().c_str (), "wb");
+        if (!file)
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::writeRun] Could not write %s.\n", ss.str ().c_str ());
+          return (false);
+        }
+        runs_.push_back (ss.str ());
+        std::vector<unsigned char> record (sizeof (VoxelKey) + point_step_);
+        std::vector<double> average (channels);
+        bool ok = true;
+        for (size_t v = 0; v < voxels.size () && ok; ++v)
+        {
+          const double *sum = &part.sums[voxels[v].second * stride];
+          for (int c = 0; c < channels; ++c)
+            average[c] = sum[c + 1] / sum[0];
+          memcpy (&record[0], &voxels[v].first, sizeof (VoxelKey));
+          encodePoint (average, &record[sizeof (VoxelKey)]);
+          ok = fwrite (&record[0], 1, record.size (), file) == record.size ();
+        }
+        temporary_bytes_ += voxels.size () * record.size ();
+        return (fclose (file) == 0 && ok);
+      }
+
+      /** \brief k-way merge of the runs by tile into the output PCD. */
+      bool
+      mergeRuns (const std::string &output)
+      {
+        FILE *out = fopen (output.c_str (), "wb");
+        if (!out)
+        {
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::mergeRuns] Could not write %s.\n", output.c_str ());
+          return (false);
+        }
+        writePCDHeader (out, 0);
+
+        const size_t record_bytes = sizeof (VoxelKey) + point_step_;
+        const int runs = static_cast<int> (runs_.size ());
+        std::vector<FILE*> files (runs, static_cast<FILE*> (NULL));
+        std::vector<std::vector<unsigned char> > heads (runs, std::vector<unsigned char> (record_bytes));
+        std::vector<VoxelKey> keys (runs);
+        std::vector<int> heap;
+        bool ok = true;
+        for (int r = 0; r < runs && ok; ++r)
+        {
+          files[r] = fopen (runs_[r].c_str (), "rb");
+          ok = files[r] != NULL;
+          if (ok && fread (&heads[r][0], 1, record_bytes, files[r]) == record_bytes)
+          {
+            memcpy (&keys[r], &heads[r][0], sizeof (VoxelKey));
+            heap.push_back (r);
+          }
+        }
+        RunOrder order (keys, TileOrder (*this));
+        std::make_heap (heap.begin (), heap.end (), order);
+        while (ok && !heap.empty ())
+        {
+          std::pop_heap (heap.begin (), heap.end (), order);
+          const int r = heap.back ();
+          ok = fwrite (&heads[r][sizeof (VoxelKey)], 1, point_step_, out) == static_cast<size_t> (point_step_);
+          ++voxels_;
+          if (fread (&heads[r][0], 1, record_bytes, files[r]) == record_bytes)
+          {
+            memcpy (&keys[r], &heads[r][0], sizeof (VoxelKey));
+            std::push_heap (heap.begin (), heap.end (), order);
+          }
+          else
+            heap.pop_back ();
+        }
+        for (int r = 0; r < runs; ++r)
+          if (files[r])
+            fclose (files[r]);
+
+        // 点数在写完后才知道，回到文件头填上（位置已经留好）
+        ok = ok && fseek (out, 0, SEEK_SET) == 0;
+        if (ok)
+          writePCDHeader (out, voxels_);
+        ok = fclose (out) == 0 && ok;
+        if (!ok)
+          PCL_ERROR ("[pcl::OutOfCoreVoxelGrid::mergeRuns] Writing %s failed.\n", output.c_str ());
+        return (ok);
+      }
+
+      /** \brief Heap order of the runs: the run with the smallest head key on top. */
+      struct RunOrder
+      {
+        RunOrder (const std::vector<VoxelKey> &keys, const TileOrder &less) : keys_ (keys), less_ (less) {}
+
+        inline bool
+        operator() (int a, int b) const { return (less_ (keys_[b], keys_[a])); }
+
+        const std::vector<VoxelKey> &keys_;
+        TileOrder less_;
+      };
+
+      /** \brief Binary PCD header with the input fields; WIDTH and POINTS are padded
+        * so the header can be rewritten in place once the count is known.
+        */
+      void
+      writePCDHeader (FILE *file, size_t points) const
+      {
+        std::stringstream size, type, count;
+        std::stringstream ss;
+        ss << "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS";
+        for (size_t i = 0; i < fields_.size (); ++i)
+        {
+          ss << " " << fields_[i].name;
+          size << " " << fields_[i].size;
+          type << " " << fields_[i].type;
+          count << " " << fields_[i].count;
+        }
+        ss << "\nSIZE" << size.str () << "\nTYPE" << type.str () << "\nCOUNT" << count.str ()
+           << "\nWIDTH " << std::left << std::setw (20) << points
+           << "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS " << std::setw (20) << points
+           << "\nDATA binary\n";
+        const std::string header = ss.str ();
+        fwrite (header.c_str (), 1, header.size (), file);
+      }
+
+      static inline double
+      readValue (const unsigned char *p, int size, char type)
+      {
+        if (type == 'F')
+        {
+          if (size == 8) { double v; memcpy (&v, p, 8); return (v); }
+          float v; memcpy (&v, p, 4); return (v);
+        }
+        if (type == 'U')
+        {
+          if (size == 1) return (*p);
+          if (size == 2) { unsigned short v; memcpy (&v, p, 2); return (v); }
+          if (size == 4) { unsigned int v; memcpy (&v, p, 4); return (v); }
+          unsigned long long v; memcpy (&v, p, 8); return (static_cast<double> (v));
+        }
+        if (size == 1) return (static_cast<signed char> (*p));
+        if (size == 2) { short v; memcpy (&v, p, 2); return (v); }
+        if (size == 4) { int v; memcpy (&v, p, 4); return (v); }
+        long long v; memcpy (&v, p, 8); return (static_cast<double> (v));
+      }
+
+      static inline void
+      writeValue (unsigned char *p, int size, char type, double value)
+      {
+        if (type == 'F')
+        {
+          if (size == 8) { memcpy (p, &value, 8); return; }
+          float v = static_cast<float> (value); memcpy (p, &v, 4); return;
+        }
+        // 整数字段取平均后四舍五入
+        value = std::floor (value + 0.5);
+        if (type == 'U')
+        {
+          if (size == 1) { *p = static_cast<unsigned char> (value); return; }
+          if (size == 2) { unsigned short v = static_cast<unsigned short> (value); memcpy (p, &v, 2); return; }
+          if (size == 4) { unsigned int v = static_cast<unsigned int> (value); memcpy (p, &v, 4); return; }
+          unsigned long long v = static_cast<unsigned long long> (value); memcpy (p, &v, 8); return;
+        }
+        if (size == 1) { signed char v = static_cast<signed char> (value); memcpy (p, &v, 1); return; }
+        if (size == 2) { short v = static_cast<short> (value); memcpy (p, &v, 2); return; }
+        if (size == 4) { int v = static_cast<int> (value); memcpy (p, &v, 4); return; }
+        long long v = static_cast<long long> (value); memcpy (p, &v, 8);
+      }
+
+      static inline double
+      readChannel (const unsigned char *point, const Channel &c)
+      {
+        if (c.shift < 0)
+          return (readValue (point + c.offset, c.size, c.type));
+        unsigned int rgba;
+        memcpy (&rgba, point + c.offset, 4);
+        return ((rgba >> c.shift) & 0xff);
+      }
+
+      void
+      encodePoint (const std::vector<double> &values, unsigned char *point) const
+      {
+        memset (point, 0, point_step_);
+        for (size_t c = 0; c < channels_.size (); ++c)
+        {
+          const Channel &channel = channels_[c];
+          if (channel.shift < 0)
+          {
+            writeValue (point + channel.offset, channel.size, channel.type, values[c]);
+            continue;
+          }
+          unsigned int rgba;
+          memcpy (&rgba, point + channel.offset, 4);
+          rgba |= static_cast<unsigned int> (std::min (255.0, std::floor (values[c] + 0.5))) << channel.shift;
+          memcpy (point + channel.offset, &rgba, 4);
+        }
+      }
+
+      static inline int
+      floorDiv (int a, int b)
+      {
+        return (a >= 0 ? a / b : -((-a + b - 1) / b));
+      }
+
+      inline VoxelKey
+      tileOf (const VoxelKey &k) const
+      {
+        VoxelKey t = { floorDiv (k.x, tile_voxels_), floorDiv (k.y, tile_voxels_), floorDiv (k.z, tile_voxels_) };
+        return (t);
+      }
+
+      static inline unsigned long long
+      hashKey (const VoxelKey &k, unsigned int seed)
+      {
+        unsigned long long h = static_cast<unsigned int> (k.x);
+        h = h * 0x9E3779B97F4A7C15ULL + static_cast<unsigned int> (k.y);
+        h = h * 0x9E3779B97F4A7C15ULL + static_cast<unsigned int> (k.z);
+        h ^= seed * 0xC2B2AE3D27D4EB4FULL;
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return (h);
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      float leaf_size_;
+      float tile_size_;
+      size_t memory_limit_;
+      int chunk_size_;
+      int partitions_;
+      std::string temporary_directory_;
+      unsigned int min_points_per_voxel_;
+      unsigned int threads_;
+
+      std::vector<PCDField> fields_;
+      int point_step_;
+      std::vector<Channel> channels_;
+      int xyz_[3];
+      int tile_voxels_;
+      std::string directory_;
+      std::vector<Partition> partition_maps_;
+      std::vector<std::string> runs_;
+      std::vector<double> values_;
+      std::vector<VoxelKey> keys_;
+
+      size_t points_read_;
+      size_t points_valid_;
+      size_t voxels_;
+      size_t spills_;
+      size_t temporary_bytes_;
+  };
+}
+
+#endif
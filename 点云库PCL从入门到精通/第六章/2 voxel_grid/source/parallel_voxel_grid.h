@@ -0,0 +1,346 @@
+/*! \file parallel_voxel_grid.h
+*  Multi-threaded voxel grid filter: per-thread voxel keys, parallel radix sort, parallel centroid reduction, 64-bit voxel indices.
+*/
+#ifndef PARALLEL_VOXEL_GRID_H_
+#define PARALLEL_VOXEL_GRID_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/console/print.h>
+#include <pcl/filters/filter.h>
+#include <pcl/common/centroid.h>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief Voxel grid filter with the same results as pcl::VoxelGrid, computed in parallel.
+    *
+    * pcl::VoxelGrid computes a voxel index per point, sorts all (index, point)
+    * pairs with std::sort and averages the voxels one after another, all on one
+    * core, and refuses leaf sizes for which the number of voxels of the bounding
+    * box does not fit into 32 bits. Here:
+    *  - voxel keys are computed by all threads, as 32-bit keys when the grid
+    *    allows it and 64-bit keys otherwise (so fine leaves over large extents work);
+    *  - the (key, point) pairs are grouped with a parallel LSD radix sort that
+    *    only runs as many byte passes as the largest key needs;
+    *  - the voxels are reduced to their centroids in parallel; with
+    *    setDownsampleAllData (true) all fields are averaged (pcl::CentroidPoint),
+    *    otherwise only x, y and z.
+    * Voxels come out in the same order as with pcl::VoxelGrid (x fastest, then y, z).
+    */
+  template <typename PointT>
+  class ParallelVoxelGrid : public Filter<PointT>
+  {
+    protected:
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+
+      typedef typename Filter<PointT>::PointCloud PointCloud;
+
+    public:
+      ParallelVoxelGrid ()
+        : leaf_size_ (Eigen::Vector3f::Zero ())
+        , downsample_all_data_ (true)
+        , min_points_per_voxel_ (0)
+        , threads_ (0)
+        , voxels_ (0)
+      {
+        filter_name_ = "ParallelVoxelGrid";
+      }
+
+      inline void
+      setLeafSize (float lx, float ly, float lz) { leaf_size_ = Eigen::Vector3f (lx, ly, lz); }
+
+      inline void
+      setLeafSize (const Eigen::Vector4f &leaf_size) { leaf_size_ = leaf_size.head<3> (); }
+
+      inline Eigen::Vector3f
+      getLeafSize () const { return (leaf_size_); }
+
+      /** \brief Average all fields of the points in a voxel (default), or only x, y, z. */
+      inline void
+      setDownsampleAllData (bool downsample) { downsample_all_data_ = downsample; }
+
+      inline bool
+      getDownsampleAllData () const { return (downsample_all_data_); }
+
+      /** \brief Voxels with fewer points are dropped. */
+      inline void
+      setMinimumPointsNumberPerVoxel (unsigned int min_points) { min_points_per_voxel_ = min_points; }
+
+      inline unsigned int
+      getMinimumPointsNumberPerVoxel () const { return (min_points_per_voxel_); }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Number of occupied voxels found by the last filter call (before the minimum points check). */
+      inline size_t
+      getNumberOfVoxels () const { return (voxels_); }
+
+    protected:
+      void
+      applyFilter (PointCloud &output)
+      {
+        output.points.clear ();
+        output.width = 0;
+        output.height = 1;
+        output.is_dense = true;
+        voxels_ = 0;
+        if (leaf_size_[0] <= 0.0f || leaf_size_[1] <= 0.0f || leaf_size_[2] <= 0.0f)
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] Invalid leaf size.\n", getClassName ().c_str ());
+          return;
+        }
+        const int n = static_cast<int> (indices_->size ());
+        const int threads = getThreads ();
+        inverse_leaf_ = leaf_size_.cwiseInverse ();
+
+        // 1. 有限点的包围盒，每个线程先算自己的一段
+        std::vector<Eigen::Vector3f> t_min (threads, Eigen::Vector3f::Constant (std::numeric_limits<float>::max ()));
+        std::vector<Eigen::Vector3f> t_max (threads, Eigen::Vector3f::Constant (-std::numeric_limits<float>::max ()));
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+          {
+            const PointT &p = input_->points[(*indices_)[i]];
+            if (!isFinite (p))
+              continue;
+            t_min[t] = t_min[t].cwiseMin (p.getVector3fMap ());
+            t_max[t] = t_max[t].cwiseMax (p.getVector3fMap ());
+          }
+        }
+        Eigen::Vector3f min_p = t_min[0], max_p = t_max[0];
+        for (int t = 1; t < threads; ++t)
+        {
+          min_p = min_p.cwiseMin (t_min[t]);
+          max_p = max_p.cwiseMax (t_max[t]);
+        }
+        if (min_p[0] > max_p[0])
+          return;
+
+        // 2. 体素网格的大小，决定用 32 位还是 64 位键
+        double total = 1.0;
+        for (int k = 0; k < 3; ++k)
+        {
+          min_b_[k] = static_cast<long long> (std::floor (min_p[k] * inverse_leaf_[k]));
+          long long max_b = static_cast<long long> (std::floor (max_p[k] * inverse_leaf_[k]));
+          div_b_[k] = max_b - min_b_[k] + 1;
+          total *= static_cast<double> (div_b_[k]);
+        }
+        div_mul_[0] = 1;
+        div_mul_[1] = static_cast<unsigned long long> (div_b_[0]);
+        div_mul_[2] = div_mul_[1] * static_cast<unsigned long long> (div_b_[1]);
+        if (total < static_cast<double> (std::numeric_limits<unsigned int>::max ()))
+          binAndReduce<unsigned int> (output, threads);
+        else if (total < 1.8e19)
+          binAndReduce<unsigned long long> (output, threads);
+        else
+          PCL_ERROR ("[pcl::%s::applyFilter] Leaf size is too small for the input dataset, 64-bit voxel indices would overflow.\n",
+                     getClassName ().c_str ());
+      }
+
+      template <typename KeyT> struct KeyIndex
+      {
+        KeyT key;
+        unsigned int index;
+      };
+
+      /** \brief Steps 3-6 with voxel keys of type KeyT. Non-finite points get the largest
+        * key and end up behind all voxels after sorting.
+        */
+      template <typename KeyT> void
+      binAndReduce (PointCloud &output, int threads)
+      {
+        const int n = static_cast<int> (indices_->size ());
+        const KeyT invalid = std::numeric_limits<KeyT>::max ();
+        std::vector<KeyIndex<KeyT> > pairs (n), buffer (n);
+
+        // 3. 每个点的体素键
+        int invalid_count = 0;
+#pragma omp parallel for reduction(+:invalid_count) num_threads(threads)
+        for (int i = 0; i < n; ++i)
+        {
+          const PointT &p = input_->points[(*indices_)[i]];
+          pairs[i].index = static_cast<unsigned int> ((*indices_)[i]);
+          if (!isFinite (p))
+          {
+            pairs[i].key = invalid;
+            ++invalid_count;
+            continue;
+          }
+          KeyT key = 0;
+          const float xyz[3] = { p.x, p.y, p.z };
+          for (int k = 0; k < 3; ++k)
+          {
+            long long b = static_cast<long long> (std::floor (xyz[k] * inverse_leaf_[k])) - min_b_[k];
+            b = std::max (0LL, std::min (b, div_b_[k] - 1));
+            key += static_cast<KeyT> (b) * static_cast<KeyT> (div_mul_[k]);
+          }
+          pairs[i].key = key;
+        }
+
+        // 4. 基数排序，只做最大有效键所需的字节轮数
+        KeyT max_key = static_cast<KeyT> (div_mul_[2] * static_cast<unsigned long long> (div_b_[2]) - 1);
+        int passes = 0;
+        while (passes < static_cast<int> (sizeof (KeyT)) && (max_key >> (8 * passes)) != 0)
+          ++passes;
+        if (invalid_count > 0)
+          passes = static_cast<int> (sizeof (KeyT));
+        for (int pass = 0; pass < passes; ++pass)
+        {
+          radixPass (pairs, buffer, 8 * pass, threads);
+          pairs.swap (buffer);
+        }
+        std::vector<KeyIndex<KeyT> > ().swap (buffer);
+        const int valid = n - invalid_count;
+
+        // 5. 体素起点：各线程数自己一段里的起点，前缀和后写入
+        std::vector<int> t_count (threads + 1, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          const int first = chunkBegin (valid, threads, t), last = chunkBegin (valid, threads, t + 1);
+          for (int i = first; i < last; ++i)
+            if (i == 0 || pairs[i].key != pairs[i - 1].key)
+              ++t_count[t + 1];
+        }
+        for (int t = 0; t < threads; ++t)
+          t_count[t + 1] += t_count[t];
+        std::vector<int> starts (t_count[threads] + 1);
+        starts[t_count[threads]] = valid;
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          const int first = chunkBegin (valid, threads, t), last = chunkBegin (valid, threads, t + 1);
+          int v = t_count[t];
+          for (int i = first; i < last; ++i)
+            if (i == 0 || pairs[i].key != pairs[i - 1].key)
+              starts[v++] = i;
+        }
+        voxels_ = t_count[threads];
+
+        // 点数不足的体素去掉，其余每个体素输出一个点
+        std::vector<int> voxel_ids;
+        voxel_ids.reserve (voxels_);
+        for (int v = 0; v < static_cast<int> (voxels_); ++v)
+          if (starts[v + 1] - starts[v] >= static_cast<int> (min_points_per_voxel_))
+            voxel_ids.push_back (v);
+        const int out_size = static_cast<int> (voxel_ids.size ());
+        output.points.resize (out_size);
+        output.width = static_cast<uint32_t> (out_size);
+
+        // 6. 并行求每个体素的重心
+#pragma omp parallel for schedule(dynamic,1024) num_threads(threads)
+        for (int o = 0; o < out_size; ++o)
+        {
+          const int first = starts[voxel_ids[o]], last = starts[voxel_ids[o] + 1];
+          if (downsample_all_data_)
+          {
+            pcl::CentroidPoint<PointT> centroid;
+            for (int i = first; i < last; ++i)
+              centroid.add (input_->points[pairs[i].index]);
+            centroid.get (output.points[o]);
+          }
+          else
+          {
+            double sum[3] = { 0.0, 0.0, 0.0 };
+            for (int i = first; i < last; ++i)
+            {
+              const PointT &p = input_->points[pairs[i].index];
+              sum[0] += p.x;
+              sum[1] += p.y;
+              sum[2] += p.z;
+            }
+            const double count = last - first;
+            output.points[o].x = static_cast<float> (sum[0] / count);
+            output.points[o].y = static_cast<float> (sum[1] / count);
+            output.points[o].z = static_cast<float> (sum[2] / count);
+          }
+        }
+      }
+
+      /** \brief One stable counting-sort pass over the byte at shift: every thread
+        * counts its own chunk, the per-thread histograms are turned into write
+        * offsets, then every thread scatters its chunk.
+        */
+      template <typename KeyT> static void
+      radixPass (const std::vector<KeyIndex<KeyT> > &src, std::vector<KeyIndex<KeyT> > &dst, int shift, int threads)
+      {
+        const int n = static_cast<int> (src.size ());
+        std::vector<size_t> offsets (static_cast<size_t> (threads) * 256, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          size_t *hist = &offsets[static_cast<size_t> (t) * 256];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+            ++hist[(src[i].key >> shift) & 0xff];
+        }
+        size_t sum = 0;
+        for (int d = 0; d < 256; ++d)
+          for (int t = 0; t < threads; ++t)
+          {
+            size_t c = offsets[static_cast<size_t> (t) * 256 + d];
+            offsets[static_cast<size_t> (t) * 256 + d] = sum;
+            sum += c;
+          }
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          size_t *offset = &offsets[static_cast<size_t> (t) * 256];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+            dst[offset[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+      }
+
+      static inline int
+      chunkBegin (int n, int chunks, int c)
+      {
+        return (static_cast<int> (static_cast<long long> (n) * c / chunks));
+      }
+
+      static inline bool
+      isFinite (const PointT &p)
+      {
+        return (pcl_isfinite (p.x) && pcl_isfinite (p.y) && pcl_isfinite (p.z));
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      Eigen::Vector3f leaf_size_;
+      Eigen::Vector3f inverse_leaf_;
+      bool downsample_all_data_;
+      unsigned int min_points_per_voxel_;
+      unsigned int threads_;
+      size_t voxels_;
+
+      long long min_b_[3];
+      long long div_b_[3];
+      unsigned long long div_mul_[3];
+  };
+}
+
+#endif
@@ -0,0 +1,130 @@
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "parallel_voxel_grid.h"
+
+typedef pcl::PointXYZRGB PointT;
+using namespace pcl::console;
+
+// 合成点云：带噪声的起伏地面，点号决定位置，颜色随高度变化
+void
+generateCloud (size_t n, float extent, pcl::PointCloud<PointT> &cloud)
+{
+  cloud.points.resize (n);
+  cloud.width = static_cast<uint32_t> (n);
+  cloud.height = 1;
+  cloud.is_dense = true;
+#pragma omp parallel for
+  for (int i = 0; i < static_cast<int> (n); ++i)
+  {
+    unsigned long long h = i * 6364136223846793005ULL + 1442695040888963407ULL;
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdULL; h ^= h >> 33;
+    float u = static_cast<float> (h & 0xfffff) / 1048576.0f;
+    float v = static_cast<float> ((h >> 20) & 0xfffff) / 1048576.0f;
+    float w = static_cast<float> ((h >> 40) & 0xfffff) / 1048576.0f;
+    PointT &p = cloud.points[i];
+    p.x = u * extent;
+    p.y = v * extent;
+    p.z = 0.02f * extent * std::sin (10.0f * u) * std::cos (7.0f * v) + 0.01f * w;
+    p.r = static_cast<uint8_t> (255 * u);
+    p.g = static_cast<uint8_t> (255 * v);
+    p.b = static_cast<uint8_t> (255 * w);
+  }
+}
+
+// 两个结果的体素顺序相同，逐点比较重心
+float
+maxDifference (const pcl::PointCloud<PointT> &a, const pcl::PointCloud<PointT> &b)
+{
+  if (a.points.size () != b.points.size ())
+    return (-1.0f);
+  float diff = 0.0f;
+  for (size_t i = 0; i < a.points.size (); ++i)
+    diff = std::max (diff, (a.points[i].getVector3fMap () - b.points[i].getVector3fMap ()).norm ());
+  return (diff);
+}
+
+int
+main (int argc, char** argv)
+{
+  std::vector<int> files = parse_file_extension_argument (argc, argv, ".pcd");
+  // -o 后面的输出文件不是输入
+  const int output_index = find_argument (argc, argv, "-o") + 1;
+  files.erase (std::remove (files.begin (), files.end (), output_index), files.end ());
+  float leaf = 0.01f, synthetic = 0.0f, extent = 100.0f;
+  int max_threads = 0;
+  std::string output;
+  parse_argument (argc, argv, "-leaf", leaf);
+  parse_argument (argc, argv, "-synthetic", synthetic);
+  parse_argument (argc, argv, "-extent", extent);
+  parse_argument (argc, argv, "-t", max_threads);
+  parse_argument (argc, argv, "-o", output);
+  bool xyz_only = find_switch (argc, argv, "-xyz");
+  bool skip_pcl = find_switch (argc, argv, "-skip_pcl");
+  if (files.empty () && synthetic <= 0.0f)
+  {
+    std::cout << argv[0] << " input.pcd | -synthetic millions [-extent 100] [options]\n"
+              << "  -leaf size     leaf size (default 0.01)\n"
+              << "  -t n           maximum number of threads (default: all cores)\n"
+              << "  -xyz           average only x, y, z (setDownsampleAllData (false))\n"
+              << "  -skip_pcl      do not run the serial pcl::VoxelGrid\n"
+              << "  -o out.pcd     save the parallel result\n";
+    return (0);
+  }
+
+  TicToc tt;
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  tt.tic ();
+  if (!files.empty ())
+  {
+    if (pcl::io::loadPCDFile (argv[files[0]], *cloud) < 0)
+      return (-1);
+  }
+  else
+    generateCloud (static_cast<size_t> (synthetic * 1e6), extent, *cloud);
+  std::cout << cloud->points.size () << " points, leaf " << leaf << ", prepared in " << tt.toc () << " ms" << std::endl;
+
+  pcl::PointCloud<PointT> reference, filtered;
+  if (!skip_pcl)
+  {
+    pcl::VoxelGrid<PointT> vg;
+    vg.setInputCloud (cloud);
+    vg.setLeafSize (leaf, leaf, leaf);
+    vg.setDownsampleAllData (!xyz_only);
+    tt.tic ();
+    vg.filter (reference);
+    std::cout << "  pcl::VoxelGrid:             " << tt.toc () << " ms, " << reference.points.size () << " points" << std::endl;
+  }
+
+#ifdef _OPENMP
+  if (max_threads <= 0)
+    max_threads = omp_get_max_threads ();
+#else
+  max_threads = 1;
+#endif
+  pcl::ParallelVoxelGrid<PointT> pvg;
+  pvg.setInputCloud (cloud);
+  pvg.setLeafSize (leaf, leaf, leaf);
+  pvg.setDownsampleAllData (!xyz_only);
+  for (int threads = 1; threads <= max_threads; threads = (threads == max_threads ? threads + 1 : std::min (2 * threads, max_threads)))
+  {
+    pvg.setNumberOfThreads (threads);
+    tt.tic ();
+    pvg.filter (filtered);
+    double ms = tt.toc ();
+    std::cout << "  ParallelVoxelGrid, " << threads << " threads: " << ms << " ms, " << filtered.points.size () << " points";
+    if (!skip_pcl)
+      std::cout << ", max centroid difference " << maxDifference (reference, filtered);
+    std::cout << std::endl;
+  }
+
+  if (!output.empty ())
+    pcl::io::savePCDFile (output, filtered, true);
+  return (0);
+}
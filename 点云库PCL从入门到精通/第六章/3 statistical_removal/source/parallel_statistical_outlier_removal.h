@@ -0,0 +1,305 @@
+/*! \file parallel_statistical_outlier_removal.h
+*  Statistical outlier removal with parallel kNN queries and cached mean neighbor distances, so the threshold can be re-tuned without searching again.
+*/
+#ifndef PARALLEL_STATISTICAL_OUTLIER_REMOVAL_H_
+#define PARALLEL_STATISTICAL_OUTLIER_REMOVAL_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/console/print.h>
+#include <pcl/common/io.h>
+#include <pcl/filters/filter_indices.h>
+#include <pcl/search/kdtree.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief StatisticalOutlierRemoval with parallel neighbor search and reusable distances.
+    *
+    * Gives the same result as pcl::StatisticalOutlierRemoval: for every point of
+    * the indices the mean distance to its mean_k nearest neighbors in the whole
+    * input cloud is computed, and points whose mean distance is larger than
+    * mean + stddev_mult * stddev (over the indexed points) are outliers. Differences:
+    *  - the kNN queries run on all cores, in batches of setBatchSize consecutive
+    *    points per task with the result buffers reused inside a batch;
+    *  - the mean distances are kept after filtering. As long as the input cloud,
+    *    the indices and mean_k stay the same, filtering again (e.g. with another
+    *    setStddevMulThresh, or setNegative) only re-applies the threshold.
+    *    Call invalidateCache after changing the points of the input in place.
+    * countInliers answers "how many points would be kept with this multiplier"
+    * without producing a cloud, for tuning the threshold.
+    */
+  template <typename PointT>
+  class ParallelStatisticalOutlierRemoval : public FilterIndices<PointT>
+  {
+    protected:
+      typedef typename FilterIndices<PointT>::PointCloud PointCloud;
+      typedef typename pcl::search::KdTree<PointT>::Ptr SearcherPtr;
+
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+      using FilterIndices<PointT>::negative_;
+      using FilterIndices<PointT>::keep_organized_;
+      using FilterIndices<PointT>::user_filter_value_;
+      using FilterIndices<PointT>::extract_removed_indices_;
+      using FilterIndices<PointT>::removed_indices_;
+
+    public:
+      ParallelStatisticalOutlierRemoval (bool extract_removed_indices = false)
+        : FilterIndices<PointT> (extract_removed_indices)
+        , mean_k_ (1)
+        , std_mul_ (0.0)
+        , batch_size_ (256)
+        , threads_ (0)
+        , cached_cloud_size_ (0)
+        , cached_indices_size_ (0)
+        , cached_mean_k_ (0)
+        , mean_ (0.0)
+        , stddev_ (0.0)
+        , searches_ (0)
+      {
+        filter_name_ = "ParallelStatisticalOutlierRemoval";
+      }
+
+      /** \brief Number of nearest neighbors the mean distance is computed from. */
+      inline void
+      setMeanK (int nr_k) { mean_k_ = nr_k; }
+
+      inline int
+      getMeanK () const { return (mean_k_); }
+
+      /** \brief Points with a mean distance above mean + stddev_mult * stddev are outliers. */
+      inline void
+      setStddevMulThresh (double stddev_mult) { std_mul_ = stddev_mult; }
+
+      inline double
+      getStddevMulThresh () const { return (std_mul_); }
+
+      /** \brief Number of consecutive points a thread queries as one task. */
+      inline void
+      setBatchSize (int batch_size) { batch_size_ = std::max (batch_size, 1); }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Drop the cached mean distances, e.g. after the input points were changed in place. */
+      inline void
+      invalidateCache () { cached_cloud_.reset (); cached_indices_.reset (); distances_.clear (); }
+
+      /** \brief Run the kNN pass now (filter does it when needed).
+        * \return false if there is no input or mean_k is invalid
+        */
+      bool
+      computeMeanDistances ()
+      {
+        if (!this->initCompute ())
+          return (false);
+        bool ok = updateDistances ();
+        this->deinitCompute ();
+        return (ok);
+      }
+
+      /** \brief Mean neighbor distance of every point of the indices (0 for points
+        * that are not finite or have no neighbors, as in StatisticalOutlierRemoval).
+        */
+      inline const std::vector<float>&
+      getMeanDistances () const { return (distances_); }
+
+      /** \brief Mean and standard deviation of the mean distances of the valid points. */
+      inline void
+      getDistanceStatistics (double &mean, double &stddev) const { mean = mean_; stddev = stddev_; }
+
+      /** \brief The distance threshold for a given multiplier. */
+      inline double
+      getDistanceThreshold (double stddev_mult) const { return (mean_ + stddev_mult * stddev_); }
+
+      /** \brief Number of points that are kept (with setNegative (false)) at the given multiplier. */
+      size_t
+      countInliers (double stddev_mult)
+      {
+        if (!computeMeanDistances ())
+          return (0);
+        const double threshold = getDistanceThreshold (stddev_mult);
+        const int n = static_cast<int> (distances_.size ());
+        int inliers = 0;
+#pragma omp parallel for reduction(+:inliers) num_threads(getThreads ())
+        for (int i = 0; i < n; ++i)
+          if (distances_[i] <= threshold)
+            ++inliers;
+        return (static_cast<size_t> (inliers));
+      }
+
+      /** \brief How many kNN passes have been run (one per change of cloud, indices or mean_k). */
+      inline size_t
+      getNumberOfSearches () const { return (searches_); }
+
+    protected:
+      void
+      applyFilter (PointCloud &output)
+      {
+        std::vector<int> indices;
+        if (keep_organized_)
+        {
+          bool temp = extract_removed_indices_;
+          extract_removed_indices_ = true;
+          applyFilterIndices (indices);
+          extract_removed_indices_ = temp;
+
+          output = *input_;
+          for (int rii = 0; rii < static_cast<int> (removed_indices_->size ()); ++rii)
+            output.points[(*removed_indices_)[rii]].x = output.points[(*removed_indices_)[rii]].y = output.points[(*removed_indices_)[rii]].z = user_filter_value_;
+          if (!pcl_isfinite (user_filter_value_))
+            output.is_dense = false;
+        }
+        else
+        {
+          applyFilterIndices (indices);
+          copyPointCloud (*input_, indices, output);
+        }
+      }
+
+      void
+      applyFilter (std::vector<int> &indices)
+      {
+        applyFilterIndices (indices);
+      }
+
+      void
+      applyFilterIndices (std::vector<int> &indices)
+      {
+        indices.clear ();
+        removed_indices_->clear ();
+        if (!updateDistances ())
+          return;
+
+        // 阈值判断很便宜，串行写出两组索引以保持原有顺序
+        const double threshold = getDistanceThreshold (std_mul_);
+        indices.reserve (indices_->size ());
+        if (extract_removed_indices_)
+          removed_indices_->reserve (indices_->size ());
+        for (size_t i = 0; i < indices_->size (); ++i)
+        {
+          if ((!negative_ && distances_[i] > threshold) || (negative_ && distances_[i] <= threshold))
+          {
+            if (extract_removed_indices_)
+              removed_indices_->push_back ((*indices_)[i]);
+            continue;
+          }
+          indices.push_back ((*indices_)[i]);
+        }
+      }
+
+      /** \brief The kNN pass, skipped if the cache belongs to the current input. */
+      bool
+      updateDistances ()
+      {
+        if (mean_k_ < 1)
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] Invalid mean_k (%d).\n", getClassName ().c_str (), mean_k_);
+          return (false);
+        }
+        if (cached_cloud_ == input_ && cached_cloud_size_ == input_->points.size () && cached_indices_ == indices_ &&
+            cached_indices_size_ == indices_->size () && cached_mean_k_ == mean_k_ &&
+            distances_.size () == indices_->size ())
+          return (true);
+
+        // 与 StatisticalOutlierRemoval 相同：近邻在整个输入点云中查找，只对索引中的点计算
+        SearcherPtr searcher (new pcl::search::KdTree<PointT> (false));
+        searcher->setInputCloud (input_);
+
+        const int n = static_cast<int> (indices_->size ());
+        const int batches = (n + batch_size_ - 1) / batch_size_;
+        distances_.assign (n, 0.0f);
+        std::vector<char> valid (n, 0);
+        int failed = 0;
+#pragma omp parallel for schedule(dynamic,1) reduction(+:failed) num_threads(getThreads ())
+        for (int b = 0; b < batches; ++b)
+        {
+          // 结果缓冲区在一批查询内复用；k+1 个近邻里第一个是点自己
+          std::vector<int> nn_indices (mean_k_ + 1);
+          std::vector<float> nn_dists (mean_k_ + 1);
+          const int last = std::min (n, (b + 1) * batch_size_);
+          for (int i = b * batch_size_; i < last; ++i)
+          {
+            const PointT &p = input_->points[(*indices_)[i]];
+            if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+              continue;
+            const int found = searcher->nearestKSearch (p, mean_k_ + 1, nn_indices, nn_dists);
+            if (found == 0)
+            {
+              ++failed;
+              continue;
+            }
+            double dist_sum = 0.0;
+            for (int k = 1; k < found; ++k)
+              dist_sum += std::sqrt (nn_dists[k]);
+            distances_[i] = static_cast<float> (dist_sum / mean_k_);
+            valid[i] = 1;
+          }
+        }
+        if (failed > 0)
+          PCL_WARN ("[pcl::%s::applyFilter] Searching for the closest %d neighbors failed for %d points.\n",
+                    getClassName ().c_str (), mean_k_, failed);
+
+        // 有效点平均距离的均值与标准差
+        double sum = 0.0, sq_sum = 0.0;
+        int valid_distances = 0;
+#pragma omp parallel for reduction(+:sum,sq_sum,valid_distances) num_threads(getThreads ())
+        for (int i = 0; i < n; ++i)
+          if (valid[i])
+          {
+            sum += distances_[i];
+            sq_sum += static_cast<double> (distances_[i]) * distances_[i];
+            ++valid_distances;
+          }
+        mean_ = valid_distances > 0 ? sum / valid_distances : 0.0;
+        const double variance = valid_distances > 1 ? (sq_sum - sum * sum / valid_distances) / (valid_distances - 1) : 0.0;
+        stddev_ = std::sqrt (std::max (variance, 0.0));
+
+        cached_cloud_ = input_;
+        cached_cloud_size_ = input_->points.size ();
+        cached_indices_ = indices_;
+        cached_indices_size_ = indices_->size ();
+        cached_mean_k_ = mean_k_;
+        ++searches_;
+        return (true);
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      int mean_k_;
+      double std_mul_;
+      int batch_size_;
+      unsigned int threads_;
+
+      // 持有缓存对应的点云和索引，地址不会被新对象复用
+      typename PointCloud::ConstPtr cached_cloud_;
+      size_t cached_cloud_size_;
+      boost::shared_ptr<std::vector<int> > cached_indices_;
+      size_t cached_indices_size_;
+      int cached_mean_k_;
+      std::vector<float> distances_;
+      double mean_;
+      double stddev_;
+      size_t searches_;
+  };
+}
+
+#endif
@@ -1,7 +1,8 @@
-﻿#include <pcl/filters/statistical_outlier_removal.h>
-#include <pcl/io/pcd_io.h>
+﻿#include <pcl/io/pcd_io.h>
 #include <pcl/point_types.h>
+#include <pcl/console/time.h>
 #include <iostream>
+#include "parallel_statistical_outlier_removal.h"
 int main(int argc, char** argv) {
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_filtered(
@@ -12,20 +13,31 @@ int main(int argc, char** argv) {
   reader.read<pcl::PointXYZ>("table_scene_lms400.pcd", *cloud);
   std::cerr << "Cloud before filtering: " << std::endl;
   std::cerr << *cloud << std::endl;
-  // 创建滤波器对象
-  pcl::StatisticalOutlierRemoval<pcl::PointXYZ> sor;
+  // 创建滤波器对象，多线程做 kNN，平均距离缓存下来
+  pcl::ParallelStatisticalOutlierRemoval<pcl::PointXYZ> sor;
   sor.setInputCloud(cloud);
   sor.setMeanK(50);
   sor.setStddevMulThresh(1.0);
+  pcl::console::TicToc tt;
+  tt.tic();
   sor.filter(*cloud_filtered);
+  std::cerr << "kNN pass and filtering: " << tt.toc() << " ms" << std::endl;
   std::cerr << "Cloud after filtering: " << std::endl;
   std::cerr << *cloud_filtered << std::endl;
   pcl::PCDWriter writer;
   writer.write<pcl::PointXYZ>("table_scene_lms400_inliers.pcd", *cloud_filtered,
                               false);
+  // 再次滤波只重新比较阈值，不再搜索近邻
   sor.setNegative(true);
   sor.filter(*cloud_filtered);
   writer.write<pcl::PointXYZ>("table_scene_lms400_outliers.pcd",
                               *cloud_filtered, false);
+  // 调参：不同倍数下保留的点数
+  tt.tic();
+  for (double mul = 0.5; mul <= 3.0; mul += 0.5)
+    std::cerr << "StddevMulThresh " << mul << ": " << sor.countInliers(mul)
+              << " inliers" << std::endl;
+  std::cerr << "Threshold sweep: " << tt.toc() << " ms, "
+            << sor.getNumberOfSearches() << " kNN pass(es) in total" << std::endl;
   return (0);
 }
@@ -0,0 +1,97 @@
+#include <pcl/ModelCoefficients.h>
+#include <pcl/point_types.h>
+#include <pcl/filters/project_inliers.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "parallel_project_inliers.h"
+
+typedef pcl::PointXYZ PointT;
+using namespace pcl::console;
+
+static float
+random11 ()
+{
+  return (2.0f * rand () / (RAND_MAX + 1.0f) - 1.0f);
+}
+
+int
+main (int argc, char** argv)
+{
+  float millions = 10.0f;
+  int threads = 0;
+  parse_argument (argc, argv, "-n", millions);
+  parse_argument (argc, argv, "-t", threads);
+  bool skip_pcl = find_switch (argc, argv, "-skip");
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [-n millions (default 10)] [-t threads] [-skip (no ProjectInliers)]\n";
+    return (0);
+  }
+
+  // 填入点云数据：略微倾斜的地面附近 50 x 50 m 内的点
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  cloud->width = static_cast<uint32_t> (millions * 1e6);
+  cloud->height = 1;
+  cloud->points.resize (cloud->width);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    cloud->points[i].x = 25.0f * random11 ();
+    cloud->points[i].y = 25.0f * random11 ();
+    cloud->points[i].z = 0.02f * cloud->points[i].x + 0.1f * random11 ();
+  }
+  pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients ());
+  coefficients->values.resize (4);
+  const float norm = std::sqrt (1.0f + 0.02f * 0.02f);
+  coefficients->values[0] = -0.02f / norm;
+  coefficients->values[1] = 0.0f;
+  coefficients->values[2] = 1.0f / norm;
+  coefficients->values[3] = 0.0f;
+  const double megabytes = cloud->points.size () * sizeof (PointT) / 1e6;
+  std::cerr << cloud->points.size () << " points (" << megabytes << " MB)" << std::endl;
+
+  TicToc tt;
+  pcl::PointCloud<PointT> reference;
+  if (!skip_pcl)
+  {
+    pcl::ProjectInliers<PointT> proj;
+    proj.setModelType (pcl::SACMODEL_PLANE);
+    proj.setInputCloud (cloud);
+    proj.setModelCoefficients (coefficients);
+    tt.tic ();
+    proj.filter (reference);
+    std::cerr << "ProjectInliers:                    " << tt.toc () << " ms" << std::endl;
+  }
+
+  pcl::ParallelProjectInliers<PointT> proj;
+  proj.setModelType (pcl::SACMODEL_PLANE);
+  proj.setInputCloud (cloud);
+  proj.setModelCoefficients (coefficients);
+  proj.setNumberOfThreads (threads);
+  pcl::PointCloud<PointT> projected;
+  tt.tic ();
+  proj.filter (projected);
+  std::cerr << "ParallelProjectInliers (copy):     " << tt.toc () << " ms" << std::endl;
+
+  // 原地投影只读写一遍点云，耗时应接近内存带宽的极限
+  tt.tic ();
+  proj.projectInPlace (*cloud);
+  const double ms = tt.toc ();
+  std::cerr << "ParallelProjectInliers (in place): " << ms << " ms, " << 2.0 * megabytes / ms << " GB/s read + write" << std::endl;
+
+  // 与 ProjectInliers 的最大差别（浮点舍入）
+  double max_difference = 0.0;
+  for (size_t i = 0; !skip_pcl && i < projected.points.size (); ++i)
+  {
+    max_difference = std::max (max_difference, static_cast<double> (
+      (projected.points[i].getVector3fMap () - reference.points[i].getVector3fMap ()).norm ()));
+    max_difference = std::max (max_difference, static_cast<double> (
+      (cloud->points[i].getVector3fMap () - reference.points[i].getVector3fMap ()).norm ()));
+  }
+  if (!skip_pcl)
+    std::cerr << "Largest difference to ProjectInliers: " << max_difference << std::endl;
+  return (max_difference < 1e-4 ? 0 : -1);
+}
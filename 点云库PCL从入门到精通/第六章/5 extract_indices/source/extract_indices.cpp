@@ -6,12 +6,12 @@
 #include <pcl/sample_consensus/model_types.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/filters/voxel_grid.h>
-#include <pcl/filters/extract_indices.h>
+#include "indexed_view.h"
 int
 main (int argc, char** argv)
 {
   sensor_msgs::PointCloud2::Ptr cloud_blob (new sensor_msgs::PointCloud2), cloud_filtered_blob (new sensor_msgs::PointCloud2);
-  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_filtered (new pcl::PointCloud<pcl::PointXYZ>), cloud_p (new pcl::PointCloud<pcl::PointXYZ>), cloud_f (new pcl::PointCloud<pcl::PointXYZ>);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_filtered (new pcl::PointCloud<pcl::PointXYZ>);
   // 
   pcl::PCDReader reader;
   reader.read ("table_scene_lms400.pcd", *cloud_blob);
@@ -38,33 +38,27 @@ main (int argc, char** argv)
   seg.setMethodType (pcl::SAC_RANSAC);
   seg.setMaxIterations (1000);
   seg.setDistanceThreshold (0.01);
-  // ˲
-  pcl::ExtractIndices<pcl::PointXYZ> extract;
+  // µĵ cloud_filtered ϵͼʾѭвƵ
+  pcl::IndexedView<pcl::PointXYZ> remaining (cloud_filtered);
   int i = 0, nr_points = (int) cloud_filtered->points.size ();
   // 30%ԭʼʱ
-  while (cloud_filtered->points.size () > 0.3 * nr_points)
+  while (remaining.size () > 0.3 * nr_points)
   {
-    // µĵзָƽɲ
-    seg.setInputCloud (cloud_filtered);
+    // µĵзָƽɲ֣ڵΪ cloud_filtered е
+    remaining.setInputOf (seg);
     seg.segment (*inliers, *coefficients);
     if (inliers->indices.size () == 0)
     {
       std::cerr << "Could not estimate a planar model for the given dataset." << std::endl;
       break;
     }
-    // ڲ
-    extract.setInputCloud (cloud_filtered);
-    extract.setIndices (inliers);
-    extract.setNegative (false);
-    extract.filter (*cloud_p);
-    std::cerr << "PointCloud representing the planar component: " << cloud_p->width * cloud_p->height << " data points." << std::endl;
+    // ֱдڲ
+    std::cerr << "PointCloud representing the planar component: " << inliers->indices.size () << " data points." << std::endl;
     std::stringstream ss;
     ss << "table_scene_lms400_plane_" << i << ".pcd";
-    writer.write<pcl::PointXYZ> (ss.str (), *cloud_p, false);
-    // ˲
-    extract.setNegative (true);
-    extract.filter (*cloud_f);
-    cloud_filtered.swap (cloud_f);
+    writer.write<pcl::PointXYZ> (ss.str (), *cloud_filtered, inliers->indices, false);
+    // ͼԭȥڲ
+    remaining.remove (inliers->indices);
     i++;
   }
   return (0);
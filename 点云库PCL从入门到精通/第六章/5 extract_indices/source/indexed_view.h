@@ -0,0 +1,168 @@
+/*! \file indexed_view.h
+*  A cloud plus an index vector that any PCL algorithm can take through setInputCloud/setIndices, with in-place stable partitioning so peeling loops never copy the cloud.
+*/
+#ifndef INDEXED_VIEW_H_
+#define INDEXED_VIEW_H_
+
+#include <pcl/pcl_base.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/io.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief A view on a subset of a cloud: the cloud (shared, never copied) and the indices of the points in the view.
+    *
+    * Every PCL algorithm derived from PCLBase (filters, SACSegmentation,
+    * EuclideanClusterExtraction, NormalEstimation, ...) accepts a cloud plus
+    * indices and returns results as indices into the full cloud, so the view
+    * can be handed to them with setInputOf instead of materializing the subset
+    * with ExtractIndices. The index vector is shared with the algorithms it was
+    * given to: remove and partition reorder it in place and those algorithms
+    * see the new subset on their next call.
+    *
+    * Plane peeling, without the ExtractIndices setNegative (false) / (true)
+    * pair and the copy of the remainder on every iteration:
+    * \code
+    * pcl::IndexedView<PointT> remaining (cloud);
+    * while (remaining.size () > 0.3 * cloud->points.size ())
+    * {
+    *   remaining.setInputOf (seg);
+    *   seg.segment (*inliers, *coefficients);
+    *   if (inliers->indices.empty ())
+    *     break;
+    *   writer.write (file, *cloud, inliers->indices);   // or remaining.copyTo for a cloud
+    *   remaining.remove (inliers->indices);
+    * }
+    * \endcode
+    */
+  template <typename PointT>
+  class IndexedView
+  {
+    public:
+      typedef pcl::PointCloud<PointT> PointCloud;
+      typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+      typedef boost::shared_ptr<IndexedView<PointT> > Ptr;
+
+      /** \brief View on all points of the cloud. */
+      explicit IndexedView (const PointCloudConstPtr &cloud)
+        : cloud_ (cloud)
+        , indices_ (new std::vector<int> (cloud->points.size ()))
+        , generation_ (0)
+      {
+        for (size_t i = 0; i < indices_->size (); ++i)
+          (*indices_)[i] = static_cast<int> (i);
+      }
+
+      /** \brief View on the given indices of the cloud; the index vector is shared, not copied. */
+      IndexedView (const PointCloudConstPtr &cloud, const IndicesPtr &indices)
+        : cloud_ (cloud)
+        , indices_ (indices)
+        , generation_ (0)
+      {
+      }
+
+      inline const PointCloudConstPtr&
+      getCloud () const { return (cloud_); }
+
+      /** \brief The index vector of the view, as passed to the algorithms. */
+      inline const IndicesPtr&
+      getIndices () const { return (indices_); }
+
+      inline size_t
+      size () const { return (indices_->size ()); }
+
+      inline bool
+      empty () const { return (indices_->empty ()); }
+
+      /** \brief The i-th point of the view. */
+      inline const PointT&
+      operator[] (size_t i) const { return (cloud_->points[(*indices_)[i]]); }
+
+      /** \brief Give the view to a PCLBase algorithm: setInputCloud (cloud) and setIndices (indices). */
+      template <typename AlgorithmT> inline void
+      setInputOf (AlgorithmT &algorithm) const
+      {
+        algorithm.setInputCloud (cloud_);
+        algorithm.setIndices (indices_);
+      }
+
+      /** \brief Drop the selected points from the view, in place, keeping the order of the others.
+        * \param[in] selected indices into the cloud, e.g. the inliers of a segmentation of this view
+        * \return the number of points removed
+        */
+      size_t
+      remove (const std::vector<int> &selected)
+      {
+        mark (selected);
+        size_t kept = 0;
+        for (size_t i = 0; i < indices_->size (); ++i)
+          if (marks_[(*indices_)[i]] != generation_)
+            (*indices_)[kept++] = (*indices_)[i];
+        const size_t removed = indices_->size () - kept;
+        indices_->resize (kept);
+        return (removed);
+      }
+
+      /** \brief Stable partition of the view, in place: the selected points first, then the others,
+        * both in their previous order.
+        * \return the number of selected points, i.e. where the second group starts
+        */
+      size_t
+      partition (const std::vector<int> &selected)
+      {
+        mark (selected);
+        rest_.clear ();
+        size_t front = 0;
+        for (size_t i = 0; i < indices_->size (); ++i)
+        {
+          const int index = (*indices_)[i];
+          if (marks_[index] == generation_)
+            (*indices_)[front++] = index;
+          else
+            rest_.push_back (index);
+        }
+        std::copy (rest_.begin (), rest_.end (), indices_->begin () + front);
+        return (front);
+      }
+
+      /** \brief Keep only the first n points of the view (e.g. the selected group after partition). */
+      inline void
+      truncate (size_t n)
+      {
+        if (n < indices_->size ())
+          indices_->resize (n);
+      }
+
+      /** \brief Materialize the view as a cloud. */
+      inline void
+      copyTo (PointCloud &output) const { copyPointCloud (*cloud_, *indices_, output); }
+
+    protected:
+      /** \brief Stamp the selected points; the stamps are kept between calls, so no clearing is needed. */
+      void
+      mark (const std::vector<int> &selected)
+      {
+        if (marks_.size () != cloud_->points.size ())
+          marks_.assign (cloud_->points.size (), 0);
+        if (++generation_ == 0)
+        {
+          std::fill (marks_.begin (), marks_.end (), 0);
+          generation_ = 1;
+        }
+        for (size_t i = 0; i < selected.size (); ++i)
+          marks_[selected[i]] = generation_;
+      }
+
+      PointCloudConstPtr cloud_;
+      IndicesPtr indices_;
+      std::vector<unsigned int> marks_;
+      unsigned int generation_;
+      std::vector<int> rest_;   // partition 的临时缓冲，多次调用复用
+  };
+}
+
+#endif
@@ -0,0 +1,418 @@
+/*! \file filter_chain.h
+*  Fused filter chain: PassThrough, field comparisons, CropBox and NaN removal composed into one templated predicate and applied in a single parallel pass.
+*/
+#ifndef FILTER_CHAIN_H_
+#define FILTER_CHAIN_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/point_traits.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/filters/filter_indices.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief Predicates for FilterChain.
+    *
+    * A predicate is any copyable functor with
+    *   template <typename PointT> bool operator() (const PointT &p) const;
+    * that returns true for the points to keep. Fields are named by their PCL
+    * tag (pcl::fields::z, pcl::fields::intensity, ...) and read at a compile-time
+    * offset, and predicates are combined with allOf / anyOf / negate into one
+    * type, so the compiler sees (and inlines) the whole chain: no virtual
+    * evaluate and no field lookup by name per point, as in ConditionalRemoval.
+    */
+  namespace chain
+  {
+    /** \brief The field FieldTag of a point in its own type, read at its static offset. */
+    template <typename FieldTag, typename PointT> inline const typename pcl::traits::datatype<PointT, FieldTag>::type&
+    fieldData (const PointT &p)
+    {
+      typedef typename pcl::traits::datatype<PointT, FieldTag>::type FieldType;
+      const char *data = reinterpret_cast<const char*> (&p) + pcl::traits::offset<PointT, FieldTag>::value;
+      return (*reinterpret_cast<const FieldType*> (data));
+    }
+
+    /** \brief Value of the field FieldTag of a point as float. */
+    template <typename FieldTag, typename PointT> inline float
+    fieldValue (const PointT &p)
+    {
+      return (static_cast<float> (fieldData<FieldTag> (p)));
+    }
+
+    /** \brief Keeps points with finite x, y and z (what removeNaNFromPointCloud does). */
+    struct FiniteXYZ
+    {
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const
+      {
+        return (pcl_isfinite (p.x) && pcl_isfinite (p.y) && pcl_isfinite (p.z));
+      }
+    };
+
+    /** \brief pcl::PassThrough on one field: keeps min <= value <= max (outside with
+      * negative = true). Points whose field is NaN are always removed.
+      */
+    template <typename FieldTag>
+    struct PassThrough
+    {
+      PassThrough (float min = -FLT_MAX, float max = FLT_MAX, bool negative = false)
+        : min_ (min), max_ (max), negative_ (negative) {}
+
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const
+      {
+        const float v = fieldValue<FieldTag> (p);
+        if (!pcl_isfinite (v))
+          return (false);
+        return ((v >= min_ && v <= max_) != negative_);
+      }
+
+      float min_;
+      float max_;
+      bool negative_;
+    };
+
+    /** \brief The ComparisonOps of FieldComparison, one functor per operator. */
+    template <typename FieldTag>
+    struct Greater
+    {
+      Greater (float value) : value_ (value) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (fieldValue<FieldTag> (p) > value_); }
+      float value_;
+    };
+
+    template <typename FieldTag>
+    struct GreaterEqual
+    {
+      GreaterEqual (float value) : value_ (value) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (fieldValue<FieldTag> (p) >= value_); }
+      float value_;
+    };
+
+    template <typename FieldTag>
+    struct Less
+    {
+      Less (float value) : value_ (value) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (fieldValue<FieldTag> (p) < value_); }
+      float value_;
+    };
+
+    template <typename FieldTag>
+    struct LessEqual
+    {
+      LessEqual (float value) : value_ (value) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (fieldValue<FieldTag> (p) <= value_); }
+      float value_;
+    };
+
+    template <typename FieldTag>
+    struct Equal
+    {
+      Equal (float value) : value_ (value) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (fieldValue<FieldTag> (p) == value_); }
+      float value_;
+    };
+
+    /** \brief pcl::CropBox: keeps points inside the box [min, max] (outside with
+      * negative = true). The box can be placed with a pose (box frame to cloud
+      * frame); points are mapped into the box frame by its inverse. Points with
+      * non-finite coordinates are always removed.
+      */
+    struct CropBox
+    {
+      CropBox (const Eigen::Vector3f &min = Eigen::Vector3f::Constant (-1.0f),
+               const Eigen::Vector3f &max = Eigen::Vector3f::Constant (1.0f), bool negative = false)
+        : min_ (min), max_ (max), negative_ (negative), transformed_ (false)
+        , rotation_ (Eigen::Matrix3f::Identity ()), translation_ (Eigen::Vector3f::Zero ()) {}
+
+      CropBox (const Eigen::Vector3f &min, const Eigen::Vector3f &max, const Eigen::Affine3f &pose, bool negative = false)
+        : min_ (min), max_ (max), negative_ (negative), transformed_ (true)
+      {
+        Eigen::Affine3f inverse = pose.inverse ();
+        rotation_ = inverse.linear ();
+        translation_ = inverse.translation ();
+      }
+
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const
+      {
+        if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+          return (false);
+        Eigen::Vector3f q (p.x, p.y, p.z);
+        if (transformed_)
+          q = rotation_ * q + translation_;
+        const bool inside = q[0] >= min_[0] && q[0] <= max_[0] && q[1] >= min_[1] && q[1] <= max_[1] &&
+                            q[2] >= min_[2] && q[2] <= max_[2];
+        return (inside != negative_);
+      }
+
+      Eigen::Vector3f min_;
+      Eigen::Vector3f max_;
+      bool negative_;
+      bool transformed_;
+      // 位姿的逆拆成 3x3 与平移，不需要 16 字节对齐，可以放进任意谓词组合
+      Eigen::Matrix3f rotation_;
+      Eigen::Vector3f translation_;
+    };
+
+    /** \brief Both predicates hold; b is not evaluated for points a rejects. */
+    template <typename A, typename B>
+    struct And
+    {
+      And (const A &a, const B &b) : a_ (a), b_ (b) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (a_ (p) && b_ (p)); }
+      A a_;
+      B b_;
+    };
+
+    template <typename A, typename B>
+    struct Or
+    {
+      Or (const A &a, const B &b) : a_ (a), b_ (b) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (a_ (p) || b_ (p)); }
+      A a_;
+      B b_;
+    };
+
+    template <typename A>
+    struct Not
+    {
+      Not (const A &a) : a_ (a) {}
+      template <typename PointT> inline bool operator() (const PointT &p) const { return (!a_ (p)); }
+      A a_;
+    };
+
+    // 组合函数，类型由编译器推导；把便宜、拒绝率高的谓词放在前面
+    template <typename A, typename B> inline And<A, B>
+    allOf (const A &a, const B &b) { return (And<A, B> (a, b)); }
+
+    template <typename A, typename B, typename C> inline And<A, And<B, C> >
+    allOf (const A &a, const B &b, const C &c) { return (allOf (a, allOf (b, c))); }
+
+    template <typename A, typename B, typename C, typename D> inline And<A, And<B, And<C, D> > >
+    allOf (const A &a, const B &b, const C &c, const D &d) { return (allOf (a, allOf (b, c, d))); }
+
+    template <typename A, typename B> inline Or<A, B>
+    anyOf (const A &a, const B &b) { return (Or<A, B> (a, b)); }
+
+    template <typename A, typename B, typename C> inline Or<A, Or<B, C> >
+    anyOf (const A &a, const B &b, const C &c) { return (anyOf (a, anyOf (b, c))); }
+
+    template <typename A> inline Not<A>
+    negate (const A &a) { return (Not<A> (a)); }
+
+    /** \brief First item of chunk c when n items are split into chunks parts whose
+      * borders are multiples of align.
+      */
+    inline int
+    chunkBegin (int n, int chunks, int c, int align = 1)
+    {
+      const long long blocks = (static_cast<long long> (n) + align - 1) / align;
+      return (static_cast<int> (std::min<long long> (n, blocks * c / chunks * align)));
+    }
+
+    /** \brief Item i of data, or data[(*indices)[i]] with indices. */
+    template <typename Container>
+    struct Gather
+    {
+      Gather (const Container &data, const std::vector<int> *indices = NULL) : data_ (data), indices_ (indices) {}
+      inline const typename Container::value_type&
+      operator() (int i) const { return (data_[indices_ ? (*indices_)[i] : i]); }
+      const Container &data_;
+      const std::vector<int> *indices_;
+    };
+
+    template <typename Container> inline Gather<Container>
+    gather (const Container &data, const std::vector<int> *indices = NULL) { return (Gather<Container> (data, indices)); }
+
+    /** \brief The position i itself. */
+    struct Position
+    {
+      inline int operator() (int i) const { return (i); }
+    };
+
+    /** \brief Writes source (i) for every kept i to out, in input order.
+      * \param[in] keep keep mask
+      * \param[in] offsets output offset of every thread (offsets[threads] kept items in total)
+      * \param[in] threads number of threads, each one copies the chunk it counted
+      * \param[in] align chunk alignment used when counting
+      * \param[in] source item for a kept position (Gather, Position)
+      * \param[out] out output, already resized to offsets[threads] items
+      */
+    template <typename Source, typename Container> void
+    compact (const std::vector<unsigned char> &keep, const std::vector<int> &offsets, int threads, int align,
+             const Source &source, Container &out)
+    {
+      const int n = static_cast<int> (keep.size ());
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+      for (int t = 0; t < threads; ++t)
+      {
+        int o = offsets[t];
+        const int first = chunkBegin (n, threads, t, align), last = chunkBegin (n, threads, t + 1, align);
+        for (int i = first; i < last; ++i)
+          if (keep[i])
+            out[o++] = source (i);
+      }
+    }
+  }
+
+  /** \brief Applies a composed predicate (see pcl::chain) in one parallel pass.
+    *
+    * Chaining removeNaNFromPointCloud, PassThrough, ConditionalRemoval and
+    * CropBox (or ExtractIndices) sweeps the cloud once per stage and allocates a
+    * full intermediate cloud each time. Here every point is tested once against
+    * the whole chain: the threads fill a keep mask over their part of the
+    * indices, the per-thread counts give each thread its output offset, and the
+    * kept points (or indices) are written in their original order, directly into
+    * the output. setNegative, setKeepOrganized and the removed indices behave as
+    * in the other FilterIndices.
+    *
+    * \code
+    * typedef pcl::chain::And<pcl::chain::FiniteXYZ, pcl::chain::PassThrough<pcl::fields::z> > Predicate;
+    * pcl::FilterChain<pcl::PointXYZ, Predicate> chain (pcl::chain::allOf (pcl::chain::FiniteXYZ (),
+    *                                                   pcl::chain::PassThrough<pcl::fields::z> (0.0f, 1.0f)));
+    * \endcode
+    */
+  template <typename PointT, typename Predicate>
+  class FilterChain : public FilterIndices<PointT>
+  {
+    protected:
+      typedef typename FilterIndices<PointT>::PointCloud PointCloud;
+
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+      using FilterIndices<PointT>::negative_;
+      using FilterIndices<PointT>::keep_organized_;
+      using FilterIndices<PointT>::user_filter_value_;
+      using FilterIndices<PointT>::extract_removed_indices_;
+      using FilterIndices<PointT>::removed_indices_;
+
+    public:
+      FilterChain (const Predicate &predicate = Predicate (), bool extract_removed_indices = false)
+        : FilterIndices<PointT> (extract_removed_indices)
+        , predicate_ (predicate)
+        , threads_ (0)
+      {
+        filter_name_ = "FilterChain";
+      }
+
+      inline void
+      setPredicate (const Predicate &predicate) { predicate_ = predicate; }
+
+      inline const Predicate&
+      getPredicate () const { return (predicate_); }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+    protected:
+      void
+      applyFilter (PointCloud &output)
+      {
+        const int threads = getThreads ();
+        std::vector<int> offsets;
+        evaluate (threads, offsets);
+        const int n = static_cast<int> (indices_->size ());
+        const int kept = offsets[threads];
+        collectRemoved ();
+
+        if (keep_organized_)
+        {
+          // 保持结构：整体拷贝，被去掉的点 xyz 置为 user_filter_value
+          output = *input_;
+#pragma omp parallel for schedule(static) num_threads(threads)
+          for (int i = 0; i < n; ++i)
+            if (!keep_[i])
+            {
+              PointT &p = output.points[(*indices_)[i]];
+              p.x = p.y = p.z = user_filter_value_;
+            }
+          if (!pcl_isfinite (user_filter_value_))
+            output.is_dense = false;
+          return;
+        }
+
+        // 保留的点直接写入输出，不经过中间索引或点云
+        output.points.resize (kept);
+        output.width = static_cast<uint32_t> (kept);
+        output.height = 1;
+        output.is_dense = input_->is_dense;
+        chain::compact (keep_, offsets, threads, 1, chain::gather (input_->points, indices_.get ()), output.points);
+      }
+
+      void
+      applyFilter (std::vector<int> &indices)
+      {
+        const int threads = getThreads ();
+        std::vector<int> offsets;
+        evaluate (threads, offsets);
+        indices.resize (offsets[threads]);
+        chain::compact (keep_, offsets, threads, 1, chain::gather (*indices_), indices);
+        collectRemoved ();
+      }
+
+      /** \brief The single predicate sweep: keep mask and the output offset of every thread. */
+      void
+      evaluate (int threads, std::vector<int> &offsets)
+      {
+        const int n = static_cast<int> (indices_->size ());
+        keep_.resize (n);
+        offsets.assign (threads + 1, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          const Predicate predicate = predicate_;
+          const bool negative = negative_;
+          int count = 0;
+          const int first = chain::chunkBegin (n, threads, t), last = chain::chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+          {
+            const bool keep = predicate (input_->points[(*indices_)[i]]) != negative;
+            keep_[i] = keep;
+            count += keep;
+          }
+          offsets[t + 1] = count;
+        }
+        for (int t = 0; t < threads; ++t)
+          offsets[t + 1] += offsets[t];
+      }
+
+      void
+      collectRemoved ()
+      {
+        removed_indices_->clear ();
+        if (!extract_removed_indices_ && !keep_organized_)
+          return;
+        for (size_t i = 0; i < keep_.size (); ++i)
+          if (!keep_[i])
+            removed_indices_->push_back ((*indices_)[i]);
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      Predicate predicate_;
+      unsigned int threads_;
+      std::vector<unsigned char> keep_;
+  };
+}
+
+#endif
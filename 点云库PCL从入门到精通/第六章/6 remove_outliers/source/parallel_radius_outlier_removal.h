@@ -0,0 +1,525 @@
+/*! \file parallel_radius_outlier_removal.h
+*  Radius outlier removal that only counts neighbors up to the threshold, in parallel, on a voxel hash or a kd-tree.
+*/
+#ifndef PARALLEL_RADIUS_OUTLIER_REMOVAL_H_
+#define PARALLEL_RADIUS_OUTLIER_REMOVAL_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/console/print.h>
+#include <pcl/common/io.h>
+#include <pcl/filters/filter_indices.h>
+#include <pcl/search/kdtree.h>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief RadiusOutlierRemoval that stops counting once a point has enough neighbors.
+    *
+    * Gives the same result as pcl::RadiusOutlierRemoval: a point of the indices
+    * is kept if at least min_pts + 1 points (itself included) of the whole input
+    * cloud lie within the search radius. RadiusOutlierRemoval runs a full radiusSearch per point and
+    * collects every neighbor only to compare the count with min_pts, here the
+    * query stops as soon as the count is reached, and the points are processed
+    * in parallel. Two backends:
+    *  - VOXEL_HASH (default): the points are sorted into cubic cells of edge
+    *    radius / sqrt (3), so all points of a cell are within the radius of each
+    *    other. A cell with more than min_pts points keeps all of them without a
+    *    single distance computation; otherwise the neighbor cells are visited
+    *    nearest first, cells out of reach are skipped and cells entirely inside
+    *    the radius are counted whole;
+    *  - KDTREE: pcl::search::KdTree radiusSearch with max_nn = min_pts + 1.
+    * The voxel hash falls back to the kd-tree when the cloud spans more than
+    * 2^21 cells along an axis.
+    */
+  template <typename PointT>
+  class ParallelRadiusOutlierRemoval : public FilterIndices<PointT>
+  {
+    protected:
+      typedef typename FilterIndices<PointT>::PointCloud PointCloud;
+      typedef typename pcl::search::KdTree<PointT>::Ptr SearcherPtr;
+
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+      using FilterIndices<PointT>::negative_;
+      using FilterIndices<PointT>::keep_organized_;
+      using FilterIndices<PointT>::user_filter_value_;
+      using FilterIndices<PointT>::extract_removed_indices_;
+      using FilterIndices<PointT>::removed_indices_;
+
+    public:
+      enum SearchBackend { VOXEL_HASH, KDTREE };
+
+      ParallelRadiusOutlierRemoval (bool extract_removed_indices = false)
+        : FilterIndices<PointT> (extract_removed_indices)
+        , search_radius_ (0.0)
+        , min_pts_radius_ (1)
+        , backend_ (VOXEL_HASH)
+        , threads_ (0)
+      {
+        filter_name_ = "ParallelRadiusOutlierRemoval";
+      }
+
+      inline void
+      setRadiusSearch (double radius) { search_radius_ = radius; }
+
+      inline double
+      getRadiusSearch () const { return (search_radius_); }
+
+      /** \brief Points with at most this many neighbors (not counting themselves) are outliers. */
+      inline void
+      setMinNeighborsInRadius (int min_pts) { min_pts_radius_ = min_pts; }
+
+      inline int
+      getMinNeighborsInRadius () const { return (min_pts_radius_); }
+
+      inline void
+      setSearchBackend (SearchBackend backend) { backend_ = backend; }
+
+      inline SearchBackend
+      getSearchBackend () const { return (backend_); }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+    protected:
+      void
+      applyFilter (PointCloud &output)
+      {
+        std::vector<int> indices;
+        if (keep_organized_)
+        {
+          bool temp = extract_removed_indices_;
+          extract_removed_indices_ = true;
+          applyFilterIndices (indices);
+          extract_removed_indices_ = temp;
+
+          output = *input_;
+          for (int rii = 0; rii < static_cast<int> (removed_indices_->size ()); ++rii)
+            output.points[(*removed_indices_)[rii]].x = output.points[(*removed_indices_)[rii]].y = output.points[(*removed_indices_)[rii]].z = user_filter_value_;
+          if (!pcl_isfinite (user_filter_value_))
+            output.is_dense = false;
+        }
+        else
+        {
+          applyFilterIndices (indices);
+          copyPointCloud (*input_, indices, output);
+        }
+      }
+
+      void
+      applyFilter (std::vector<int> &indices)
+      {
+        applyFilterIndices (indices);
+      }
+
+      void
+      applyFilterIndices (std::vector<int> &indices)
+      {
+        indices.clear ();
+        removed_indices_->clear ();
+        if (search_radius_ <= 0.0)
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] No radius defined!\n", getClassName ().c_str ());
+          return;
+        }
+
+        // 统计到 min_pts + 1（含自身）即可停止
+        const int need = std::max (min_pts_radius_ + 1, 0);
+        std::vector<unsigned char> enough (indices_->size (), need <= 0);
+        if (need > 0 && (backend_ != VOXEL_HASH || !countWithVoxelHash (need, enough)))
+          countWithKdTree (need, enough);
+
+        indices.reserve (indices_->size ());
+        if (extract_removed_indices_)
+          removed_indices_->reserve (indices_->size ());
+        for (size_t i = 0; i < indices_->size (); ++i)
+        {
+          if (static_cast<bool> (enough[i]) == negative_)
+          {
+            if (extract_removed_indices_)
+              removed_indices_->push_back ((*indices_)[i]);
+            continue;
+          }
+          indices.push_back ((*indices_)[i]);
+        }
+      }
+
+      void
+      countWithKdTree (int need, std::vector<unsigned char> &enough)
+      {
+        // 与 RadiusOutlierRemoval 相同：近邻在整个输入点云中统计
+        SearcherPtr searcher (new pcl::search::KdTree<PointT> (false));
+        searcher->setInputCloud (input_);
+        const int n = static_cast<int> (indices_->size ());
+#pragma omp parallel num_threads(getThreads ())
+        {
+          std::vector<int> nn_indices;
+          std::vector<float> nn_dists;
+#pragma omp for schedule(dynamic,256)
+          for (int i = 0; i < n; ++i)
+          {
+            const PointT &p = input_->points[(*indices_)[i]];
+            if (!isFinite (p))
+              continue;
+            if (need <= 1)
+            {
+              enough[i] = 1;
+              continue;
+            }
+            enough[i] = searcher->radiusSearch (p, search_radius_, nn_indices, nn_dists, need) >= need;
+          }
+        }
+      }
+
+      struct KeyIndex
+      {
+        boost::uint64_t key;
+        int index;       // 在 input_ 中的下标
+      };
+
+      struct CellPoint
+      {
+        float x, y, z;
+      };
+
+      /** \brief Index of the cell with this key, -1 if it holds no points. */
+      inline int
+      findCell (boost::uint64_t key) const
+      {
+        size_t slot = hashSlot (key);
+        while (hash_table_[slot] >= 0)
+        {
+          if (cell_keys_[hash_table_[slot]] == key)
+            return (hash_table_[slot]);
+          slot = (slot + 1) & (hash_table_.size () - 1);
+        }
+        return (-1);
+      }
+
+      inline size_t
+      hashSlot (boost::uint64_t key) const
+      {
+        return (static_cast<size_t> ((key * 0x9E3779B97F4A7C15ULL) >> hash_shift_));
+      }
+
+      static inline boost::uint64_t
+      cellKey (boost::uint64_t bx, boost::uint64_t by, boost::uint64_t bz)
+      {
+        return (bx | (by << 21) | (bz << 42));
+      }
+
+      /** \brief The voxel hash backend, built over the whole input cloud.
+        * \return false if the cloud is too large for 21-bit cell coordinates
+        */
+      bool
+      countWithVoxelHash (int need, std::vector<unsigned char> &enough)
+      {
+        const int threads = getThreads ();
+        const int n = static_cast<int> (input_->points.size ());
+
+        // 只为索引中的点计数，结果按 input_ 下标存放
+        std::vector<unsigned char> wanted (n, 0), point_enough (n, 0);
+        for (size_t i = 0; i < indices_->size (); ++i)
+          wanted[(*indices_)[i]] = 1;
+
+        // 1. 有效点的包围盒
+        Eigen::Vector3f min_p = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        Eigen::Vector3f max_p = -min_p;
+        std::vector<Eigen::Vector3f> t_min (threads, min_p), t_max (threads, max_p);
+        std::vector<int> t_valid (threads + 1, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+          {
+            const PointT &p = input_->points[i];
+            if (!isFinite (p))
+              continue;
+            t_min[t] = t_min[t].cwiseMin (p.getVector3fMap ());
+            t_max[t] = t_max[t].cwiseMax (p.getVector3fMap ());
+            ++t_valid[t + 1];
+          }
+        }
+        for (int t = 0; t < threads; ++t)
+        {
+          min_p = min_p.cwiseMin (t_min[t]);
+          max_p = max_p.cwiseMax (t_max[t]);
+          t_valid[t + 1] += t_valid[t];
+        }
+        const int valid = t_valid[threads];
+        if (valid == 0)
+          return (true);     // 没有有效点，enough 保持全 0
+
+        // 2. 格子边长 r / sqrt (3) 略小一点，同一格子内的点两两都在半径内；四周留两圈格子
+        cell_size_ = search_radius_ * 0.577;
+        const double inverse = 1.0 / cell_size_;
+        for (int k = 0; k < 3; ++k)
+        {
+          if ((max_p[k] - min_p[k]) * inverse + 5.0 >= static_cast<double> (1 << 21))
+          {
+            PCL_WARN ("[pcl::%s::applyFilter] Radius too small for the voxel hash, using a kd-tree.\n", getClassName ().c_str ());
+            return (false);
+          }
+          origin_[k] = min_p[k] - 2.0 * cell_size_;
+        }
+
+        std::vector<KeyIndex> pairs (valid), buffer (valid);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          int o = t_valid[t];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+          {
+            const PointT &p = input_->points[i];
+            if (!isFinite (p))
+              continue;
+            pairs[o].key = cellKey (static_cast<boost::uint64_t> ((p.x - origin_[0]) * inverse),
+                                    static_cast<boost::uint64_t> ((p.y - origin_[1]) * inverse),
+                                    static_cast<boost::uint64_t> ((p.z - origin_[2]) * inverse));
+            pairs[o++].index = i;
+          }
+        }
+
+        // 3. 按格子排序（基数排序），同一格子的点连续存放
+        int passes = 0;
+        boost::uint64_t max_key = 0;
+        for (int i = 0; i < valid; ++i)
+          max_key |= pairs[i].key;
+        while (passes < 8 && (max_key >> (8 * passes)) != 0)
+          ++passes;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+          radixPass (pairs, buffer, 8 * pass, threads);
+          pairs.swap (buffer);
+        }
+        std::vector<KeyIndex> ().swap (buffer);
+
+        cell_keys_.clear ();
+        cell_begin_.clear ();
+        for (int i = 0; i < valid; ++i)
+          if (i == 0 || pairs[i].key != pairs[i - 1].key)
+          {
+            cell_keys_.push_back (pairs[i].key);
+            cell_begin_.push_back (i);
+          }
+        cell_begin_.push_back (valid);
+        const int cells = static_cast<int> (cell_keys_.size ());
+
+        points_.resize (valid);
+#pragma omp parallel for num_threads(threads)
+        for (int i = 0; i < valid; ++i)
+        {
+          const PointT &p = input_->points[pairs[i].index];
+          points_[i].x = p.x;
+          points_[i].y = p.y;
+          points_[i].z = p.z;
+        }
+
+        // 4. 开放寻址哈希表：格子键 -> 格子编号
+        int bits = 1;
+        while ((1 << bits) < 2 * cells)
+          ++bits;
+        hash_shift_ = 64 - bits;
+        hash_table_.assign (static_cast<size_t> (1) << bits, -1);
+        for (int c = 0; c < cells; ++c)
+        {
+          size_t slot = hashSlot (cell_keys_[c]);
+          while (hash_table_[slot] >= 0)
+            slot = (slot + 1) & (hash_table_.size () - 1);
+          hash_table_[slot] = c;
+        }
+
+        // 5. 5x5x5 邻域按格子间最近距离排序，近的先查；自身格子排在最前
+        std::vector<std::pair<int, int> > order;
+        for (int dz = -2; dz <= 2; ++dz)
+          for (int dy = -2; dy <= 2; ++dy)
+            for (int dx = -2; dx <= 2; ++dx)
+            {
+              const int gap = gapOf (dx) + gapOf (dy) + gapOf (dz);
+              order.push_back (std::make_pair (gap * 1000 + (dx * dx + dy * dy + dz * dz), (dz + 2) * 25 + (dy + 2) * 5 + (dx + 2)));
+            }
+        std::sort (order.begin (), order.end ());
+
+        const float radius_sqr = static_cast<float> (search_radius_ * search_radius_);
+#pragma omp parallel num_threads(threads)
+        {
+          std::vector<int> neighbor_cells;
+          std::vector<int> neighbor_offsets;
+#pragma omp for schedule(dynamic,64)
+          for (int c = 0; c < cells; ++c)
+          {
+            const int size = cell_begin_[c + 1] - cell_begin_[c];
+            if (size >= need)
+            {
+              for (int i = cell_begin_[c]; i < cell_begin_[c + 1]; ++i)
+                point_enough[pairs[i].index] = 1;
+              continue;
+            }
+
+            // 邻域格子只查一次哈希表
+            const boost::uint64_t key = cell_keys_[c];
+            const int b[3] = { static_cast<int> (key & 0x1FFFFF), static_cast<int> ((key >> 21) & 0x1FFFFF),
+                               static_cast<int> ((key >> 42) & 0x1FFFFF) };
+            neighbor_cells.clear ();
+            neighbor_offsets.clear ();
+            for (size_t o = 1; o < order.size (); ++o)
+            {
+              const int code = order[o].second;
+              const int d[3] = { code % 5 - 2, (code / 5) % 5 - 2, code / 25 - 2 };
+              const int cell = findCell (cellKey (b[0] + d[0], b[1] + d[1], b[2] + d[2]));
+              if (cell < 0)
+                continue;
+              neighbor_cells.push_back (cell);
+              neighbor_offsets.push_back (code);
+            }
+
+            for (int i = cell_begin_[c]; i < cell_begin_[c + 1]; ++i)
+            {
+              if (!wanted[pairs[i].index])
+                continue;
+              const CellPoint &q = points_[i];
+              int count = size;
+              for (size_t k = 0; k < neighbor_cells.size () && count < need; ++k)
+              {
+                const int cell = neighbor_cells[k];
+                const int code = neighbor_offsets[k];
+                const int d[3] = { code % 5 - 2, (code / 5) % 5 - 2, code / 25 - 2 };
+                double near_sqr, far_sqr;
+                boxDistances (q, b, d, near_sqr, far_sqr);
+                if (near_sqr > radius_sqr)
+                  continue;
+                const int cell_size = cell_begin_[cell + 1] - cell_begin_[cell];
+                if (far_sqr < radius_sqr)
+                {
+                  count += cell_size;
+                  continue;
+                }
+                for (int j = cell_begin_[cell]; j < cell_begin_[cell + 1] && count < need; ++j)
+                {
+                  const float dx = points_[j].x - q.x, dy = points_[j].y - q.y, dz = points_[j].z - q.z;
+                  if (dx * dx + dy * dy + dz * dz <= radius_sqr)
+                    ++count;
+                }
+              }
+              point_enough[pairs[i].index] = count >= need;
+            }
+          }
+        }
+
+        for (size_t i = 0; i < indices_->size (); ++i)
+          enough[i] = point_enough[(*indices_)[i]];
+        return (true);
+      }
+
+      static inline int
+      gapOf (int d)
+      {
+        return (d == 0 ? 0 : (std::abs (d) - 1) * (std::abs (d) - 1));
+      }
+
+      /** \brief Squared distances from q to the nearest and farthest point of the cell b + d,
+        * the cell padded a little against rounding.
+        */
+      inline void
+      boxDistances (const CellPoint &q, const int b[3], const int d[3], double &near_sqr, double &far_sqr) const
+      {
+        const double xyz[3] = { q.x, q.y, q.z };
+        const double pad = 1e-5 * cell_size_;
+        near_sqr = far_sqr = 0.0;
+        for (int k = 0; k < 3; ++k)
+        {
+          const double lo = origin_[k] + (b[k] + d[k]) * cell_size_ - pad;
+          const double hi = lo + cell_size_ + 2.0 * pad;
+          const double near_d = std::max (std::max (lo - xyz[k], xyz[k] - hi), 0.0);
+          const double far_d = std::max (xyz[k] - lo, hi - xyz[k]);
+          near_sqr += near_d * near_d;
+          far_sqr += far_d * far_d;
+        }
+      }
+
+      /** \brief One stable counting-sort pass over the byte at shift (see ParallelVoxelGrid). */
+      static void
+      radixPass (const std::vector<KeyIndex> &src, std::vector<KeyIndex> &dst, int shift, int threads)
+      {
+        const int n = static_cast<int> (src.size ());
+        std::vector<size_t> offsets (static_cast<size_t> (threads) * 256, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          size_t *hist = &offsets[static_cast<size_t> (t) * 256];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+            ++hist[(src[i].key >> shift) & 0xff];
+        }
+        size_t sum = 0;
+        for (int d = 0; d < 256; ++d)
+          for (int t = 0; t < threads; ++t)
+          {
+            size_t c = offsets[static_cast<size_t> (t) * 256 + d];
+            offsets[static_cast<size_t> (t) * 256 + d] = sum;
+            sum += c;
+          }
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          size_t *offset = &offsets[static_cast<size_t> (t) * 256];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+            dst[offset[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+      }
+
+      static inline int
+      chunkBegin (int n, int chunks, int c)
+      {
+        return (static_cast<int> (static_cast<long long> (n) * c / chunks));
+      }
+
+      static inline bool
+      isFinite (const PointT &p)
+      {
+        return (pcl_isfinite (p.x) && pcl_isfinite (p.y) && pcl_isfinite (p.z));
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      double search_radius_;
+      int min_pts_radius_;
+      SearchBackend backend_;
+      unsigned int threads_;
+
+      // 体素哈希，每次滤波重建
+      double cell_size_;
+      double origin_[3];
+      std::vector<boost::uint64_t> cell_keys_;
+      std::vector<int> cell_begin_;
+      std::vector<CellPoint> points_;
+      std::vector<int> hash_table_;
+      int hash_shift_;
+  };
+}
+
+#endif
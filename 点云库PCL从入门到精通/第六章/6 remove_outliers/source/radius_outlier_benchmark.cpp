@@ -0,0 +1,85 @@
+#include <pcl/point_types.h>
+#include <pcl/filters/radius_outlier_removal.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "parallel_radius_outlier_removal.h"
+
+typedef pcl::PointXYZ PointT;
+using namespace pcl::console;
+
+static float
+random01 ()
+{
+  return (rand () / (RAND_MAX + 1.0f));
+}
+
+int
+main (int argc, char** argv)
+{
+  float millions = 1.0f, noise = 0.02f;
+  double radius = 0.01;
+  int min_neighbors = 2, threads = 0;
+  parse_argument (argc, argv, "-n", millions);
+  parse_argument (argc, argv, "-noise", noise);
+  parse_argument (argc, argv, "-r", radius);
+  parse_argument (argc, argv, "-min", min_neighbors);
+  parse_argument (argc, argv, "-t", threads);
+  bool skip_pcl = find_switch (argc, argv, "-skip");
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [-n millions (default 1)] [-noise ratio (default 0.02)] [-r radius (default 0.01)]"
+              << " [-min neighbors (default 2)] [-t threads] [-skip (no RadiusOutlierRemoval)]\n";
+    return (0);
+  }
+
+  // 填入点云数据：单位正方形上的稠密薄层，加上散布在单位立方体里的噪声点
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  cloud->width = static_cast<uint32_t> (millions * 1e6);
+  cloud->height = 1;
+  cloud->points.resize (cloud->width);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    cloud->points[i].x = random01 ();
+    cloud->points[i].y = random01 ();
+    cloud->points[i].z = random01 () < noise ? random01 () : 0.001f * random01 ();
+  }
+  std::cerr << cloud->points.size () << " points, radius " << radius << ", min neighbors " << min_neighbors << std::endl;
+
+  TicToc tt;
+  std::vector<int> reference;
+  if (!skip_pcl)
+  {
+    pcl::RadiusOutlierRemoval<PointT> outrem;
+    outrem.setInputCloud (cloud);
+    outrem.setRadiusSearch (radius);
+    outrem.setMinNeighborsInRadius (min_neighbors);
+    tt.tic ();
+    outrem.filter (reference);
+    std::cerr << "RadiusOutlierRemoval:                    " << tt.toc () << " ms, " << reference.size () << " points" << std::endl;
+  }
+
+  bool same = true;
+  const char *names[2] = { "voxel hash", "kd-tree" };
+  const pcl::ParallelRadiusOutlierRemoval<PointT>::SearchBackend backends[2] =
+    { pcl::ParallelRadiusOutlierRemoval<PointT>::VOXEL_HASH, pcl::ParallelRadiusOutlierRemoval<PointT>::KDTREE };
+  for (int b = 0; b < 2; ++b)
+  {
+    std::vector<int> indices;
+    pcl::ParallelRadiusOutlierRemoval<PointT> outrem;
+    outrem.setInputCloud (cloud);
+    outrem.setRadiusSearch (radius);
+    outrem.setMinNeighborsInRadius (min_neighbors);
+    outrem.setSearchBackend (backends[b]);
+    outrem.setNumberOfThreads (threads);
+    tt.tic ();
+    outrem.filter (indices);
+    std::cerr << "ParallelRadiusOutlierRemoval (" << names[b] << "): " << tt.toc () << " ms, " << indices.size () << " points" << std::endl;
+    same = same && (skip_pcl || indices == reference);
+  }
+  if (!skip_pcl)
+    std::cerr << (same ? "Results are identical." : "Results differ!") << std::endl;
+  return (same ? 0 : -1);
+}
@@ -2,12 +2,14 @@
 #include <pcl/point_types.h>
 #include <pcl/filters/radius_outlier_removal.h>
 #include <pcl/filters/conditional_removal.h>
+#include "condition_expressions.h"
+#include "parallel_radius_outlier_removal.h"
 int
  main (int argc, char** argv)
 {
   if (argc != 2)
   {
-    std::cerr << "please specify command line arg '-r' or '-c'" << std::endl;
+    std::cerr << "please specify command line arg '-r', '-p', '-c' or '-e'" << std::endl;
     exit(0);
   }
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
@@ -31,6 +33,14 @@ int
     // Ӧ˲
     outrem.filter (*cloud_filtered);
   }
+  else if (strcmp(argv[1], "-p") == 0){
+    //  -r ͬھ˾ֹͣд
+    pcl::ParallelRadiusOutlierRemoval<pcl::PointXYZ> outrem;
+    outrem.setInputCloud(cloud);
+    outrem.setRadiusSearch(0.8);
+    outrem.setMinNeighborsInRadius (2);
+    outrem.filter (*cloud_filtered);
+  }
   else if (strcmp(argv[1], "-c") == 0){
     // 
     pcl::ConditionAnd<pcl::PointXYZ>::Ptr range_cond (new
@@ -46,8 +56,14 @@ int
     // Ӧ˲
     condrem.filter (*cloud_filtered);
   }
+  else if (strcmp(argv[1], "-e") == 0){
+    //  -c ͬдɱڱʽֶƫƾ̬ȷ鲢м
+    using pcl::condition::field;
+    pcl::condition::filter (*cloud, field<pcl::fields::z> () > 0.0f && field<pcl::fields::z> () < 0.8f,
+                            *cloud_filtered, true);
+  }
   else{
-    std::cerr << "please specify command line arg '-r' or '-c'" << std::endl;
+    std::cerr << "please specify command line arg '-r', '-p', '-c' or '-e'" << std::endl;
     exit(0);
   }
   std::cerr << "Cloud before filtering: " << std::endl;
@@ -0,0 +1,127 @@
+#include <pcl/point_types.h>
+#include <pcl/filters/crop_hull.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "batch_cropper.h"
+
+typedef pcl::PointXYZ PointT;
+using namespace pcl::console;
+
+static float
+random01 ()
+{
+  return (rand () / (RAND_MAX + 1.0f));
+}
+
+int
+main (int argc, char** argv)
+{
+  float millions = 2.0f;
+  int parcels = 20, threads = 0;
+  parse_argument (argc, argv, "-n", millions);
+  parse_argument (argc, argv, "-parcels", parcels);
+  parse_argument (argc, argv, "-t", threads);
+  bool skip_loop = find_switch (argc, argv, "-skip");
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [-n millions (default 2)] [-parcels per side (default 20)] [-t threads] [-skip (no per-region loop)]\n";
+    return (0);
+  }
+
+  // 填入点云数据：100 x 100 m 的场地，高 0..10 m
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  cloud->width = static_cast<uint32_t> (millions * 1e6);
+  cloud->height = 1;
+  cloud->points.resize (cloud->width);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    cloud->points[i].x = 100.0f * random01 ();
+    cloud->points[i].y = 100.0f * random01 ();
+    cloud->points[i].z = 10.0f * random01 ();
+  }
+
+  // 区域：每块地一个不规则的 2D 边界（CropHull），外加一个房间大小的盒子（CropBox）
+  std::vector<pcl::PointCloud<PointT>::Ptr> hull_clouds;
+  std::vector<std::vector<pcl::Vertices> > hull_polygons;
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > box_min, box_max;
+  const float size = 100.0f / parcels;
+  for (int i = 0; i < parcels; ++i)
+    for (int j = 0; j < parcels; ++j)
+    {
+      const float cx = (i + 0.5f) * size, cy = (j + 0.5f) * size;
+      pcl::PointCloud<PointT>::Ptr hull_cloud (new pcl::PointCloud<PointT>);
+      std::vector<pcl::Vertices> polygons (1);
+      for (int k = 0; k < 16; ++k)
+      {
+        const float angle = 2.0f * static_cast<float> (M_PI) * k / 16;
+        const float radius = size * (0.35f + 0.2f * random01 ());
+        hull_cloud->push_back (PointT (cx + radius * std::cos (angle), cy + radius * std::sin (angle), 0.0f));
+        polygons[0].vertices.push_back (k);
+      }
+      hull_clouds.push_back (hull_cloud);
+      hull_polygons.push_back (polygons);
+      box_min.push_back (Eigen::Vector4f (cx - 0.3f * size, cy - 0.3f * size, 0.0f, 1.0f));
+      box_max.push_back (Eigen::Vector4f (cx + 0.3f * size, cy + 0.3f * size, 3.0f, 1.0f));
+    }
+  std::cerr << cloud->points.size () << " points, " << hull_clouds.size () + box_min.size () << " regions" << std::endl;
+
+  TicToc tt;
+  std::vector<size_t> loop_sizes;
+  if (!skip_loop)
+  {
+    // 逐个区域裁剪：每个区域扫描一遍点云
+    tt.tic ();
+    for (size_t r = 0; r < hull_clouds.size (); ++r)
+    {
+      pcl::PointCloud<PointT> cropped;
+      pcl::CropHull<PointT> crop_hull;
+      crop_hull.setDim (2);
+      crop_hull.setHullCloud (hull_clouds[r]);
+      crop_hull.setHullIndices (hull_polygons[r]);
+      crop_hull.setInputCloud (cloud);
+      crop_hull.filter (cropped);
+      loop_sizes.push_back (cropped.points.size ());
+    }
+    for (size_t r = 0; r < box_min.size (); ++r)
+    {
+      pcl::PointCloud<PointT> cropped;
+      pcl::CropBox<PointT> crop_box;
+      crop_box.setMin (box_min[r]);
+      crop_box.setMax (box_max[r]);
+      crop_box.setInputCloud (cloud);
+      crop_box.filter (cropped);
+      loop_sizes.push_back (cropped.points.size ());
+    }
+    std::cerr << "per-region CropHull/CropBox: " << tt.toc () << " ms" << std::endl;
+  }
+
+  // 一次并行扫描，同时得到所有区域的索引
+  pcl::BatchCropper<PointT> cropper;
+  for (size_t r = 0; r < hull_clouds.size (); ++r)
+    cropper.addHull (hull_clouds[r], hull_polygons[r], 2);
+  for (size_t r = 0; r < box_min.size (); ++r)
+    cropper.addBox (box_min[r].head<3> (), box_max[r].head<3> ());
+  cropper.setInputCloud (cloud);
+  cropper.setNumberOfThreads (threads);
+  std::vector<std::vector<int> > region_indices;
+  tt.tic ();
+  cropper.crop (region_indices);
+  std::cerr << "BatchCropper:                " << tt.toc () << " ms" << std::endl;
+
+  size_t total = 0;
+  bool same = true;
+  for (size_t r = 0; r < region_indices.size (); ++r)
+  {
+    total += region_indices[r].size ();
+    same = same && (skip_loop || loop_sizes[r] == region_indices[r].size ());
+  }
+  std::cerr << total << " point-region assignments" << std::endl;
+  if (!skip_loop)
+    std::cerr << (same ? "Region sizes are identical." : "Region sizes differ!") << std::endl;
+  return (same ? 0 : -1);
+}
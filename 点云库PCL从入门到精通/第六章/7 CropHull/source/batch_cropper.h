@@ -0,0 +1,319 @@
+/*! \file batch_cropper.h
+*  Crops one cloud against many boxes and hulls at once: a grid over the regions gives every point its candidate regions, one parallel pass fills per-region index lists.
+*/
+#ifndef BATCH_CROPPER_H_
+#define BATCH_CROPPER_H_
+
+#include <pcl/pcl_base.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/Vertices.h>
+#include <pcl/console/print.h>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "fast_crop_hull.h"
+
+namespace pcl
+{
+  /** \brief Assigns every point of a cloud to all the regions (boxes or hulls) that contain it.
+    *
+    * Running CropBox, PassThrough or CropHull once per region scans the whole
+    * cloud once per region. Here the bounding boxes of the regions are put in a
+    * uniform grid once; every point looks up its grid cell and is only tested
+    * against the few regions registered there, so the cost is about one pass
+    * over the cloud whatever the number of regions. The pass runs in parallel
+    * and gives, for every region, the indices of the points inside it in input
+    * order. A point inside several overlapping regions is listed in each.
+    *
+    * Boxes are axis aligned and closed (min <= p <= max), as in CropBox; use
+    * -FLT_MAX / FLT_MAX for an unbounded axis, e.g. addBox on a single axis
+    * range is a PassThrough. Hulls are tested with FastCropHull, i.e. exactly
+    * like CropHull with setCropOutside (true).
+    */
+  template <typename PointT>
+  class BatchCropper : public PCLBase<PointT>
+  {
+    public:
+      typedef pcl::PointCloud<PointT> PointCloud;
+      typedef typename PointCloud::Ptr PointCloudPtr;
+
+      using PCLBase<PointT>::input_;
+      using PCLBase<PointT>::indices_;
+
+      BatchCropper ()
+        : target_cells_per_region_ (8)
+        , threads_ (0)
+        , grid_ready_ (false)
+      {
+      }
+
+      /** \brief Add an axis aligned box. \return the region id (index into the crop result) */
+      int
+      addBox (const Eigen::Vector3f &min_p, const Eigen::Vector3f &max_p)
+      {
+        Region region;
+        region.min = min_p;
+        region.max = max_p;
+        regions_.push_back (region);
+        grid_ready_ = false;
+        return (static_cast<int> (regions_.size ()) - 1);
+      }
+
+      /** \brief Add a hull, given as for CropHull. \return the region id, or -1 if the hull is invalid */
+      int
+      addHull (const PointCloudPtr &hull_cloud, const std::vector<Vertices> &polygons, int dim)
+      {
+        Region region;
+        region.hull.reset (new FastCropHull<PointT>);
+        region.hull->setHullCloud (hull_cloud);
+        region.hull->setHullIndices (polygons);
+        region.hull->setDim (dim);
+        if (!region.hull->prepareHull ())
+          return (-1);
+        region.hull->getHullBoundingBox (region.min, region.max);
+        regions_.push_back (region);
+        grid_ready_ = false;
+        return (static_cast<int> (regions_.size ()) - 1);
+      }
+
+      inline void
+      clearRegions () { regions_.clear (); grid_ready_ = false; }
+
+      inline size_t
+      getNumberOfRegions () const { return (regions_.size ()); }
+
+      /** \brief About how many grid cells to use per region (default 8). */
+      inline void
+      setCellsPerRegion (int cells) { target_cells_per_region_ = std::max (cells, 1); grid_ready_ = false; }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Crop the input (or its indices) against all regions.
+        * \param[out] region_indices one index list per region, in region id order
+        */
+      void
+      crop (std::vector<std::vector<int> > &region_indices)
+      {
+        region_indices.assign (regions_.size (), std::vector<int> ());
+        if (regions_.empty () || !this->initCompute ())
+          return;
+        buildGrid ();
+
+        // 每个线程处理连续的一段点，各自按区域收集索引，最后按线程顺序拼接，保持输入顺序
+        const int threads = getThreads ();
+        const int n = static_cast<int> (indices_->size ());
+        const int regions = static_cast<int> (regions_.size ());
+        std::vector<std::vector<std::vector<int> > > partial (threads, std::vector<std::vector<int> > (regions));
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          std::vector<std::vector<int> > &local = partial[t];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+          {
+            const int index = (*indices_)[i];
+            const PointT &p = input_->points[index];
+            const int cell = cellOf (p);
+            if (cell < 0)
+              continue;
+            for (int k = cell_begin_[cell]; k < cell_begin_[cell + 1]; ++k)
+            {
+              const int r = cell_regions_[k];
+              if (contains (regions_[r], p))
+                local[r].push_back (index);
+            }
+          }
+        }
+
+#pragma omp parallel for schedule(dynamic,16) num_threads(threads)
+        for (int r = 0; r < regions; ++r)
+        {
+          size_t size = 0;
+          for (int t = 0; t < threads; ++t)
+            size += partial[t][r].size ();
+          region_indices[r].reserve (size);
+          for (int t = 0; t < threads; ++t)
+            region_indices[r].insert (region_indices[r].end (), partial[t][r].begin (), partial[t][r].end ());
+        }
+        this->deinitCompute ();
+      }
+
+    protected:
+      struct Region
+      {
+        Eigen::Vector3f min, max;
+        boost::shared_ptr<FastCropHull<PointT> > hull;   // 为空时是盒子
+      };
+
+      static inline bool
+      isBounded (float min_v, float max_v)
+      {
+        return (pcl_isfinite (min_v) && pcl_isfinite (max_v) &&
+                min_v > -std::numeric_limits<float>::max () && max_v < std::numeric_limits<float>::max ());
+      }
+
+      static inline bool
+      contains (const Region &region, const PointT &p)
+      {
+        if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+          return (false);
+        if (p.x < region.min[0] || p.y < region.min[1] || p.z < region.min[2] ||
+            p.x > region.max[0] || p.y > region.max[1] || p.z > region.max[2])
+          return (false);
+        return (!region.hull || region.hull->contains (p));
+      }
+
+      /** \brief Uniform grid over the union of the region boxes, each cell listing the regions that overlap it.
+        *
+        * An axis on which some region is unbounded gets a single cell.
+        */
+      void
+      buildGrid ()
+      {
+        if (grid_ready_)
+          return;
+        grid_min_ = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        Eigen::Vector3f grid_max = -grid_min_;
+        bool bounded[3] = { true, true, true };
+        for (size_t r = 0; r < regions_.size (); ++r)
+          for (int k = 0; k < 3; ++k)
+          {
+            bounded[k] = bounded[k] && isBounded (regions_[r].min[k], regions_[r].max[k]);
+            grid_min_[k] = std::min (grid_min_[k], regions_[r].min[k]);
+            grid_max[k] = std::max (grid_max[k], regions_[r].max[k]);
+          }
+
+        // 有界的轴上取大小相同的格子，总数约为区域数乘以 target_cells_per_region_
+        double volume = 1.0;
+        int bounded_axes = 0;
+        for (int k = 0; k < 3; ++k)
+          if (bounded[k] && grid_max[k] > grid_min_[k])
+          {
+            volume *= grid_max[k] - grid_min_[k];
+            ++bounded_axes;
+          }
+        // 很扁的范围会让格子数远超目标，此时放大格子
+        const double target = static_cast<double> (regions_.size ()) * target_cells_per_region_;
+        double cell_size = bounded_axes > 0 ? std::pow (volume / target, 1.0 / bounded_axes) : 0.0;
+        do
+        {
+          for (int k = 0; k < 3; ++k)
+          {
+            grid_size_[k] = 1;
+            cell_scale_[k] = 0.0f;
+            grid_bounded_[k] = bounded[k];
+            if (bounded[k] && grid_max[k] > grid_min_[k] && cell_size > 0.0)
+            {
+              grid_size_[k] = static_cast<int> (std::min (std::ceil ((grid_max[k] - grid_min_[k]) / cell_size), 1024.0));
+              grid_size_[k] = std::max (grid_size_[k], 1);
+              cell_scale_[k] = static_cast<float> (grid_size_[k] / (grid_max[k] - grid_min_[k]));
+            }
+            grid_max_[k] = grid_max[k];
+          }
+          cell_size *= 1.5;
+        }
+        while (static_cast<double> (grid_size_[0]) * grid_size_[1] * grid_size_[2] > 4.0 * target + 64.0);
+
+        // 两遍：先数每个格子的区域数，再填入
+        const int cells = grid_size_[0] * grid_size_[1] * grid_size_[2];
+        cell_begin_.assign (cells + 1, 0);
+        for (int pass = 0; pass < 2; ++pass)
+        {
+          std::vector<int> fill;
+          if (pass == 1)
+          {
+            for (int c = 0; c < cells; ++c)
+              cell_begin_[c + 1] += cell_begin_[c];
+            cell_regions_.resize (cell_begin_[cells]);
+            fill.assign (cell_begin_.begin (), cell_begin_.end () - 1);
+          }
+          for (size_t r = 0; r < regions_.size (); ++r)
+          {
+            int lo[3], hi[3];
+            for (int k = 0; k < 3; ++k)
+            {
+              lo[k] = grid_size_[k] > 1 ? coordinateCell (regions_[r].min[k], k) : 0;
+              hi[k] = grid_size_[k] > 1 ? coordinateCell (regions_[r].max[k], k) : 0;
+            }
+            for (int z = lo[2]; z <= hi[2]; ++z)
+              for (int y = lo[1]; y <= hi[1]; ++y)
+                for (int x = lo[0]; x <= hi[0]; ++x)
+                {
+                  const int c = (z * grid_size_[1] + y) * grid_size_[0] + x;
+                  if (pass == 0)
+                    ++cell_begin_[c + 1];
+                  else
+                    cell_regions_[fill[c]++] = static_cast<int> (r);
+                }
+          }
+        }
+        grid_ready_ = true;
+      }
+
+      /** \brief Cell coordinate of the finite value v along axis k, clamped to the grid. */
+      inline int
+      coordinateCell (float v, int k) const
+      {
+        // 先在 double 中截断再转 int，超出 int 范围的值转换是未定义行为
+        const double c = (static_cast<double> (v) - grid_min_[k]) * cell_scale_[k];
+        return (static_cast<int> (std::max (0.0, std::min (c, static_cast<double> (grid_size_[k] - 1)))));
+      }
+
+      /** \brief Grid cell of a point, -1 if it is not finite or outside every region box. */
+      inline int
+      cellOf (const PointT &p) const
+      {
+        if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+          return (-1);
+        const Eigen::Vector3f q = p.getVector3fMap ();
+        int c[3];
+        for (int k = 0; k < 3; ++k)
+        {
+          if (grid_bounded_[k] && (q[k] < grid_min_[k] || q[k] > grid_max_[k]))
+            return (-1);
+          c[k] = grid_size_[k] > 1 ? coordinateCell (q[k], k) : 0;
+        }
+        return ((c[2] * grid_size_[1] + c[1]) * grid_size_[0] + c[0]);
+      }
+
+      static inline int
+      chunkBegin (int n, int chunks, int c)
+      {
+        return (static_cast<int> (static_cast<long long> (n) * c / chunks));
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      std::vector<Region> regions_;
+      int target_cells_per_region_;
+      unsigned int threads_;
+
+      bool grid_ready_;
+      Eigen::Vector3f grid_min_, grid_max_;
+      Eigen::Vector3f cell_scale_;
+      int grid_size_[3];
+      bool grid_bounded_[3];
+      std::vector<int> cell_begin_;     // 格子 c 的区域：cell_regions_[cell_begin_[c] .. cell_begin_[c + 1])
+      std::vector<int> cell_regions_;
+  };
+}
+
+#endif
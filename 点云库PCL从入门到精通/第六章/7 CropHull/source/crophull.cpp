@@ -6,7 +6,9 @@
 #include <pcl/surface/concave_hull.h>
 #include <pcl/visualization/cloud_viewer.h>
 #include <iostream>
+#include <string>
 #include <vector>
+#include "fast_crop_hull.h"
 
 int main(int argc, char** argv) {
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
@@ -31,12 +33,22 @@ int main(int argc, char** argv) {
 
   pcl::PointCloud<pcl::PointXYZ>::Ptr objects(
       new pcl::PointCloud<pcl::PointXYZ>);
-  pcl::CropHull<pcl::PointXYZ> bb_filter;
-  bb_filter.setDim(2);
-  bb_filter.setInputCloud(cloud);
-  bb_filter.setHullIndices(polygons);
-  bb_filter.setHullCloud(surface_hull);
-  bb_filter.filter(*objects);
+  if (argc > 2 && std::string(argv[2]) == "-fast") {
+    // 凸包预处理一次，点的判断并行进行，结果与 CropHull 相同
+    pcl::FastCropHull<pcl::PointXYZ> bb_filter;
+    bb_filter.setDim(2);
+    bb_filter.setInputCloud(cloud);
+    bb_filter.setHullIndices(polygons);
+    bb_filter.setHullCloud(surface_hull);
+    bb_filter.filter(*objects);
+  } else {
+    pcl::CropHull<pcl::PointXYZ> bb_filter;
+    bb_filter.setDim(2);
+    bb_filter.setInputCloud(cloud);
+    bb_filter.setHullIndices(polygons);
+    bb_filter.setHullCloud(surface_hull);
+    bb_filter.filter(*objects);
+  }
   std::cout << objects->size() << std::endl;
 
   // visualize
@@ -0,0 +1,168 @@
+#include <pcl/point_types.h>
+#include <pcl/filters/crop_hull.h>
+#include <pcl/surface/convex_hull.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "fast_crop_hull.h"
+
+typedef pcl::PointXYZ PointT;
+using namespace pcl::console;
+
+static float
+random11 ()
+{
+  return (2.0f * rand () / (RAND_MAX + 1.0f) - 1.0f);
+}
+
+// 凹的闭合三角网格：半径随经纬度起伏的球面，相对球心是星形的，不自交
+static void
+makeBumpySphere (int rings, int segments, pcl::PointCloud<PointT> &cloud, std::vector<pcl::Vertices> &triangles)
+{
+  cloud.clear ();
+  triangles.clear ();
+  cloud.push_back (PointT (0.0f, 0.0f, 1.0f));
+  for (int j = 1; j < rings; ++j)
+    for (int i = 0; i < segments; ++i)
+    {
+      const float theta = static_cast<float> (M_PI) * j / rings, phi = 2.0f * static_cast<float> (M_PI) * i / segments;
+      const float radius = 1.0f + 0.3f * std::sin (5.0f * phi) * std::sin (3.0f * theta);
+      cloud.push_back (PointT (radius * std::sin (theta) * std::cos (phi), radius * std::sin (theta) * std::sin (phi),
+                               radius * std::cos (theta)));
+    }
+  cloud.push_back (PointT (0.0f, 0.0f, -1.0f));
+  const int south = static_cast<int> (cloud.points.size ()) - 1;
+
+  pcl::Vertices triangle;
+  triangle.vertices.resize (3);
+  for (int j = 0; j < rings; ++j)
+    for (int i = 0; i < segments; ++i)
+    {
+      // 第 j 圈（0 和 rings 为两极）上的第 i 个顶点
+      const int a = j == 0 ? 0 : 1 + (j - 1) * segments + i, b = j == 0 ? 0 : 1 + (j - 1) * segments + (i + 1) % segments;
+      const int c = j + 1 == rings ? south : 1 + j * segments + i, d = j + 1 == rings ? south : 1 + j * segments + (i + 1) % segments;
+      if (j > 0)
+      {
+        triangle.vertices[0] = a; triangle.vertices[1] = c; triangle.vertices[2] = b;
+        triangles.push_back (triangle);
+      }
+      if (j + 1 < rings)
+      {
+        triangle.vertices[0] = b; triangle.vertices[1] = c; triangle.vertices[2] = d;
+        triangles.push_back (triangle);
+      }
+    }
+}
+
+// 同一个多边形或三角网格分别用 CropHull 和 FastCropHull 裁剪，比较时间和结果
+static bool
+compare (const char *name, const pcl::PointCloud<PointT>::Ptr &cloud, const pcl::PointCloud<PointT>::Ptr &hull_cloud,
+         const std::vector<pcl::Vertices> &polygons, int dim, int threads, bool skip_crop_hull, bool use_convex_test = true)
+{
+  TicToc tt;
+  std::vector<int> fast;
+  pcl::FastCropHull<PointT> fast_filter;
+  fast_filter.setDim (dim);
+  fast_filter.setUseConvexTest (use_convex_test);
+  fast_filter.setHullCloud (hull_cloud);
+  fast_filter.setHullIndices (polygons);
+  fast_filter.setInputCloud (cloud);
+  fast_filter.setNumberOfThreads (threads);
+  tt.tic ();
+  fast_filter.filter (fast);
+  std::cerr << name << " FastCropHull: " << tt.toc () << " ms, " << fast.size () << " points"
+            << (fast_filter.isConvex () ? " (half-space test)" : "") << std::endl;
+  if (skip_crop_hull)
+    return (true);
+
+  pcl::PointCloud<PointT> reference;
+  pcl::CropHull<PointT> crop_hull;
+  crop_hull.setDim (dim);
+  crop_hull.setHullCloud (hull_cloud);
+  crop_hull.setHullIndices (polygons);
+  crop_hull.setInputCloud (cloud);
+  tt.tic ();
+  crop_hull.filter (reference);
+  std::cerr << name << " CropHull:     " << tt.toc () << " ms, " << reference.points.size () << " points" << std::endl;
+
+  // 凸包的半空间判断只在恰好落在表面上的点上可能与射线法不同
+  bool same = reference.points.size () == fast.size ();
+  for (size_t i = 0; same && i < fast.size (); ++i)
+    same = reference.points[i].x == cloud->points[fast[i]].x && reference.points[i].y == cloud->points[fast[i]].y &&
+           reference.points[i].z == cloud->points[fast[i]].z;
+  std::cerr << name << (same ? " results are identical." : " results differ!") << std::endl;
+  return (same);
+}
+
+int
+main (int argc, char** argv)
+{
+  float millions = 2.0f;
+  int vertices = 500, threads = 0;
+  parse_argument (argc, argv, "-n", millions);
+  parse_argument (argc, argv, "-v", vertices);
+  parse_argument (argc, argv, "-t", threads);
+  bool skip_crop_hull = find_switch (argc, argv, "-skip");
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [-n millions (default 2)] [-v polygon vertices (default 500)] [-t threads] [-skip (no CropHull)]\n";
+    return (0);
+  }
+
+  // 填入点云数据：[-1.5, 1.5]^3 内的随机点
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  cloud->width = static_cast<uint32_t> (millions * 1e6);
+  cloud->height = 1;
+  cloud->points.resize (cloud->width);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    cloud->points[i].x = 1.5f * random11 ();
+    cloud->points[i].y = 1.5f * random11 ();
+    cloud->points[i].z = 1.5f * random11 ();
+  }
+  std::cerr << cloud->points.size () << " points" << std::endl;
+
+  // 2D：锯齿状的凹多边形，类似一块不规则场地的边界
+  pcl::PointCloud<PointT>::Ptr boundary (new pcl::PointCloud<PointT>);
+  std::vector<pcl::Vertices> boundary_polygons (1);
+  for (int i = 0; i < vertices; ++i)
+  {
+    const float angle = 2.0f * static_cast<float> (M_PI) * i / vertices;
+    const float radius = (i % 2) ? 0.6f + 0.2f * random11 () : 1.0f;
+    boundary->push_back (PointT (radius * std::cos (angle), radius * std::sin (angle), 0.0f));
+    boundary_polygons[0].vertices.push_back (i);
+  }
+  bool same = compare ("2D", cloud, boundary, boundary_polygons, 2, threads, skip_crop_hull);
+
+  // 3D：单位球内随机点的凸包
+  pcl::PointCloud<PointT>::Ptr hull_input (new pcl::PointCloud<PointT>);
+  while (static_cast<int> (hull_input->points.size ()) < vertices)
+  {
+    PointT p (random11 (), random11 (), random11 ());
+    if (p.getVector3fMap ().norm () <= 1.0f)
+      hull_input->push_back (p);
+  }
+  pcl::PointCloud<PointT>::Ptr hull_cloud (new pcl::PointCloud<PointT>);
+  std::vector<pcl::Vertices> hull_polygons;
+  pcl::ConvexHull<PointT> hull;
+  hull.setInputCloud (hull_input);
+  hull.setDimension (3);
+  hull.reconstruct (*hull_cloud, hull_polygons);
+  std::cerr << "3D hull: " << hull_polygons.size () << " triangles" << std::endl;
+  same = compare ("3D", cloud, hull_cloud, hull_polygons, 3, threads, skip_crop_hull) && same;
+  // 同一个凸包关掉半空间判断，走与凹网格相同的 BVH 射线法
+  same = compare ("3D rays", cloud, hull_cloud, hull_polygons, 3, threads, skip_crop_hull, false) && same;
+
+  // 3D：凹的闭合网格，只能用射线法
+  pcl::PointCloud<PointT>::Ptr bumpy_cloud (new pcl::PointCloud<PointT>);
+  std::vector<pcl::Vertices> bumpy_polygons;
+  const int segments = std::max (8, static_cast<int> (std::sqrt (2.0f * vertices)));
+  makeBumpySphere (segments / 2, segments, *bumpy_cloud, bumpy_polygons);
+  std::cerr << "3D concave mesh: " << bumpy_polygons.size () << " triangles" << std::endl;
+  same = compare ("3D concave", cloud, bumpy_cloud, bumpy_polygons, 3, threads, skip_crop_hull) && same;
+  return (same ? 0 : -1);
+}
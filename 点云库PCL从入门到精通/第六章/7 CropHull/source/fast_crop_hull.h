@@ -0,0 +1,661 @@
+/*! \file fast_crop_hull.h
+*  CropHull with precomputed hull structures: bounding box reject, slab-bucketed 2D polygons, half-space test for closed convex hulls, BVH ray casting otherwise, parallel over points.
+*/
+#ifndef FAST_CROP_HULL_H_
+#define FAST_CROP_HULL_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/Vertices.h>
+#include <pcl/console/print.h>
+#include <pcl/filters/filter_indices.h>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief pcl::CropHull with the same interface and results, for large clouds and hulls.
+    *
+    * CropHull tests every point against every hull polygon (a 2D crossing test
+    * per polygon, or three ray casts against every triangle in 3D). Here the
+    * hull is preprocessed once, when it is set, and the points are tested in
+    * parallel:
+    *  - points outside the bounding box of the hull (of each polygon in 2D) are
+    *    rejected right away; in 3D only for a closed hull, since CropHull's ray
+    *    test can put points outside the box of an open mesh inside;
+    *  - dim 2: every polygon's edges are bucketed into vertical slabs, so the
+    *    crossing test of a point only visits the few edges over its x;
+    *  - dim 3, closed convex hull (e.g. from ConvexHull): a point is inside if it
+    *    is behind all face planes, no ray casting at all;
+    *  - dim 3 otherwise: the same three rays as CropHull, cast through a BVH over
+    *    the triangles, so a ray only visits the triangles near it.
+    * The 2D test and the 3D ray-triangle test are those of CropHull, so results
+    * agree except for points exactly on the surface of a convex hull.
+    */
+  template <typename PointT>
+  class FastCropHull : public FilterIndices<PointT>
+  {
+    protected:
+      typedef typename FilterIndices<PointT>::PointCloud PointCloud;
+      typedef typename PointCloud::Ptr PointCloudPtr;
+
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+      using FilterIndices<PointT>::negative_;
+      using FilterIndices<PointT>::keep_organized_;
+      using FilterIndices<PointT>::user_filter_value_;
+      using FilterIndices<PointT>::extract_removed_indices_;
+      using FilterIndices<PointT>::removed_indices_;
+
+    public:
+      FastCropHull ()
+        : dim_ (3)
+        , crop_outside_ (true)
+        , use_convex_test_ (true)
+        , threads_ (0)
+        , prepared_ (false)
+        , convex_ (false)
+        , closed_ (false)
+      {
+        filter_name_ = "FastCropHull";
+      }
+
+      /** \brief The hull polygons, as indices into the hull cloud. */
+      inline void
+      setHullIndices (const std::vector<Vertices> &polygons) { hull_polygons_ = polygons; prepared_ = false; }
+
+      inline std::vector<Vertices>
+      getHullIndices () const { return (hull_polygons_); }
+
+      inline void
+      setHullCloud (PointCloudPtr points) { hull_cloud_ = points; prepared_ = false; }
+
+      inline PointCloudPtr
+      getHullCloud () const { return (hull_cloud_); }
+
+      /** \brief 2 for a planar hull (points are projected on the plane of the two
+        * axes along which the hull extends most), 3 for a closed surface.
+        */
+      inline void
+      setDim (int dim) { dim_ = dim; prepared_ = false; }
+
+      /** \brief true (default): keep the points inside the hull, false: keep those outside. */
+      inline void
+      setCropOutside (bool crop_outside) { crop_outside_ = crop_outside; }
+
+      /** \brief Use the half-space test for closed convex 3D hulls (default true). */
+      inline void
+      setUseConvexTest (bool use_convex_test) { use_convex_test_ = use_convex_test; prepared_ = false; }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Whether the last filter call used the half-space test. */
+      inline bool
+      isConvex () const { return (convex_); }
+
+      /** \brief Build the hull structures now (filter does it when needed).
+        * \return false if no valid hull is set
+        */
+      inline bool
+      prepareHull () { return (prepare ()); }
+
+      /** \brief Test a single point against the hull, after prepareHull succeeded.
+        * Does not look at crop_outside or negative. Safe to call from several threads.
+        */
+      inline bool
+      contains (const PointT &p) const { return (isInside (p)); }
+
+      /** \brief Box that holds every point inside the hull, after prepareHull. For dim 2
+        * the axis the polygons are projected along is unbounded (-FLT_MAX .. FLT_MAX),
+        * for an open 3D mesh all axes are.
+        */
+      inline void
+      getHullBoundingBox (Eigen::Vector3f &min_p, Eigen::Vector3f &max_p) const
+      {
+        if (dim_ == 3 && !closed_)
+        {
+          max_p = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+          min_p = -max_p;
+          return;
+        }
+        min_p = hull_min_;
+        max_p = hull_max_;
+      }
+
+    protected:
+      void
+      applyFilter (PointCloud &output)
+      {
+        std::vector<int> indices;
+        if (keep_organized_)
+        {
+          bool temp = extract_removed_indices_;
+          extract_removed_indices_ = true;
+          applyFilter (indices);
+          extract_removed_indices_ = temp;
+
+          output = *input_;
+          for (int rii = 0; rii < static_cast<int> (removed_indices_->size ()); ++rii)
+            output.points[(*removed_indices_)[rii]].x = output.points[(*removed_indices_)[rii]].y = output.points[(*removed_indices_)[rii]].z = user_filter_value_;
+          if (!pcl_isfinite (user_filter_value_))
+            output.is_dense = false;
+          return;
+        }
+        applyFilter (indices);
+        output.points.resize (indices.size ());
+        output.width = static_cast<uint32_t> (indices.size ());
+        output.height = 1;
+        output.is_dense = input_->is_dense;
+        const int n = static_cast<int> (indices.size ());
+#pragma omp parallel for num_threads(getThreads ())
+        for (int i = 0; i < n; ++i)
+          output.points[i] = input_->points[indices[i]];
+      }
+
+      void
+      applyFilter (std::vector<int> &indices)
+      {
+        indices.clear ();
+        removed_indices_->clear ();
+        if (!prepare ())
+          return;
+
+        // 每个线程测试自己那一段点，记下保留标记和数目，再按前缀和写出
+        const int threads = getThreads ();
+        const int n = static_cast<int> (indices_->size ());
+        std::vector<unsigned char> keep (n);
+        std::vector<int> offsets (threads + 1, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          int count = 0;
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+          {
+            keep[i] = (isInside (input_->points[(*indices_)[i]]) == crop_outside_) != negative_;
+            count += keep[i];
+          }
+          offsets[t + 1] = count;
+        }
+        for (int t = 0; t < threads; ++t)
+          offsets[t + 1] += offsets[t];
+
+        indices.resize (offsets[threads]);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          int o = offsets[t];
+          const int first = chunkBegin (n, threads, t), last = chunkBegin (n, threads, t + 1);
+          for (int i = first; i < last; ++i)
+            if (keep[i])
+              indices[o++] = (*indices_)[i];
+        }
+        if (extract_removed_indices_)
+          for (int i = 0; i < n; ++i)
+            if (!keep[i])
+              removed_indices_->push_back ((*indices_)[i]);
+      }
+
+      /** \brief One edge of a 2D polygon as used by CropHull's crossing test. */
+      struct Edge2D
+      {
+        double x_old, x_new;     // 边的两个端点的 x，按多边形顺序
+        double x1, y1, x2, y2;   // 同一条边，按 x 从小到大
+      };
+
+      /** \brief A 2D polygon with its bounding box and its edges bucketed into slabs along x. */
+      struct Polygon2D
+      {
+        double min_x, max_x, min_y, max_y;
+        double slab_scale;
+        std::vector<Edge2D> edges;
+        std::vector<int> slab_begin;   // slab s: slab_edges[slab_begin[s] .. slab_begin[s + 1])
+        std::vector<int> slab_edges;
+      };
+
+      struct Triangle
+      {
+        Eigen::Vector3f a, u, v, n;
+        float uu, uv, vv, denominator;
+      };
+
+      struct Plane
+      {
+        Eigen::Vector3f n;
+        float d;
+      };
+
+      struct BVHNode
+      {
+        Eigen::Vector3f min, max;
+        int first, count;        // 叶子：triangle_order_[first .. first + count)
+        int left, right;         // 内部节点的子节点
+      };
+
+      /** \brief Build the hull structures once per hull. */
+      bool
+      prepare ()
+      {
+        if (prepared_)
+          return (true);
+        if (!hull_cloud_ || hull_cloud_->points.empty () || hull_polygons_.empty ())
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] No hull set.\n", getClassName ().c_str ());
+          return (false);
+        }
+        convex_ = false;
+        closed_ = false;
+        polygons_.clear ();
+        triangles_.clear ();
+        planes_.clear ();
+        nodes_.clear ();
+        if (dim_ == 2)
+          prepare2D ();
+        else if (dim_ == 3)
+          prepare3D ();
+        else
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] Dimension must be 2 or 3.\n", getClassName ().c_str ());
+          return (false);
+        }
+        prepared_ = true;
+        return (true);
+      }
+
+      void
+      prepare2D ()
+      {
+        // 与 CropHull 一样，丢掉凸包范围最小的那个轴
+        Eigen::Vector3f min_p = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        Eigen::Vector3f max_p = -min_p;
+        for (size_t i = 0; i < hull_cloud_->points.size (); ++i)
+        {
+          min_p = min_p.cwiseMin (hull_cloud_->points[i].getVector3fMap ());
+          max_p = max_p.cwiseMax (hull_cloud_->points[i].getVector3fMap ());
+        }
+        const Eigen::Vector3f range = max_p - min_p;
+        if (range[0] <= range[1] && range[0] <= range[2])
+          { plane_dim1_ = 1; plane_dim2_ = 2; }
+        else if (range[1] <= range[2] && range[1] <= range[0])
+          { plane_dim1_ = 2; plane_dim2_ = 0; }
+        else
+          { plane_dim1_ = 0; plane_dim2_ = 1; }
+
+        for (size_t p = 0; p < hull_polygons_.size (); ++p)
+        {
+          const std::vector<uint32_t> &verts = hull_polygons_[p].vertices;
+          if (verts.empty ())
+            continue;
+          Polygon2D poly;
+          poly.min_x = poly.min_y = std::numeric_limits<double>::max ();
+          poly.max_x = poly.max_y = -std::numeric_limits<double>::max ();
+          double x_old = hull_cloud_->points[verts.back ()].getVector3fMap ()[plane_dim1_];
+          double y_old = hull_cloud_->points[verts.back ()].getVector3fMap ()[plane_dim2_];
+          for (size_t i = 0; i < verts.size (); ++i)
+          {
+            const double x_new = hull_cloud_->points[verts[i]].getVector3fMap ()[plane_dim1_];
+            const double y_new = hull_cloud_->points[verts[i]].getVector3fMap ()[plane_dim2_];
+            Edge2D e;
+            e.x_old = x_old;
+            e.x_new = x_new;
+            if (x_new > x_old)
+              { e.x1 = x_old; e.x2 = x_new; e.y1 = y_old; e.y2 = y_new; }
+            else
+              { e.x1 = x_new; e.x2 = x_old; e.y1 = y_new; e.y2 = y_old; }
+            poly.edges.push_back (e);
+            poly.min_x = std::min (poly.min_x, x_new);
+            poly.max_x = std::max (poly.max_x, x_new);
+            poly.min_y = std::min (poly.min_y, y_new);
+            poly.max_y = std::max (poly.max_y, y_new);
+            x_old = x_new;
+            y_old = y_new;
+          }
+
+          // 按 x 分条：每条只记与它的 x 区间重叠的边
+          const int slabs = static_cast<int> (std::min<size_t> (std::max<size_t> (poly.edges.size (), 1), 4096));
+          const double width = poly.max_x - poly.min_x;
+          poly.slab_scale = width > 0.0 ? slabs / width : 0.0;
+          std::vector<std::vector<int> > buckets (slabs);
+          for (size_t i = 0; i < poly.edges.size (); ++i)
+          {
+            const int s1 = slabOf (poly, poly.edges[i].x1, slabs), s2 = slabOf (poly, poly.edges[i].x2, slabs);
+            for (int s = s1; s <= s2; ++s)
+              buckets[s].push_back (static_cast<int> (i));
+          }
+          poly.slab_begin.assign (1, 0);
+          for (int s = 0; s < slabs; ++s)
+          {
+            poly.slab_edges.insert (poly.slab_edges.end (), buckets[s].begin (), buckets[s].end ());
+            poly.slab_begin.push_back (static_cast<int> (poly.slab_edges.size ()));
+          }
+          polygons_.push_back (poly);
+        }
+
+        // 包围盒：投影平面内为各多边形的范围，投影方向不限
+        hull_min_ = Eigen::Vector3f::Constant (-std::numeric_limits<float>::max ());
+        hull_max_ = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        if (!polygons_.empty ())
+        {
+          hull_min_[plane_dim1_] = hull_min_[plane_dim2_] = std::numeric_limits<float>::max ();
+          hull_max_[plane_dim1_] = hull_max_[plane_dim2_] = -std::numeric_limits<float>::max ();
+        }
+        for (size_t i = 0; i < polygons_.size (); ++i)
+        {
+          hull_min_[plane_dim1_] = std::min (hull_min_[plane_dim1_], static_cast<float> (polygons_[i].min_x));
+          hull_max_[plane_dim1_] = std::max (hull_max_[plane_dim1_], static_cast<float> (polygons_[i].max_x));
+          hull_min_[plane_dim2_] = std::min (hull_min_[plane_dim2_], static_cast<float> (polygons_[i].min_y));
+          hull_max_[plane_dim2_] = std::max (hull_max_[plane_dim2_], static_cast<float> (polygons_[i].max_y));
+        }
+      }
+
+      static inline int
+      slabOf (const Polygon2D &poly, double x, int slabs)
+      {
+        const int s = static_cast<int> ((x - poly.min_x) * poly.slab_scale);
+        return (std::max (0, std::min (s, slabs - 1)));
+      }
+
+      void
+      prepare3D ()
+      {
+        hull_min_ = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        hull_max_ = -hull_min_;
+        Eigen::Vector3f centroid = Eigen::Vector3f::Zero ();
+        std::vector<char> used (hull_cloud_->points.size (), 0);
+        int used_count = 0;
+        std::map<std::pair<uint32_t, uint32_t>, int> edge_uses;
+        for (size_t p = 0; p < hull_polygons_.size (); ++p)
+        {
+          const std::vector<uint32_t> &verts = hull_polygons_[p].vertices;
+          for (size_t i = 0; i < verts.size (); ++i)
+          {
+            const Eigen::Vector3f v = hull_cloud_->points[verts[i]].getVector3fMap ();
+            hull_min_ = hull_min_.cwiseMin (v);
+            hull_max_ = hull_max_.cwiseMax (v);
+            if (!used[verts[i]])
+            {
+              used[verts[i]] = 1;
+              centroid += v;
+              ++used_count;
+            }
+            const uint32_t a = verts[i], b = verts[(i + 1) % verts.size ()];
+            ++edge_uses[std::make_pair (std::min (a, b), std::max (a, b))];
+          }
+          // CropHull 只用每个多边形的前三个顶点
+          if (verts.size () < 3)
+            continue;
+          Triangle tri;
+          tri.a = hull_cloud_->points[verts[0]].getVector3fMap ();
+          tri.u = hull_cloud_->points[verts[1]].getVector3fMap () - tri.a;
+          tri.v = hull_cloud_->points[verts[2]].getVector3fMap () - tri.a;
+          tri.n = tri.u.cross (tri.v);
+          tri.uu = tri.u.dot (tri.u);
+          tri.uv = tri.u.dot (tri.v);
+          tri.vv = tri.v.dot (tri.v);
+          tri.denominator = tri.uv * tri.uv - tri.uu * tri.vv;
+          triangles_.push_back (tri);
+        }
+        if (used_count > 0)
+          centroid /= static_cast<float> (used_count);
+
+        // 封闭（每条边恰好两个面共用）且所有顶点都在每个面的内侧，就是凸包
+        bool closed = !edge_uses.empty ();
+        for (std::map<std::pair<uint32_t, uint32_t>, int>::const_iterator it = edge_uses.begin (); closed && it != edge_uses.end (); ++it)
+          closed = it->second == 2;
+        closed_ = closed;
+        if (use_convex_test_ && closed && triangles_.size () >= 4)
+        {
+          const float eps = 1e-5f * (hull_max_ - hull_min_).norm ();
+          convex_ = true;
+          for (size_t t = 0; t < triangles_.size () && convex_; ++t)
+          {
+            const float length = triangles_[t].n.norm ();
+            if (length <= 0.0f)
+              continue;
+            Plane plane;
+            plane.n = triangles_[t].n / length;
+            plane.d = plane.n.dot (triangles_[t].a);
+            if (plane.n.dot (centroid) > plane.d)
+            {
+              plane.n = -plane.n;
+              plane.d = -plane.d;
+            }
+            for (size_t i = 0; i < used.size () && convex_; ++i)
+              if (used[i] && plane.n.dot (hull_cloud_->points[i].getVector3fMap ()) - plane.d > eps)
+                convex_ = false;
+            planes_.push_back (plane);
+          }
+        }
+        if (convex_)
+          return;
+        planes_.clear ();
+
+        triangle_order_.resize (triangles_.size ());
+        for (size_t t = 0; t < triangles_.size (); ++t)
+          triangle_order_[t] = static_cast<int> (t);
+        if (!triangles_.empty ())
+          buildNode (0, static_cast<int> (triangles_.size ()));
+      }
+
+      /** \brief BVH over triangle_order_[first .. last), split at the median along the longest axis. */
+      int
+      buildNode (int first, int last)
+      {
+        BVHNode node;
+        node.min = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        node.max = -node.min;
+        for (int i = first; i < last; ++i)
+        {
+          const Triangle &tri = triangles_[triangle_order_[i]];
+          node.min = node.min.cwiseMin (tri.a).cwiseMin (tri.a + tri.u).cwiseMin (tri.a + tri.v);
+          node.max = node.max.cwiseMax (tri.a).cwiseMax (tri.a + tri.u).cwiseMax (tri.a + tri.v);
+        }
+        // 稍微放大包围盒，射线擦过边界时不会漏掉三角形
+        const Eigen::Vector3f pad = (node.max - node.min) * 1e-4f + Eigen::Vector3f::Constant (1e-6f);
+        node.min -= pad;
+        node.max += pad;
+        node.first = first;
+        node.count = last - first;
+        node.left = node.right = -1;
+        const int index = static_cast<int> (nodes_.size ());
+        nodes_.push_back (node);
+        if (last - first <= 4)
+          return (index);
+
+        int axis = 0;
+        const Eigen::Vector3f extent = node.max - node.min;
+        if (extent[1] > extent[axis]) axis = 1;
+        if (extent[2] > extent[axis]) axis = 2;
+        const int middle = (first + last) / 2;
+        std::nth_element (triangle_order_.begin () + first, triangle_order_.begin () + middle,
+                          triangle_order_.begin () + last, CentroidLess (triangles_, axis));
+        const int left = buildNode (first, middle);
+        const int right = buildNode (middle, last);
+        nodes_[index].count = 0;
+        nodes_[index].left = left;
+        nodes_[index].right = right;
+        return (index);
+      }
+
+      struct CentroidLess
+      {
+        CentroidLess (const std::vector<Triangle> &triangles, int axis) : triangles_ (triangles), axis_ (axis) {}
+
+        inline bool
+        operator() (int a, int b) const
+        {
+          const Triangle &ta = triangles_[a], &tb = triangles_[b];
+          return (3.0f * ta.a[axis_] + ta.u[axis_] + ta.v[axis_] < 3.0f * tb.a[axis_] + tb.u[axis_] + tb.v[axis_]);
+        }
+
+        const std::vector<Triangle> &triangles_;
+        int axis_;
+      };
+
+      inline bool
+      isInside (const PointT &p) const
+      {
+        if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+          return (false);
+        if (dim_ == 2)
+        {
+          const Eigen::Vector3f q = p.getVector3fMap ();
+          const double x = q[plane_dim1_], y = q[plane_dim2_];
+          for (size_t i = 0; i < polygons_.size (); ++i)
+            if (isInPolygon (polygons_[i], x, y))
+              return (true);
+          return (false);
+        }
+
+        // 开放网格外的点也可能被射线判为内部，只对封闭的网格做包围盒剔除
+        const Eigen::Vector3f q = p.getVector3fMap ();
+        if (closed_ && ((q.array () < hull_min_.array ()).any () || (q.array () > hull_max_.array ()).any ()))
+          return (false);
+        if (convex_)
+        {
+          for (size_t i = 0; i < planes_.size (); ++i)
+            if (planes_[i].n.dot (q) > planes_[i].d)
+              return (false);
+          return (true);
+        }
+        // CropHull 的三条固定射线，多数射线穿过奇数次即在内部
+        static const float rays[3][3] = { { 0.264882f, -0.688399f, 0.675237f },
+                                          { 0.0145442f, 0.732538f, 0.68037f },
+                                          { 0.856376f, 0.509797f, 0.0819642f } };
+        int odd = 0;
+        for (int r = 0; r < 3; ++r)
+          odd += countCrossings (q, Eigen::Vector3f (rays[r][0], rays[r][1], rays[r][2])) & 1;
+        return (odd > 1);
+      }
+
+      /** \brief CropHull's 2D crossing test, restricted to the edges of the point's slab. */
+      inline bool
+      isInPolygon (const Polygon2D &poly, double x, double y) const
+      {
+        if (x < poly.min_x || x > poly.max_x || y < poly.min_y || y > poly.max_y)
+          return (false);
+        const int s = slabOf (poly, x, static_cast<int> (poly.slab_begin.size ()) - 1);
+        bool in_poly = false;
+        for (int k = poly.slab_begin[s]; k < poly.slab_begin[s + 1]; ++k)
+        {
+          const Edge2D &e = poly.edges[poly.slab_edges[k]];
+          if ((e.x_new < x) == (x <= e.x_old) && (y - e.y1) * (e.x2 - e.x1) < (e.y2 - e.y1) * (x - e.x1))
+            in_poly = !in_poly;
+        }
+        return (in_poly);
+      }
+
+      int
+      countCrossings (const Eigen::Vector3f &origin, const Eigen::Vector3f &ray) const
+      {
+        const Eigen::Vector3f inverse (1.0f / ray[0], 1.0f / ray[1], 1.0f / ray[2]);
+        int crossings = 0;
+        if (nodes_.empty ())
+          return (crossings);
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+          const BVHNode &node = nodes_[stack[--top]];
+          if (!rayHitsBox (origin, inverse, node))
+            continue;
+          if (node.count > 0)
+          {
+            for (int i = node.first; i < node.first + node.count; ++i)
+              crossings += rayTriangleIntersect (origin, ray, triangles_[triangle_order_[i]]);
+            continue;
+          }
+          stack[top++] = node.left;
+          stack[top++] = node.right;
+        }
+        return (crossings);
+      }
+
+      static inline bool
+      rayHitsBox (const Eigen::Vector3f &origin, const Eigen::Vector3f &inverse, const BVHNode &node)
+      {
+        float t_min = 0.0f, t_max = std::numeric_limits<float>::max ();
+        for (int k = 0; k < 3; ++k)
+        {
+          float t1 = (node.min[k] - origin[k]) * inverse[k];
+          float t2 = (node.max[k] - origin[k]) * inverse[k];
+          if (t1 > t2)
+            std::swap (t1, t2);
+          t_min = std::max (t_min, t1);
+          t_max = std::min (t_max, t2);
+        }
+        return (t_min <= t_max);
+      }
+
+      /** \brief CropHull::rayTriangleIntersect with the per-triangle terms precomputed. */
+      static inline bool
+      rayTriangleIntersect (const Eigen::Vector3f &point, const Eigen::Vector3f &ray, const Triangle &tri)
+      {
+        const float n_dot_ray = tri.n.dot (ray);
+        if (std::fabs (n_dot_ray) < 1e-9)
+          return (false);
+        const float r = tri.n.dot (tri.a - point) / n_dot_ray;
+        if (r < 0)
+          return (false);
+        const Eigen::Vector3f w = point + ray * r - tri.a;
+        const float wu = w.dot (tri.u), wv = w.dot (tri.v);
+        const float s = (tri.uv * wv - tri.vv * wu) / tri.denominator;
+        if (s < 0 || s > 1)
+          return (false);
+        const float t = (tri.uv * wu - tri.uu * wv) / tri.denominator;
+        if (t < 0 || s + t > 1)
+          return (false);
+        return (true);
+      }
+
+      static inline int
+      chunkBegin (int n, int chunks, int c)
+      {
+        return (static_cast<int> (static_cast<long long> (n) * c / chunks));
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      PointCloudPtr hull_cloud_;
+      std::vector<Vertices> hull_polygons_;
+      int dim_;
+      bool crop_outside_;
+      bool use_convex_test_;
+      unsigned int threads_;
+
+      bool prepared_;
+      bool convex_;
+      bool closed_;
+      int plane_dim1_, plane_dim2_;
+      std::vector<Polygon2D> polygons_;
+      Eigen::Vector3f hull_min_, hull_max_;
+      std::vector<Triangle> triangles_;
+      std::vector<Plane> planes_;
+      std::vector<BVHNode> nodes_;
+      std::vector<int> triangle_order_;
+  };
+}
+
+#endif
@@ -7,13 +7,13 @@
 #include <pcl/filters/project_inliers.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/surface/concave_hull.h>
+#include "parallel_project_inliers.h"
 
 int
 main (int argc, char** argv)
 {
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>), 
-                                      cloud_filtered (new pcl::PointCloud<pcl::PointXYZ>), 
-                                      cloud_projected (new pcl::PointCloud<pcl::PointXYZ>);
+                                      cloud_filtered (new pcl::PointCloud<pcl::PointXYZ>);
   pcl::PCDReader reader;
 
   reader.read ("table_scene_mug_stereo_textured.pcd", *cloud);
@@ -42,12 +42,12 @@ main (int argc, char** argv)
   std::cerr << "PointCloud after segmentation has: "
             << inliers->indices.size () << " inliers." << std::endl;
 
-  // Project the model inliers
-  pcl::ProjectInliers<pcl::PointXYZ> proj;
+  // Project the model inliers, in place and in parallel: cloud_filtered is not needed afterwards
+  pcl::ParallelProjectInliers<pcl::PointXYZ> proj;
   proj.setModelType (pcl::SACMODEL_PLANE);
-  proj.setInputCloud (cloud_filtered);
   proj.setModelCoefficients (coefficients);
-  proj.filter (*cloud_projected);
+  proj.projectInPlace (*cloud_filtered);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_projected = cloud_filtered;
   std::cerr << "PointCloud after projection has: "
             << cloud_projected->points.size () << " data points." << std::endl;
 
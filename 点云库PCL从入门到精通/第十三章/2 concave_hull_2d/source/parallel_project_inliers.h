@@ -0,0 +1,339 @@
+/*! \file parallel_project_inliers.h
+*  ProjectInliers for plane, line, cylinder and sphere models: points are projected in SoA blocks, blocks in parallel, optionally in place.
+*/
+#ifndef PARALLEL_PROJECT_INLIERS_H_
+#define PARALLEL_PROJECT_INLIERS_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/ModelCoefficients.h>
+#include <pcl/console/print.h>
+#include <pcl/filters/filter.h>
+#include <pcl/sample_consensus/model_types.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief ProjectInliers with a blocked, parallel projection kernel that can also work in place.
+    *
+    * ProjectInliers builds a SampleConsensusModel and projects the points one
+    * at a time through it, serially. Here the model coefficients are turned
+    * into a few constants once, the points are loaded into x / y / z arrays
+    * of kBlockSize points, projected with straight loops over the arrays
+    * (which the compiler vectorizes) and stored back; blocks run in parallel.
+    * Supported models:
+    *  - planes (SACMODEL_PLANE and the other plane models): [a b c d];
+    *  - lines (SACMODEL_LINE, SACMODEL_PARALLEL_LINE): [point, direction];
+    *  - SACMODEL_CYLINDER: [point on axis, axis direction, radius];
+    *  - SACMODEL_SPHERE: [center, radius] (ProjectInliers leaves the points
+    *    unchanged for spheres); points at the center are left unchanged.
+    * The plane equation is normalized as a whole, which is what ProjectInliers
+    * computes for the normalized coefficients SACSegmentation returns.
+    *
+    * filter behaves like ProjectInliers (setCopyAllData included) and writes
+    * a new cloud; use projectInPlace to project the points without any copy.
+    */
+  template <typename PointT>
+  class ParallelProjectInliers : public Filter<PointT>
+  {
+    protected:
+      typedef typename Filter<PointT>::PointCloud PointCloud;
+
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+
+    public:
+      /** \brief Number of points projected together. */
+      static const int kBlockSize = 256;
+
+      ParallelProjectInliers ()
+        : model_type_ (-1)
+        , copy_all_data_ (false)
+        , threads_ (0)
+      {
+        filter_name_ = "ParallelProjectInliers";
+      }
+
+      inline void
+      setModelType (int model) { model_type_ = model; }
+
+      inline int
+      getModelType () const { return (model_type_); }
+
+      inline void
+      setModelCoefficients (const ModelCoefficientsConstPtr &model) { model_ = model; }
+
+      inline ModelCoefficientsConstPtr
+      getModelCoefficients () const { return (model_); }
+
+      /** \brief Output the whole input cloud, with only the indexed points projected. */
+      inline void
+      setCopyAllData (bool val) { copy_all_data_ = val; }
+
+      inline bool
+      getCopyAllData () const { return (copy_all_data_); }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Project all points of a cloud onto the model, in place. */
+      bool
+      projectInPlace (PointCloud &cloud)
+      {
+        return (project (cloud, NULL, cloud, false));
+      }
+
+      /** \brief Project the given points of a cloud onto the model, in place. */
+      bool
+      projectInPlace (PointCloud &cloud, const std::vector<int> &indices)
+      {
+        return (project (cloud, &indices, cloud, false));
+      }
+
+    protected:
+      void
+      applyFilter (PointCloud &output)
+      {
+        // 只有 PCL 1.7 的 Filter::filter 会把输入点云本身作为输出传进来（之后的版本传临时点云）：
+        // 保留全部点，或索引正好是全部点时，直接原地投影
+        if (&output == input_.get () && (copy_all_data_ || isIdentity (*indices_, output.points.size ())))
+        {
+          project (output, indices_.get (), output, false);
+          return;
+        }
+        if (copy_all_data_)
+        {
+          output = *input_;
+          project (output, indices_.get (), output, false);
+          return;
+        }
+
+        // 只输出索引中的点：读入、投影、写出在同一遍中完成
+        PointCloud projected;
+        PointCloud &target = &output == input_.get () ? projected : output;
+        target.header = input_->header;
+        target.points.resize (indices_->size ());
+        target.width = static_cast<uint32_t> (indices_->size ());
+        target.height = 1;
+        target.is_dense = input_->is_dense;
+        if (!project (*input_, indices_.get (), target, true))
+          target.points.clear ();
+        if (&target == &projected)
+          output.swap (projected);
+      }
+
+      static bool
+      isIdentity (const std::vector<int> &indices, size_t size)
+      {
+        if (indices.size () != size)
+          return (false);
+        for (size_t i = 0; i < size; ++i)
+          if (indices[i] != static_cast<int> (i))
+            return (false);
+        return (true);
+      }
+
+      enum Kind { PLANE, LINE, CYLINDER, SPHERE };
+
+      /** \brief The model reduced to the constants the kernels use. */
+      struct Model
+      {
+        Kind kind;
+        float px, py, pz;   // 平面法向 / 直线、圆柱轴上一点 / 球心
+        float dx, dy, dz;   // 直线、圆柱轴方向（单位向量）
+        float d;            // 平面常数项
+        float radius;
+      };
+
+      bool
+      makeModel (Model &m) const
+      {
+        if (!model_)
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] No model coefficients given!\n", getClassName ().c_str ());
+          return (false);
+        }
+        const std::vector<float> &c = model_->values;
+        size_t needed = 0;
+        switch (model_type_)
+        {
+          case SACMODEL_PLANE:
+          case SACMODEL_NORMAL_PLANE:
+          case SACMODEL_PARALLEL_PLANE:
+          case SACMODEL_PERPENDICULAR_PLANE:
+          case SACMODEL_NORMAL_PARALLEL_PLANE:
+            m.kind = PLANE;
+            needed = 4;
+            break;
+          case SACMODEL_LINE:
+          case SACMODEL_PARALLEL_LINE:
+            m.kind = LINE;
+            needed = 6;
+            break;
+          case SACMODEL_CYLINDER:
+            m.kind = CYLINDER;
+            needed = 7;
+            break;
+          case SACMODEL_SPHERE:
+            m.kind = SPHERE;
+            needed = 4;
+            break;
+          default:
+            PCL_ERROR ("[pcl::%s::applyFilter] Model type %d not supported!\n", getClassName ().c_str (), model_type_);
+            return (false);
+        }
+        if (c.size () < needed)
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] Model needs %d coefficients, got %d!\n", getClassName ().c_str (),
+                     static_cast<int> (needed), static_cast<int> (c.size ()));
+          return (false);
+        }
+
+        if (m.kind == PLANE)
+        {
+          const float norm = std::sqrt (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+          if (norm == 0.0f)
+          {
+            PCL_ERROR ("[pcl::%s::applyFilter] Plane normal is zero!\n", getClassName ().c_str ());
+            return (false);
+          }
+          m.px = c[0] / norm; m.py = c[1] / norm; m.pz = c[2] / norm;
+          m.d = c[3] / norm;
+          return (true);
+        }
+        m.px = c[0]; m.py = c[1]; m.pz = c[2];
+        if (m.kind == SPHERE)
+        {
+          m.radius = c[3];
+          return (true);
+        }
+        const float norm = std::sqrt (c[3] * c[3] + c[4] * c[4] + c[5] * c[5]);
+        if (norm == 0.0f)
+        {
+          PCL_ERROR ("[pcl::%s::applyFilter] Direction is zero!\n", getClassName ().c_str ());
+          return (false);
+        }
+        m.dx = c[3] / norm; m.dy = c[4] / norm; m.dz = c[5] / norm;
+        m.radius = m.kind == CYLINDER ? c[6] : 0.0f;
+        return (true);
+      }
+
+      /** \brief Project the points of src (all, or the given indices) block by block.
+        * \param[out] dst src itself (the points are projected in place), or a cloud of the
+        * size of indices when compact is set (the points are copied and projected in order)
+        */
+      bool
+      project (const PointCloud &src, const std::vector<int> *indices, PointCloud &dst, bool compact)
+      {
+        Model m;
+        if (!makeModel (m))
+          return (false);
+        const int n = indices ? static_cast<int> (indices->size ()) : static_cast<int> (src.points.size ());
+        const int blocks = (n + kBlockSize - 1) / kBlockSize;
+#pragma omp parallel for schedule(static) num_threads(getThreads ())
+        for (int b = 0; b < blocks; ++b)
+        {
+          float x[kBlockSize], y[kBlockSize], z[kBlockSize];
+          const int first = b * kBlockSize;
+          const int count = std::min (kBlockSize, n - first);
+          for (int i = 0; i < count; ++i)
+          {
+            const PointT &p = src.points[indices ? (*indices)[first + i] : first + i];
+            x[i] = p.x;
+            y[i] = p.y;
+            z[i] = p.z;
+          }
+          projectBlock (m, x, y, z, count);
+          for (int i = 0; i < count; ++i)
+          {
+            const int source = indices ? (*indices)[first + i] : first + i;
+            PointT &p = dst.points[compact ? first + i : source];
+            if (compact)
+              p = src.points[source];
+            p.x = x[i];
+            p.y = y[i];
+            p.z = z[i];
+          }
+        }
+        return (true);
+      }
+
+      /** \brief The projection kernels; one branch per block, plain loops over the arrays. */
+      static void
+      projectBlock (const Model &m, float *x, float *y, float *z, int count)
+      {
+        switch (m.kind)
+        {
+          case PLANE:
+            for (int i = 0; i < count; ++i)
+            {
+              const float distance = m.px * x[i] + m.py * y[i] + m.pz * z[i] + m.d;
+              x[i] -= distance * m.px;
+              y[i] -= distance * m.py;
+              z[i] -= distance * m.pz;
+            }
+            break;
+          case LINE:
+            for (int i = 0; i < count; ++i)
+            {
+              const float k = (x[i] - m.px) * m.dx + (y[i] - m.py) * m.dy + (z[i] - m.pz) * m.dz;
+              x[i] = m.px + k * m.dx;
+              y[i] = m.py + k * m.dy;
+              z[i] = m.pz + k * m.dz;
+            }
+            break;
+          case CYLINDER:
+            // 先投影到轴上，再沿垂直于轴的方向移到半径处
+            for (int i = 0; i < count; ++i)
+            {
+              const float k = (x[i] - m.px) * m.dx + (y[i] - m.py) * m.dy + (z[i] - m.pz) * m.dz;
+              const float ax = m.px + k * m.dx, ay = m.py + k * m.dy, az = m.pz + k * m.dz;
+              const float ox = x[i] - ax, oy = y[i] - ay, oz = z[i] - az;
+              const float length = std::sqrt (ox * ox + oy * oy + oz * oz);
+              const float scale = length > 0.0f ? m.radius / length : 0.0f;
+              x[i] = ax + ox * scale;
+              y[i] = ay + oy * scale;
+              z[i] = az + oz * scale;
+            }
+            break;
+          case SPHERE:
+            for (int i = 0; i < count; ++i)
+            {
+              const float ox = x[i] - m.px, oy = y[i] - m.py, oz = z[i] - m.pz;
+              const float length = std::sqrt (ox * ox + oy * oy + oz * oz);
+              const float scale = length > 0.0f ? m.radius / length : 1.0f;
+              x[i] = m.px + ox * scale;
+              y[i] = m.py + oy * scale;
+              z[i] = m.pz + oz * scale;
+            }
+            break;
+        }
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      int model_type_;
+      ModelCoefficientsConstPtr model_;
+      bool copy_all_data_;
+      unsigned int threads_;
+  };
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include <pcl/sample_consensus/method_types.h>
 #include <pcl/sample_consensus/model_types.h>
 #include <pcl/segmentation/sac_segmentation.h>
+#include "indexed_view.h"
 
 typedef pcl::PointXYZ PointT;
 
@@ -20,15 +21,12 @@ main (int argc, char** argv)
   pcl::SACSegmentationFromNormals<PointT, pcl::Normal> seg; 
   pcl::PCDWriter writer;
   pcl::ExtractIndices<PointT> extract;
-  pcl::ExtractIndices<pcl::Normal> extract_normals;
   pcl::search::KdTree<PointT>::Ptr tree (new pcl::search::KdTree<PointT> ());
 
   // Datasets
   pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
   pcl::PointCloud<PointT>::Ptr cloud_filtered (new pcl::PointCloud<PointT>);
   pcl::PointCloud<pcl::Normal>::Ptr cloud_normals (new pcl::PointCloud<pcl::Normal>);
-  pcl::PointCloud<PointT>::Ptr cloud_filtered2 (new pcl::PointCloud<PointT>);
-  pcl::PointCloud<pcl::Normal>::Ptr cloud_normals2 (new pcl::PointCloud<pcl::Normal>);
   pcl::ModelCoefficients::Ptr coefficients_plane (new pcl::ModelCoefficients), coefficients_cylinder (new pcl::ModelCoefficients);
   pcl::PointIndices::Ptr inliers_plane (new pcl::PointIndices), inliers_cylinder (new pcl::PointIndices);
 
@@ -73,13 +71,10 @@ main (int argc, char** argv)
   std::cerr << "PointCloud representing the planar component: " << cloud_plane->points.size () << " data points." << std::endl;
   writer.write ("table_scene_mug_stereo_textured_plane.pcd", *cloud_plane, false);
 
-  // Remove the planar inliers, extract the rest
-  extract.setNegative (true);
-  extract.filter (*cloud_filtered2);
-  extract_normals.setNegative (true);
-  extract_normals.setInputCloud (cloud_normals);
-  extract_normals.setIndices (inliers_plane);
-  extract_normals.filter (*cloud_normals2);
+  // Remove the planar inliers: the rest is a view on cloud_filtered, and since the
+  // normals are indexed like cloud_filtered neither points nor normals are copied
+  pcl::IndexedView<PointT> remaining (cloud_filtered);
+  remaining.remove (inliers_plane->indices);
 
   // Create the segmentation object for cylinder segmentation and set all the parameters
   seg.setOptimizeCoefficients (true);
@@ -89,15 +84,15 @@ main (int argc, char** argv)
   seg.setMaxIterations (10000);
   seg.setDistanceThreshold (0.05);
   seg.setRadiusLimits (0, 0.1);
-  seg.setInputCloud (cloud_filtered2);
-  seg.setInputNormals (cloud_normals2);
+  remaining.setInputOf (seg);
+  seg.setInputNormals (cloud_normals);
 
   // Obtain the cylinder inliers and coefficients
   seg.segment (*inliers_cylinder, *coefficients_cylinder);
   std::cerr << "Cylinder coefficients: " << *coefficients_cylinder << std::endl;
 
-  // Write the cylinder inliers to disk
-  extract.setInputCloud (cloud_filtered2);
+  // Write the cylinder inliers to disk (indices into cloud_filtered)
+  extract.setInputCloud (cloud_filtered);
   extract.setIndices (inliers_cylinder);
   extract.setNegative (false);
   pcl::PointCloud<PointT>::Ptr cloud_cylinder (new pcl::PointCloud<PointT> ());
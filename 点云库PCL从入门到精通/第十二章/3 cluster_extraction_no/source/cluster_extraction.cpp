@@ -9,6 +9,7 @@
 #include <pcl/sample_consensus/model_types.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/segmentation/extract_clusters.h>
+#include "indexed_view.h"
 
 
 int 
@@ -16,7 +17,7 @@ main (int argc, char** argv)
 {
   // Read in the cloud data
   pcl::PCDReader reader;
-  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>), cloud_f (new pcl::PointCloud<pcl::PointXYZ>);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
   reader.read ("table_scene_lms400.pcd", *cloud);
   std::cout << "PointCloud before filtering has: " << cloud->points.size () << " data points." << std::endl; //*
 
@@ -32,7 +33,6 @@ main (int argc, char** argv)
   pcl::SACSegmentation<pcl::PointXYZ> seg;
   pcl::PointIndices::Ptr inliers (new pcl::PointIndices);
   pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients);
-  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_plane (new pcl::PointCloud<pcl::PointXYZ> ());
   pcl::PCDWriter writer;
   seg.setOptimizeCoefficients (true);
   seg.setModelType (pcl::SACMODEL_PLANE);
@@ -40,11 +40,13 @@ main (int argc, char** argv)
   seg.setMaxIterations (100);
   seg.setDistanceThreshold (0.02);
 
+  // The remaining points are a view on cloud_filtered: peeling planes copies no cloud
+  pcl::IndexedView<pcl::PointXYZ> remaining (cloud_filtered);
   int i=0, nr_points = (int) cloud_filtered->points.size ();
-  while (cloud_filtered->points.size () > 0.3 * nr_points)
+  while (remaining.size () > 0.3 * nr_points)
   {
-    // Segment the largest planar component from the remaining cloud
-    seg.setInputCloud (cloud_filtered);
+    // Segment the largest planar component from the remaining points
+    remaining.setInputOf (seg);
     seg.segment (*inliers, *coefficients);
     if (inliers->indices.size () == 0)
     {
@@ -52,25 +54,15 @@ main (int argc, char** argv)
       break;
     }
 
-    // Extract the planar inliers from the input cloud
-    pcl::ExtractIndices<pcl::PointXYZ> extract;
-    extract.setInputCloud (cloud_filtered);
-    extract.setIndices (inliers);
-    extract.setNegative (false);
+    // The inliers are indices into cloud_filtered
+    std::cout << "PointCloud representing the planar component: " << inliers->indices.size () << " data points." << std::endl;
 
-    // Write the planar inliers to disk
-    extract.filter (*cloud_plane);
-    std::cout << "PointCloud representing the planar component: " << cloud_plane->points.size () << " data points." << std::endl;
-
-    // Remove the planar inliers, extract the rest
-    extract.setNegative (true);
-    extract.filter (*cloud_f);
-    cloud_filtered = cloud_f;
+    // Remove the planar inliers from the view, in place
+    remaining.remove (inliers->indices);
   }
 
   // Creating the KdTree object for the search method of the extraction
   pcl::search::KdTree<pcl::PointXYZ>::Ptr tree (new pcl::search::KdTree<pcl::PointXYZ>);
-  tree->setInputCloud (cloud_filtered);
 
   std::vector<pcl::PointIndices> cluster_indices;
   pcl::EuclideanClusterExtraction<pcl::PointXYZ> ec;
@@ -78,7 +70,7 @@ main (int argc, char** argv)
   ec.setMinClusterSize (100);
   ec.setMaxClusterSize (25000);
   ec.setSearchMethod (tree);
-  ec.setInputCloud (cloud_filtered);
+  remaining.setInputOf (ec);
   ec.extract (cluster_indices);
 
   int j = 0;
@@ -0,0 +1,370 @@
+/*! \file condition_expressions.h
+*  Compile-time conditions for conditional removal: expression templates over fields with static offsets, evaluated block-wise in parallel.
+*/
+#ifndef CONDITION_EXPRESSIONS_H_
+#define CONDITION_EXPRESSIONS_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/point_traits.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/filters/conditional_removal.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "filter_chain.h"
+
+namespace pcl
+{
+  /** \brief A compile-time counterpart of ConditionAnd / ConditionOr / FieldComparison.
+    *
+    * \code
+    * using pcl::condition::field;
+    * pcl::condition::filter (*cloud, field<pcl::fields::z> () > 0.0f && field<pcl::fields::z> () < 0.8f, *filtered);
+    * \endcode
+    *
+    * ConditionalRemoval calls the virtual evaluate of every comparison for every
+    * point, and each FieldComparison reads its field through a by-name offset
+    * found at run time. Here the condition is an expression template: the field
+    * tags resolve to static offsets (pcl::traits), and the whole tree is one
+    * type known to the compiler. It is evaluated in blocks of kBlockSize points:
+    * every field used is first gathered into a double array (array of structures
+    * to structure of arrays), then each comparison and each &&, ||, ! is a plain
+    * loop over the block, which the compiler vectorizes. The blocks are split
+    * over OpenMP threads, so filtering is limited by memory bandwidth instead of
+    * call dispatch. Fields are read with pcl::chain::fieldData and the kept
+    * points are written by pcl::chain::compact, as in FilterChain.
+    *
+    * Values are compared in double, like FieldComparison compares the field
+    * with its double compare_val_, so both give the same points.
+    *
+    * The run-time API stays available: runtime (condition) wraps any existing
+    * ConditionBase (e.g. built from field names read at run time) and can be
+    * used alone or combined with static terms.
+    */
+  namespace condition
+  {
+    /** \brief Number of points evaluated together. */
+    const int kBlockSize = 256;
+
+    /** \brief Base of expressions with a double value per point (fields and constants). */
+    template <typename Derived> struct ValueExpression
+    {
+      inline const Derived& derived () const { return (static_cast<const Derived&> (*this)); }
+    };
+
+    /** \brief Base of expressions with a boolean value per point (comparisons and their combinations). */
+    template <typename Derived> struct BoolExpression
+    {
+      inline const Derived& derived () const { return (static_cast<const Derived&> (*this)); }
+    };
+
+    /** \brief Point j of a block: indices[first + j], or first + j without indices. */
+    template <typename PointT> inline const PointT&
+    blockPoint (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int j)
+    {
+      return (cloud.points[indices ? indices[first + j] : first + j]);
+    }
+
+    /** \brief The field FieldTag, read at its static offset and converted to double. */
+    template <typename FieldTag>
+    struct Field : public ValueExpression<Field<FieldTag> >
+    {
+      template <typename PointT> inline double
+      value (const PointT &p) const { return (static_cast<double> (chain::fieldData<FieldTag> (p))); }
+
+      template <typename PointT> inline void
+      load (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int n, double *out) const
+      {
+        if (indices)
+        {
+          for (int j = 0; j < n; ++j)
+            out[j] = value (cloud.points[indices[first + j]]);
+          return;
+        }
+        const PointT *points = &cloud.points[first];
+        for (int j = 0; j < n; ++j)
+          out[j] = value (points[j]);
+      }
+    };
+
+    struct Constant : public ValueExpression<Constant>
+    {
+      Constant (double value) : value_ (value) {}
+
+      template <typename PointT> inline double
+      value (const PointT &) const { return (value_); }
+
+      template <typename PointT> inline void
+      load (const pcl::PointCloud<PointT> &, const int *, int, int n, double *out) const
+      {
+        std::fill (out, out + n, value_);
+      }
+
+      double value_;
+    };
+
+    template <typename FieldTag> inline Field<FieldTag>
+    field () { return (Field<FieldTag> ()); }
+
+    // 比较运算符，对应 ComparisonOps 的 GT, GE, LT, LE, EQ（另加不等于）
+    struct GreaterOp      { static inline bool apply (double a, double b) { return (a > b); } };
+    struct GreaterEqualOp { static inline bool apply (double a, double b) { return (a >= b); } };
+    struct LessOp         { static inline bool apply (double a, double b) { return (a < b); } };
+    struct LessEqualOp    { static inline bool apply (double a, double b) { return (a <= b); } };
+    struct EqualOp        { static inline bool apply (double a, double b) { return (a == b); } };
+    struct NotEqualOp     { static inline bool apply (double a, double b) { return (a != b); } };
+
+    template <typename L, typename R, typename Op>
+    struct Compare : public BoolExpression<Compare<L, R, Op> >
+    {
+      Compare (const L &l, const R &r) : l_ (l), r_ (r) {}
+
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const { return (Op::apply (l_.value (p), r_.value (p))); }
+
+      template <typename PointT> inline void
+      evaluate (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int n, unsigned char *mask) const
+      {
+        double a[kBlockSize], b[kBlockSize];
+        l_.load (cloud, indices, first, n, a);
+        r_.load (cloud, indices, first, n, b);
+        for (int j = 0; j < n; ++j)
+          mask[j] = Op::apply (a[j], b[j]);
+      }
+
+      L l_;
+      R r_;
+    };
+
+    template <typename A, typename B>
+    struct And : public BoolExpression<And<A, B> >
+    {
+      And (const A &a, const B &b) : a_ (a), b_ (b) {}
+
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const { return (a_ (p) && b_ (p)); }
+
+      template <typename PointT> inline void
+      evaluate (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int n, unsigned char *mask) const
+      {
+        unsigned char other[kBlockSize];
+        a_.evaluate (cloud, indices, first, n, mask);
+        b_.evaluate (cloud, indices, first, n, other);
+        for (int j = 0; j < n; ++j)
+          mask[j] &= other[j];
+      }
+
+      A a_;
+      B b_;
+    };
+
+    template <typename A, typename B>
+    struct Or : public BoolExpression<Or<A, B> >
+    {
+      Or (const A &a, const B &b) : a_ (a), b_ (b) {}
+
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const { return (a_ (p) || b_ (p)); }
+
+      template <typename PointT> inline void
+      evaluate (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int n, unsigned char *mask) const
+      {
+        unsigned char other[kBlockSize];
+        a_.evaluate (cloud, indices, first, n, mask);
+        b_.evaluate (cloud, indices, first, n, other);
+        for (int j = 0; j < n; ++j)
+          mask[j] |= other[j];
+      }
+
+      A a_;
+      B b_;
+    };
+
+    template <typename A>
+    struct Not : public BoolExpression<Not<A> >
+    {
+      Not (const A &a) : a_ (a) {}
+
+      template <typename PointT> inline bool
+      operator() (const PointT &p) const { return (!a_ (p)); }
+
+      template <typename PointT> inline void
+      evaluate (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int n, unsigned char *mask) const
+      {
+        a_.evaluate (cloud, indices, first, n, mask);
+        for (int j = 0; j < n; ++j)
+          mask[j] ^= 1;
+      }
+
+      A a_;
+    };
+
+    /** \brief Fallback to the run-time API: evaluates a ConditionBase (ConditionAnd,
+      * ConditionOr, FieldComparison by name, ...) point by point.
+      */
+    template <typename PointT>
+    struct Runtime : public BoolExpression<Runtime<PointT> >
+    {
+      Runtime (const typename pcl::ConditionBase<PointT>::ConstPtr &condition) : condition_ (condition) {}
+
+      inline bool
+      operator() (const PointT &p) const { return (condition_->evaluate (p)); }
+
+      inline void
+      evaluate (const pcl::PointCloud<PointT> &cloud, const int *indices, int first, int n, unsigned char *mask) const
+      {
+        for (int j = 0; j < n; ++j)
+          mask[j] = condition_->evaluate (blockPoint (cloud, indices, first, j));
+      }
+
+      typename pcl::ConditionBase<PointT>::ConstPtr condition_;
+    };
+
+    template <typename PointT> inline Runtime<PointT>
+    runtime (const typename pcl::ConditionBase<PointT>::ConstPtr &condition) { return (Runtime<PointT> (condition)); }
+
+#define PCL_CONDITION_COMPARISON(op, Op)                                                   \
+    template <typename L, typename R> inline Compare<L, R, Op>                             \
+    operator op (const ValueExpression<L> &l, const ValueExpression<R> &r)                 \
+    { return (Compare<L, R, Op> (l.derived (), r.derived ())); }                           \
+    template <typename L> inline Compare<L, Constant, Op>                                  \
+    operator op (const ValueExpression<L> &l, double r)                                    \
+    { return (Compare<L, Constant, Op> (l.derived (), Constant (r))); }                    \
+    template <typename R> inline Compare<Constant, R, Op>                                  \
+    operator op (double l, const ValueExpression<R> &r)                                    \
+    { return (Compare<Constant, R, Op> (Constant (l), r.derived ())); }
+
+    PCL_CONDITION_COMPARISON (>, GreaterOp)
+    PCL_CONDITION_COMPARISON (>=, GreaterEqualOp)
+    PCL_CONDITION_COMPARISON (<, LessOp)
+    PCL_CONDITION_COMPARISON (<=, LessEqualOp)
+    PCL_CONDITION_COMPARISON (==, EqualOp)
+    PCL_CONDITION_COMPARISON (!=, NotEqualOp)
+#undef PCL_CONDITION_COMPARISON
+
+    // && 和 || 按块计算两边再合并，不短路，换来无分支的循环
+    template <typename A, typename B> inline And<A, B>
+    operator&& (const BoolExpression<A> &a, const BoolExpression<B> &b) { return (And<A, B> (a.derived (), b.derived ())); }
+
+    template <typename A, typename B> inline Or<A, B>
+    operator|| (const BoolExpression<A> &a, const BoolExpression<B> &b) { return (Or<A, B> (a.derived (), b.derived ())); }
+
+    template <typename A> inline Not<A>
+    operator! (const BoolExpression<A> &a) { return (Not<A> (a.derived ())); }
+
+    inline int
+    getThreads (int threads)
+    {
+#ifdef _OPENMP
+      return (threads > 0 ? threads : omp_get_max_threads ());
+#else
+      return (1);
+#endif
+    }
+
+    /** \brief Keep mask of the points (non-finite points are never kept, as in
+      * ConditionalRemoval) and the output offset of every thread.
+      */
+    template <typename PointT, typename Condition> void
+    evaluate (const pcl::PointCloud<PointT> &cloud, const std::vector<int> *indices, const Condition &condition,
+              int threads, std::vector<unsigned char> &keep, std::vector<int> &offsets)
+    {
+      const int n = static_cast<int> (indices ? indices->size () : cloud.points.size ());
+      const int *ids = indices && !indices->empty () ? &(*indices)[0] : NULL;
+      keep.resize (n);
+      offsets.assign (threads + 1, 0);
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+      for (int t = 0; t < threads; ++t)
+      {
+        // 各线程的范围按整块对齐
+        int count = 0;
+        const int last = chain::chunkBegin (n, threads, t + 1, kBlockSize);
+        for (int first = chain::chunkBegin (n, threads, t, kBlockSize); first < last; first += kBlockSize)
+        {
+          const int size = std::min (kBlockSize, last - first);
+          unsigned char *mask = &keep[first];
+          condition.evaluate (cloud, ids, first, size, mask);
+          for (int j = 0; j < size; ++j)
+          {
+            const PointT &p = blockPoint (cloud, ids, first, j);
+            mask[j] &= pcl_isfinite (p.x) && pcl_isfinite (p.y) && pcl_isfinite (p.z);
+            count += mask[j];
+          }
+        }
+        offsets[t + 1] = count;
+      }
+      for (int t = 0; t < threads; ++t)
+        offsets[t + 1] += offsets[t];
+    }
+
+    /** \brief Indices of the points that satisfy the condition, in input order.
+      * \param[in] cloud the input cloud
+      * \param[in] condition an expression built from field<Tag> (), comparisons, &&, ||, ! and runtime ()
+      * \param[out] indices the kept points
+      * \param[in] threads number of OpenMP threads, 0 = one per core
+      * \param[in] input_indices only consider these points (all if NULL)
+      */
+    template <typename PointT, typename Condition> void
+    filterIndices (const pcl::PointCloud<PointT> &cloud, const BoolExpression<Condition> &condition,
+                   std::vector<int> &indices, int threads = 0, const std::vector<int> *input_indices = NULL)
+    {
+      threads = getThreads (threads);
+      std::vector<unsigned char> keep;
+      std::vector<int> offsets;
+      evaluate (cloud, input_indices, condition.derived (), threads, keep, offsets);
+      indices.resize (offsets[threads]);
+      if (input_indices)
+        chain::compact (keep, offsets, threads, kBlockSize, chain::gather (*input_indices), indices);
+      else
+        chain::compact (keep, offsets, threads, kBlockSize, chain::Position (), indices);
+    }
+
+    /** \brief ConditionalRemoval with a static condition.
+      * \param[in] cloud the input cloud
+      * \param[in] condition the condition the kept points satisfy
+      * \param[out] output the kept points, or with keep_organized a copy of the
+      *             cloud in which the other points have NaN coordinates
+      * \param[in] keep_organized as ConditionalRemoval::setKeepOrganized
+      * \param[in] threads number of OpenMP threads, 0 = one per core
+      */
+    template <typename PointT, typename Condition> void
+    filter (const pcl::PointCloud<PointT> &cloud, const BoolExpression<Condition> &condition,
+            pcl::PointCloud<PointT> &output, bool keep_organized = false, int threads = 0)
+    {
+      threads = getThreads (threads);
+      std::vector<unsigned char> keep;
+      std::vector<int> offsets;
+      evaluate (cloud, static_cast<const std::vector<int>*> (NULL), condition.derived (), threads, keep, offsets);
+      const int n = static_cast<int> (keep.size ());
+      if (keep_organized)
+      {
+        if (&output != &cloud)
+          output = cloud;
+        const float nan = std::numeric_limits<float>::quiet_NaN ();
+#pragma omp parallel for num_threads(threads)
+        for (int i = 0; i < n; ++i)
+          if (!keep[i])
+            output.points[i].x = output.points[i].y = output.points[i].z = nan;
+        output.is_dense = offsets[threads] == n;
+        return;
+      }
+      // 输出可以就是输入：先写到临时点云再交换
+      pcl::PointCloud<PointT> result;
+      result.header = cloud.header;
+      result.sensor_origin_ = cloud.sensor_origin_;
+      result.sensor_orientation_ = cloud.sensor_orientation_;
+      result.points.resize (offsets[threads]);
+      result.width = static_cast<uint32_t> (offsets[threads]);
+      result.height = 1;
+      result.is_dense = true;
+      chain::compact (keep, offsets, threads, kBlockSize, chain::gather (cloud.points), result.points);
+      output.swap (result);
+    }
+  }
+}
+
+#endif
@@ -14,6 +14,7 @@
 #include <pcl/search/kdtree.h>
 #include <pcl/features/normal_3d_omp.h>
 #include <pcl/filters/conditional_removal.h>
+#include "condition_expressions.h"
 #include <pcl/segmentation/extract_clusters.h>
 #include <pcl/segmentation/impl/extract_clusters.hpp>
 
@@ -250,21 +251,14 @@ main (int argc, char *argv[])
   // Filter by magnitude
   cout << "Filtering out DoN mag <= " << threshold << "..." << endl;
 
-  // Build the condition for filtering
-  pcl::ConditionOr<PointNormal>::Ptr range_cond (
-    new pcl::ConditionOr<PointNormal> ()
-    );
-  range_cond->addComparison (pcl::FieldComparison<PointNormal>::ConstPtr (
-                               new pcl::FieldComparison<PointNormal> ("curvature", pcl::ComparisonOps::GT, threshold))
-                             );
-  // Build the filter
-  pcl::ConditionalRemoval<PointNormal> condrem (range_cond);
-  condrem.setInputCloud (doncloud);
-
+  // Build the condition for filtering: curvature > threshold as a compile-time
+  // expression (static field offset, evaluated block-wise on all cores) instead of
+  // ConditionOr + FieldComparison ("curvature", GT, threshold)
+  using pcl::condition::field;
   pcl::PointCloud<PointNormal>::Ptr doncloud_filtered (new pcl::PointCloud<PointNormal>);
 
   // Apply filter
-  condrem.filter (*doncloud_filtered);
+  pcl::condition::filter (*doncloud, field<pcl::fields::curvature> () > threshold, *doncloud_filtered);
 
   doncloud = doncloud_filtered;
 
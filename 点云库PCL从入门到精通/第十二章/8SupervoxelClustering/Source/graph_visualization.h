@@ -0,0 +1,139 @@
+/*! \file graph_visualization.h
+*  Batched drawing of large graphs (e.g. supervoxel adjacency) in PCLVisualizer: one actor for all edges, one for all nodes.
+*/
+#ifndef GRAPH_VISUALIZATION_H_
+#define GRAPH_VISUALIZATION_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/segmentation/supervoxel_clustering.h>
+#include <pcl/visualization/pcl_visualizer.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+  namespace visualization
+  {
+    /** \brief Add a graph to the viewer as two shapes, "<id>_edges" and "<id>_nodes".
+      *
+      * addLine/addSphere create one actor per edge or node, which is what makes
+      * drawing tens of thousands of them take minutes. Here the node positions are
+      * stored once in a vtkPoints shared by two polydata: one with a single line
+      * cell array holding every edge, one with a single poly-vertex cell over all
+      * nodes. Use setShapeRenderingProperties on the two ids for color, line width
+      * and point size.
+      * \param[in] viewer the viewer
+      * \param[in] nodes node positions
+      * \param[in] edges pairs of indices into nodes
+      * \param[in] id prefix of the two shape ids
+      * \param[in] viewport the viewport to add the shapes to
+      * \return false if the ids are already in use
+      */
+    template <typename PointT> bool
+    addGraphToViewer (PCLVisualizer &viewer, const pcl::PointCloud<PointT> &nodes,
+                      const std::vector<std::pair<int, int> > &edges,
+                      const std::string &id = "graph", int viewport = 0)
+    {
+      const vtkIdType n = static_cast<vtkIdType> (nodes.points.size ());
+      vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New ();
+      points->SetDataTypeToFloat ();
+      points->SetNumberOfPoints (n);
+      float *xyz = static_cast<float*> (points->GetData ()->GetVoidPointer (0));
+      for (vtkIdType i = 0; i < n; ++i)
+      {
+        xyz[3 * i + 0] = nodes.points[i].x;
+        xyz[3 * i + 1] = nodes.points[i].y;
+        xyz[3 * i + 2] = nodes.points[i].z;
+      }
+
+      // 连接数组按 VTK 的格式直接写入：每条边 [2, a, b]
+      vtkSmartPointer<vtkIdTypeArray> line_ids = vtkSmartPointer<vtkIdTypeArray>::New ();
+      line_ids->SetNumberOfValues (3 * static_cast<vtkIdType> (edges.size ()));
+      vtkIdType *line = line_ids->GetPointer (0);
+      vtkIdType lines_count = 0;
+      for (size_t e = 0; e < edges.size (); ++e)
+      {
+        if (edges[e].first < 0 || edges[e].first >= n || edges[e].second < 0 || edges[e].second >= n)
+          continue;
+        *line++ = 2;
+        *line++ = edges[e].first;
+        *line++ = edges[e].second;
+        ++lines_count;
+      }
+      line_ids->SetNumberOfValues (3 * lines_count);
+      vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New ();
+      lines->SetCells (lines_count, line_ids);
+
+      vtkSmartPointer<vtkIdTypeArray> vert_ids = vtkSmartPointer<vtkIdTypeArray>::New ();
+      vert_ids->SetNumberOfValues (n + 1);
+      vtkIdType *vert = vert_ids->GetPointer (0);
+      vert[0] = n;
+      for (vtkIdType i = 0; i < n; ++i)
+        vert[i + 1] = i;
+      vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New ();
+      verts->SetCells (n > 0 ? 1 : 0, vert_ids);
+
+      vtkSmartPointer<vtkPolyData> edges_data = vtkSmartPointer<vtkPolyData>::New ();
+      edges_data->SetPoints (points);
+      edges_data->SetLines (lines);
+      vtkSmartPointer<vtkPolyData> nodes_data = vtkSmartPointer<vtkPolyData>::New ();
+      nodes_data->SetPoints (points);
+      nodes_data->SetVerts (verts);
+
+      return (viewer.addModelFromPolyData (edges_data, id + "_edges", viewport) &&
+              viewer.addModelFromPolyData (nodes_data, id + "_nodes", viewport));
+    }
+
+    /** \brief Add the supervoxel adjacency graph (as returned by
+      * SupervoxelClustering::getSupervoxelAdjacency) with addGraphToViewer.
+      * Every supervoxel centroid is a node; every adjacent pair is drawn once,
+      * although the adjacency map holds it in both directions.
+      * Call with an explicit point type: addSupervoxelGraphToViewer<PointT> (...).
+      */
+    template <typename PointT> bool
+    addSupervoxelGraphToViewer (PCLVisualizer &viewer,
+                                const std::map<uint32_t, typename pcl::Supervoxel<PointT>::Ptr> &supervoxels,
+                                const std::multimap<uint32_t, uint32_t> &adjacency,
+                                const std::string &id = "supervoxel_graph", int viewport = 0)
+    {
+      pcl::PointCloud<pcl::PointXYZ> nodes;
+      nodes.points.reserve (supervoxels.size ());
+      std::map<uint32_t, int> node_index;
+      typename std::map<uint32_t, typename pcl::Supervoxel<PointT>::Ptr>::const_iterator sv_itr = supervoxels.begin ();
+      for ( ; sv_itr != supervoxels.end (); ++sv_itr)
+      {
+        node_index[sv_itr->first] = static_cast<int> (nodes.points.size ());
+        const PointT &c = sv_itr->second->centroid_;
+        nodes.points.push_back (pcl::PointXYZ (c.x, c.y, c.z));
+      }
+      nodes.width = static_cast<uint32_t> (nodes.points.size ());
+      nodes.height = 1;
+
+      std::vector<std::pair<int, int> > edges;
+      edges.reserve (adjacency.size ());
+      std::multimap<uint32_t, uint32_t>::const_iterator adj_itr = adjacency.begin ();
+      for ( ; adj_itr != adjacency.end (); ++adj_itr)
+      {
+        std::map<uint32_t, int>::const_iterator a = node_index.find (adj_itr->first);
+        std::map<uint32_t, int>::const_iterator b = node_index.find (adj_itr->second);
+        if (a != node_index.end () && b != node_index.end () && a->second != b->second)
+          edges.push_back (std::make_pair (std::min (a->second, b->second), std::max (a->second, b->second)));
+      }
+      // 每对相邻超体素只画一次
+      std::sort (edges.begin (), edges.end ());
+      edges.erase (std::unique (edges.begin (), edges.end ()), edges.end ());
+      return (addGraphToViewer (viewer, nodes, edges, id, viewport));
+    }
+  }
+}
+
+#endif
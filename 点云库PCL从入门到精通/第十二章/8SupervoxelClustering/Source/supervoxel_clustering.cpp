@@ -1,9 +1,11 @@
 #include <pcl/console/parse.h>
+#include <pcl/console/time.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/segmentation/supervoxel_clustering.h>
+#include "graph_visualization.h"
 
 // Types
 typedef pcl::PointXYZRGBA PointT;
@@ -28,7 +30,8 @@ int
 			"--NT Dsables the single cloud transform \n"
 			"-v <voxel resolution>\n-s <seed resolution>\n"
 			"-c <color weight> \n-z <spatial weight> \n"
-			"-n <normal_weight>\n", argv[0]);
+			"-n <normal_weight>\n"
+			"--per_edge draws the adjacency with one shape per edge (slow, for comparison)\n", argv[0]);
 		return (1);
 	}
 
@@ -43,6 +46,7 @@ int
 	cout<<"point size of input: "<<cloud->size()<<endl;
 
 	bool disable_transform = pcl::console::find_switch (argc, argv, "--NT");
+	bool per_edge_shapes = pcl::console::find_switch (argc, argv, "--per_edge");
 
 	float voxel_resolution = 0.008f;
 	bool voxel_res_specified = pcl::console::find_switch (argc, argv, "-v");
@@ -118,32 +122,50 @@ int
 	super.getSupervoxelAdjacency (supervoxel_adjacency);
 	cout<<"size of supervoxel_adjacency: "<<supervoxel_adjacency.size()<<endl;
 
-	//ӳڽͼ
-	std::multimap<uint32_t,uint32_t>::iterator label_itr = supervoxel_adjacency.begin ();
-	for ( ; label_itr != supervoxel_adjacency.end (); )
+	pcl::console::TicToc tt;
+	tt.tic ();
+	if (per_edge_shapes)
 	{
-		//ȡǩֵ
-		uint32_t supervoxel_label = label_itr->first;
-		//ݱǩó
-		pcl::Supervoxel<PointT>::Ptr supervoxel = supervoxel_clusters.at (supervoxel_label);
-
-		//óڳزڳΪ㼯ƣںӻڳڶӳоͬļֵ
-		PointCloudT adjacent_supervoxel_centers;
-		std::multimap<uint32_t,uint32_t>::iterator adjacent_itr = supervoxel_adjacency.equal_range (supervoxel_label).first;
-		for ( ; adjacent_itr!=supervoxel_adjacency.equal_range (supervoxel_label).second; ++adjacent_itr)
+		//ӳڽͼ
+		std::multimap<uint32_t,uint32_t>::iterator label_itr = supervoxel_adjacency.begin ();
+		for ( ; label_itr != supervoxel_adjacency.end (); )
 		{
-			pcl::Supervoxel<PointT>::Ptr neighbor_supervoxel = supervoxel_clusters.at (adjacent_itr->second);
-			adjacent_supervoxel_centers.push_back (neighbor_supervoxel->centroid_);
+			//ȡǩֵ
+			uint32_t supervoxel_label = label_itr->first;
+			//ݱǩó
+			pcl::Supervoxel<PointT>::Ptr supervoxel = supervoxel_clusters.at (supervoxel_label);
+
+			//óڳزڳΪ㼯ƣںӻڳڶӳоͬļֵ
+			PointCloudT adjacent_supervoxel_centers;
+			std::multimap<uint32_t,uint32_t>::iterator adjacent_itr = supervoxel_adjacency.equal_range (supervoxel_label).first;
+			for ( ; adjacent_itr!=supervoxel_adjacency.equal_range (supervoxel_label).second; ++adjacent_itr)
+			{
+				pcl::Supervoxel<PointT>::Ptr neighbor_supervoxel = supervoxel_clusters.at (adjacent_itr->second);
+				adjacent_supervoxel_centers.push_back (neighbor_supervoxel->centroid_);
+			}
+			//
+			std::stringstream ss;
+			ss << "supervoxel_" << supervoxel_label;
+			//cout<<ss.str()<<endl;
+			//Ƹóڳͼ
+			addSupervoxelConnectionsToViewer (supervoxel->centroid_, adjacent_supervoxel_centers, ss.str (), viewer);
+			//ʹָһǩ
+			label_itr = supervoxel_adjacency.upper_bound (supervoxel_label);
 		}
-		//
-		std::stringstream ss;
-		ss << "supervoxel_" << supervoxel_label;
-		//cout<<ss.str()<<endl;
-		//Ƹóڳͼ
-		addSupervoxelConnectionsToViewer (supervoxel->centroid_, adjacent_supervoxel_centers, ss.str (), viewer);
-		//ʹָһǩ
-		label_itr = supervoxel_adjacency.upper_bound (supervoxel_label);
 	}
+	else
+	{
+		//б߷һгķһֻactor
+		pcl::visualization::addSupervoxelGraphToViewer<PointT> (*viewer, supervoxel_clusters, supervoxel_adjacency, "supervoxel_graph");
+		viewer->setShapeRenderingProperties (pcl::visualization::PCL_VISUALIZER_LINE_WIDTH, 3, "supervoxel_graph_edges");
+		viewer->setShapeRenderingProperties (pcl::visualization::PCL_VISUALIZER_COLOR, 0, 1, 0, "supervoxel_graph_edges");
+		viewer->setShapeRenderingProperties (pcl::visualization::PCL_VISUALIZER_POINT_SIZE, 8, "supervoxel_graph_nodes");
+		viewer->setShapeRenderingProperties (pcl::visualization::PCL_VISUALIZER_COLOR, 0, 0, 1, "supervoxel_graph_nodes");
+	}
+	cout<<"adjacency graph added in "<<tt.toc()<<" ms"<<endl;
+	tt.tic ();
+	viewer->spinOnce();
+	cout<<"first frame: "<<tt.toc()<<" ms"<<endl;
 
 	while (!viewer->wasStopped ())
 	{
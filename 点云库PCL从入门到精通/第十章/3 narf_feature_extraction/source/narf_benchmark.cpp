@@ -0,0 +1,196 @@
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/features/narf_descriptor.h>
+#include <pcl/features/range_image_border_extractor.h>
+#include <pcl/keypoints/narf_keypoint.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "parallel_narf.h"
+
+typedef pcl::PointXYZ PointType;
+using namespace pcl::console;
+
+/** \brief A wall 3 m in front of the sensor with three boxes standing before it, 5 mm grid. */
+static void
+makeScene (pcl::PointCloud<PointType> &cloud)
+{
+  const float boxes[3][3] = { { -0.6f, 0.1f, 2.2f }, { 0.0f, -0.2f, 1.8f }, { 0.5f, 0.2f, 2.5f } };
+  for (float x = -1.0f; x <= 1.0f; x += 0.005f)
+    for (float y = -0.75f; y <= 0.75f; y += 0.005f)
+    {
+      PointType point;
+      point.x = x;
+      point.y = y;
+      point.z = 3.0f;
+      for (int b = 0; b < 3; ++b)
+        if (std::fabs (x - boxes[b][0]) < 0.2f && std::fabs (y - boxes[b][1]) < 0.3f)
+          point.z = std::min (point.z, boxes[b][2]);
+      cloud.points.push_back (point);
+    }
+  cloud.width = static_cast<uint32_t> (cloud.points.size ());
+  cloud.height = 1;
+}
+
+static bool
+sameDescriptors (const pcl::PointCloud<pcl::Narf36> &a, const pcl::PointCloud<pcl::Narf36> &b)
+{
+  if (a.points.size () != b.points.size ())
+    return (false);
+  for (size_t i = 0; i < a.points.size (); ++i)
+  {
+    const pcl::Narf36 &p = a.points[i], &q = b.points[i];
+    if (p.x != q.x || p.y != q.y || p.z != q.z || p.roll != q.roll || p.pitch != q.pitch || p.yaw != q.yaw
+        || std::memcmp (p.descriptor, q.descriptor, sizeof (p.descriptor)) != 0)
+      return (false);
+  }
+  return (true);
+}
+
+int
+main (int argc, char** argv)
+{
+  float angular_resolution = 0.5f, support_size = 0.2f;
+  bool rotation_invariant = true;
+#ifdef _OPENMP
+  int max_threads = omp_get_max_threads ();
+#else
+  int max_threads = 1;
+#endif
+  int runs = 5;
+  parse_argument (argc, argv, "-r", angular_resolution);
+  parse_argument (argc, argv, "-s", support_size);
+  parse_argument (argc, argv, "-o", rotation_invariant);
+  parse_argument (argc, argv, "-t", max_threads);
+  parse_argument (argc, argv, "-runs", runs);
+  bool skip_pcl = find_switch (argc, argv, "-skip");
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [scene.pcd, e.g. frame_00000.pcd of chapter 8] [-r angular resolution in degrees (default 0.5)]"
+              << " [-s support size (default 0.2)] [-o 0/1 rotation invariant (default 1)] [-t max threads]"
+              << " [-runs runs (default 5)] [-skip (no serial NarfKeypoint/NarfDescriptor)]\n";
+    return (0);
+  }
+  if (max_threads < 1 || runs < 1)
+  {
+    std::cerr << "Need at least one thread and one run." << std::endl;
+    return (-1);
+  }
+
+  // 读入 pcd 文件，没有给出时生成一个场景
+  pcl::PointCloud<PointType> point_cloud;
+  Eigen::Affine3f scene_sensor_pose (Eigen::Affine3f::Identity ());
+  bool set_unseen_to_max_range = false;
+  std::vector<int> pcd_filename_indices = parse_file_extension_argument (argc, argv, "pcd");
+  if (!pcd_filename_indices.empty ())
+  {
+    const std::string filename = argv[pcd_filename_indices[0]];
+    if (pcl::io::loadPCDFile (filename, point_cloud) == -1)
+    {
+      std::cerr << "Was not able to open file \"" << filename << "\"." << std::endl;
+      return (-1);
+    }
+    scene_sensor_pose = Eigen::Affine3f (Eigen::Translation3f (point_cloud.sensor_origin_[0],
+                                                               point_cloud.sensor_origin_[1],
+                                                               point_cloud.sensor_origin_[2])) *
+                        Eigen::Affine3f (point_cloud.sensor_orientation_);
+  }
+  else
+  {
+    makeScene (point_cloud);
+    set_unseen_to_max_range = true;
+  }
+
+  pcl::RangeImage range_image;
+  range_image.createFromPointCloud (point_cloud, pcl::deg2rad (angular_resolution), pcl::deg2rad (360.0f), pcl::deg2rad (180.0f),
+                                    scene_sensor_pose, pcl::RangeImage::CAMERA_FRAME, 0.0f, 0.0f, 1);
+  if (set_unseen_to_max_range)
+    range_image.setUnseenToMaxRange ();
+  std::cerr << point_cloud.points.size () << " points, " << range_image.width << "x" << range_image.height
+            << " range image, " << runs << " runs" << std::endl;
+
+  TicToc tt;
+  pcl::PointCloud<int> keypoint_indices, keypoint_indices_pcl;
+  pcl::PointCloud<pcl::Narf36> descriptors, descriptors_pcl;
+  if (!skip_pcl)
+  {
+    pcl::RangeImageBorderExtractor border_extractor;
+    pcl::NarfKeypoint keypoint_detector (&border_extractor);
+    keypoint_detector.getParameters ().support_size = support_size;
+    tt.tic ();
+    for (int r = 0; r < runs; ++r)
+    {
+      keypoint_detector.setRangeImage (&range_image);
+      keypoint_detector.compute (keypoint_indices);
+    }
+    const double keypoint_ms = tt.toc ();
+    std::vector<int> indices (keypoint_indices.points.begin (), keypoint_indices.points.end ());
+    pcl::NarfDescriptor descriptor (&range_image, &indices);
+    descriptor.getParameters ().support_size = support_size;
+    descriptor.getParameters ().rotation_invariant = rotation_invariant;
+    tt.tic ();
+    for (int r = 0; r < runs; ++r)
+      descriptor.compute (descriptors);
+    const double descriptor_ms = tt.toc ();
+    std::cerr << "NarfKeypoint + NarfDescriptor:  " << keypoint_indices.points.size () * runs * 1000.0 / keypoint_ms
+              << " keypoints/s, " << descriptors.points.size () * runs * 1000.0 / descriptor_ms << " descriptors/s ("
+              << keypoint_indices.points.size () << " keypoints, " << descriptors.points.size () << " descriptors)" << std::endl;
+    keypoint_indices_pcl = keypoint_indices;
+    descriptors_pcl = descriptors;
+  }
+
+  // 每个线程数的结果都应与单线程的相同，包括顺序；单线程的又应与 NarfKeypoint/NarfDescriptor 的相同
+  pcl::PointCloud<int> keypoint_indices_1;
+  pcl::PointCloud<pcl::Narf36> descriptors_1;
+  for (int threads = 1; threads <= max_threads; ++threads)
+  {
+    pcl::ParallelRangeImageBorderExtractor border_extractor;
+    pcl::ParallelNarfKeypoint keypoint_detector (&border_extractor);
+    keypoint_detector.setNumberOfThreads (threads);
+    keypoint_detector.getParameters ().support_size = support_size;
+    tt.tic ();
+    for (int r = 0; r < runs; ++r)
+    {
+      keypoint_detector.setRangeImage (&range_image);
+      keypoint_detector.compute (keypoint_indices);
+    }
+    const double keypoint_ms = tt.toc ();
+    std::vector<int> indices (keypoint_indices.points.begin (), keypoint_indices.points.end ());
+    pcl::ParallelNarfDescriptor descriptor (&range_image, &indices);
+    descriptor.setNumberOfThreads (threads);
+    descriptor.getParameters ().support_size = support_size;
+    descriptor.getParameters ().rotation_invariant = rotation_invariant;
+    tt.tic ();
+    for (int r = 0; r < runs; ++r)
+      descriptor.compute (descriptors);
+    const double descriptor_ms = tt.toc ();
+    std::cerr << threads << (threads == 1 ? " thread:  " : " threads: ") << keypoint_indices.points.size () * runs * 1000.0 / keypoint_ms
+              << " keypoints/s, " << descriptors.points.size () * runs * 1000.0 / descriptor_ms << " descriptors/s" << std::endl;
+
+    if (threads == 1)
+    {
+      keypoint_indices_1 = keypoint_indices;
+      descriptors_1 = descriptors;
+      if (!skip_pcl && (keypoint_indices.points != keypoint_indices_pcl.points || !sameDescriptors (descriptors, descriptors_pcl)))
+      {
+        std::cerr << "1 thread gives other keypoints or descriptors than NarfKeypoint/NarfDescriptor!" << std::endl;
+        return (-1);
+      }
+    }
+    else if (keypoint_indices.points != keypoint_indices_1.points || !sameDescriptors (descriptors, descriptors_1))
+    {
+      std::cerr << threads << " threads give other keypoints or descriptors than 1 thread!" << std::endl;
+      return (-1);
+    }
+  }
+  return (0);
+}
@@ -9,6 +9,7 @@
 #include <pcl/visualization/range_image_visualizer.h>
 #include <boost/thread/thread.hpp>
 #include <iostream>
+#include "parallel_narf.h"
 
 typedef pcl::PointXYZ PointType;
 // -----参数-----
@@ -158,8 +159,8 @@ int main(int argc, char** argv) {
   pcl::visualization::RangeImageVisualizer range_image_widget("Range image");
   range_image_widget.showRangeImage(range_image);
   // -----提取 NARF 关键点-----
-  pcl::RangeImageBorderExtractor range_image_border_extractor;
-  pcl::NarfKeypoint narf_keypoint_detector;
+  pcl::ParallelRangeImageBorderExtractor range_image_border_extractor;
+  pcl::ParallelNarfKeypoint narf_keypoint_detector;
   narf_keypoint_detector.setRangeImageBorderExtractor(
       &range_image_border_extractor);
   narf_keypoint_detector.setRangeImage(&range_image);
@@ -192,7 +193,8 @@ int main(int argc, char** argv) {
   for (unsigned int i = 0; i < keypoint_indices.size(); ++i)
     //要得到正确的向量类型，这一步是必要的
     keypoint_indices2[i] = keypoint_indices.points[i];
-  pcl::NarfDescriptor narf_descriptor(&range_image, &keypoint_indices2);
+  // 各个关键点的描述子并行计算，顺序与关键点的相同
+  pcl::ParallelNarfDescriptor narf_descriptor(&range_image, &keypoint_indices2);
   narf_descriptor.getParameters().support_size = support_size;
   narf_descriptor.getParameters().rotation_invariant = rotation_invariant;
   pcl::PointCloud<pcl::Narf36> narf_descriptors;
@@ -0,0 +1,162 @@
+/*! \file parallel_narf.h
+*  NarfKeypoint and NarfDescriptor on several threads, with the same output and order as on one.
+*/
+#ifndef PARALLEL_NARF_H_
+#define PARALLEL_NARF_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/features/narf.h>
+#include <pcl/features/narf_descriptor.h>
+#include <pcl/keypoints/narf_keypoint.h>
+#include <boost/shared_ptr.hpp>
+#include <iostream>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "parallel_range_image_border_extractor.h"
+
+namespace pcl
+{
+  /** \brief NarfKeypoint that computes its border extractor caches and its interest image on several threads.
+    *
+    * Most of the time of NarfKeypoint goes into the surface changes of the
+    * border extractor and into the interest image. With a
+    * ParallelRangeImageBorderExtractor the first are computed by its parallel
+    * stages before the detection starts. The interest image is computed per
+    * pixel by the OpenMP loops of NarfKeypoint itself
+    * (Parameters::max_no_of_threads), set here to the same number of threads.
+    * The keypoints and their order (by interest value) are the same as on one
+    * thread, narf_benchmark checks this for 1 to N threads.
+    */
+  class ParallelNarfKeypoint : public NarfKeypoint
+  {
+    public:
+      typedef boost::shared_ptr<ParallelNarfKeypoint> Ptr;
+      typedef boost::shared_ptr<const ParallelNarfKeypoint> ConstPtr;
+
+      explicit ParallelNarfKeypoint (RangeImageBorderExtractor *range_image_border_extractor = NULL, float support_size = -1.0f)
+        : NarfKeypoint (range_image_border_extractor, support_size)
+        , threads_ (0)
+      {}
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+    protected:
+      virtual void
+      detectKeypoints (PointCloudOut &output)
+      {
+        parameters_.max_no_of_threads = getThreads ();
+        ParallelRangeImageBorderExtractor *border_extractor =
+          dynamic_cast<ParallelRangeImageBorderExtractor*> (range_image_border_extractor_);
+        if (border_extractor != NULL)
+        {
+          border_extractor->setNumberOfThreads (threads_);
+          border_extractor->computeSurfaceChanges ();
+        }
+        NarfKeypoint::detectKeypoints (output);
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      unsigned int threads_;
+  };
+
+  /** \brief NarfDescriptor that extracts the descriptors of the keypoints on several threads.
+    *
+    * Every keypoint is independent of the others. Each one gets its own list
+    * of features (the rotation invariant version can give more than one per
+    * keypoint), and the lists are joined in the order of the keypoints
+    * afterwards. The output is the one of NarfDescriptor, in the same order,
+    * independent of the number of threads, unlike Narf::extractForInterestPoints
+    * which collects the features in the order the threads finish them.
+    */
+  class ParallelNarfDescriptor : public NarfDescriptor
+  {
+    public:
+      typedef boost::shared_ptr<ParallelNarfDescriptor> Ptr;
+      typedef boost::shared_ptr<const ParallelNarfDescriptor> ConstPtr;
+
+      explicit ParallelNarfDescriptor (const RangeImage *range_image = NULL, const std::vector<int> *indices = NULL)
+        : NarfDescriptor (range_image, indices)
+        , threads_ (0)
+      {}
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+    protected:
+      virtual void
+      computeFeature (PointCloudOut &output)
+      {
+        output.points.clear ();
+        output.width = output.height = 0;
+        if (range_image_ == NULL)
+        {
+          std::cerr << __PRETTY_FUNCTION__ << ": RangeImage is not set. Sorry, the NARF descriptor calculation works on range images, not on normal point clouds.\n\n";
+          return;
+        }
+        if (parameters_.support_size <= 0.0f)
+        {
+          std::cerr << __PRETTY_FUNCTION__ << ": support size is not set. Use getParameters ().support_size = ...\n\n";
+          return;
+        }
+        output.is_dense = true;
+
+        // 没有给出关键点时为每个像素计算描述子
+        const int width = range_image_->width;
+        const int no_of_points = indices_ ? static_cast<int> (indices_->size ()) : static_cast<int> (range_image_->points.size ());
+        std::vector<std::vector<Narf*> > features (no_of_points);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int i = 0; i < no_of_points; ++i)
+        {
+          const int point_index = indices_ ? (*indices_)[i] : i;
+          const int y = point_index / width, x = point_index - y * width;
+          Narf::extractFromRangeImageAndAddToList (*range_image_, static_cast<float> (x), static_cast<float> (y), 36,
+                                                   parameters_.support_size, parameters_.rotation_invariant, features[i]);
+        }
+
+        // 按关键点的顺序合并
+        size_t no_of_features = 0;
+        for (int i = 0; i < no_of_points; ++i)
+          no_of_features += features[i].size ();
+        output.points.resize (no_of_features);
+        size_t feature_idx = 0;
+        for (int i = 0; i < no_of_points; ++i)
+          for (size_t j = 0; j < features[i].size (); ++j, ++feature_idx)
+          {
+            features[i][j]->copyToNarf36 (output.points[feature_idx]);
+            delete features[i][j];
+          }
+        output.width = static_cast<uint32_t> (no_of_features);
+        output.height = 1;
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      unsigned int threads_;
+  };
+}
+
+#endif
@@ -0,0 +1,463 @@
+/*! \file parallel_range_image_border_extractor.h
+*  RangeImageBorderExtractor with every stage parallel over the image rows; NarfKeypoint reuses the caches it fills.
+*/
+#ifndef PARALLEL_RANGE_IMAGE_BORDER_EXTRACTOR_H_
+#define PARALLEL_RANGE_IMAGE_BORDER_EXTRACTOR_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/console/print.h>
+#include <pcl/common/angles.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/features/range_image_border_extractor.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief RangeImageBorderExtractor that computes each of its stages in parallel over the image rows.
+    *
+    * RangeImageBorderExtractor fills its caches lazily, one stage after the
+    * other, each in a single thread: local surface structure, border scores
+    * (raw, then smoothed with the neighbors), shadow borders, border
+    * descriptions, border directions and surface changes. This class runs the
+    * same stages with the same helper functions in parallel and stores the
+    * results in the caches of the base class. Anything that reads them through
+    * a RangeImageBorderExtractor afterwards, NarfKeypoint in particular, finds
+    * them filled and computes nothing again:
+    * \code
+    *   pcl::ParallelRangeImageBorderExtractor border_extractor;
+    *   pcl::NarfKeypoint narf_keypoint_detector (&border_extractor);
+    *   narf_keypoint_detector.setRangeImage (&range_image);   // clears the caches of border_extractor
+    *   border_extractor.compute (border_descriptions);        // borders in parallel
+    *   border_extractor.computeSurfaceChanges ();             // everything NarfKeypoint reads, in parallel
+    *   narf_keypoint_detector.compute (keypoint_indices);
+    * \endcode
+    * The results are the ones of the serial stages. Two stages need care:
+    *  - the serial shadow border search changes the score of a pixel and reads
+    *    the opposite scores of its neighbors, which are already changed for the
+    *    pixels before it (left, above) and not yet for the ones after it (right,
+    *    below). The right and bottom scores only depend on unchanged left and
+    *    top scores, so they are done in a first pass, left and top in a second;
+    *  - classification marks shadow and veil pixels next to a border pixel.
+    *    Traits are only ever set, so horizontal borders are marked in a pass over
+    *    rows and vertical ones in a pass over columns, and no two threads write to
+    *    the same pixel.
+    * The getters hide the ones of the base class and run the parallel stages.
+    */
+  class ParallelRangeImageBorderExtractor : public RangeImageBorderExtractor
+  {
+    public:
+      typedef boost::shared_ptr<ParallelRangeImageBorderExtractor> Ptr;
+      typedef boost::shared_ptr<const ParallelRangeImageBorderExtractor> ConstPtr;
+
+      explicit ParallelRangeImageBorderExtractor (const RangeImage *range_image = NULL)
+        : RangeImageBorderExtractor (range_image)
+        , threads_ (0)
+      {}
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Same as RangeImageBorderExtractor::compute, with the stages in parallel. */
+      void
+      compute (PointCloudOut &output)
+      {
+        classifyBordersParallel ();
+        RangeImageBorderExtractor::compute (output);
+      }
+
+      /** \brief Fill all caches up to the surface changes, everything NarfKeypoint reads. */
+      inline void
+      computeSurfaceChanges () { calculateSurfaceChangesParallel (); }
+
+      inline LocalSurface**
+      getSurfaceStructure () { extractLocalSurfaceStructureParallel (); return (surface_structure_); }
+
+      inline float*
+      getBorderScoresLeft () { extractBorderScoreImagesParallel (); return (&border_scores_left_[0]); }
+
+      inline float*
+      getBorderScoresRight () { extractBorderScoreImagesParallel (); return (&border_scores_right_[0]); }
+
+      inline float*
+      getBorderScoresTop () { extractBorderScoreImagesParallel (); return (&border_scores_top_[0]); }
+
+      inline float*
+      getBorderScoresBottom () { extractBorderScoreImagesParallel (); return (&border_scores_bottom_[0]); }
+
+      inline ShadowBorderIndices**
+      getShadowBorderInformations () { findAndEvaluateShadowBordersParallel (); return (shadow_border_informations_); }
+
+      inline PointCloudOut&
+      getBorderDescriptions () { classifyBordersParallel (); return (*border_descriptions_); }
+
+      inline Eigen::Vector3f**
+      getBorderDirections () { calculateBorderDirectionsParallel (); return (border_directions_); }
+
+      inline float*
+      getSurfaceChangeScores () { calculateSurfaceChangesParallel (); return (surface_change_scores_); }
+
+      inline Eigen::Vector3f*
+      getSurfaceChangeDirections () { calculateSurfaceChangesParallel (); return (surface_change_directions_); }
+
+    protected:
+      void
+      extractLocalSurfaceStructureParallel ()
+      {
+        if (surface_structure_ != NULL || !checkRangeImage ())
+          return;
+        const int width = range_image_->width, height = range_image_->height;
+        range_image_size_during_extraction_ = width * height;
+        surface_structure_ = new LocalSurface*[width * height];
+        const int step_size = (std::max) (1, parameters_.pixel_radius_plane_extraction / 2);
+        const int side = parameters_.pixel_radius_plane_extraction / step_size + 1;
+        const int no_of_nearest_neighbors = side * side;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            LocalSurface *&local_surface = surface_structure_[y * width + x];
+            local_surface = NULL;
+            if (!range_image_->isValid (x, y))
+              continue;
+            local_surface = new LocalSurface;
+            Eigen::Vector3f point;
+            range_image_->getPoint (x, y, point);
+            if (!range_image_->getSurfaceInformation (x, y, parameters_.pixel_radius_plane_extraction, point,
+                                                      no_of_nearest_neighbors, step_size, local_surface->max_neighbor_distance_squared,
+                                                      local_surface->normal_no_jumps, local_surface->neighborhood_mean_no_jumps,
+                                                      local_surface->eigen_values_no_jumps, &local_surface->normal,
+                                                      &local_surface->neighborhood_mean, &local_surface->eigen_values))
+            {
+              delete local_surface;
+              local_surface = NULL;
+            }
+          }
+      }
+
+      void
+      extractBorderScoreImagesParallel ()
+      {
+        if (!border_scores_left_.empty () || !checkRangeImage ())
+          return;
+        extractLocalSurfaceStructureParallel ();
+        const int width = range_image_->width, height = range_image_->height;
+        border_scores_left_.resize (width * height);
+        border_scores_right_.resize (width * height);
+        border_scores_top_.resize (width * height);
+        border_scores_bottom_.resize (width * height);
+        const int radius = parameters_.pixel_radius_borders;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            const int index = y * width + x;
+            const LocalSurface *local_surface = surface_structure_[index];
+            if (local_surface == NULL)
+            {
+              border_scores_left_[index] = border_scores_right_[index] = border_scores_top_[index] = border_scores_bottom_[index] = 0.0f;
+              continue;
+            }
+            border_scores_left_[index] = getNeighborDistanceChangeScore (*local_surface, x, y, -1, 0, radius);
+            border_scores_right_[index] = getNeighborDistanceChangeScore (*local_surface, x, y, 1, 0, radius);
+            border_scores_top_[index] = getNeighborDistanceChangeScore (*local_surface, x, y, 0, -1, radius);
+            border_scores_bottom_[index] = getNeighborDistanceChangeScore (*local_surface, x, y, 0, 1, radius);
+          }
+      }
+
+      /** \brief updateScoresAccordingToNeighborValues, the four directions in one pass. */
+      void
+      updateScoresAccordingToNeighborValuesParallel ()
+      {
+        extractBorderScoreImagesParallel ();
+        if (border_scores_left_.empty ())
+          return;
+        const int width = range_image_->width, height = range_image_->height;
+        const std::vector<float> left (border_scores_left_), right (border_scores_right_);
+        const std::vector<float> top (border_scores_top_), bottom (border_scores_bottom_);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            const int index = y * width + x;
+            border_scores_left_[index] = updatedScoreAccordingToNeighborValues (x, y, &left[0]);
+            border_scores_right_[index] = updatedScoreAccordingToNeighborValues (x, y, &right[0]);
+            border_scores_top_[index] = updatedScoreAccordingToNeighborValues (x, y, &top[0]);
+            border_scores_bottom_[index] = updatedScoreAccordingToNeighborValues (x, y, &bottom[0]);
+          }
+      }
+
+      void
+      findAndEvaluateShadowBordersParallel ()
+      {
+        if (shadow_border_informations_ != NULL || !checkRangeImage ())
+          return;
+        if (border_scores_left_.empty ())
+        {
+          PCL_ERROR ("[pcl::ParallelRangeImageBorderExtractor] Border score images not available!\n");
+          return;
+        }
+        const int width = range_image_->width, height = range_image_->height;
+        shadow_border_informations_ = new ShadowBorderIndices*[width * height];
+        float *left = &border_scores_left_[0], *right = &border_scores_right_[0];
+        float *top = &border_scores_top_[0], *bottom = &border_scores_bottom_[0];
+
+        // 1. 向右、向下：只读尚未修改的向左、向上的分数
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            ShadowBorderIndices *&shadow_border_indices = shadow_border_informations_[y * width + x];
+            shadow_border_indices = NULL;
+            int shadow_border_idx;
+            if (changeScoreAccordingToShadowBorderValue (x, y, 1, 0, right, left, shadow_border_idx))
+              getShadowBorderIndices (shadow_border_indices).right = shadow_border_idx;
+            if (changeScoreAccordingToShadowBorderValue (x, y, 0, 1, bottom, top, shadow_border_idx))
+              getShadowBorderIndices (shadow_border_indices).bottom = shadow_border_idx;
+          }
+        // 2. 向左、向上：读第 1 步修改过的向右、向下的分数，与逐行处理时的顺序一致
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            ShadowBorderIndices *&shadow_border_indices = shadow_border_informations_[y * width + x];
+            int shadow_border_idx;
+            if (changeScoreAccordingToShadowBorderValue (x, y, -1, 0, left, right, shadow_border_idx))
+              getShadowBorderIndices (shadow_border_indices).left = shadow_border_idx;
+            if (changeScoreAccordingToShadowBorderValue (x, y, 0, -1, top, bottom, shadow_border_idx))
+              getShadowBorderIndices (shadow_border_indices).top = shadow_border_idx;
+          }
+      }
+
+      void
+      classifyBordersParallel ()
+      {
+        if (border_descriptions_ != NULL || !checkRangeImage ())
+          return;
+        extractLocalSurfaceStructureParallel ();
+        extractBorderScoreImagesParallel ();
+        updateScoresAccordingToNeighborValuesParallel ();
+        findAndEvaluateShadowBordersParallel ();
+
+        const int width = range_image_->width, height = range_image_->height;
+        BorderDescription initial_border_description;
+        initial_border_description.traits = 0;
+        border_descriptions_ = new PointCloudOut;
+        border_descriptions_->width = width;
+        border_descriptions_->height = height;
+        border_descriptions_->is_dense = true;
+        border_descriptions_->points.resize (width * height, initial_border_description);
+        std::vector<BorderDescription, Eigen::aligned_allocator<BorderDescription> > &descriptions = border_descriptions_->points;
+
+        // 1. 左右方向的边界：阴影和遮挡点与边界点在同一行
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            const int index = y * width + x;
+            descriptions[index].x = x;
+            descriptions[index].y = y;
+            const ShadowBorderIndices *shadow_border_indices = shadow_border_informations_[index];
+            if (shadow_border_indices == NULL)
+              continue;
+            const int left = shadow_border_indices->left;
+            if (left >= 0 && checkIfMaximum (x, y, -1, 0, &border_scores_left_[0], left))
+            {
+              markBorder (index, BORDER_TRAIT__OBSTACLE_BORDER_LEFT, left, BORDER_TRAIT__SHADOW_BORDER_RIGHT);
+              for (int veil = index - 1; veil > left; --veil)
+                markVeil (veil, BORDER_TRAIT__VEIL_POINT_RIGHT);
+            }
+            const int right = shadow_border_indices->right;
+            if (right >= 0 && checkIfMaximum (x, y, 1, 0, &border_scores_right_[0], right))
+            {
+              markBorder (index, BORDER_TRAIT__OBSTACLE_BORDER_RIGHT, right, BORDER_TRAIT__SHADOW_BORDER_LEFT);
+              for (int veil = index + 1; veil < right; ++veil)
+                markVeil (veil, BORDER_TRAIT__VEIL_POINT_LEFT);
+            }
+          }
+
+        // 2. 上下方向的边界：阴影和遮挡点在同一列，每个线程一段列
+        const int threads = getThreads ();
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+        for (int t = 0; t < threads; ++t)
+        {
+          const int x_begin = chunkBegin (width, threads, t), x_end = chunkBegin (width, threads, t + 1);
+          for (int y = 0; y < height; ++y)
+            for (int x = x_begin; x < x_end; ++x)
+            {
+              const int index = y * width + x;
+              const ShadowBorderIndices *shadow_border_indices = shadow_border_informations_[index];
+              if (shadow_border_indices == NULL)
+                continue;
+              const int top = shadow_border_indices->top;
+              if (top >= 0 && checkIfMaximum (x, y, 0, -1, &border_scores_top_[0], top))
+              {
+                markBorder (index, BORDER_TRAIT__OBSTACLE_BORDER_TOP, top, BORDER_TRAIT__SHADOW_BORDER_BOTTOM);
+                for (int veil = index - width; veil > top; veil -= width)
+                  markVeil (veil, BORDER_TRAIT__VEIL_POINT_BOTTOM);
+              }
+              const int bottom = shadow_border_indices->bottom;
+              if (bottom >= 0 && checkIfMaximum (x, y, 0, 1, &border_scores_bottom_[0], bottom))
+              {
+                markBorder (index, BORDER_TRAIT__OBSTACLE_BORDER_BOTTOM, bottom, BORDER_TRAIT__SHADOW_BORDER_TOP);
+                for (int veil = index + width; veil < bottom; veil += width)
+                  markVeil (veil, BORDER_TRAIT__VEIL_POINT_TOP);
+              }
+            }
+        }
+      }
+
+      void
+      calculateBorderDirectionsParallel ()
+      {
+        if (border_directions_ != NULL || !checkRangeImage ())
+          return;
+        classifyBordersParallel ();
+        const int width = range_image_->width, height = range_image_->height, size = width * height;
+        border_directions_ = new Eigen::Vector3f*[size];
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+            calculateBorderDirection (x, y);
+
+        // 与邻域中方向相近、中间没有边界的方向取平均
+        Eigen::Vector3f **average_border_directions = new Eigen::Vector3f*[size];
+        const int radius = parameters_.pixel_radius_border_direction;
+        const int minimum_weight = radius + 1;
+        const float min_cos_angle = std::cos (deg2rad (120.0f));
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            const int index = y * width + x;
+            Eigen::Vector3f *&average_border_direction = average_border_directions[index];
+            average_border_direction = NULL;
+            const Eigen::Vector3f *border_direction = border_directions_[index];
+            if (border_direction == NULL)
+              continue;
+            average_border_direction = new Eigen::Vector3f (*border_direction);
+            float weight_sum = 1.0f;
+            for (int y2 = (std::max) (0, y - radius); y2 <= (std::min) (y + radius, height - 1); ++y2)
+              for (int x2 = (std::max) (0, x - radius); x2 <= (std::min) (x + radius, width - 1); ++x2)
+              {
+                const int index2 = y2 * width + x2;
+                const Eigen::Vector3f *neighbor_border_direction = border_directions_[index2];
+                if (neighbor_border_direction == NULL || index2 == index)
+                  continue;
+                if (neighbor_border_direction->dot (*border_direction) < min_cos_angle)
+                  continue;
+                const float border_between_points_score = getNeighborDistanceChangeScore (*surface_structure_[index], x, y, x2 - x, y2 - y, 1);
+                if (std::fabs (border_between_points_score) >= 0.95f * parameters_.minimum_border_probability)
+                  continue;
+                *average_border_direction += *neighbor_border_direction;
+                weight_sum += 1.0f;
+              }
+            if (pcl_lrint (weight_sum) < minimum_weight)
+            {
+              delete average_border_direction;
+              average_border_direction = NULL;
+            }
+            else
+              average_border_direction->normalize ();
+          }
+
+        for (int i = 0; i < size; ++i)
+          delete border_directions_[i];
+        delete[] border_directions_;
+        border_directions_ = average_border_directions;
+      }
+
+      void
+      calculateSurfaceChangesParallel ()
+      {
+        if (surface_change_scores_ != NULL || !checkRangeImage ())
+          return;
+        calculateBorderDirectionsParallel ();
+        const int width = range_image_->width, height = range_image_->height;
+        surface_change_scores_ = new float[width * height];
+        surface_change_directions_ = new Eigen::Vector3f[width * height];
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            const int index = y * width + x;
+            float &surface_change_score = surface_change_scores_[index];
+            Eigen::Vector3f &surface_change_direction = surface_change_directions_[index];
+            surface_change_score = 0.0f;
+            surface_change_direction.setZero ();
+            const BorderTraits &border_traits = border_descriptions_->points[index].traits;
+            if (border_traits[BORDER_TRAIT__VEIL_POINT] || border_traits[BORDER_TRAIT__SHADOW_BORDER])
+              continue;
+            if (border_directions_[index] != NULL)
+            {
+              surface_change_score = 1.0f;
+              surface_change_direction = *border_directions_[index];
+            }
+            else if (!calculateMainPrincipalCurvature (x, y, parameters_.pixel_radius_principal_curvature,
+                                                       surface_change_score, surface_change_direction))
+              surface_change_score = 0.0f;
+          }
+      }
+
+      inline bool
+      checkRangeImage () const
+      {
+        if (range_image_ != NULL)
+          return (true);
+        PCL_ERROR ("[pcl::ParallelRangeImageBorderExtractor] RangeImage is not set, use setRangeImage (...)!\n");
+        return (false);
+      }
+
+      static inline ShadowBorderIndices&
+      getShadowBorderIndices (ShadowBorderIndices *&shadow_border_indices)
+      {
+        if (shadow_border_indices == NULL)
+          shadow_border_indices = new ShadowBorderIndices;
+        return (*shadow_border_indices);
+      }
+
+      inline void
+      markBorder (int index, BorderTrait obstacle_side, int shadow_index, BorderTrait shadow_side)
+      {
+        BorderTraits &border_traits = border_descriptions_->points[index].traits;
+        BorderTraits &shadow_traits = border_descriptions_->points[shadow_index].traits;
+        border_traits[BORDER_TRAIT__OBSTACLE_BORDER] = border_traits[obstacle_side] = true;
+        shadow_traits[BORDER_TRAIT__SHADOW_BORDER] = shadow_traits[shadow_side] = true;
+      }
+
+      inline void
+      markVeil (int index, BorderTrait side)
+      {
+        BorderTraits &veil_traits = border_descriptions_->points[index].traits;
+        veil_traits[BORDER_TRAIT__VEIL_POINT] = veil_traits[side] = true;
+      }
+
+      static inline int
+      chunkBegin (int n, int chunks, int c)
+      {
+        return (static_cast<int> (static_cast<long long> (n) * c / chunks));
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      unsigned int threads_;
+  };
+}
+
+#endif
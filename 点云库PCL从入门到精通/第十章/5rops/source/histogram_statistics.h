@@ -0,0 +1,300 @@
+/*! \file histogram_statistics.h
+*  Per-bin statistics (mean, percentiles, density) of a histogram feature over a whole cloud, shown as one PCLPlotter chart.
+*/
+#ifndef HISTOGRAM_STATISTICS_H_
+#define HISTOGRAM_STATISTICS_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/visualization/pcl_plotter.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  namespace visualization
+  {
+    /** \brief The histogram of a feature point, for all types with a float histogram[N] member
+      * (FPFHSignature33, PFHSignature125, VFHSignature308, Histogram<N>, ...).
+      */
+    template <typename PointT> inline const float*
+    getHistogramData (const PointT &p, int &bins)
+    {
+      bins = static_cast<int> (sizeof (p.histogram) / sizeof (float));
+      return (p.histogram);
+    }
+
+    inline const float*
+    getHistogramData (const pcl::SHOT352 &p, int &bins)
+    {
+      bins = 352;
+      return (p.descriptor);
+    }
+
+    /** \brief Per-bin statistics of a histogram feature over all points of a cloud.
+      *
+      * addFeatureHistogram shows the histogram of a single point. To judge the
+      * descriptors of a full scan, this class computes for every bin the mean,
+      * a set of percentiles and a density (how many points have which value in
+      * that bin) over all valid points, with the bins split over OpenMP threads,
+      * and draws everything into one chart: the density as a heat map of gray
+      * levels, the percentile bands and the mean as lines on top.
+      */
+    class HistogramStatistics
+    {
+      public:
+        HistogramStatistics ()
+          : density_rows_ (40)
+          , density_levels_ (6)
+          , threads_ (0)
+          , bins_ (0)
+          , count_ (0)
+          , density_min_ (0.0)
+          , density_max_ (0.0)
+          , density_peak_ (0)
+        {
+          percentiles_.push_back (5);
+          percentiles_.push_back (25);
+          percentiles_.push_back (50);
+          percentiles_.push_back (75);
+          percentiles_.push_back (95);
+        }
+
+        /** \brief Number of value rows of the density heat map. */
+        inline void
+        setDensityRows (int rows) { density_rows_ = std::max (rows, 2); }
+
+        /** \brief Number of gray levels the density is drawn with. */
+        inline void
+        setDensityLevels (int levels) { density_levels_ = std::max (levels, 1); }
+
+        /** \brief Number of OpenMP threads, 0 = one per core. */
+        inline void
+        setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+        /** \brief Percentiles (0..100) to compute per bin; drawn as symmetric bands
+          * around the middle one, so keep the list sorted and of odd length.
+          */
+        inline void
+        setPercentiles (const std::vector<double> &percentiles) { percentiles_ = percentiles; }
+
+        template <typename PointT> void
+        compute (const pcl::PointCloud<PointT> &cloud)
+        {
+          bins_ = 0;
+          count_ = 0;
+          if (cloud.points.empty ())
+            return;
+          getHistogramData (cloud.points[0], bins_);
+
+          // 第一个值为 NaN 的描述子（没有足够邻域）不参与统计
+          std::vector<const float*> valid;
+          valid.reserve (cloud.points.size ());
+          for (size_t i = 0; i < cloud.points.size (); ++i)
+          {
+            int bins;
+            const float *h = getHistogramData (cloud.points[i], bins);
+            if (pcl_isfinite (h[0]))
+              valid.push_back (h);
+          }
+          count_ = valid.size ();
+
+          mean_.assign (bins_, 0.0);
+          min_.assign (bins_, 0.0);
+          max_.assign (bins_, 0.0);
+          values_.assign (percentiles_.size (), std::vector<double> (bins_, 0.0));
+          density_.assign (static_cast<size_t> (bins_) * density_rows_, 0);
+          density_min_ = density_max_ = 0.0;
+          density_peak_ = 0;
+          if (count_ == 0)
+            return;
+
+          // 每个 bin 独立：拷出一列、排序，得到均值、百分位数与极值
+          const int bins = bins_;
+          std::vector<double> upper (bins, 0.0);
+#pragma omp parallel for schedule(dynamic,1) num_threads(getThreads ())
+          for (int b = 0; b < bins; ++b)
+          {
+            std::vector<float> column (count_);
+            double sum = 0.0;
+            for (size_t i = 0; i < count_; ++i)
+            {
+              column[i] = valid[i][b];
+              sum += column[i];
+            }
+            std::sort (column.begin (), column.end ());
+            mean_[b] = sum / count_;
+            min_[b] = column.front ();
+            max_[b] = column.back ();
+            for (size_t k = 0; k < percentiles_.size (); ++k)
+              values_[k][b] = column[rank (percentiles_[k])];
+            upper[b] = column[rank (99.0)];
+          }
+
+          // 密度图的值域：最小值到各 bin 99% 分位数的最大值，更大的值记入最上一行
+          density_min_ = *std::min_element (min_.begin (), min_.end ());
+          density_max_ = *std::max_element (upper.begin (), upper.end ());
+          if (density_max_ <= density_min_)
+            density_max_ = density_min_ + 1.0;
+          const double scale = density_rows_ / (density_max_ - density_min_);
+#pragma omp parallel for schedule(dynamic,1) num_threads(getThreads ())
+          for (int b = 0; b < bins; ++b)
+          {
+            size_t *column = &density_[static_cast<size_t> (b) * density_rows_];
+            for (size_t i = 0; i < count_; ++i)
+            {
+              int row = static_cast<int> ((valid[i][b] - density_min_) * scale);
+              ++column[std::max (0, std::min (row, density_rows_ - 1))];
+            }
+          }
+          density_peak_ = *std::max_element (density_.begin (), density_.end ());
+        }
+
+        /** \brief Draw the statistics into the plotter as one chart.
+          * \param[in] plotter the plotter
+          * \param[in] id prefix of the plot names shown in the legend
+          */
+        void
+        addToPlotter (PCLPlotter &plotter, const std::string &id = "feature") const
+        {
+          if (bins_ == 0 || count_ == 0)
+            return;
+          std::vector<double> x (bins_);
+          for (int b = 0; b < bins_; ++b)
+            x[b] = b;
+
+          // 密度：按对数刻度分成若干灰度级，每级一组散点，颜色越深点越多
+          const double row_height = (density_max_ - density_min_) / density_rows_;
+          for (int level = 1; level <= density_levels_; ++level)
+          {
+            std::vector<double> dx, dy;
+            for (int b = 0; b < bins_; ++b)
+              for (int r = 0; r < density_rows_; ++r)
+                if (densityLevel (getDensity (b, r)) == level)
+                {
+                  dx.push_back (b);
+                  dy.push_back (density_min_ + (r + 0.5) * row_height);
+                }
+            if (dx.empty ())
+              continue;
+            unsigned char gray = static_cast<unsigned char> (230 - 200 * level / density_levels_);
+            std::stringstream name;
+            name << id << " density " << level << "/" << density_levels_;
+            plotter.addPlotData (dx, dy, name.str ().c_str (), vtkChart::POINTS, makeColor (gray, gray, gray));
+          }
+
+          // 百分位数成对画出（5/95、25/75），中间一个单独画，最后是均值
+          const size_t n = percentiles_.size ();
+          for (size_t k = 0; k < n; ++k)
+          {
+            size_t band = std::min (k, n - 1 - k);
+            unsigned char blue = static_cast<unsigned char> (255 - 100 * band / (n / 2 + 1));
+            std::stringstream name;
+            name << id << " p" << percentiles_[k];
+            plotter.addPlotData (x, values_[k], name.str ().c_str (), vtkChart::LINE, makeColor (0, static_cast<unsigned char> (blue / 2), blue));
+          }
+          plotter.addPlotData (x, mean_, (id + " mean").c_str (), vtkChart::LINE, makeColor (220, 0, 0));
+
+          plotter.setXRange (0, bins_ - 1);
+          plotter.setYRange (density_min_, density_max_);
+          std::stringstream title;
+          title << id << ": " << count_ << " histograms, " << bins_ << " bins";
+          plotter.setTitle (title.str ().c_str ());
+          plotter.setXTitle ("bin");
+          plotter.setYTitle ("value");
+        }
+
+        inline int
+        getBins () const { return (bins_); }
+
+        /** \brief Number of valid (finite) histograms the statistics were computed from. */
+        inline size_t
+        getCount () const { return (count_); }
+
+        inline const std::vector<double>&
+        getMean () const { return (mean_); }
+
+        inline const std::vector<double>&
+        getMin () const { return (min_); }
+
+        inline const std::vector<double>&
+        getMax () const { return (max_); }
+
+        /** \brief Per-bin values of the k-th percentile given to setPercentiles. */
+        inline const std::vector<double>&
+        getPercentile (size_t k) const { return (values_[k]); }
+
+        /** \brief Number of points whose value in bin lies in the given density row. */
+        inline size_t
+        getDensity (int bin, int row) const { return (density_[static_cast<size_t> (bin) * density_rows_ + row]); }
+
+        /** \brief Value range covered by the density rows. */
+        inline void
+        getDensityRange (double &min, double &max) const { min = density_min_; max = density_max_; }
+
+      private:
+        inline size_t
+        rank (double percentile) const
+        {
+          size_t r = static_cast<size_t> (std::ceil (percentile / 100.0 * count_));
+          return (std::min (std::max<size_t> (r, 1), count_) - 1);
+        }
+
+        inline int
+        densityLevel (size_t c) const
+        {
+          if (c == 0 || density_peak_ == 0)
+            return (0);
+          double f = std::log (1.0 + c) / std::log (1.0 + density_peak_);
+          return (std::max (1, static_cast<int> (std::ceil (f * density_levels_))));
+        }
+
+        static std::vector<char>
+        makeColor (unsigned char r, unsigned char g, unsigned char b)
+        {
+          std::vector<char> color (4);
+          color[0] = static_cast<char> (r);
+          color[1] = static_cast<char> (g);
+          color[2] = static_cast<char> (b);
+          color[3] = static_cast<char> (255);
+          return (color);
+        }
+
+        inline int
+        getThreads () const
+        {
+#ifdef _OPENMP
+          return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+          return (1);
+#endif
+        }
+
+        int density_rows_;
+        int density_levels_;
+        unsigned int threads_;
+        std::vector<double> percentiles_;
+
+        int bins_;
+        size_t count_;
+        std::vector<double> mean_;
+        std::vector<double> min_;
+        std::vector<double> max_;
+        std::vector<std::vector<double> > values_;  // 百分位数 x bin
+        std::vector<size_t> density_;               // bin x 行
+        double density_min_;
+        double density_max_;
+        size_t density_peak_;
+    };
+  }
+}
+
+#endif
@@ -2,10 +2,18 @@
 #include <pcl/io/pcd_io.h>
 #include <pcl/visualization/histogram_visualizer.h>
 #include<pcl/visualization/pcl_plotter.h>
+#include <pcl/console/parse.h>
+#include <pcl/common/time.h>
+#include "histogram_statistics.h"
 int main (int argc, char** argv)
 {
-	if (argc != 4)
+	if (argc < 4)
+	{
+		std::cout<<argv[0]<<" points.pcd indices.txt triangles.txt [-stats]"<<std::endl;
 		return (-1);
+	}
+	//-statsеROPSʾÿbinͳͼ
+	bool stats = pcl::console::find_switch (argc, argv, "-stats");
 
 	pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ> ());
 	if (pcl::io::loadPCDFile (argv[1], *cloud) == -1)
@@ -51,7 +59,8 @@ int main (int argc, char** argv)
 	feature_estimator.setSearchMethod (search_method);
 	feature_estimator.setSearchSurface (cloud);
 	feature_estimator.setInputCloud (cloud);
-	feature_estimator.setIndices (indices);
+	if (!stats)
+		feature_estimator.setIndices (indices);
 	feature_estimator.setTriangles (triangles);
 	feature_estimator.setRadiusSearch (support_radius);
 	feature_estimator.setNumberOfPartitionBins (number_of_partition_bins);
@@ -66,7 +75,16 @@ int main (int argc, char** argv)
 	pcl::visualization::PCLPlotter *plotter = new pcl::visualization::PCLPlotter (title.c_str());//˴ӦиbugͨݵĴá
 	plotter->setWindowName(title);//øúô
 	plotter->setShowLegend (true);
-	plotter->addFeatureHistogram<pcl::Histogram <135>>(*histograms,135,"rops");//
+	if (stats)
+	{
+		double start = pcl::getTime ();
+		pcl::visualization::HistogramStatistics rops_stats;
+		rops_stats.compute (*histograms);
+		std::cout<<"statistics of "<<rops_stats.getCount ()<<" ROPS: "<<(pcl::getTime () - start) * 1000.0<<" ms"<<std::endl;
+		rops_stats.addToPlotter (*plotter, "rops");
+	}
+	else
+		plotter->addFeatureHistogram<pcl::Histogram <135>>(*histograms,135,"rops");//
 	//ʾ0Ӧֱͼ,ҪʾPCLPOINT_CLOUD_REGISTER_POINT_STRUCTעĽṹ壬fpfhͿú
     /*pcl::visualization::PCLPlotter::addFeatureHistogram (
     const pcl::PointCloud<PointT> &cloud, 
@@ -0,0 +1,306 @@
+/*! \file descriptor_matcher.h
+*  Batched, multi-threaded nearest neighbor matching of scene descriptors against model descriptors.
+*/
+#ifndef DESCRIPTOR_MATCHER_H_
+#define DESCRIPTOR_MATCHER_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_representation.h>
+#include <pcl/correspondence.h>
+#include <flann/flann.hpp>
+#include <Eigen/Core>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  /** \brief Finds for every scene descriptor its nearest model descriptor in one batched call.
+    *
+    * Two search back ends are available:
+    *  - EXACT: brute force over all model descriptors. Blocks of queries are
+    *    matched with a single matrix product (Eigen, SIMD vectorized), which
+    *    beats a kd-tree in 352 dimensions as long as the model is small.
+    *  - FLANN_KDTREES: FLANN randomized kd-trees; the number of leaf checks
+    *    trades accuracy for speed and can be tuned automatically for a target recall.
+    * AUTO uses EXACT below a model size threshold and FLANN_KDTREES above it.
+    * Queries are split over OpenMP threads; results keep the scene order.
+    */
+  template <typename DescriptorT>
+  class DescriptorMatcher
+  {
+    public:
+      typedef pcl::PointCloud<DescriptorT> DescriptorCloud;
+      typedef typename DescriptorCloud::ConstPtr DescriptorCloudConstPtr;
+
+      enum Method { AUTO, EXACT, FLANN_KDTREES };
+
+      DescriptorMatcher ()
+        : method_ (AUTO)
+        , threads_ (0)
+        , max_sqr_distance_ (std::numeric_limits<float>::max ())
+        , trees_ (4)
+        , checks_ (64)
+        , target_recall_ (0.0)
+        , calibrated_recall_ (-1.0)
+        , exact_threshold_ (5000)
+        , dim_ (0)
+        , model_size_ (0)
+      {
+      }
+
+      inline void
+      setMethod (Method method) { method_ = method; }
+
+      /** \brief Number of OpenMP threads, 0 = one per core. */
+      inline void
+      setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+      /** \brief Only matches with a squared descriptor distance below this value are returned by match(). */
+      inline void
+      setMaxSquaredDistance (float max_sqr_distance) { max_sqr_distance_ = max_sqr_distance; }
+
+      /** \brief Number of randomized kd-trees (FLANN_KDTREES), takes effect on the next setInputModel. */
+      inline void
+      setNumberOfTrees (int trees) { trees_ = std::max (trees, 1); }
+
+      /** \brief Leaf checks per query (FLANN_KDTREES), disables the recall target. */
+      inline void
+      setChecks (int checks) { checks_ = std::max (checks, 1); target_recall_ = 0.0; }
+
+      inline int
+      getChecks () const { return (checks_); }
+
+      /** \brief Pick the smallest number of checks that reaches this recall (0..1) against
+        * exact search. Calibrated on a sample of the next scene passed to match().
+        */
+      inline void
+      setTargetRecall (double recall) { target_recall_ = recall; calibrated_recall_ = -1.0; }
+
+      /** \brief Recall measured by the last calibration, negative if none ran. */
+      inline double
+      getCalibratedRecall () const { return (calibrated_recall_); }
+
+      /** \brief AUTO switches from EXACT to FLANN_KDTREES at this model size. */
+      inline void
+      setExactThreshold (size_t model_size) { exact_threshold_ = model_size; }
+
+      /** \brief Method that will actually be used for the current model. */
+      inline Method
+      getEffectiveMethod () const
+      {
+        if (method_ != AUTO)
+          return (method_);
+        return (model_size_ < exact_threshold_ ? EXACT : FLANN_KDTREES);
+      }
+
+      /** \brief Set the model descriptors; they are copied into one contiguous matrix. */
+      void
+      setInputModel (const DescriptorCloudConstPtr &model)
+      {
+        dim_ = representation_.getNumberOfDimensions ();
+        model_index_.clear ();
+        for (size_t i = 0; i < model->points.size (); ++i)
+          if (representation_.isValid (model->points[i]))
+            model_index_.push_back (static_cast<int> (i));
+        model_size_ = model_index_.size ();
+        model_data_.resize (model_size_ * dim_);
+        for (size_t i = 0; i < model_size_; ++i)
+        {
+          float *out = &model_data_[i * dim_];
+          representation_.vectorize (model->points[model_index_[i]], out);
+        }
+        Eigen::Map<const Eigen::MatrixXf> m (model_data_.empty () ? 0 : &model_data_[0], dim_, model_size_);
+        model_norms_ = m.colwise ().squaredNorm ().transpose ();
+        flann_index_.reset ();
+        calibrated_recall_ = -1.0;
+      }
+
+      /** \brief Nearest model descriptor for every scene descriptor.
+        * \param[in] scene scene descriptors
+        * \param[out] indices index into the model cloud, -1 for invalid (NaN) scene descriptors
+        * \param[out] sqr_distances squared descriptor distances
+        */
+      void
+      findNearest (const DescriptorCloud &scene, std::vector<int> &indices, std::vector<float> &sqr_distances)
+      {
+        std::vector<int> query_index;
+        std::vector<float> queries;
+        vectorizeScene (scene, query_index, queries);
+        indices.assign (scene.points.size (), -1);
+        sqr_distances.assign (scene.points.size (), std::numeric_limits<float>::max ());
+        if (model_size_ == 0 || query_index.empty ())
+          return;
+
+        std::vector<int> nn (query_index.size ());
+        std::vector<float> nn_dist (query_index.size ());
+        if (getEffectiveMethod () == EXACT)
+          searchExact (queries, nn, nn_dist);
+        else
+        {
+          buildFlannIndex ();
+          if (target_recall_ > 0.0 && calibrated_recall_ < 0.0)
+            calibrate (queries);
+          searchFlann (queries, checks_, nn, nn_dist);
+        }
+        for (size_t q = 0; q < query_index.size (); ++q)
+        {
+          indices[query_index[q]] = model_index_[nn[q]];
+          sqr_distances[query_index[q]] = nn_dist[q];
+        }
+      }
+
+      /** \brief Model-scene correspondences (index_query = model, index_match = scene)
+        * for every scene descriptor whose nearest model descriptor is closer than the
+        * maximum squared distance, in scene order.
+        */
+      void
+      match (const DescriptorCloud &scene, pcl::Correspondences &correspondences)
+      {
+        std::vector<int> indices;
+        std::vector<float> sqr_distances;
+        findNearest (scene, indices, sqr_distances);
+        correspondences.clear ();
+        for (size_t i = 0; i < indices.size (); ++i)
+          if (indices[i] >= 0 && sqr_distances[i] < max_sqr_distance_)
+            correspondences.push_back (pcl::Correspondence (indices[i], static_cast<int> (i), sqr_distances[i]));
+      }
+
+    private:
+      void
+      vectorizeScene (const DescriptorCloud &scene, std::vector<int> &query_index, std::vector<float> &queries) const
+      {
+        query_index.clear ();
+        for (size_t i = 0; i < scene.points.size (); ++i)
+          if (representation_.isValid (scene.points[i]))
+            query_index.push_back (static_cast<int> (i));
+        queries.resize (query_index.size () * dim_);
+        for (size_t q = 0; q < query_index.size (); ++q)
+        {
+          float *out = &queries[q * dim_];
+          representation_.vectorize (scene.points[query_index[q]], out);
+        }
+      }
+
+      /** \brief ||q - m||^2 = ||q||^2 + ||m||^2 - 2 q.m, the dot products of a block of
+        * queries against all model descriptors come from one matrix product. The
+        * expansion only picks the nearest model descriptor, its distance is computed directly.
+        */
+      void
+      searchExact (const std::vector<float> &queries, std::vector<int> &nn, std::vector<float> &nn_dist) const
+      {
+        const int block = 128;
+        const int n = static_cast<int> (nn.size ());
+        const int blocks = (n + block - 1) / block;
+        Eigen::Map<const Eigen::MatrixXf> model (&model_data_[0], dim_, model_size_);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int b = 0; b < blocks; ++b)
+        {
+          const int first = b * block;
+          const int count = std::min (block, n - first);
+          Eigen::Map<const Eigen::MatrixXf> q (&queries[first * dim_], dim_, count);
+          Eigen::MatrixXf dots = model.transpose () * q;
+          for (int j = 0; j < count; ++j)
+          {
+            Eigen::MatrixXf::Index best;
+            (model_norms_ - 2.0f * dots.col (j)).minCoeff (&best);
+            nn[first + j] = static_cast<int> (best);
+            // 展开式只用来找最近的描述子，距离重新直接计算，避免相减带来的误差
+            nn_dist[first + j] = (q.col (j) - model.col (best)).squaredNorm ();
+          }
+        }
+      }
+
+      void
+      buildFlannIndex ()
+      {
+        if (flann_index_)
+          return;
+        flann::Matrix<float> data (&model_data_[0], model_size_, dim_);
+        flann_index_.reset (new FlannIndex (data, flann::KDTreeIndexParams (trees_)));
+        flann_index_->buildIndex ();
+      }
+
+      void
+      searchFlann (const std::vector<float> &queries, int checks, std::vector<int> &nn, std::vector<float> &nn_dist) const
+      {
+        const int block = 256;
+        const int n = static_cast<int> (nn.size ());
+        const int blocks = (n + block - 1) / block;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+        for (int b = 0; b < blocks; ++b)
+        {
+          const int first = b * block;
+          const int count = std::min (block, n - first);
+          flann::Matrix<float> q (const_cast<float*> (&queries[first * dim_]), count, dim_);
+          flann::Matrix<int> idx (&nn[first], count, 1);
+          flann::Matrix<float> dist (&nn_dist[first], count, 1);
+          flann_index_->knnSearch (q, idx, dist, 1, flann::SearchParams (checks));
+        }
+      }
+
+      /** \brief Double the leaf checks until the recall on a query sample reaches the target. */
+      void
+      calibrate (const std::vector<float> &queries)
+      {
+        const size_t n = queries.size () / dim_;
+        const size_t sample = std::min<size_t> (n, 500);
+        const size_t step = std::max<size_t> (1, n / sample);
+        std::vector<float> sample_queries;
+        for (size_t q = 0; q < n && sample_queries.size () < sample * dim_; q += step)
+          sample_queries.insert (sample_queries.end (), queries.begin () + q * dim_, queries.begin () + (q + 1) * dim_);
+        const size_t m = sample_queries.size () / dim_;
+
+        std::vector<int> exact (m), approx (m);
+        std::vector<float> exact_dist (m), approx_dist (m);
+        searchExact (sample_queries, exact, exact_dist);
+        for (int checks = 16; ; checks *= 2)
+        {
+          searchFlann (sample_queries, checks, approx, approx_dist);
+          size_t hits = 0;
+          for (size_t q = 0; q < m; ++q)
+            if (approx[q] == exact[q] || approx_dist[q] <= exact_dist[q] * (1.0f + 1e-5f))
+              ++hits;
+          checks_ = checks;
+          calibrated_recall_ = m > 0 ? static_cast<double> (hits) / m : 1.0;
+          if (calibrated_recall_ >= target_recall_ || checks >= static_cast<int> (model_size_))
+            break;
+        }
+      }
+
+      inline int
+      getThreads () const
+      {
+#ifdef _OPENMP
+        return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+        return (1);
+#endif
+      }
+
+      typedef flann::Index<flann::L2<float> > FlannIndex;
+
+      Method method_;
+      unsigned int threads_;
+      float max_sqr_distance_;
+      int trees_;
+      int checks_;
+      double target_recall_;
+      double calibrated_recall_;
+      size_t exact_threshold_;
+
+      pcl::DefaultPointRepresentation<DescriptorT> representation_;
+      int dim_;
+      size_t model_size_;
+      std::vector<int> model_index_;          // 有效模型描述子在原点云中的索引
+      std::vector<float> model_data_;         // model_size_ x dim_，按行连续存放
+      Eigen::VectorXf model_norms_;
+      boost::shared_ptr<FlannIndex> flann_index_;
+  };
+}
+
+#endif
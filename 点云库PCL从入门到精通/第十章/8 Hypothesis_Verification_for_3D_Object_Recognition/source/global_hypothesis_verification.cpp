@@ -51,6 +51,7 @@
 #include <pcl/registration/icp.h>
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/kdtree/impl/kdtree_flann.hpp>
+#include "descriptor_matcher.h"
 
 typedef pcl::PointXYZRGBA PointType;
 typedef pcl::Normal NormalType;
@@ -314,30 +315,20 @@ int main(int argc, char *argv[]) {
   descr_est.compute(*scene_descriptors);
 
   /**
-   *  Find Model-Scene Correspondences with KdTree
+   *  Find Model-Scene Correspondences with DescriptorMatcher
    */
   pcl::CorrespondencesPtr model_scene_corrs(new pcl::Correspondences());
-  pcl::KdTreeFLANN<DescriptorType> match_search;
-  match_search.setInputCloud(model_descriptors);
+  pcl::DescriptorMatcher<DescriptorType> match_search;
+  match_search.setMethod(pcl::DescriptorMatcher<DescriptorType>::EXACT);
+  match_search.setMaxSquaredDistance(0.25f);
+  match_search.setInputModel(model_descriptors);
+  match_search.match(*scene_descriptors, *model_scene_corrs);  // skips NaNs
+
   std::vector<int> model_good_keypoints_indices;
   std::vector<int> scene_good_keypoints_indices;
-
-  for (size_t i = 0; i < scene_descriptors->size(); ++i) {
-    std::vector<int> neigh_indices(1);
-    std::vector<float> neigh_sqr_dists(1);
-    if (!pcl_isfinite(scene_descriptors->at(i).descriptor[0]))  // skipping NaNs
-    {
-      continue;
-    }
-    int found_neighs = match_search.nearestKSearch(
-        scene_descriptors->at(i), 1, neigh_indices, neigh_sqr_dists);
-    if (found_neighs == 1 && neigh_sqr_dists[0] < 0.25f) {
-      pcl::Correspondence corr(neigh_indices[0], static_cast<int>(i),
-                               neigh_sqr_dists[0]);
-      model_scene_corrs->push_back(corr);
-      model_good_keypoints_indices.push_back(corr.index_query);
-      scene_good_keypoints_indices.push_back(corr.index_match);
-    }
+  for (size_t i = 0; i < model_scene_corrs->size(); ++i) {
+    model_good_keypoints_indices.push_back((*model_scene_corrs)[i].index_query);
+    scene_good_keypoints_indices.push_back((*model_scene_corrs)[i].index_match);
   }
   pcl::PointCloud<PointType>::Ptr model_good_kp(
       new pcl::PointCloud<PointType>());
@@ -0,0 +1,485 @@
+/*! \file compressed_cloud_stream.h
+*  TCP streaming of octree-compressed point clouds (sender/receiver pair).
+*/
+#ifndef COMPRESSED_CLOUD_STREAM_H_
+#define COMPRESSED_CLOUD_STREAM_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/time.h>
+#include <pcl/compression/octree_pointcloud_compression.h>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace pcl
+{
+  namespace octree
+  {
+    /** \brief Header sent in front of every compressed frame.
+      *
+      * Wire layout (little endian, 28 bytes):
+      * \code
+      *   "PCCS" | uint32 sequence | uint32 flags | uint64 capture_us | uint32 point_count | uint32 payload_bytes
+      * \endcode
+      * A keyframe is encoded by a freshly created encoder, so it can be decoded
+      * without any previous frame. Delta frames depend on every frame since the
+      * last keyframe.
+      */
+    struct CompressedFrameHeader
+    {
+      enum { KEYFRAME = 1 };
+      static const size_t SIZE = 28;
+
+      uint32_t sequence;
+      uint32_t flags;
+      uint64_t capture_us;
+      uint32_t point_count;
+      uint32_t payload_bytes;
+
+      inline bool
+      isKeyframe () const { return ((flags & KEYFRAME) != 0); }
+
+      void
+      serialize (unsigned char *buf) const
+      {
+        buf[0] = 'P'; buf[1] = 'C'; buf[2] = 'C'; buf[3] = 'S';
+        put (buf + 4, sequence, 4);
+        put (buf + 8, flags, 4);
+        put (buf + 12, capture_us, 8);
+        put (buf + 20, point_count, 4);
+        put (buf + 24, payload_bytes, 4);
+      }
+
+      bool
+      deserialize (const unsigned char *buf)
+      {
+        if (buf[0] != 'P' || buf[1] != 'C' || buf[2] != 'C' || buf[3] != 'S')
+          return (false);
+        sequence = static_cast<uint32_t> (get (buf + 4, 4));
+        flags = static_cast<uint32_t> (get (buf + 8, 4));
+        capture_us = get (buf + 12, 8);
+        point_count = static_cast<uint32_t> (get (buf + 20, 4));
+        payload_bytes = static_cast<uint32_t> (get (buf + 24, 4));
+        return (true);
+      }
+
+      static void
+      put (unsigned char *buf, uint64_t value, int bytes)
+      {
+        for (int b = 0; b < bytes; ++b)
+          buf[b] = static_cast<unsigned char> ((value >> (8 * b)) & 0xff);
+      }
+
+      static uint64_t
+      get (const unsigned char *buf, int bytes)
+      {
+        uint64_t value = 0;
+        for (int b = 0; b < bytes; ++b)
+          value |= static_cast<uint64_t> (buf[b]) << (8 * b);
+        return (value);
+      }
+    };
+
+    /** \brief Microseconds on the wall clock, used for the capture time stamps.
+      * End-to-end latency is only meaningful when sender and receiver clocks are synchronized.
+      */
+    inline uint64_t
+    streamClockMicroseconds ()
+    {
+      return (static_cast<uint64_t> (pcl::getTime () * 1e6));
+    }
+
+    /** \brief Running counters of one side of the stream. */
+    struct CompressedStreamStats
+    {
+      CompressedStreamStats ()
+        : frames (0), keyframes (0), dropped (0), bytes (0), points (0)
+        , codec_ms (0), latency_ms (0), max_latency_ms (0), first_us (0), last_us (0)
+      {
+      }
+
+      /** \brief Payload plus header bandwidth in Mbit/s over the time the stream was active. */
+      double
+      bandwidthMbps () const
+      {
+        double seconds = (last_us - first_us) * 1e-6;
+        return (seconds > 0 ? 8.0 * bytes / seconds * 1e-6 : 0.0);
+      }
+
+      size_t frames;
+      size_t keyframes;
+      size_t dropped;
+      uint64_t bytes;
+      uint64_t points;
+      double codec_ms;        // 编码（发送端）或解码（接收端）总耗时
+      double latency_ms;      // 接收端：采集到解码完成的总延迟
+      double max_latency_ms;
+      uint64_t first_us;
+      uint64_t last_us;
+    };
+
+    /** \brief Encodes point clouds with PointCloudCompression and pushes them to a
+      * CompressedCloudReceiver over TCP. Every keyframe_interval frames the encoder
+      * is recreated so that the frame is a keyframe a receiver can resynchronize on.
+      */
+    template <typename PointT>
+    class CompressedCloudSender
+    {
+      public:
+        typedef PointCloudCompression<PointT> Codec;
+        typedef typename pcl::PointCloud<PointT>::ConstPtr PointCloudConstPtr;
+
+        CompressedCloudSender (compression_Profiles_e profile = MED_RES_ONLINE_COMPRESSION_WITH_COLOR,
+                               unsigned int keyframe_interval = 30)
+          : profile_ (profile)
+          , keyframe_interval_ (keyframe_interval > 0 ? keyframe_interval : 1)
+          , socket_ (io_service_)
+          , sequence_ (0)
+        {
+        }
+
+        /** \brief Connect to a receiver, the first frame after connecting is a keyframe. */
+        bool
+        connect (const std::string &host, unsigned short port)
+        {
+          boost::system::error_code ec;
+          boost::asio::ip::tcp::endpoint endpoint (boost::asio::ip::address::from_string (host, ec), port);
+          if (ec)
+            return (false);
+          socket_.close (ec);
+          socket_.connect (endpoint, ec);
+          if (ec)
+            return (false);
+          socket_.set_option (boost::asio::ip::tcp::no_delay (true), ec);
+          encoder_.reset ();
+          return (true);
+        }
+
+        void
+        close ()
+        {
+          boost::system::error_code ec;
+          socket_.shutdown (boost::asio::ip::tcp::socket::shutdown_both, ec);
+          socket_.close (ec);
+        }
+
+        /** \brief Compress a cloud and send it.
+          * \param[in] cloud frame to send
+          * \param[in] capture_us capture time stamp, 0 means "now"
+          * \return false if the connection is lost
+          */
+        bool
+        sendFrame (const PointCloudConstPtr &cloud, uint64_t capture_us = 0)
+        {
+          CompressedFrameHeader header;
+          header.sequence = sequence_;
+          header.capture_us = capture_us ? capture_us : streamClockMicroseconds ();
+          header.point_count = static_cast<uint32_t> (cloud->points.size ());
+          header.flags = 0;
+          if (!encoder_ || sequence_ % keyframe_interval_ == 0)
+          {
+            encoder_.reset (new Codec (profile_, false));
+            header.flags |= CompressedFrameHeader::KEYFRAME;
+          }
+
+          double start = pcl::getTime ();
+          std::stringstream compressed;
+          encoder_->encodePointCloud (cloud, compressed);
+          std::string payload = compressed.str ();
+          stats_.codec_ms += (pcl::getTime () - start) * 1000.0;
+          header.payload_bytes = static_cast<uint32_t> (payload.size ());
+
+          unsigned char head[CompressedFrameHeader::SIZE];
+          header.serialize (head);
+          std::vector<boost::asio::const_buffer> buffers;
+          buffers.push_back (boost::asio::buffer (head, sizeof (head)));
+          buffers.push_back (boost::asio::buffer (payload));
+          boost::system::error_code ec;
+          boost::asio::write (socket_, buffers, ec);
+          if (ec)
+            return (false);
+
+          uint64_t now = streamClockMicroseconds ();
+          if (stats_.frames == 0)
+            stats_.first_us = header.capture_us;
+          stats_.last_us = now;
+          ++stats_.frames;
+          if (header.isKeyframe ())
+            ++stats_.keyframes;
+          stats_.bytes += sizeof (head) + payload.size ();
+          stats_.points += header.point_count;
+          ++sequence_;
+          return (true);
+        }
+
+        inline const CompressedStreamStats&
+        getStats () const { return (stats_); }
+
+      private:
+        compression_Profiles_e profile_;
+        unsigned int keyframe_interval_;
+        boost::asio::io_service io_service_;
+        boost::asio::ip::tcp::socket socket_;
+        boost::shared_ptr<Codec> encoder_;
+        uint32_t sequence_;
+        CompressedStreamStats stats_;
+    };
+
+    /** \brief Accepts one sender at a time, decodes its frames on a background thread
+      * and hands them to a callback. Decoded clouds come from a small pool and are
+      * reused once the callback has released them, so steady-state decoding does
+      * not allocate. The sockets are only used by the background thread, which runs
+      * the asynchronous accept and reads; stop() posts their closing to it.
+      */
+    template <typename PointT>
+    class CompressedCloudReceiver
+    {
+      public:
+        typedef PointCloudCompression<PointT> Codec;
+        typedef pcl::PointCloud<PointT> PointCloud;
+        typedef typename PointCloud::Ptr PointCloudPtr;
+        typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+        typedef boost::function<void (const PointCloudConstPtr&, const CompressedFrameHeader&)> FrameCallback;
+
+        CompressedCloudReceiver (unsigned int pool_size = 4)
+          : acceptor_ (io_service_)
+          , socket_ (io_service_)
+          , port_ (0)
+          , pool_ (pool_size > 0 ? pool_size : 1)
+          , pool_next_ (0)
+          , running_ (false)
+          , have_sequence_ (false)
+          , expected_ (0)
+        {
+          for (size_t i = 0; i < pool_.size (); ++i)
+            pool_[i].reset (new PointCloud);
+        }
+
+        ~CompressedCloudReceiver () { stop (); }
+
+        inline void
+        registerCallback (const FrameCallback &callback) { callback_ = callback; }
+
+        /** \brief Bind the listening socket.
+          * \param[in] port TCP port, 0 picks a free one
+          * \return the bound port, 0 on failure
+          */
+        unsigned short
+        listen (unsigned short port = 0)
+        {
+          boost::system::error_code ec;
+          boost::asio::ip::tcp::endpoint endpoint (boost::asio::ip::tcp::v4 (), port);
+          acceptor_.open (endpoint.protocol (), ec);
+          if (!ec) acceptor_.set_option (boost::asio::ip::tcp::acceptor::reuse_address (true), ec);
+          if (!ec) acceptor_.bind (endpoint, ec);
+          if (!ec) acceptor_.listen (1, ec);
+          if (ec)
+            return (0);
+          port_ = acceptor_.local_endpoint ().port ();
+          return (port_);
+        }
+
+        /** \brief Start the receive thread, it serves senders until stop() is called. */
+        void
+        start ()
+        {
+          running_ = true;
+          io_service_.reset ();
+          acceptNext ();
+          thread_.reset (new boost::thread (boost::bind (&CompressedCloudReceiver::run, this)));
+        }
+
+        void
+        stop ()
+        {
+          if (!thread_)
+            return;
+          running_ = false;
+          // 套接字只在接收线程里使用：关闭也交给它执行，挂起的 accept / read 随之以错误结束
+          io_service_.post (boost::bind (&CompressedCloudReceiver::closeSockets, this));
+          thread_->join ();
+          thread_.reset ();
+        }
+
+        /** \brief Snapshot of the counters, safe to call while the thread is running. */
+        CompressedStreamStats
+        getStats ()
+        {
+          boost::mutex::scoped_lock lock (stats_mutex_);
+          return (stats_);
+        }
+
+      private:
+        // 接收线程只运行 io_service，accept、读帧头、读载荷依次以异步操作衔接
+        void
+        run ()
+        {
+          boost::system::error_code ec;
+          io_service_.run (ec);
+        }
+
+        void
+        closeSockets ()
+        {
+          boost::system::error_code ec;
+          socket_.close (ec);
+          acceptor_.close (ec);
+        }
+
+        void
+        acceptNext ()
+        {
+          acceptor_.async_accept (socket_, boost::bind (&CompressedCloudReceiver::onAccept, this,
+                                                        boost::asio::placeholders::error));
+        }
+
+        void
+        onAccept (const boost::system::error_code &error)
+        {
+          if (error || !running_)
+            return;
+          boost::system::error_code ec;
+          socket_.set_option (boost::asio::ip::tcp::no_delay (true), ec);
+          // 新连接上的解码器状态无效，必须等到下一个关键帧
+          decoder_.reset ();
+          have_sequence_ = false;
+          readHeader ();
+        }
+
+        void
+        readHeader ()
+        {
+          boost::asio::async_read (socket_, boost::asio::buffer (head_, sizeof (head_)),
+                                   boost::bind (&CompressedCloudReceiver::onHeader, this, boost::asio::placeholders::error));
+        }
+
+        void
+        onHeader (const boost::system::error_code &error)
+        {
+          if (!running_)
+            return;
+          if (error || !header_.deserialize (head_))
+          {
+            closeConnection ();
+            return;
+          }
+          payload_.resize (header_.payload_bytes);
+          if (payload_.empty ())
+          {
+            onPayload (error);
+            return;
+          }
+          boost::asio::async_read (socket_, boost::asio::buffer (&payload_[0], payload_.size ()),
+                                   boost::bind (&CompressedCloudReceiver::onPayload, this, boost::asio::placeholders::error));
+        }
+
+        void
+        onPayload (const boost::system::error_code &error)
+        {
+          if (!running_)
+            return;
+          if (error)
+          {
+            closeConnection ();
+            return;
+          }
+          decodeFrame ();
+          readHeader ();
+        }
+
+        /** \brief The sender went away or sent garbage: wait for the next one. */
+        void
+        closeConnection ()
+        {
+          boost::system::error_code ec;
+          socket_.close (ec);
+          acceptNext ();
+        }
+
+        void
+        decodeFrame ()
+        {
+          const CompressedFrameHeader &header = header_;
+          bool gap = have_sequence_ && header.sequence != expected_;
+          have_sequence_ = true;
+          expected_ = header.sequence + 1;
+          if (header.isKeyframe ())
+            decoder_.reset (new Codec ());
+          else if (gap || !decoder_)
+          {
+            // 丢失了参考帧，差分帧无法解码
+            decoder_.reset ();
+            boost::mutex::scoped_lock lock (stats_mutex_);
+            ++stats_.dropped;
+            return;
+          }
+
+          double start = pcl::getTime ();
+          PointCloudPtr cloud = nextPoolCloud ();
+          std::istringstream compressed (payload_);
+          decoder_->decodePointCloud (compressed, cloud);
+          double decode_ms = (pcl::getTime () - start) * 1000.0;
+
+          uint64_t now = streamClockMicroseconds ();
+          double latency_ms = now > header.capture_us ? (now - header.capture_us) * 1e-3 : 0.0;
+          {
+            boost::mutex::scoped_lock lock (stats_mutex_);
+            if (stats_.frames == 0)
+              stats_.first_us = header.capture_us;
+            stats_.last_us = now;
+            ++stats_.frames;
+            if (header.isKeyframe ())
+              ++stats_.keyframes;
+            stats_.bytes += CompressedFrameHeader::SIZE + header.payload_bytes;
+            stats_.points += cloud->points.size ();
+            stats_.codec_ms += decode_ms;
+            stats_.latency_ms += latency_ms;
+            stats_.max_latency_ms = std::max (stats_.max_latency_ms, latency_ms);
+          }
+          if (callback_)
+            callback_ (cloud, header);
+        }
+
+        /** \brief Next cloud of the pool; a slot still referenced by the user is replaced. */
+        PointCloudPtr
+        nextPoolCloud ()
+        {
+          PointCloudPtr &slot = pool_[pool_next_];
+          pool_next_ = (pool_next_ + 1) % pool_.size ();
+          if (slot.use_count () > 1)
+            slot.reset (new PointCloud);
+          return (slot);
+        }
+
+        boost::asio::io_service io_service_;
+        boost::asio::ip::tcp::acceptor acceptor_;
+        boost::asio::ip::tcp::socket socket_;
+        unsigned short port_;
+        boost::shared_ptr<boost::thread> thread_;
+        boost::shared_ptr<Codec> decoder_;
+        std::vector<PointCloudPtr> pool_;
+        size_t pool_next_;
+        boost::atomic<bool> running_;
+        unsigned char head_[CompressedFrameHeader::SIZE];
+        CompressedFrameHeader header_;
+        std::string payload_;
+        bool have_sequence_;
+        uint32_t expected_;
+        FrameCallback callback_;
+        boost::mutex stats_mutex_;
+        CompressedStreamStats stats_;
+    };
+  }
+}
+
+#endif
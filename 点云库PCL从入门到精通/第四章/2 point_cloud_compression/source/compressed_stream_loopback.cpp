@@ -0,0 +1,113 @@
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/parse.h>
+#include <boost/thread/thread.hpp>
+#include <iostream>
+#include <cmath>
+#include "compressed_cloud_stream.h"
+
+typedef pcl::PointXYZRGBA PointT;
+using namespace pcl::console;
+
+// 接收端回调：检查帧序号是否连续
+class FrameChecker
+{
+public:
+FrameChecker () : received (0), out_of_order (0), next (0)
+  {
+  }
+
+void
+cloud_cb_ (const pcl::PointCloud<PointT>::ConstPtr& cloud, const pcl::octree::CompressedFrameHeader& header)
+  {
+if (header.sequence != next)
+  ++out_of_order;
+next = header.sequence + 1;
+++received;
+  }
+
+size_t received;
+size_t out_of_order;
+uint32_t next;
+};
+
+int
+main (int argc, char** argv)
+{
+  int frames = 100, keyframe_interval = 30, port = 0;
+  float fps = 30.0f;
+  parse_argument (argc, argv, "-n", frames);
+  parse_argument (argc, argv, "-k", keyframe_interval);
+  parse_argument (argc, argv, "-p", port);
+  parse_argument (argc, argv, "-fps", fps);
+
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  std::vector<int> pcd_files = parse_file_extension_argument (argc, argv, ".pcd");
+  if (!pcd_files.empty () && pcl::io::loadPCDFile (argv[pcd_files[0]], *cloud) < 0)
+    return (-1);
+  bool synthetic = pcd_files.empty ();
+
+  // 中心处理端：监听本地端口，后台线程接收并解码
+  FrameChecker checker;
+  pcl::octree::CompressedCloudReceiver<PointT> receiver;
+  receiver.registerCallback (boost::bind (&FrameChecker::cloud_cb_, &checker, _1, _2));
+  unsigned short bound_port = receiver.listen (static_cast<unsigned short> (port));
+  if (bound_port == 0)
+  {
+    std::cerr << "Could not listen on port " << port << std::endl;
+    return (-1);
+  }
+  receiver.start ();
+
+  // 采集端：连接到 127.0.0.1，按帧率压缩并发送
+  pcl::octree::CompressedCloudSender<PointT> sender (pcl::octree::MED_RES_ONLINE_COMPRESSION_WITH_COLOR, keyframe_interval);
+  if (!sender.connect ("127.0.0.1", bound_port))
+  {
+    std::cerr << "Could not connect to port " << bound_port << std::endl;
+    return (-1);
+  }
+  for (int f = 0; f < frames; ++f)
+  {
+    if (synthetic)
+    {
+      cloud->width = 320;
+      cloud->height = 240;
+      cloud->points.resize (cloud->width * cloud->height);
+      for (size_t i = 0; i < cloud->points.size (); ++i)
+      {
+        PointT &p = cloud->points[i];
+        int u = static_cast<int> (i % cloud->width), v = static_cast<int> (i / cloud->width);
+        p.z = 1.0f + 0.1f * std::sin (0.05f * u + 0.2f * f);
+        p.x = (u - 160) * p.z / 262.5f;
+        p.y = (v - 120) * p.z / 262.5f;
+        p.r = static_cast<uint8_t> (u); p.g = static_cast<uint8_t> (v); p.b = static_cast<uint8_t> (f); p.a = 255;
+      }
+    }
+    if (!sender.sendFrame (cloud))
+    {
+      std::cerr << "Connection lost at frame " << f << std::endl;
+      break;
+    }
+    boost::this_thread::sleep (boost::posix_time::milliseconds (static_cast<int> (1000.0f / fps)));
+  }
+  sender.close ();
+  // 等待接收端处理完最后的帧
+  boost::this_thread::sleep (boost::posix_time::milliseconds (500));
+  receiver.stop ();
+
+  const pcl::octree::CompressedStreamStats &tx = sender.getStats ();
+  pcl::octree::CompressedStreamStats rx = receiver.getStats ();
+  std::cout << "sent " << tx.frames << " frames (" << tx.keyframes << " keyframes), received "
+            << checker.received << ", out of order " << checker.out_of_order
+            << ", dropped " << rx.dropped << std::endl;
+  if (tx.frames == 0 || rx.frames == 0)
+    return (-1);
+  std::cout << "bandwidth:       " << tx.bandwidthMbps () << " Mbit/s, "
+            << 8.0 * tx.bytes / tx.points << " bits/point" << std::endl;
+  std::cout << "encode latency:  " << tx.codec_ms / tx.frames << " ms/frame" << std::endl;
+  std::cout << "decode latency:  " << rx.codec_ms / rx.frames << " ms/frame" << std::endl;
+  std::cout << "end-to-end:      " << rx.latency_ms / rx.frames << " ms/frame (max "
+            << rx.max_latency_ms << " ms)" << std::endl;
+  return (checker.received == tx.frames && checker.out_of_order == 0 ? 0 : 1);
+}
@@ -0,0 +1,114 @@
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <pcl/compression/octree_pointcloud_compression.h>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include "parallel_point_cloud_compression.h"
+
+typedef pcl::PointXYZRGBA PointT;
+using namespace pcl::console;
+
+// 生成一帧模拟的 RGBD 点云（640x480，带颜色的起伏曲面）
+void
+makeSyntheticFrame (pcl::PointCloud<PointT> &cloud, int frame)
+{
+  cloud.width = 640;
+  cloud.height = 480;
+  cloud.points.resize (cloud.width * cloud.height);
+  for (unsigned int v = 0; v < cloud.height; ++v)
+    for (unsigned int u = 0; u < cloud.width; ++u)
+    {
+      PointT &p = cloud.points[v * cloud.width + u];
+      p.z = 1.5f + 0.2f * std::sin (0.02f * u + 0.1f * frame) * std::cos (0.03f * v);
+      p.x = (u - 320.0f) * p.z / 525.0f;
+      p.y = (v - 240.0f) * p.z / 525.0f;
+      p.r = static_cast<uint8_t> (u % 256);
+      p.g = static_cast<uint8_t> (v % 256);
+      p.b = static_cast<uint8_t> ((u + v + frame) % 256);
+      p.a = 255;
+    }
+  cloud.is_dense = true;
+}
+
+int
+main (int argc, char** argv)
+{
+  if (find_switch (argc, argv, "-h"))
+  {
+    std::cout << argv[0] << " [cloud.pcd] -s slices -t threads -n frames" << std::endl;
+    return (0);
+  }
+  int slices = 8, threads = 0, frames = 30;
+  parse_argument (argc, argv, "-s", slices);
+  parse_argument (argc, argv, "-t", threads);
+  parse_argument (argc, argv, "-n", frames);
+
+  pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  std::vector<int> pcd_files = parse_file_extension_argument (argc, argv, ".pcd");
+  bool from_file = !pcd_files.empty ();
+  if (from_file && pcl::io::loadPCDFile (argv[pcd_files[0]], *cloud) < 0)
+  {
+    std::cerr << "Could not read " << argv[pcd_files[0]] << std::endl;
+    return (-1);
+  }
+
+  pcl::octree::compression_Profiles_e profile = pcl::octree::MED_RES_ONLINE_COMPRESSION_WITH_COLOR;
+  // 单线程的原始编解码器，作为对照
+  pcl::octree::PointCloudCompression<PointT> serial_encoder (profile, false);
+  pcl::octree::PointCloudCompression<PointT> serial_decoder;
+  // 多线程分片编解码器
+  pcl::octree::ParallelPointCloudCompression<PointT> parallel_encoder (profile, slices, threads);
+  pcl::octree::ParallelPointCloudCompression<PointT> parallel_decoder (profile, slices, threads);
+
+  TicToc tt;
+  double serial_enc = 0, serial_dec = 0, parallel_enc = 0, parallel_dec = 0;
+  size_t serial_bytes = 0, parallel_bytes = 0, points = 0, serial_out = 0, parallel_out = 0;
+  for (int f = 0; f < frames; ++f)
+  {
+    if (!from_file)
+      makeSyntheticFrame (*cloud, f);
+    points += cloud->points.size ();
+
+    std::stringstream serial_data;
+    pcl::PointCloud<PointT>::Ptr serial_cloud (new pcl::PointCloud<PointT>);
+    tt.tic ();
+    serial_encoder.encodePointCloud (cloud, serial_data);
+    serial_enc += tt.toc ();
+    serial_bytes += serial_data.str ().size ();
+    tt.tic ();
+    serial_decoder.decodePointCloud (serial_data, serial_cloud);
+    serial_dec += tt.toc ();
+    serial_out += serial_cloud->points.size ();
+
+    std::stringstream parallel_data;
+    pcl::PointCloud<PointT>::Ptr parallel_cloud (new pcl::PointCloud<PointT>);
+    tt.tic ();
+    parallel_encoder.encodePointCloud (cloud, parallel_data);
+    parallel_enc += tt.toc ();
+    parallel_bytes += parallel_data.str ().size ();
+    tt.tic ();
+    if (!parallel_decoder.decodePointCloud (parallel_data, parallel_cloud))
+    {
+      std::cerr << "Frame " << f << ": invalid slice table" << std::endl;
+      return (-1);
+    }
+    parallel_dec += tt.toc ();
+    parallel_out += parallel_cloud->points.size ();
+  }
+
+  std::cout << frames << " frames, " << points / frames << " points per frame, "
+            << slices << " slices" << std::endl;
+  std::cout << "serial:   encode " << serial_enc / frames << " ms, decode " << serial_dec / frames
+            << " ms, " << 8.0 * serial_bytes / points << " bits/point, "
+            << serial_out / frames << " decoded points" << std::endl;
+  std::cout << "parallel: encode " << parallel_enc / frames << " ms, decode " << parallel_dec / frames
+            << " ms, " << 8.0 * parallel_bytes / points << " bits/point, "
+            << parallel_out / frames << " decoded points" << std::endl;
+  std::cout << "speedup:  encode x" << serial_enc / parallel_enc
+            << ", decode x" << serial_dec / parallel_dec << std::endl;
+  return (0);
+}
@@ -0,0 +1,360 @@
+/*! \file parallel_point_cloud_compression.h
+*  Multi-threaded octree point cloud codec built on top of PointCloudCompression.
+*/
+#ifndef PARALLEL_POINT_CLOUD_COMPRESSION_H_
+#define PARALLEL_POINT_CLOUD_COMPRESSION_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/compression/octree_pointcloud_compression.h>
+#include <pcl/compression/compression_profiles.h>
+#include <boost/shared_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  namespace octree
+  {
+    /** \brief Octree point cloud codec that cuts the cloud into independent spatial
+      * slices and encodes every slice with its own PointCloudCompression instance
+      * (and therefore its own range coder stream), one slice per thread.
+      *
+      * The slices are slabs along the longest axis of the bounding box of the first
+      * frame; the slab boundaries are snapped to the octree resolution of the
+      * profile so that no voxel is shared by two slices. The boundaries are kept
+      * between frames so that every slice codec can keep doing I/P frame coding.
+      *
+      * Stream layout:
+      * \code
+      *   "PCSL" | uint32 version | uint32 slice_count
+      *   slice_count x { uint32 point_count | uint64 byte_count }   (slice table)
+      *   slice_count x payload                                      (one per slice)
+      * \endcode
+      * Since every payload size is known from the table the decoder can hand the
+      * slices to its threads without parsing them first.
+      */
+    template <typename PointT>
+    class ParallelPointCloudCompression
+    {
+      public:
+        typedef PointCloudCompression<PointT> SliceCodec;
+        typedef boost::shared_ptr<SliceCodec> SliceCodecPtr;
+
+        typedef pcl::PointCloud<PointT> PointCloud;
+        typedef typename PointCloud::Ptr PointCloudPtr;
+        typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+        /** \brief Largest slice count the decoder accepts from a stream. */
+        static const unsigned int kMaxSliceCount = 4096;
+
+        /** \brief One entry of the slice table written in front of the payloads. */
+        struct SliceInfo
+        {
+          uint32_t point_count;
+          uint64_t byte_count;
+        };
+
+        /** \brief Constructor.
+          * \param[in] profile compression profile used by every slice codec
+          * \param[in] slice_count number of spatial slices the cloud is cut into
+          * \param[in] threads number of worker threads, 0 means one per core
+          */
+        ParallelPointCloudCompression (compression_Profiles_e profile = MED_RES_ONLINE_COMPRESSION_WITH_COLOR,
+                                       unsigned int slice_count = 4,
+                                       unsigned int threads = 0)
+          : profile_ (profile)
+          , slice_count_ (std::max (1u, std::min (slice_count, static_cast<unsigned int> (kMaxSliceCount))))
+          , threads_ (threads)
+          , slicing_valid_ (false)
+          , axis_ (0)
+          , slice_origin_ (0.0f)
+          , slice_width_ (0.0f)
+        {
+        }
+
+        /** \brief Set the number of worker threads (0 = one per core). */
+        inline void
+        setNumberOfThreads (unsigned int threads) { threads_ = threads; }
+
+        /** \brief Number of slices the encoder cuts every frame into. */
+        inline unsigned int
+        getSliceCount () const { return (slice_count_); }
+
+        /** \brief Forget the slab boundaries; the next frame recomputes them and all
+          * slice codecs restart with an I-frame. Call this when the scene extent changes.
+          */
+        void
+        resetSlicing ()
+        {
+          slicing_valid_ = false;
+          encoders_.clear ();
+          decoders_.clear ();
+        }
+
+        /** \brief Slice table of the last frame that was encoded or decoded. */
+        inline const std::vector<SliceInfo>&
+        getLastSliceTable () const { return (slice_table_); }
+
+        /** \brief Encode a point cloud, slices are compressed in parallel.
+          * \param[in] cloud input cloud
+          * \param[out] compressed_tree_data binary output stream
+          */
+        void
+        encodePointCloud (const PointCloudConstPtr &cloud, std::ostream &compressed_tree_data)
+        {
+          if (!slicing_valid_)
+            computeSlicing (*cloud);
+          if (encoders_.size () != slice_count_)
+          {
+            encoders_.resize (slice_count_);
+            for (unsigned int s = 0; s < slice_count_; ++s)
+              encoders_[s].reset (new SliceCodec (profile_, false));
+          }
+
+          // 按切片分配点
+          std::vector<PointCloudPtr> slices (slice_count_);
+          for (unsigned int s = 0; s < slice_count_; ++s)
+          {
+            slices[s].reset (new PointCloud);
+            slices[s]->reserve (cloud->points.size () / slice_count_ + 1);
+          }
+          for (size_t i = 0; i < cloud->points.size (); ++i)
+          {
+            const PointT &p = cloud->points[i];
+            if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+              continue;
+            slices[sliceOf (p)]->push_back (p);
+          }
+
+          // 每个切片独立编码，拥有各自的区间编码器
+          std::vector<std::string> payloads (slice_count_);
+          slice_table_.resize (slice_count_);
+          int n = static_cast<int> (slice_count_);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+          for (int s = 0; s < n; ++s)
+          {
+            slice_table_[s].point_count = static_cast<uint32_t> (slices[s]->points.size ());
+            if (slices[s]->points.empty ())
+            {
+              slice_table_[s].byte_count = 0;
+              continue;
+            }
+            std::stringstream slice_stream;
+            encoders_[s]->encodePointCloud (slices[s], slice_stream);
+            payloads[s] = slice_stream.str ();
+            slice_table_[s].byte_count = payloads[s].size ();
+          }
+
+          compressed_tree_data.write ("PCSL", 4);
+          writeUInt (compressed_tree_data, 1, 4);
+          writeUInt (compressed_tree_data, slice_count_, 4);
+          for (unsigned int s = 0; s < slice_count_; ++s)
+          {
+            writeUInt (compressed_tree_data, slice_table_[s].point_count, 4);
+            writeUInt (compressed_tree_data, slice_table_[s].byte_count, 8);
+          }
+          for (unsigned int s = 0; s < slice_count_; ++s)
+            compressed_tree_data.write (payloads[s].data (), payloads[s].size ());
+        }
+
+        /** \brief Decode a point cloud written by encodePointCloud, slices are
+          * decompressed in parallel and concatenated in slice order.
+          * \param[in] compressed_tree_data binary input stream
+          * \param[out] cloud output cloud
+          * \return false if the stream does not start with a valid slice table or
+          *         ends before the payloads it announces
+          */
+        bool
+        decodePointCloud (std::istream &compressed_tree_data, PointCloudPtr &cloud)
+        {
+          char magic[4];
+          compressed_tree_data.read (magic, 4);
+          if (!compressed_tree_data || std::string (magic, 4) != "PCSL")
+            return (false);
+          uint64_t version = readUInt (compressed_tree_data, 4);
+          uint64_t count = readUInt (compressed_tree_data, 4);
+          if (!compressed_tree_data || version != 1 || count == 0 || count > kMaxSliceCount)
+            return (false);
+
+          // 表中的大小来自网络，不可信：载荷按块读入，流提前结束时返回 false 而不是先分配
+          std::vector<SliceInfo> table (count);
+          for (size_t s = 0; s < count; ++s)
+          {
+            table[s].point_count = static_cast<uint32_t> (readUInt (compressed_tree_data, 4));
+            table[s].byte_count = readUInt (compressed_tree_data, 8);
+          }
+          if (!compressed_tree_data)
+            return (false);
+          std::vector<std::string> payloads (count);
+          for (size_t s = 0; s < count; ++s)
+            if (!readPayload (compressed_tree_data, table[s].byte_count, payloads[s]))
+              return (false);
+          slice_table_.swap (table);
+
+          if (decoders_.size () != count)
+          {
+            decoders_.resize (count);
+            for (size_t s = 0; s < count; ++s)
+              decoders_[s].reset (new SliceCodec ());
+          }
+
+          std::vector<PointCloudPtr> slices (count);
+          int n = static_cast<int> (count);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+          for (int s = 0; s < n; ++s)
+          {
+            slices[s].reset (new PointCloud);
+            if (payloads[s].empty ())
+              continue;
+            std::istringstream slice_stream (payloads[s]);
+            decoders_[s]->decodePointCloud (slice_stream, slices[s]);
+          }
+
+          // 按切片顺序拼接，每个切片并行拷贝到各自的偏移处
+          std::vector<size_t> offsets (count + 1, 0);
+          for (size_t s = 0; s < count; ++s)
+            offsets[s + 1] = offsets[s] + slices[s]->points.size ();
+          if (!cloud)
+            cloud.reset (new PointCloud);
+          cloud->points.resize (offsets[count]);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(getThreads ())
+          for (int s = 0; s < n; ++s)
+            std::copy (slices[s]->points.begin (), slices[s]->points.end (), cloud->points.begin () + offsets[s]);
+          cloud->width = static_cast<uint32_t> (cloud->points.size ());
+          cloud->height = 1;
+          cloud->is_dense = true;
+          return (true);
+        }
+
+      private:
+        /** \brief Octree resolution of the profile (compressionProfiles_), used to snap the slab
+          * boundaries; MANUAL_CONFIGURATION uses the default of PointCloudCompression.
+          */
+        double
+        octreeResolution () const
+        {
+          if (profile_ < COMPRESSION_PROFILE_COUNT)
+            return (compressionProfiles_[profile_].octreeResolution);
+          return (0.01);
+        }
+
+        void
+        computeSlicing (const PointCloud &cloud)
+        {
+          float min_p[3], max_p[3];
+          for (int d = 0; d < 3; ++d)
+          {
+            min_p[d] = std::numeric_limits<float>::max ();
+            max_p[d] = -std::numeric_limits<float>::max ();
+          }
+          for (size_t i = 0; i < cloud.points.size (); ++i)
+          {
+            const PointT &p = cloud.points[i];
+            if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+              continue;
+            const float c[3] = { p.x, p.y, p.z };
+            for (int d = 0; d < 3; ++d)
+            {
+              if (c[d] < min_p[d]) min_p[d] = c[d];
+              if (c[d] > max_p[d]) max_p[d] = c[d];
+            }
+          }
+          axis_ = 0;
+          for (int d = 1; d < 3; ++d)
+            if (max_p[d] - min_p[d] > max_p[axis_] - min_p[axis_])
+              axis_ = d;
+
+          const double resolution = octreeResolution ();
+          const double extent = max_p[axis_] > min_p[axis_] ? max_p[axis_] - min_p[axis_] : 0.0;
+          const double voxels_per_slice = std::ceil (extent / resolution / slice_count_) + 1.0;
+          slice_origin_ = max_p[axis_] >= min_p[axis_] ? static_cast<float> (std::floor (min_p[axis_] / resolution) * resolution) : 0.0f;
+          slice_width_ = static_cast<float> (voxels_per_slice * resolution);
+          slicing_valid_ = true;
+          encoders_.clear ();
+        }
+
+        inline unsigned int
+        sliceOf (const PointT &p) const
+        {
+          const float c[3] = { p.x, p.y, p.z };
+          const float s = std::floor ((c[axis_] - slice_origin_) / slice_width_);
+          if (s <= 0.0f)
+            return (0);
+          return (s >= static_cast<float> (slice_count_) ? slice_count_ - 1 : static_cast<unsigned int> (s));
+        }
+
+        inline int
+        getThreads () const
+        {
+#ifdef _OPENMP
+          return (threads_ > 0 ? static_cast<int> (threads_) : omp_get_max_threads ());
+#else
+          return (1);
+#endif
+        }
+
+        static void
+        writeUInt (std::ostream &os, uint64_t value, int bytes)
+        {
+          for (int b = 0; b < bytes; ++b)
+            os.put (static_cast<char> ((value >> (8 * b)) & 0xff));
+        }
+
+        /** \brief Read byte_count bytes in pieces of at most 1 MB, so the buffer only grows
+          * with data that actually arrived.
+          */
+        static bool
+        readPayload (std::istream &is, uint64_t byte_count, std::string &payload)
+        {
+          const uint64_t piece = 1 << 20;
+          payload.clear ();
+          while (payload.size () < byte_count)
+          {
+            const size_t n = static_cast<size_t> (std::min (piece, byte_count - payload.size ()));
+            const size_t old_size = payload.size ();
+            if (payload.capacity () < old_size + n)
+              payload.reserve (static_cast<size_t> (std::min<uint64_t> (byte_count, 2 * old_size + n)));
+            payload.resize (old_size + n);
+            is.read (&payload[old_size], n);
+            if (!is)
+              return (false);
+          }
+          return (true);
+        }
+
+        static uint64_t
+        readUInt (std::istream &is, int bytes)
+        {
+          uint64_t value = 0;
+          for (int b = 0; b < bytes; ++b)
+            value |= static_cast<uint64_t> (static_cast<unsigned char> (is.get ())) << (8 * b);
+          return (value);
+        }
+
+        compression_Profiles_e profile_;
+        unsigned int slice_count_;
+        unsigned int threads_;
+
+        bool slicing_valid_;
+        int axis_;
+        float slice_origin_;
+        float slice_width_;
+
+        std::vector<SliceCodecPtr> encoders_;
+        std::vector<SliceCodecPtr> decoders_;
+        std::vector<SliceInfo> slice_table_;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "quantized_point_codec.h"
+
+using namespace pcl::console;
+
+// 打印一行结果：压缩率、编码与解码速度（百万点/秒）
+void
+printRow (const std::string &name, size_t raw_bytes, size_t bytes, size_t points, double enc_ms, double dec_ms)
+{
+  std::cout << "  " << std::setw (18) << std::left << name << std::right
+            << std::setw (10) << bytes << " bytes  ratio " << std::setw (6) << std::setprecision (3)
+            << static_cast<double> (raw_bytes) / bytes << "  encode " << std::setw (7)
+            << points / (enc_ms * 1e3) << " Mpts/s  decode " << std::setw (7)
+            << points / (dec_ms * 1e3) << " Mpts/s" << std::endl;
+}
+
+template <typename PointT> int
+runBenchmark (const std::string &file, double precision)
+{
+  typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+  if (pcl::io::loadPCDFile (file, *cloud) < 0)
+    return (-1);
+  const size_t points = cloud->points.size ();
+  const size_t raw_bytes = points * sizeof (PointT);
+  std::cout << file << ": " << points << " points, " << raw_bytes << " bytes in memory" << std::endl;
+  if (points == 0)
+    return (0);
+  TicToc tt;
+
+  // 对照：PCL 自带的 binary_compressed PCD（LZF）
+  const std::string tmp_file = "quantized_codec_benchmark_tmp.pcd";
+  pcl::PCDWriter writer;
+  tt.tic ();
+  writer.writeBinaryCompressed (tmp_file, *cloud);
+  double enc_ms = tt.toc ();
+  pcl::PointCloud<PointT> reloaded;
+  tt.tic ();
+  pcl::io::loadPCDFile (tmp_file, reloaded);
+  double dec_ms = tt.toc ();
+  std::ifstream tmp (tmp_file.c_str (), std::ios::binary | std::ios::ate);
+  size_t pcd_bytes = static_cast<size_t> (tmp.tellg ());
+  tmp.close ();
+  std::remove (tmp_file.c_str ());
+  printRow ("binary_compressed", raw_bytes, pcd_bytes, points, enc_ms, dec_ms);
+
+  const char *names[] = { "quantized fast", "quantized dense" };
+  for (int m = 0; m < 2; ++m)
+  {
+    pcl::io::QuantizedPointCodec<PointT> codec (precision, static_cast<typename pcl::io::QuantizedPointCodec<PointT>::Mode> (m));
+    std::stringstream data;
+    tt.tic ();
+    if (!codec.encodePointCloud (*cloud, data))
+    {
+      std::cerr << "  extent too large for precision " << precision << std::endl;
+      return (-1);
+    }
+    enc_ms = tt.toc ();
+    size_t bytes = data.str ().size ();
+    pcl::PointCloud<PointT> decoded;
+    tt.tic ();
+    codec.decodePointCloud (data, decoded);
+    dec_ms = tt.toc ();
+    printRow (names[m], raw_bytes, bytes, points, enc_ms, dec_ms);
+  }
+
+  // 检查误差上界：每个解码点到最近原始网格位置的误差不超过 precision/2
+  pcl::io::QuantizedPointCodec<PointT> codec (precision);
+  std::stringstream data;
+  codec.encodePointCloud (*cloud, data);
+  pcl::PointCloud<PointT> decoded;
+  codec.decodePointCloud (data, decoded);
+  std::vector<float> a, b;
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+    if (pcl_isfinite (cloud->points[i].x))
+      a.push_back (cloud->points[i].x);
+  for (size_t i = 0; i < decoded.points.size (); ++i)
+    b.push_back (decoded.points[i].x);
+  std::sort (a.begin (), a.end ());
+  std::sort (b.begin (), b.end ());
+  double max_err = 0;
+  for (size_t i = 0; i < a.size () && i < b.size (); ++i)
+    max_err = std::max (max_err, static_cast<double> (std::fabs (a[i] - b[i])));
+  std::cout << "  max x error " << max_err << " (bound " << codec.getMaxError () << "), "
+            << decoded.points.size () << " of " << a.size () << " finite points" << std::endl;
+  return (0);
+}
+
+int
+main (int argc, char** argv)
+{
+  std::vector<int> pcd_files = parse_file_extension_argument (argc, argv, ".pcd");
+  if (pcd_files.empty ())
+  {
+    std::cout << argv[0] << " a.pcd [b.pcd ...] -p precision -t xyz|xyzi|xyzrgb|xyzrgba" << std::endl;
+    return (0);
+  }
+  double precision = 0.0001;
+  std::string type = "xyzrgba";
+  parse_argument (argc, argv, "-p", precision);
+  parse_argument (argc, argv, "-t", type);
+  for (size_t i = 0; i < pcd_files.size (); ++i)
+  {
+    std::string file = argv[pcd_files[i]];
+    if (type == "xyz")
+      runBenchmark<pcl::PointXYZ> (file, precision);
+    else if (type == "xyzi")
+      runBenchmark<pcl::PointXYZI> (file, precision);
+    else if (type == "xyzrgb")
+      runBenchmark<pcl::PointXYZRGB> (file, precision);
+    else
+      runBenchmark<pcl::PointXYZRGBA> (file, precision);
+  }
+  return (0);
+}
@@ -0,0 +1,643 @@
+/*! \file quantized_point_codec.h
+*  Fixed-point quantized point codec with bounded coordinate error, meant for archival.
+*/
+#ifndef QUANTIZED_POINT_CODEC_H_
+#define QUANTIZED_POINT_CODEC_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/compression/entropy_range_coder.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace pcl
+{
+  namespace io
+  {
+    /** \brief Which non-geometric fields of a point type the quantized codec stores.
+      * Point types without a specialization are coded as plain XYZ.
+      */
+    template <typename PointT>
+    struct QuantizedCodecTraits
+    {
+      enum { color_channels = 0, has_intensity = 0 };
+      static void getColor (const PointT &, uint8_t *) {}
+      static void setColor (PointT &, const uint8_t *) {}
+      static float getIntensity (const PointT &) { return (0.0f); }
+      static void setIntensity (PointT &, float) {}
+    };
+
+    template <>
+    struct QuantizedCodecTraits<pcl::PointXYZRGB>
+    {
+      enum { color_channels = 3, has_intensity = 0 };
+      static void getColor (const pcl::PointXYZRGB &p, uint8_t *c) { c[0] = p.r; c[1] = p.g; c[2] = p.b; }
+      static void setColor (pcl::PointXYZRGB &p, const uint8_t *c) { p.r = c[0]; p.g = c[1]; p.b = c[2]; }
+      static float getIntensity (const pcl::PointXYZRGB &) { return (0.0f); }
+      static void setIntensity (pcl::PointXYZRGB &, float) {}
+    };
+
+    template <>
+    struct QuantizedCodecTraits<pcl::PointXYZRGBA>
+    {
+      enum { color_channels = 4, has_intensity = 0 };
+      static void getColor (const pcl::PointXYZRGBA &p, uint8_t *c) { c[0] = p.r; c[1] = p.g; c[2] = p.b; c[3] = p.a; }
+      static void setColor (pcl::PointXYZRGBA &p, const uint8_t *c) { p.r = c[0]; p.g = c[1]; p.b = c[2]; p.a = c[3]; }
+      static float getIntensity (const pcl::PointXYZRGBA &) { return (0.0f); }
+      static void setIntensity (pcl::PointXYZRGBA &, float) {}
+    };
+
+    template <>
+    struct QuantizedCodecTraits<pcl::PointXYZI>
+    {
+      enum { color_channels = 0, has_intensity = 1 };
+      static void getColor (const pcl::PointXYZI &, uint8_t *) {}
+      static void setColor (pcl::PointXYZI &, const uint8_t *) {}
+      static float getIntensity (const pcl::PointXYZI &p) { return (p.intensity); }
+      static void setIntensity (pcl::PointXYZI &p, float i) { p.intensity = i; }
+    };
+
+    /** \brief Point codec that quantizes XYZ to integers on a grid of a given precision,
+      * sorts the points in Morton order, delta-codes the coordinates and stores
+      * coordinates and attributes in separate streams.
+      *
+      * Coordinates are reconstructed with an error of at most precision / 2 per axis;
+      * colors and intensities are stored losslessly. Points with non-finite
+      * coordinates are dropped and the point order is not preserved.
+      *
+      * Two profiles are offered:
+      *  - FAST: zigzag deltas written as byte-aligned varints, then every stream
+      *    goes through a byte-oriented LZ77 pass in the manner of LZ4 (hash of
+      *    the next 4 bytes, 16-bit offsets, no entropy coding). Runs such as the
+      *    constant high bytes of colors and intensities collapse into matches.
+      *  - DENSE: deltas split into byte planes, every plane entropy-coded with
+      *    pcl::StaticRangeCoder (the coder used by the octree compression).
+      * The streams are independent and are coded in parallel.
+      */
+    template <typename PointT>
+    class QuantizedPointCodec
+    {
+      public:
+        typedef pcl::PointCloud<PointT> PointCloud;
+        typedef QuantizedCodecTraits<PointT> Traits;
+
+        enum Mode { FAST = 0, DENSE = 1 };
+
+        /** \brief Constructor.
+          * \param[in] precision quantization step in meters
+          * \param[in] mode FAST or DENSE stream coding
+          */
+        QuantizedPointCodec (double precision = 0.0001, Mode mode = DENSE)
+          : precision_ (precision > 0 ? precision : 0.0001)
+          , mode_ (mode)
+        {
+        }
+
+        inline void
+        setPrecision (double precision) { if (precision > 0) precision_ = precision; }
+
+        inline double
+        getPrecision () const { return (precision_); }
+
+        /** \brief Largest per-axis reconstruction error. */
+        inline double
+        getMaxError () const { return (0.5 * precision_); }
+
+        inline void
+        setMode (Mode mode) { mode_ = mode; }
+
+        /** \brief Encode a cloud.
+          * \return false if the quantized extent does not fit into 62 bits per axis
+          */
+        bool
+        encodePointCloud (const PointCloud &cloud, std::ostream &compressed) const
+        {
+          // 1. 量化到整数网格
+          std::vector<int64_t> q;
+          q.reserve (cloud.points.size () * 3);
+          std::vector<size_t> source;
+          source.reserve (cloud.points.size ());
+          int64_t origin[3] = { 0, 0, 0 };
+          int64_t max_q[3] = { 0, 0, 0 };
+          bool first = true;
+          for (size_t i = 0; i < cloud.points.size (); ++i)
+          {
+            const PointT &p = cloud.points[i];
+            if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+              continue;
+            const double c[3] = { p.x, p.y, p.z };
+            for (int d = 0; d < 3; ++d)
+            {
+              double v = std::floor (c[d] / precision_ + 0.5);
+              if (std::fabs (v) > 4.0e18)
+                return (false);
+              int64_t iv = static_cast<int64_t> (v);
+              q.push_back (iv);
+              if (first || iv < origin[d]) origin[d] = iv;
+              if (first || iv > max_q[d]) max_q[d] = iv;
+            }
+            first = false;
+            source.push_back (i);
+          }
+          const size_t n = source.size ();
+          int shift = 0;
+          for (int d = 0; d < 3; ++d)
+          {
+            uint64_t range = static_cast<uint64_t> (max_q[d] - origin[d]);
+            if (range >> 62)
+              return (false);
+            while ((range >> shift) >= (1u << 21))
+              ++shift;
+          }
+
+          // 2. 按 Morton 码排序，每轴取 21 位
+          std::vector<std::pair<uint64_t, size_t> > order (n);
+          for (size_t i = 0; i < n; ++i)
+          {
+            uint64_t key = 0;
+            for (int d = 0; d < 3; ++d)
+              key |= spreadBits (static_cast<uint64_t> (q[3 * i + d] - origin[d]) >> shift) << d;
+            order[i] = std::make_pair (key, i);
+          }
+          std::sort (order.begin (), order.end ());
+
+          // 3. 坐标差分，颜色按通道差分，强度与前一个值异或
+          std::vector<uint64_t> deltas[3];
+          for (int d = 0; d < 3; ++d)
+            deltas[d].resize (n);
+          const int channels = Traits::color_channels;
+          std::vector<uint8_t> colors (n * channels);
+          std::vector<uint32_t> intensities (Traits::has_intensity ? n : 0);
+          int64_t prev[3] = { 0, 0, 0 };
+          uint8_t prev_color[4] = { 0, 0, 0, 0 };
+          uint32_t prev_intensity = 0;
+          for (size_t i = 0; i < n; ++i)
+          {
+            const size_t k = order[i].second;
+            for (int d = 0; d < 3; ++d)
+            {
+              int64_t v = q[3 * k + d] - origin[d];
+              deltas[d][i] = zigzag (v - prev[d]);
+              prev[d] = v;
+            }
+            const PointT &p = cloud.points[source[k]];
+            if (channels > 0)
+            {
+              uint8_t c[4];
+              Traits::getColor (p, c);
+              for (int ch = 0; ch < channels; ++ch)
+              {
+                colors[ch * n + i] = static_cast<uint8_t> (c[ch] - prev_color[ch]);
+                prev_color[ch] = c[ch];
+              }
+            }
+            if (Traits::has_intensity)
+            {
+              float f = Traits::getIntensity (p);
+              uint32_t bits;
+              std::memcpy (&bits, &f, sizeof (bits));
+              intensities[i] = bits ^ prev_intensity;
+              prev_intensity = bits;
+            }
+          }
+
+          // 4. 每个流独立编码（并行）
+          std::vector<std::string> raw (5);
+          std::vector<int> widths (5, 0);
+          for (int d = 0; d < 3; ++d)
+            packDeltas (deltas[d], raw[d], widths[d]);
+          raw[3].assign (colors.begin (), colors.end ());
+          packPlanes (intensities, raw[4]);
+          widths[4] = 4;
+
+          std::vector<std::string> coded (raw.size ());
+          int streams = static_cast<int> (raw.size ());
+#pragma omp parallel for schedule(dynamic, 1)
+          for (int s = 0; s < streams; ++s)
+            coded[s] = codeStream (raw[s], s < 3 ? widths[s] : (s == 3 ? channels : 4));
+
+          compressed.write ("PCQZ", 4);
+          writeUInt (compressed, 2, 4);
+          writeUInt (compressed, mode_, 1);
+          writeUInt (compressed, channels, 1);
+          writeUInt (compressed, Traits::has_intensity, 1);
+          writeUInt (compressed, shift, 1);
+          uint64_t precision_bits;
+          std::memcpy (&precision_bits, &precision_, sizeof (precision_bits));
+          writeUInt (compressed, precision_bits, 8);
+          for (int d = 0; d < 3; ++d)
+            writeUInt (compressed, static_cast<uint64_t> (origin[d]), 8);
+          writeUInt (compressed, n, 8);
+          for (int s = 0; s < streams; ++s)
+          {
+            writeUInt (compressed, widths[s], 1);
+            writeUInt (compressed, raw[s].size (), 8);
+            writeUInt (compressed, coded[s].size (), 8);
+            compressed.write (coded[s].data (), coded[s].size ());
+          }
+          return (compressed.good ());
+        }
+
+        /** \brief Decode a cloud written by encodePointCloud (of the same point type).
+          * \return false on a malformed stream
+          */
+        bool
+        decodePointCloud (std::istream &compressed, PointCloud &cloud) const
+        {
+          char magic[4];
+          compressed.read (magic, 4);
+          if (!compressed || std::string (magic, 4) != "PCQZ")
+            return (false);
+          // 版本 1 的 FAST 流没有 LZ 阶段
+          const uint64_t version = readUInt (compressed, 4);
+          if (version != 1 && version != 2)
+            return (false);
+          const Mode mode = static_cast<Mode> (readUInt (compressed, 1));
+          const int channels = static_cast<int> (readUInt (compressed, 1));
+          const bool has_intensity = readUInt (compressed, 1) != 0;
+          readUInt (compressed, 1);
+          uint64_t precision_bits = readUInt (compressed, 8);
+          double precision;
+          std::memcpy (&precision, &precision_bits, sizeof (precision));
+          int64_t origin[3];
+          for (int d = 0; d < 3; ++d)
+            origin[d] = static_cast<int64_t> (readUInt (compressed, 8));
+          const size_t n = static_cast<size_t> (readUInt (compressed, 8));
+
+          std::vector<std::string> coded (5);
+          std::vector<int> widths (5);
+          std::vector<size_t> raw_sizes (5);
+          for (int s = 0; s < 5; ++s)
+          {
+            widths[s] = static_cast<int> (readUInt (compressed, 1));
+            raw_sizes[s] = static_cast<size_t> (readUInt (compressed, 8));
+            coded[s].resize (static_cast<size_t> (readUInt (compressed, 8)));
+            if (!coded[s].empty ())
+              compressed.read (&coded[s][0], coded[s].size ());
+          }
+          if (!compressed)
+            return (false);
+
+          std::vector<std::string> raw (5);
+          std::vector<char> decoded (5, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+          for (int s = 0; s < 5; ++s)
+            decoded[s] = decodeStream (coded[s], raw_sizes[s], mode, version >= 2, s < 3 ? widths[s] : (s == 3 ? channels : 4), raw[s]);
+          for (int s = 0; s < 5; ++s)
+            if (!decoded[s])
+              return (false);
+
+          std::vector<uint64_t> deltas[3];
+          for (int d = 0; d < 3; ++d)
+            if (!unpackDeltas (raw[d], n, mode, widths[d], deltas[d]))
+              return (false);
+          if (raw[3].size () != n * channels || (has_intensity && raw[4].size () != n * 4))
+            return (false);
+
+          cloud.points.resize (n);
+          cloud.width = static_cast<uint32_t> (n);
+          cloud.height = 1;
+          cloud.is_dense = true;
+          int64_t prev[3] = { 0, 0, 0 };
+          uint8_t color[4] = { 0, 0, 0, 0 };
+          uint32_t intensity = 0;
+          const bool copy_color = channels == Traits::color_channels && channels > 0;
+          for (size_t i = 0; i < n; ++i)
+          {
+            PointT &p = cloud.points[i];
+            float *xyz[3] = { &p.x, &p.y, &p.z };
+            for (int d = 0; d < 3; ++d)
+            {
+              prev[d] += unzigzag (deltas[d][i]);
+              *xyz[d] = static_cast<float> (static_cast<double> (prev[d] + origin[d]) * precision);
+            }
+            if (copy_color)
+            {
+              for (int ch = 0; ch < channels; ++ch)
+                color[ch] = static_cast<uint8_t> (color[ch] + static_cast<uint8_t> (raw[3][ch * n + i]));
+              Traits::setColor (p, color);
+            }
+            if (has_intensity && Traits::has_intensity)
+            {
+              uint32_t bits = 0;
+              for (int b = 0; b < 4; ++b)
+                bits |= static_cast<uint32_t> (static_cast<uint8_t> (raw[4][b * n + i])) << (8 * b);
+              intensity ^= bits;
+              float f;
+              std::memcpy (&f, &intensity, sizeof (f));
+              Traits::setIntensity (p, f);
+            }
+          }
+          return (true);
+        }
+
+      private:
+        /** \brief Spread the lower 21 bits of v so that they occupy every third bit. */
+        static inline uint64_t
+        spreadBits (uint64_t v)
+        {
+          v &= 0x1fffff;
+          v = (v | (v << 32)) & 0x1f00000000ffffULL;
+          v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+          v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+          v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+          v = (v | (v << 2)) & 0x1249249249249249ULL;
+          return (v);
+        }
+
+        static inline uint64_t
+        zigzag (int64_t v) { return ((static_cast<uint64_t> (v) << 1) ^ static_cast<uint64_t> (v >> 63)); }
+
+        static inline int64_t
+        unzigzag (uint64_t v) { return (static_cast<int64_t> (v >> 1) ^ -static_cast<int64_t> (v & 1)); }
+
+        /** \brief FAST: varints. DENSE: fixed-width little-endian byte planes. */
+        void
+        packDeltas (const std::vector<uint64_t> &deltas, std::string &out, int &width) const
+        {
+          const size_t n = deltas.size ();
+          if (mode_ == FAST)
+          {
+            width = 0;
+            out.reserve (n * 2);
+            for (size_t i = 0; i < n; ++i)
+            {
+              uint64_t v = deltas[i];
+              while (v >= 0x80)
+              {
+                out.push_back (static_cast<char> ((v & 0x7f) | 0x80));
+                v >>= 7;
+              }
+              out.push_back (static_cast<char> (v));
+            }
+            return;
+          }
+          uint64_t max_delta = 0;
+          for (size_t i = 0; i < n; ++i)
+            max_delta = std::max (max_delta, deltas[i]);
+          width = 1;
+          while (width < 8 && (max_delta >> (8 * width)) != 0)
+            ++width;
+          out.resize (n * width);
+          for (int b = 0; b < width; ++b)
+            for (size_t i = 0; i < n; ++i)
+              out[b * n + i] = static_cast<char> ((deltas[i] >> (8 * b)) & 0xff);
+        }
+
+        static bool
+        unpackDeltas (const std::string &in, size_t n, Mode mode, int width, std::vector<uint64_t> &deltas)
+        {
+          deltas.assign (n, 0);
+          if (mode == FAST)
+          {
+            size_t pos = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+              uint64_t v = 0;
+              int bit = 0;
+              for (;;)
+              {
+                if (pos >= in.size () || bit > 63)
+                  return (false);
+                uint8_t byte = static_cast<uint8_t> (in[pos++]);
+                v |= static_cast<uint64_t> (byte & 0x7f) << bit;
+                bit += 7;
+                if (!(byte & 0x80))
+                  break;
+              }
+              deltas[i] = v;
+            }
+            return (true);
+          }
+          if (in.size () != n * width)
+            return (false);
+          for (int b = 0; b < width; ++b)
+            for (size_t i = 0; i < n; ++i)
+              deltas[i] |= static_cast<uint64_t> (static_cast<uint8_t> (in[b * n + i])) << (8 * b);
+          return (true);
+        }
+
+        static void
+        packPlanes (const std::vector<uint32_t> &values, std::string &out)
+        {
+          const size_t n = values.size ();
+          out.resize (n * 4);
+          for (int b = 0; b < 4; ++b)
+            for (size_t i = 0; i < n; ++i)
+              out[b * n + i] = static_cast<char> ((values[i] >> (8 * b)) & 0xff);
+        }
+
+        /** \brief FAST mode LZ-codes the whole stream, DENSE mode range-codes every byte plane of it separately. */
+        std::string
+        codeStream (const std::string &raw, int planes) const
+        {
+          if (mode_ == FAST)
+            return (lzCompress (raw));
+          if (raw.empty ())
+            return (raw);
+          const size_t plane = raw.size () / planes;
+          std::ostringstream out;
+          for (int b = 0; b < planes; ++b)
+          {
+            std::vector<char> symbols (raw.begin () + b * plane, raw.begin () + (b + 1) * plane);
+            std::ostringstream plane_stream;
+            pcl::StaticRangeCoder coder;
+            coder.encodeCharVectorToStream (symbols, plane_stream);
+            const std::string bytes = plane_stream.str ();
+            writeUInt (out, bytes.size (), 8);
+            out.write (bytes.data (), bytes.size ());
+          }
+          return (out.str ());
+        }
+
+        static bool
+        decodeStream (const std::string &coded, size_t raw_size, Mode mode, bool lz, int planes, std::string &raw)
+        {
+          if (mode == FAST)
+          {
+            if (!lz)
+            {
+              raw = coded;
+              return (true);
+            }
+            return (lzDecompress (coded, raw_size, raw));
+          }
+          if (raw_size == 0 || planes == 0)
+          {
+            raw = coded;
+            return (true);
+          }
+          const size_t plane = raw_size / planes;
+          raw.clear ();
+          raw.reserve (raw_size);
+          std::istringstream in (coded);
+          for (int b = 0; b < planes; ++b)
+          {
+            std::string bytes (static_cast<size_t> (readUInt (in, 8)), '\0');
+            if (!bytes.empty ())
+              in.read (&bytes[0], bytes.size ());
+            std::istringstream plane_stream (bytes);
+            std::vector<char> symbols (plane);
+            pcl::StaticRangeCoder coder;
+            coder.decodeStreamToCharVector (plane_stream, symbols);
+            raw.append (symbols.begin (), symbols.end ());
+          }
+          return (true);
+        }
+
+        /** \brief LZ77 in the manner of LZ4: each sequence is a token (literal count in the
+          * high nibble, match length - 4 in the low nibble, 15 continued in bytes of up to 255),
+          * the literals, and a 16-bit little-endian match offset. The last sequence has no match.
+          */
+        static std::string
+        lzCompress (const std::string &in)
+        {
+          const size_t n = in.size ();
+          const unsigned char *src = reinterpret_cast<const unsigned char *> (in.data ());
+          std::string out;
+          out.reserve (n + n / 255 + 16);
+          std::vector<int> table (static_cast<size_t> (1) << 14, -1);
+          size_t pos = 0, anchor = 0, misses = 0;
+          while (pos + 4 <= n)
+          {
+            const uint32_t seq = read32 (src + pos);
+            const size_t h = static_cast<size_t> ((seq * 2654435761u) >> 18);
+            const int candidate = table[h];
+            table[h] = static_cast<int> (pos);
+            if (candidate < 0 || pos - candidate > 0xffff || read32 (src + candidate) != seq)
+            {
+              // 连续找不到匹配时加大步长，难压缩的数据很快跳过
+              pos += 1 + (misses++ >> 6);
+              continue;
+            }
+            size_t length = 4;
+            while (pos + length < n && src[candidate + length] == src[pos + length])
+              ++length;
+            writeSequence (out, src + anchor, pos - anchor, length);
+            out.push_back (static_cast<char> ((pos - candidate) & 0xff));
+            out.push_back (static_cast<char> ((pos - candidate) >> 8));
+            writeLength (out, length - 4);
+            pos += length;
+            anchor = pos;
+            misses = 0;
+          }
+          writeSequence (out, src + anchor, n - anchor, 4);
+          return (out);
+        }
+
+        /** \brief Decode lzCompress output. \return false unless it expands to exactly raw_size bytes */
+        static bool
+        lzDecompress (const std::string &in, size_t raw_size, std::string &out)
+        {
+          out.clear ();
+          // 每个输入字节最多展开为 255 个字节，更大的长度说明流已损坏
+          if (raw_size / 255 > in.size ())
+            return (false);
+          out.reserve (raw_size);
+          const unsigned char *src = reinterpret_cast<const unsigned char *> (in.data ());
+          const size_t n = in.size ();
+          size_t pos = 0;
+          while (pos < n)
+          {
+            const unsigned char token = src[pos++];
+            size_t literals = token >> 4;
+            if (!readLength (src, n, pos, literals) || literals > n - pos || literals > raw_size - out.size ())
+              return (false);
+            out.append (in, pos, literals);
+            pos += literals;
+            if (pos == n)
+              break;
+            if (n - pos < 2)
+              return (false);
+            const size_t offset = src[pos] | (static_cast<size_t> (src[pos + 1]) << 8);
+            pos += 2;
+            size_t length = token & 0x0f;
+            if (offset == 0 || offset > out.size () || !readLength (src, n, pos, length) || length + 4 > raw_size - out.size ())
+              return (false);
+            // 匹配可以与自身重叠（游程），只能逐字节复制
+            for (size_t i = 0, from = out.size () - offset; i < length + 4; ++i)
+              out.push_back (out[from + i]);
+          }
+          return (out.size () == raw_size);
+        }
+
+        static inline uint32_t
+        read32 (const unsigned char *p)
+        {
+          uint32_t v;
+          std::memcpy (&v, p, sizeof (v));
+          return (v);
+        }
+
+        /** \brief Token and literals of a sequence; a match_length below 4 means no match. */
+        static void
+        writeSequence (std::string &out, const unsigned char *literals, size_t count, size_t match_length)
+        {
+          const size_t match_code = match_length >= 4 ? match_length - 4 : 0;
+          out.push_back (static_cast<char> ((std::min<size_t> (count, 15) << 4) | std::min<size_t> (match_code, 15)));
+          writeLength (out, count);
+          out.append (reinterpret_cast<const char *> (literals), count);
+        }
+
+        /** \brief Continuation bytes of a length whose nibble is 15. */
+        static void
+        writeLength (std::string &out, size_t length)
+        {
+          if (length < 15)
+            return;
+          length -= 15;
+          while (length >= 255)
+          {
+            out.push_back (static_cast<char> (255));
+            length -= 255;
+          }
+          out.push_back (static_cast<char> (length));
+        }
+
+        static bool
+        readLength (const unsigned char *src, size_t n, size_t &pos, size_t &length)
+        {
+          if (length < 15)
+            return (true);
+          unsigned char byte;
+          do
+          {
+            if (pos >= n)
+              return (false);
+            byte = src[pos++];
+            length += byte;
+          }
+          while (byte == 255);
+          return (true);
+        }
+
+        static void
+        writeUInt (std::ostream &os, uint64_t value, int bytes)
+        {
+          for (int b = 0; b < bytes; ++b)
+            os.put (static_cast<char> ((value >> (8 * b)) & 0xff));
+        }
+
+        static uint64_t
+        readUInt (std::istream &is, int bytes)
+        {
+          uint64_t value = 0;
+          for (int b = 0; b < bytes; ++b)
+            value |= static_cast<uint64_t> (static_cast<unsigned char> (is.get ())) << (8 * b);
+          return (value);
+        }
+
+        double precision_;
+        Mode mode_;
+    };
+  }
+}
+
+#endif